@@ -0,0 +1,443 @@
+#include <vulkan/vk_enum_string_helper.h>
+#include <vulkan/vulkan.h>
+
+#include <cstring>
+#include <iostream>
+
+#include "HostAllocator.h"
+#include "Profiler.h"
+#include "VulkanContext.h"
+#include "utils.h"
+
+#include "AssetLoader.h"
+
+static const uint32_t IO_THREAD_COUNT = 2;
+static const VkDeviceSize STAGING_RING_SIZE = 16 * 1024 * 1024;
+
+struct AssetLoad
+{
+    AssetLoader *loader;
+    AssetRequest request;
+    std::vector<char> bytes;
+    std::vector<AssetUpload> uploads;
+    bool prepared;
+};
+
+AssetLoader::AssetLoader(VulkanContext *context)
+    : context(context),
+      stopping(false),
+      commandPool(VK_NULL_HANDLE),
+      stagingRing(context, STAGING_RING_SIZE),
+      pendingCount(0),
+      filesRead(0),
+      bytesRead(0),
+      readNs(0),
+      decoded(0),
+      decodeNs(0),
+      uploads(0),
+      bytesUploaded(0),
+      uploadNs(0),
+      completed(0)
+{
+}
+
+AssetLoader::~AssetLoader()
+{
+    shutdown();
+
+    for (AssetLoad *load : ioQueue)
+        delete load;
+    for (AssetLoad *load : uploadQueue)
+        delete load;
+    for (AssetLoad *load : stagingQueue)
+        delete load;
+    for (AssetLoad *load : completions)
+        delete load;
+
+    // The device is idle by now, so every batch has retired.
+    VkDevice device = context->getDevice();
+    for (UploadBatch &batch : batches)
+    {
+        for (AssetLoad *load : batch.loads)
+            delete load;
+        freeBatches.push_back(batch);
+    }
+    for (const UploadBatch &batch : freeBatches)
+        vkDestroyFence(device,
+                       batch.fence,
+                       HostAllocator::get(HostAllocationTag::Synchronization));
+
+    if (commandPool != VK_NULL_HANDLE)
+        vkDestroyCommandPool(device,
+                             commandPool,
+                             HostAllocator::get(HostAllocationTag::Commands));
+}
+
+void AssetLoader::init()
+{
+    createCommandPool();
+    stagingRing.init();
+
+    for (uint32_t i = 0; i < IO_THREAD_COUNT; i++)
+        ioThreads.emplace_back(&AssetLoader::ioLoop, this);
+}
+
+void AssetLoader::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(ioMutex);
+        stopping = true;
+    }
+    ioCondition.notify_all();
+    for (std::thread &thread : ioThreads)
+        thread.join();
+    ioThreads.clear();
+
+    // Decode jobs point back at the loader and write into their assets.
+    context->getJobSystem().wait(decodeCounter);
+}
+
+void AssetLoader::createCommandPool()
+{
+    const VulkanDevice &device = context->getDevice();
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT |
+                     VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex =
+        device.getQueueFamiyIndices().graphicsFamily.value();
+
+    VkResult result =
+        vkCreateCommandPool(device,
+                            &poolInfo,
+                            HostAllocator::get(HostAllocationTag::Commands),
+                            &commandPool);
+    if (result != VK_SUCCESS)
+    {
+        std::string errorMsg("Failed to create asset command pool: ");
+        errorMsg.append(string_VkResult(result));
+        throw std::runtime_error(errorMsg);
+    }
+}
+
+void AssetLoader::load(AssetRequest request)
+{
+    AssetLoad *load = new AssetLoad{this, std::move(request), {}, {}, false};
+    pendingCount.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(ioMutex);
+        ioQueue.push_back(load);
+    }
+    ioCondition.notify_one();
+}
+
+void AssetLoader::ioLoop()
+{
+    if (Profiler::isEnabled())
+        Profiler::setThreadName("asset io");
+
+    while (true)
+    {
+        AssetLoad *load;
+        {
+            std::unique_lock<std::mutex> lock(ioMutex);
+            ioCondition.wait(lock,
+                             [this]() { return stopping || !ioQueue.empty(); });
+            if (stopping)
+                return;
+
+            load = ioQueue.front();
+            ioQueue.pop_front();
+        }
+
+        if (!load->request.path.empty())
+        {
+            PROFILE_ZONE("readAsset");
+            uint64_t begin = Profiler::now();
+            try
+            {
+                load->bytes = readFile(load->request.path);
+            }
+            catch (...)
+            {
+                fail(load);
+                continue;
+            }
+
+            readNs.fetch_add(Profiler::now() - begin,
+                             std::memory_order_relaxed);
+            bytesRead.fetch_add(load->bytes.size(), std::memory_order_relaxed);
+            filesRead.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        context->getJobSystem().schedule(decode, load, 0, 1, &decodeCounter);
+    }
+}
+
+void AssetLoader::decode(void *data, uint32_t, uint32_t)
+{
+    AssetLoad *load = static_cast<AssetLoad *>(data);
+    AssetLoader &loader = *load->loader;
+
+    if (load->request.decode)
+    {
+        PROFILE_ZONE("decodeAsset");
+        uint64_t begin = Profiler::now();
+        try
+        {
+            load->request.decode(load->bytes);
+        }
+        catch (...)
+        {
+            loader.fail(load);
+            return;
+        }
+
+        loader.decodeNs.fetch_add(Profiler::now() - begin,
+                                  std::memory_order_relaxed);
+        loader.decoded.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::lock_guard<std::mutex> lock(loader.uploadMutex);
+    loader.uploadQueue.push_back(load);
+}
+
+void AssetLoader::update()
+{
+    PROFILE_ZONE("AssetLoader::update");
+
+    retireBatches();
+
+    {
+        std::lock_guard<std::mutex> lock(uploadMutex);
+        stagingQueue.insert(
+            stagingQueue.end(), uploadQueue.begin(), uploadQueue.end());
+        uploadQueue.clear();
+    }
+
+    if (!stagingQueue.empty())
+        submitUploads();
+}
+
+void AssetLoader::retireBatches()
+{
+    VkDevice device = context->getDevice();
+    const VulkanDispatch &dispatch = context->getDevice().getDispatch();
+
+    // Batches finish in submission order, the ring relies on it.
+    while (!batches.empty() &&
+           dispatch.vkGetFenceStatus(device, batches.front().fence) ==
+               VK_SUCCESS)
+    {
+        UploadBatch &batch = batches.front();
+        uploadNs.fetch_add(Profiler::now() - batch.submitTime,
+                           std::memory_order_relaxed);
+        stagingRing.release(batch.ringBytes);
+
+        {
+            std::lock_guard<std::mutex> lock(completionMutex);
+            completions.insert(
+                completions.end(), batch.loads.begin(), batch.loads.end());
+        }
+
+        vkResetFences(device, 1, &batch.fence);
+        batch.loads.clear();
+        freeBatches.push_back(batch);
+        batches.pop_front();
+    }
+}
+
+void AssetLoader::submitUploads()
+{
+    VkDevice device = context->getDevice();
+
+    UploadBatch batch;
+    if (freeBatches.empty())
+    {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = commandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+
+        VkResult result =
+            vkAllocateCommandBuffers(device, &allocInfo, &batch.commandBuffer);
+        if (result != VK_SUCCESS)
+        {
+            std::string errorMsg("Failed to allocate upload command buffer: ");
+            errorMsg.append(string_VkResult(result));
+            throw std::runtime_error(errorMsg);
+        }
+
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        result = vkCreateFence(
+            device,
+            &fenceInfo,
+            HostAllocator::get(HostAllocationTag::Synchronization),
+            &batch.fence);
+        if (result != VK_SUCCESS)
+        {
+            std::string errorMsg("Failed to create upload fence: ");
+            errorMsg.append(string_VkResult(result));
+            throw std::runtime_error(errorMsg);
+        }
+    }
+    else
+    {
+        batch = freeBatches.back();
+        freeBatches.pop_back();
+    }
+    batch.ringBytes = 0;
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkResetCommandBuffer(batch.commandBuffer, 0);
+    vkBeginCommandBuffer(batch.commandBuffer, &beginInfo);
+
+    // In order: an asset that does not fit waits for earlier batches to
+    // retire, and everything behind it waits too.
+    while (!stagingQueue.empty())
+    {
+        AssetLoad *load = stagingQueue.front();
+        if (!load->prepared)
+        {
+            if (load->request.prepareUpload)
+                load->request.prepareUpload(load->uploads);
+            load->prepared = true;
+        }
+
+        VkDeviceSize loadSize = 0;
+        for (const AssetUpload &upload : load->uploads)
+            loadSize += StagingRing::align(upload.size);
+
+        VkDeviceSize usedBefore = stagingRing.getUsed();
+        VkDeviceSize offset;
+        if (loadSize > 0 && !stagingRing.allocate(loadSize, offset))
+            break;
+
+        for (const AssetUpload &upload : load->uploads)
+        {
+            memcpy(
+                stagingRing.getMapped() + offset, upload.bytes, upload.size);
+
+            VkBufferCopy copyRegion{};
+            copyRegion.srcOffset = offset;
+            copyRegion.dstOffset = upload.dstOffset;
+            copyRegion.size = upload.size;
+            vkCmdCopyBuffer(batch.commandBuffer,
+                            stagingRing.getBuffer(),
+                            upload.dstBuffer,
+                            1,
+                            &copyRegion);
+
+            offset += StagingRing::align(upload.size);
+            bytesUploaded.fetch_add(upload.size, std::memory_order_relaxed);
+            uploads.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        batch.ringBytes += stagingRing.getUsed() - usedBefore;
+        batch.loads.push_back(load);
+        stagingQueue.pop_front();
+    }
+
+    // Later submissions read the copies as vertex and index data.
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+                            VK_ACCESS_INDEX_READ_BIT |
+                            VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(batch.commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                             VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                         0,
+                         1,
+                         &barrier,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr);
+
+    vkEndCommandBuffer(batch.commandBuffer);
+
+    if (batch.loads.empty())
+    {
+        freeBatches.push_back(batch);
+        return;
+    }
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &batch.commandBuffer;
+
+    VkResult result = vkQueueSubmit(context->getDevice().getGraphicsQueue(),
+                                    1,
+                                    &submitInfo,
+                                    batch.fence);
+    if (result != VK_SUCCESS)
+    {
+        std::string errorMsg("Failed to submit asset uploads: ");
+        errorMsg.append(string_VkResult(result));
+        throw std::runtime_error(errorMsg);
+    }
+
+    batch.submitTime = Profiler::now();
+    batches.push_back(batch);
+}
+
+void AssetLoader::fail(AssetLoad *load)
+{
+    {
+        std::lock_guard<std::mutex> lock(completionMutex);
+        if (!error)
+            error = std::current_exception();
+    }
+
+    delete load;
+    pendingCount.fetch_sub(1, std::memory_order_release);
+}
+
+void AssetLoader::dispatchCompletions()
+{
+    std::vector<AssetLoad *> finished;
+    std::exception_ptr finishedError;
+    {
+        std::lock_guard<std::mutex> lock(completionMutex);
+        finished.swap(completions);
+        std::swap(finishedError, error);
+    }
+
+    for (AssetLoad *load : finished)
+    {
+        if (load->request.onLoaded)
+            load->request.onLoaded();
+        delete load;
+
+        completed.fetch_add(1, std::memory_order_relaxed);
+        pendingCount.fetch_sub(1, std::memory_order_release);
+    }
+
+    if (finishedError)
+        std::rethrow_exception(finishedError);
+}
+
+AssetLoaderStats AssetLoader::getStats() const
+{
+    AssetLoaderStats stats;
+    stats.filesRead = filesRead.load(std::memory_order_relaxed);
+    stats.bytesRead = bytesRead.load(std::memory_order_relaxed);
+    stats.readNs = readNs.load(std::memory_order_relaxed);
+    stats.decoded = decoded.load(std::memory_order_relaxed);
+    stats.decodeNs = decodeNs.load(std::memory_order_relaxed);
+    stats.uploads = uploads.load(std::memory_order_relaxed);
+    stats.bytesUploaded = bytesUploaded.load(std::memory_order_relaxed);
+    stats.uploadNs = uploadNs.load(std::memory_order_relaxed);
+    stats.completed = completed.load(std::memory_order_relaxed);
+    return stats;
+}
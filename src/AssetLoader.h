@@ -0,0 +1,140 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "JobSystem.h"
+#include "StagingRing.h"
+#include "VulkanTypes.h"
+
+// One copy from the staging ring into a buffer the asset owns.
+struct AssetUpload
+{
+    const void *bytes;
+    VkDeviceSize size;
+    VkBuffer dstBuffer;
+    VkDeviceSize dstOffset;
+};
+
+// Every stage is optional. The callbacks run on, in order: an I/O thread
+// reading path, a job system worker (decode), the render thread (upload)
+// and whichever thread calls dispatchCompletions (onLoaded).
+struct AssetRequest
+{
+    std::string path;
+    std::function<void(std::vector<char> &bytes)> decode;
+    // Creates the GPU resources and lists what to copy into them. The bytes
+    // must stay alive until onLoaded.
+    std::function<void(std::vector<AssetUpload> &uploads)> prepareUpload;
+    std::function<void()> onLoaded;
+};
+
+// Plain copy of the loader's counters. Times are the summed busy time of
+// each stage, so bytes over time is the stage's throughput.
+struct AssetLoaderStats
+{
+    uint64_t filesRead;
+    uint64_t bytesRead;
+    uint64_t readNs;
+    uint64_t decoded;
+    uint64_t decodeNs;
+    uint64_t uploads;
+    uint64_t bytesUploaded;
+    uint64_t uploadNs;
+    uint64_t completed;
+};
+
+struct AssetLoad;
+
+// Copies submitted together, retired together once their fence signals.
+struct UploadBatch
+{
+    VkCommandBuffer commandBuffer;
+    VkFence fence;
+    VkDeviceSize ringBytes;
+    uint64_t submitTime;
+    std::vector<AssetLoad *> loads;
+};
+
+class AssetLoader
+{
+  public:
+    AssetLoader(VulkanContext *context);
+    ~AssetLoader();
+    void init();
+    void load(AssetRequest request);
+    // Render thread, once per frame. Never waits on the GPU.
+    void update();
+    // Runs onLoaded for every finished asset and rethrows the first error
+    // any stage raised.
+    void dispatchCompletions();
+    // Stops reading and decoding, so the assets can be destroyed. Whatever
+    // was not loaded yet never will be.
+    void shutdown();
+
+  private:
+    void createCommandPool();
+    void ioLoop();
+    static void decode(void *data, uint32_t, uint32_t);
+    void retireBatches();
+    void submitUploads();
+    void fail(AssetLoad *load);
+
+  public:
+    // Requests not yet handed to dispatchCompletions.
+    uint32_t getPendingCount() const
+    {
+        return pendingCount.load(std::memory_order_acquire);
+    }
+    AssetLoaderStats getStats() const;
+
+  private:
+    VulkanContext *context;
+
+    std::vector<std::thread> ioThreads;
+    std::mutex ioMutex;
+    std::condition_variable ioCondition;
+    std::deque<AssetLoad *> ioQueue;
+    bool stopping;
+
+    JobCounter decodeCounter;
+
+    // Decoded, waiting for the render thread.
+    std::mutex uploadMutex;
+    std::vector<AssetLoad *> uploadQueue;
+    // Only touched by the render thread.
+    std::deque<AssetLoad *> stagingQueue;
+
+    VkCommandPool commandPool;
+    std::deque<UploadBatch> batches;
+    std::vector<UploadBatch> freeBatches;
+
+    // Released in submission order, as the batches retire.
+    StagingRing stagingRing;
+
+    std::mutex completionMutex;
+    std::vector<AssetLoad *> completions;
+    std::exception_ptr error;
+
+    std::atomic<uint32_t> pendingCount;
+    std::atomic<uint64_t> filesRead;
+    std::atomic<uint64_t> bytesRead;
+    std::atomic<uint64_t> readNs;
+    std::atomic<uint64_t> decoded;
+    std::atomic<uint64_t> decodeNs;
+    std::atomic<uint64_t> uploads;
+    std::atomic<uint64_t> bytesUploaded;
+    std::atomic<uint64_t> uploadNs;
+    std::atomic<uint64_t> completed;
+};
+
+#endif // ASSET_LOADER_H
@@ -0,0 +1,73 @@
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Camera.h"
+
+Camera::Camera()
+    : position(2.0f, 2.0f, 2.0f),
+      target(0.0f, 0.0f, 0.0f),
+      up(0.0f, 0.0f, 1.0f),
+      fovY(glm::radians(45.0f)),
+      aspect(1.0f),
+      nearPlane(0.1f),
+      farPlane(10.0f),
+      dirty(true)
+{
+}
+
+void Camera::lookAt(const glm::vec3 &position,
+                    const glm::vec3 &target,
+                    const glm::vec3 &up)
+{
+    this->position = position;
+    this->target = target;
+    this->up = up;
+    dirty = true;
+}
+
+void Camera::setPerspective(float fovY, float nearPlane, float farPlane)
+{
+    this->fovY = fovY;
+    this->nearPlane = nearPlane;
+    this->farPlane = farPlane;
+    dirty = true;
+}
+
+void Camera::setAspect(float aspect)
+{
+    if (aspect == this->aspect)
+        return;
+
+    this->aspect = aspect;
+    dirty = true;
+}
+
+void Camera::update() const
+{
+    if (!dirty)
+        return;
+
+    view = glm::lookAt(position, target, up);
+    projection = glm::perspective(fovY, aspect, nearPlane, farPlane);
+    // Vulkan's clip space Y points down.
+    projection[1][1] *= -1;
+    viewProjection = projection * view;
+    dirty = false;
+}
+
+const glm::mat4 &Camera::getView() const
+{
+    update();
+    return view;
+}
+
+const glm::mat4 &Camera::getProjection() const
+{
+    update();
+    return projection;
+}
+
+const glm::mat4 &Camera::getViewProjection() const
+{
+    update();
+    return viewProjection;
+}
@@ -0,0 +1,48 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <glm/glm.hpp>
+
+// Perspective camera whose view projection is only rebuilt after one of its
+// parameters changed.
+class Camera
+{
+  public:
+    Camera();
+    void lookAt(const glm::vec3 &position,
+                const glm::vec3 &target,
+                const glm::vec3 &up);
+    void setPerspective(float fovY, float nearPlane, float farPlane);
+    // Cheap when the aspect did not change, call it every frame.
+    void setAspect(float aspect);
+
+  private:
+    void update() const;
+
+  public:
+    const glm::vec3 &getPosition() const { return position; }
+    const glm::vec3 &getTarget() const { return target; }
+    const glm::vec3 &getUp() const { return up; }
+    float getFovY() const { return fovY; }
+    float getNearPlane() const { return nearPlane; }
+    float getFarPlane() const { return farPlane; }
+    const glm::mat4 &getView() const;
+    const glm::mat4 &getProjection() const;
+    const glm::mat4 &getViewProjection() const;
+
+  private:
+    glm::vec3 position;
+    glm::vec3 target;
+    glm::vec3 up;
+    float fovY;
+    float aspect;
+    float nearPlane;
+    float farPlane;
+
+    mutable bool dirty;
+    mutable glm::mat4 view;
+    mutable glm::mat4 projection;
+    mutable glm::mat4 viewProjection;
+};
+
+#endif // CAMERA_H
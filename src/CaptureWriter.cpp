@@ -0,0 +1,421 @@
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <stdexcept>
+
+#include "Profiler.h"
+
+#include "CaptureWriter.h"
+
+// Largest payload of an uncompressed deflate block.
+static const size_t DEFLATE_STORED_BLOCK_SIZE = 65535;
+
+static bool hasExtension(const std::string &path, const char *extension)
+{
+    size_t length = std::char_traits<char>::length(extension);
+    return path.size() >= length &&
+           path.compare(path.size() - length, length, extension) == 0;
+}
+
+CaptureFormat getCaptureFormat(const std::string &path)
+{
+    if (hasExtension(path, ".y4m"))
+        return CaptureFormat::Y4m;
+    if (hasExtension(path, ".png"))
+        return CaptureFormat::Png;
+    return CaptureFormat::Rgba;
+}
+
+static const std::array<uint32_t, 256> &getCrcTable()
+{
+    static const std::array<uint32_t, 256> table = []() {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++)
+                crc = crc & 1 ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+            table[i] = crc;
+        }
+        return table;
+    }();
+    return table;
+}
+
+// PNG chunk CRC, over the chunk type and data.
+static uint32_t crc32(const uint8_t *bytes, size_t size)
+{
+    const std::array<uint32_t, 256> &table = getCrcTable();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++)
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+static uint32_t adler32(const uint8_t *bytes, size_t size)
+{
+    uint32_t a = 1;
+    uint32_t b = 0;
+    while (size > 0)
+    {
+        // Largest run that can't overflow b before the modulo.
+        size_t run = std::min<size_t>(size, 5552);
+        for (size_t i = 0; i < run; i++)
+        {
+            a += bytes[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        bytes += run;
+        size -= run;
+    }
+    return (b << 16) | a;
+}
+
+static uint8_t *putBigEndian(uint8_t *out, uint32_t value)
+{
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+    return out + 4;
+}
+
+CaptureWriter::CaptureWriter(const std::string &path,
+                             uint32_t queueCapacity,
+                             uint32_t frameRate,
+                             std::function<void(uint32_t slot)> release)
+    : path(path),
+      format(getCaptureFormat(path)),
+      frameRate(frameRate),
+      release(std::move(release)),
+      stream(nullptr),
+      streamWidth(0),
+      streamHeight(0),
+      failed(false),
+      queue(queueCapacity),
+      queueHead(0),
+      queueCount(0),
+      stopping(false),
+      writtenCount(0),
+      skippedCount(0),
+      bytesWritten(0)
+{
+    if (format != CaptureFormat::Png)
+    {
+        stream = std::fopen(path.c_str(), "wb");
+        if (!stream)
+            throw std::runtime_error("Failed to open capture file " + path);
+    }
+
+    thread = std::thread(&CaptureWriter::writeLoop, this);
+}
+
+CaptureWriter::~CaptureWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_one();
+    thread.join();
+
+    if (stream)
+        std::fclose(stream);
+}
+
+void CaptureWriter::submit(const CapturedFrame &frame)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint32_t capacity = static_cast<uint32_t>(queue.size());
+        queue[(queueHead + queueCount) % capacity] = frame;
+        queueCount++;
+    }
+    condition.notify_one();
+}
+
+void CaptureWriter::writeLoop()
+{
+    if (Profiler::isEnabled())
+        Profiler::setThreadName("capture");
+
+    while (true)
+    {
+        CapturedFrame frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return stopping || queueCount; });
+            // Drains the queue before stopping.
+            if (queueCount == 0)
+                return;
+
+            frame = queue[queueHead];
+            queueHead = (queueHead + 1) % static_cast<uint32_t>(queue.size());
+            queueCount--;
+        }
+
+        if (write(frame))
+            writtenCount++;
+        else
+            skippedCount++;
+        release(frame.slot);
+    }
+}
+
+bool CaptureWriter::write(const CapturedFrame &frame)
+{
+    PROFILE_ZONE("CaptureWriter::write");
+
+    if (failed)
+        return false;
+
+    if (format != CaptureFormat::Png)
+    {
+        if (streamWidth == 0)
+        {
+            streamWidth = frame.width;
+            streamHeight = frame.height;
+        }
+        else if (frame.width != streamWidth || frame.height != streamHeight)
+        {
+            return false;
+        }
+    }
+
+    bool written = false;
+    switch (format)
+    {
+    case CaptureFormat::Y4m:
+        written = writeY4m(frame);
+        break;
+    case CaptureFormat::Rgba:
+        written = writeRgba(frame);
+        break;
+    case CaptureFormat::Png:
+        written = writePng(frame);
+        break;
+    }
+
+    // A full disk won't get better, stop trying.
+    if (!written && format != CaptureFormat::Png)
+    {
+        std::cerr << "Failed to write to " << path
+                  << ", capture stopped" << std::endl;
+        failed = true;
+    }
+    return written;
+}
+
+bool CaptureWriter::writeY4m(const CapturedFrame &frame)
+{
+    if (writtenCount == 0)
+    {
+        char header[128];
+        int length = std::snprintf(header,
+                                   sizeof(header),
+                                   "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg\n",
+                                   frame.width,
+                                   frame.height,
+                                   frameRate);
+        if (!writeBytes(stream, reinterpret_cast<uint8_t *>(header), length))
+            return false;
+    }
+
+    uint32_t width = frame.width;
+    uint32_t height = frame.height;
+    uint32_t chromaWidth = (width + 1) / 2;
+    uint32_t chromaHeight = (height + 1) / 2;
+    size_t lumaSize = size_t(width) * height;
+    size_t chromaSize = size_t(chromaWidth) * chromaHeight;
+    if (scratch.size() < lumaSize + 2 * chromaSize)
+        scratch.resize(lumaSize + 2 * chromaSize);
+
+    uint8_t *lumaPlane = scratch.data();
+    uint8_t *cbPlane = lumaPlane + lumaSize;
+    uint8_t *crPlane = cbPlane + chromaSize;
+    int red = frame.bgra ? 2 : 0;
+    int blue = frame.bgra ? 0 : 2;
+
+    // Limited range BT.601 in 8 bit fixed point.
+    for (uint32_t y = 0; y < height; y++)
+    {
+        const uint8_t *row = frame.pixels + size_t(y) * width * 4;
+        uint8_t *luma = lumaPlane + size_t(y) * width;
+        for (uint32_t x = 0; x < width; x++)
+        {
+            const uint8_t *pixel = row + x * 4;
+            int r = pixel[red];
+            int g = pixel[1];
+            int b = pixel[blue];
+            luma[x] =
+                static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) +
+                                     16);
+        }
+    }
+
+    // Chroma from the average of each 2x2 block, centered as 420jpeg
+    // expects.
+    for (uint32_t cy = 0; cy < chromaHeight; cy++)
+    {
+        for (uint32_t cx = 0; cx < chromaWidth; cx++)
+        {
+            int r = 0;
+            int g = 0;
+            int b = 0;
+            int count = 0;
+            for (uint32_t y = cy * 2; y < std::min(cy * 2 + 2, height); y++)
+            {
+                for (uint32_t x = cx * 2; x < std::min(cx * 2 + 2, width);
+                     x++)
+                {
+                    const uint8_t *pixel =
+                        frame.pixels + (size_t(y) * width + x) * 4;
+                    r += pixel[red];
+                    g += pixel[1];
+                    b += pixel[blue];
+                    count++;
+                }
+            }
+            r /= count;
+            g /= count;
+            b /= count;
+
+            size_t index = size_t(cy) * chromaWidth + cx;
+            cbPlane[index] = static_cast<uint8_t>(
+                ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            crPlane[index] = static_cast<uint8_t>(
+                ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+
+    static const char frameHeader[] = "FRAME\n";
+    return writeBytes(stream,
+                      reinterpret_cast<const uint8_t *>(frameHeader),
+                      sizeof(frameHeader) - 1) &&
+           writeBytes(stream, scratch.data(), lumaSize + 2 * chromaSize);
+}
+
+bool CaptureWriter::writeRgba(const CapturedFrame &frame)
+{
+    size_t size = size_t(frame.width) * frame.height * 4;
+    if (!frame.bgra)
+        return writeBytes(stream, frame.pixels, size);
+
+    if (scratch.size() < size)
+        scratch.resize(size);
+    for (size_t i = 0; i < size; i += 4)
+    {
+        scratch[i] = frame.pixels[i + 2];
+        scratch[i + 1] = frame.pixels[i + 1];
+        scratch[i + 2] = frame.pixels[i];
+        scratch[i + 3] = frame.pixels[i + 3];
+    }
+    return writeBytes(stream, scratch.data(), size);
+}
+
+// Stored deflate blocks: larger files than zlib would make, but cheap
+// enough to keep up with the frame rate and needs no dependency.
+bool CaptureWriter::writePng(const CapturedFrame &frame)
+{
+    uint32_t width = frame.width;
+    uint32_t height = frame.height;
+    size_t rowSize = 1 + size_t(width) * 4;
+    size_t rawSize = rowSize * height;
+    size_t blockCount =
+        (rawSize + DEFLATE_STORED_BLOCK_SIZE - 1) / DEFLATE_STORED_BLOCK_SIZE;
+    blockCount = std::max<size_t>(blockCount, 1);
+    // zlib header, a 5 byte header per block and the Adler-32.
+    size_t idatSize = 2 + rawSize + 5 * blockCount + 4;
+
+    // Signature, IHDR, IDAT and IEND, every chunk with 12 bytes around it.
+    size_t fileSize = 8 + (12 + 13) + (12 + idatSize) + 12;
+    // The filtered scanlines go after the file, deflate copies them over.
+    if (scratch.size() < fileSize + rawSize)
+        scratch.resize(fileSize + rawSize);
+
+    uint8_t *raw = scratch.data() + fileSize;
+    int red = frame.bgra ? 2 : 0;
+    int blue = frame.bgra ? 0 : 2;
+    for (uint32_t y = 0; y < height; y++)
+    {
+        uint8_t *row = raw + y * rowSize;
+        const uint8_t *source = frame.pixels + size_t(y) * width * 4;
+        // Filter type none.
+        row[0] = 0;
+        for (uint32_t x = 0; x < width; x++)
+        {
+            row[1 + x * 4] = source[x * 4 + red];
+            row[2 + x * 4] = source[x * 4 + 1];
+            row[3 + x * 4] = source[x * 4 + blue];
+            row[4 + x * 4] = source[x * 4 + 3];
+        }
+    }
+
+    static const uint8_t signature[] = {
+        0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    uint8_t *out = std::copy(signature, signature + 8, scratch.data());
+
+    uint8_t *chunk = out;
+    out = putBigEndian(out, 13);
+    out = std::copy_n("IHDR", 4, out);
+    out = putBigEndian(out, width);
+    out = putBigEndian(out, height);
+    // 8 bit RGBA, deflate, no filtering method, no interlace.
+    const uint8_t ihdr[] = {8, 6, 0, 0, 0};
+    out = std::copy(ihdr, ihdr + 5, out);
+    out = putBigEndian(out, crc32(chunk + 4, out - chunk - 4));
+
+    chunk = out;
+    out = putBigEndian(out, static_cast<uint32_t>(idatSize));
+    out = std::copy_n("IDAT", 4, out);
+    // Deflate, 32K window, fastest, header check bits.
+    *out++ = 0x78;
+    *out++ = 0x01;
+    for (size_t offset = 0, block = 0; block < blockCount; block++)
+    {
+        size_t size = std::min(DEFLATE_STORED_BLOCK_SIZE, rawSize - offset);
+        *out++ = block + 1 == blockCount ? 1 : 0;
+        *out++ = static_cast<uint8_t>(size);
+        *out++ = static_cast<uint8_t>(size >> 8);
+        *out++ = static_cast<uint8_t>(~size);
+        *out++ = static_cast<uint8_t>(~size >> 8);
+        out = std::copy(raw + offset, raw + offset + size, out);
+        offset += size;
+    }
+    out = putBigEndian(out, adler32(raw, rawSize));
+    out = putBigEndian(out, crc32(chunk + 4, out - chunk - 4));
+
+    chunk = out;
+    out = putBigEndian(out, 0);
+    out = std::copy_n("IEND", 4, out);
+    out = putBigEndian(out, crc32(chunk + 4, 4));
+
+    // path.png becomes path_000042.png.
+    char framePath[4096];
+    std::snprintf(framePath,
+                  sizeof(framePath),
+                  "%.*s_%06llu.png",
+                  static_cast<int>(path.size() - 4),
+                  path.c_str(),
+                  static_cast<unsigned long long>(frame.number));
+    std::FILE *file = std::fopen(framePath, "wb");
+    if (!file)
+    {
+        std::cerr << "Failed to open " << framePath << std::endl;
+        return false;
+    }
+    bool written = writeBytes(file, scratch.data(), fileSize);
+    return std::fclose(file) == 0 && written;
+}
+
+bool CaptureWriter::writeBytes(std::FILE *out,
+                               const uint8_t *bytes,
+                               size_t size)
+{
+    if (std::fwrite(bytes, 1, size, out) != size)
+        return false;
+    bytesWritten += size;
+    return true;
+}
@@ -0,0 +1,103 @@
+#ifndef CAPTURE_WRITER_H
+#define CAPTURE_WRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class CaptureFormat
+{
+    // YUV4MPEG2 stream, BT.601 4:2:0, readable by ffmpeg and most players.
+    Y4m,
+    // 8 bit RGBA rows back to back, no header.
+    Rgba,
+    // One uncompressed PNG per frame, numbered after the path.
+    Png,
+};
+
+// From the extension: .y4m, .png, anything else is raw RGBA.
+CaptureFormat getCaptureFormat(const std::string &path);
+
+// Tightly packed 8 bit pixels the writer borrows until it releases the slot.
+struct CapturedFrame
+{
+    const uint8_t *pixels;
+    uint32_t width;
+    uint32_t height;
+    // Most swap chains are BGRA, the writer swizzles.
+    bool bgra;
+    uint64_t number;
+    uint32_t slot;
+};
+
+// Writes captured frames on its own thread, so disk I/O never stalls the
+// render thread. The caller owns the pixel memory: release is called with
+// the frame's slot once it was written. Y4M and raw streams keep the size
+// of their first frame; frames of another size are skipped.
+class CaptureWriter
+{
+  public:
+    CaptureWriter(const std::string &path,
+                  uint32_t queueCapacity,
+                  uint32_t frameRate,
+                  std::function<void(uint32_t slot)> release);
+    // Writes everything still queued.
+    ~CaptureWriter();
+    CaptureWriter(const CaptureWriter &) = delete;
+    CaptureWriter &operator=(const CaptureWriter &) = delete;
+
+    // Never blocks on I/O or allocates. At most queueCapacity frames may
+    // be queued, the caller's slots bound that.
+    void submit(const CapturedFrame &frame);
+
+  private:
+    void writeLoop();
+    bool write(const CapturedFrame &frame);
+    bool writeY4m(const CapturedFrame &frame);
+    bool writeRgba(const CapturedFrame &frame);
+    bool writePng(const CapturedFrame &frame);
+    bool writeBytes(std::FILE *out, const uint8_t *bytes, size_t size);
+
+  public:
+    CaptureFormat getFormat() const { return format; }
+    uint64_t getWrittenCount() const { return writtenCount.load(); }
+    uint64_t getSkippedCount() const { return skippedCount.load(); }
+    uint64_t getBytesWritten() const { return bytesWritten.load(); }
+
+  private:
+    std::string path;
+    CaptureFormat format;
+    uint32_t frameRate;
+    std::function<void(uint32_t slot)> release;
+
+    // The Y4M or raw stream. C stdio keeps the writes off operator new,
+    // which the allocation benchmark counts on every thread.
+    std::FILE *stream;
+    uint32_t streamWidth;
+    uint32_t streamHeight;
+    bool failed;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable condition;
+    // Fixed size ring, so submitting never allocates.
+    std::vector<CapturedFrame> queue;
+    uint32_t queueHead;
+    uint32_t queueCount;
+    bool stopping;
+
+    // Converted pixels, grown to the largest frame and reused.
+    std::vector<uint8_t> scratch;
+
+    std::atomic<uint64_t> writtenCount;
+    std::atomic<uint64_t> skippedCount;
+    std::atomic<uint64_t> bytesWritten;
+};
+
+#endif // CAPTURE_WRITER_H
@@ -0,0 +1,327 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+#include "Camera.h"
+#include "FrameArena.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "Scene.h"
+
+#include "DrawList.h"
+
+static const uint32_t RADIX_BITS = 8;
+static const uint32_t RADIX_SIZE = 1 << RADIX_BITS;
+static const uint32_t RADIX_PASSES = 64 / RADIX_BITS;
+
+// Entities each job keys or sorts. Chunks keep their place in the list, so
+// its order doesn't depend on how jobs get scheduled.
+static const uint32_t DRAW_LIST_CHUNK_SIZE = 4096;
+// Below this a single thread sorts faster than jobs can be handed out.
+static const uint32_t PARALLEL_SORT_MIN_COUNT = 4 * DRAW_LIST_CHUNK_SIZE;
+
+// Left, right, bottom, top, near and far.
+static const uint32_t FRUSTUM_PLANE_COUNT = 6;
+
+static uint32_t getChunkCount(uint32_t count)
+{
+    return (count + DRAW_LIST_CHUNK_SIZE - 1) / DRAW_LIST_CHUNK_SIZE;
+}
+
+static uint64_t packField(uint64_t key, uint32_t value, uint32_t bits)
+{
+    // A truncated field would sort draws with different state together.
+    assert(value <= (uint64_t(1) << bits) - 1);
+    return (key << bits) | value;
+}
+
+uint64_t makeDrawKey(uint32_t pass,
+                     uint32_t pipeline,
+                     uint32_t mesh,
+                     float depth)
+{
+    const float maxDepth = static_cast<float>((1u << DRAW_KEY_DEPTH_BITS) - 1);
+    uint32_t quantizedDepth =
+        static_cast<uint32_t>(std::clamp(depth, 0.0f, 1.0f) * maxDepth);
+
+    uint64_t key = packField(0, pass, DRAW_KEY_PASS_BITS);
+    key = packField(key, pipeline, DRAW_KEY_PIPELINE_BITS);
+    key = packField(key, mesh, DRAW_KEY_MESH_BITS);
+    return packField(key, quantizedDepth, DRAW_KEY_DEPTH_BITS);
+}
+
+// Planes of the frustum a view projection clips to, facing inwards and
+// normalized, so dot(plane.xyz, point) + plane.w is the distance to them
+// (Gribb and Hartmann). Each is the last row of the matrix plus or minus
+// another one; glm maps depth to [-1, 1], so near is row 3 plus row 2 too.
+static void getFrustumPlanes(const glm::mat4 &viewProjection,
+                             glm::vec4 *planes)
+{
+    const glm::mat4 &m = viewProjection;
+    for (int row = 0; row < 3; row++)
+    {
+        for (int side = 0; side < 2; side++)
+        {
+            float sign = side == 0 ? 1.0f : -1.0f;
+            glm::vec4 plane(m[0][3] + sign * m[0][row],
+                            m[1][3] + sign * m[1][row],
+                            m[2][3] + sign * m[2][row],
+                            m[3][3] + sign * m[3][row]);
+            float length = std::sqrt(plane.x * plane.x + plane.y * plane.y +
+                                     plane.z * plane.z);
+            planes[row * 2 + side] = plane * (1.0f / length);
+        }
+    }
+}
+
+// Least significant digit first, stable. The histograms of every digit are
+// counted in a single read of the keys, and a digit all keys share needs no
+// pass, like the high ones while there is a single pass and pipeline. The
+// pointers are swapped with the scratch ones so keys and values end up
+// pointing to the sorted arrays.
+static void radixSort(uint64_t *&keys,
+                      uint32_t *&values,
+                      uint64_t *&scratchKeys,
+                      uint32_t *&scratchValues,
+                      uint32_t count)
+{
+    uint32_t histograms[RADIX_PASSES][RADIX_SIZE] = {};
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint64_t key = keys[i];
+        for (uint32_t pass = 0; pass < RADIX_PASSES; pass++)
+            histograms[pass][(key >> (pass * RADIX_BITS)) & 0xFF]++;
+    }
+
+    for (uint32_t pass = 0; pass < RADIX_PASSES; pass++)
+    {
+        uint32_t *histogram = histograms[pass];
+        uint32_t shift = pass * RADIX_BITS;
+        if (count == 0 || histogram[(keys[0] >> shift) & 0xFF] == count)
+            continue;
+
+        // Counts become the first slot of each digit.
+        uint32_t offset = 0;
+        for (uint32_t digit = 0; digit < RADIX_SIZE; digit++)
+        {
+            uint32_t digitCount = histogram[digit];
+            histogram[digit] = offset;
+            offset += digitCount;
+        }
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t slot = histogram[(keys[i] >> shift) & 0xFF]++;
+            scratchKeys[slot] = keys[i];
+            scratchValues[slot] = values[i];
+        }
+
+        std::swap(keys, scratchKeys);
+        std::swap(values, scratchValues);
+    }
+}
+
+// The same sort with every pass split in chunks: jobs count each chunk's
+// digits, then scatter each chunk after the same digits of the chunks
+// before it, which keeps the sort stable. Digits are counted again every
+// pass, the keys move between chunks.
+static void parallelRadixSort(uint64_t *&keys,
+                              uint32_t *&values,
+                              uint64_t *&scratchKeys,
+                              uint32_t *&scratchValues,
+                              uint32_t count,
+                              FrameArena &frameArena,
+                              JobSystem &jobSystem)
+{
+    uint32_t chunkCount = getChunkCount(count);
+    uint32_t *histograms =
+        frameArena.allocate<uint32_t>(chunkCount * RADIX_SIZE);
+
+    for (uint32_t pass = 0; pass < RADIX_PASSES; pass++)
+    {
+        uint32_t shift = pass * RADIX_BITS;
+
+        jobSystem.parallelFor(
+            chunkCount, 1, [&](uint32_t beginChunk, uint32_t endChunk) {
+                PROFILE_ZONE("DrawList::count");
+
+                for (uint32_t chunk = beginChunk; chunk < endChunk; chunk++)
+                {
+                    uint32_t *histogram = histograms + chunk * RADIX_SIZE;
+                    std::fill(histogram, histogram + RADIX_SIZE, 0);
+
+                    uint32_t begin = chunk * DRAW_LIST_CHUNK_SIZE;
+                    uint32_t end =
+                        std::min(begin + DRAW_LIST_CHUNK_SIZE, count);
+                    for (uint32_t i = begin; i < end; i++)
+                        histogram[(keys[i] >> shift) & 0xFF]++;
+                }
+            });
+
+        // Counts become the first slot of each chunk's digit.
+        bool constant = false;
+        uint32_t offset = 0;
+        for (uint32_t digit = 0; digit < RADIX_SIZE; digit++)
+        {
+            uint32_t digitStart = offset;
+            for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+            {
+                uint32_t &slot = histograms[chunk * RADIX_SIZE + digit];
+                uint32_t chunkDigitCount = slot;
+                slot = offset;
+                offset += chunkDigitCount;
+            }
+            constant |= offset - digitStart == count;
+        }
+        if (constant)
+            continue;
+
+        jobSystem.parallelFor(
+            chunkCount, 1, [&](uint32_t beginChunk, uint32_t endChunk) {
+                PROFILE_ZONE("DrawList::scatter");
+
+                for (uint32_t chunk = beginChunk; chunk < endChunk; chunk++)
+                {
+                    uint32_t *histogram = histograms + chunk * RADIX_SIZE;
+                    uint32_t begin = chunk * DRAW_LIST_CHUNK_SIZE;
+                    uint32_t end =
+                        std::min(begin + DRAW_LIST_CHUNK_SIZE, count);
+                    for (uint32_t i = begin; i < end; i++)
+                    {
+                        uint32_t slot = histogram[(keys[i] >> shift) & 0xFF]++;
+                        scratchKeys[slot] = keys[i];
+                        scratchValues[slot] = values[i];
+                    }
+                }
+            });
+
+        std::swap(keys, scratchKeys);
+        std::swap(values, scratchValues);
+    }
+}
+
+DrawList::DrawList() : keys(nullptr), objects(nullptr), count(0)
+{
+}
+
+void DrawList::build(const Scene &scene,
+                     const Camera &camera,
+                     FrameArena &frameArena,
+                     JobSystem &jobSystem)
+{
+    PROFILE_ZONE("DrawList::build");
+
+    uint32_t objectCount = scene.size();
+    keys = frameArena.allocate<uint64_t>(objectCount);
+    objects = frameArena.allocate<uint32_t>(objectCount);
+    uint64_t *scratchKeys = frameArena.allocate<uint64_t>(objectCount);
+    uint32_t *scratchObjects = frameArena.allocate<uint32_t>(objectCount);
+
+    uint32_t chunkCount = getChunkCount(objectCount);
+    uint32_t *chunkCounts = frameArena.allocate<uint32_t>(chunkCount);
+
+    const TransformSystem &transforms = scene.getTransforms();
+    const float *positionX = transforms.getPositionsX();
+    const float *positionY = transforms.getPositionsY();
+    const float *positionZ = transforms.getPositionsZ();
+    const MeshHandle *meshes = scene.getMeshes();
+    const uint32_t *flags = scene.getFlags();
+    const float *boundingRadii = scene.getBoundingRadii();
+
+    glm::vec4 planes[FRUSTUM_PLANE_COUNT];
+    getFrustumPlanes(camera.getViewProjection(), planes);
+
+    // Distance from the camera is enough to order opaque draws.
+    const glm::vec3 &cameraPosition = camera.getPosition();
+    float inverseFar = 1.0f / camera.getFarPlane();
+
+    // Each chunk keys its visible entities whose bounding sphere touches
+    // the frustum into the start of its own range of the scratch arrays.
+    // One pipeline and one pass for now, their fields stay 0.
+    jobSystem.parallelFor(
+        chunkCount, 1, [&](uint32_t beginChunk, uint32_t endChunk) {
+            PROFILE_ZONE("DrawList::cull");
+
+            for (uint32_t chunk = beginChunk; chunk < endChunk; chunk++)
+            {
+                uint32_t begin = chunk * DRAW_LIST_CHUNK_SIZE;
+                uint32_t end =
+                    std::min(begin + DRAW_LIST_CHUNK_SIZE, objectCount);
+                uint32_t visible = begin;
+                for (uint32_t i = begin; i < end; i++)
+                {
+                    if (!(flags[i] & SCENE_FLAG_VISIBLE))
+                        continue;
+
+                    // Scaled like the radius LODs get picked with.
+                    float radius =
+                        boundingRadii[i] * transforms.getMaxScale(i);
+                    bool outside = false;
+                    for (const glm::vec4 &plane : planes)
+                    {
+                        float distance = plane.x * positionX[i] +
+                                         plane.y * positionY[i] +
+                                         plane.z * positionZ[i] + plane.w;
+                        outside |= distance < -radius;
+                    }
+                    if (outside)
+                        continue;
+
+                    glm::vec3 offset(positionX[i] - cameraPosition.x,
+                                     positionY[i] - cameraPosition.y,
+                                     positionZ[i] - cameraPosition.z);
+                    float depth =
+                        std::sqrt(glm::dot(offset, offset)) * inverseFar;
+                    scratchKeys[visible] = makeDrawKey(DRAW_PASS_OPAQUE,
+                                                       0,
+                                                       meshes[i],
+                                                       depth);
+                    scratchObjects[visible] = i;
+                    visible++;
+                }
+                chunkCounts[chunk] = visible - begin;
+            }
+        });
+
+    // Counts become where each chunk's entities go.
+    count = 0;
+    for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+    {
+        uint32_t visible = chunkCounts[chunk];
+        chunkCounts[chunk] = count;
+        count += visible;
+    }
+
+    jobSystem.parallelFor(
+        chunkCount, 1, [&](uint32_t beginChunk, uint32_t endChunk) {
+            for (uint32_t chunk = beginChunk; chunk < endChunk; chunk++)
+            {
+                uint32_t begin = chunk * DRAW_LIST_CHUNK_SIZE;
+                uint32_t end = chunk + 1 < chunkCount
+                                   ? chunkCounts[chunk + 1]
+                                   : count;
+                uint32_t visible = end - chunkCounts[chunk];
+                std::copy(scratchKeys + begin,
+                          scratchKeys + begin + visible,
+                          keys + chunkCounts[chunk]);
+                std::copy(scratchObjects + begin,
+                          scratchObjects + begin + visible,
+                          objects + chunkCounts[chunk]);
+            }
+        });
+
+    if (count < PARALLEL_SORT_MIN_COUNT)
+    {
+        radixSort(keys, objects, scratchKeys, scratchObjects, count);
+        return;
+    }
+
+    parallelRadixSort(keys,
+                      objects,
+                      scratchKeys,
+                      scratchObjects,
+                      count,
+                      frameArena,
+                      jobSystem);
+}
@@ -0,0 +1,61 @@
+#ifndef DRAW_LIST_H
+#define DRAW_LIST_H
+
+#include <cstdint>
+
+class Camera;
+class FrameArena;
+class JobSystem;
+class Scene;
+
+// Passes draw in this order.
+enum DrawPass : uint32_t
+{
+    DRAW_PASS_OPAQUE = 0,
+};
+
+// Bits of each sort key field, from the most significant one: draws sort
+// by pass, then by the state that costs most to change, then front to
+// back so opaque draws reject what they hide. Materials bind no state of
+// their own yet, so they have no field. The mesh field holds any
+// MeshHandle.
+static const uint32_t DRAW_KEY_PASS_BITS = 4;
+static const uint32_t DRAW_KEY_PIPELINE_BITS = 8;
+static const uint32_t DRAW_KEY_MESH_BITS = 32;
+static const uint32_t DRAW_KEY_DEPTH_BITS = 20;
+
+// pass and pipeline must fit their bits, which is asserted. depth is
+// clamped to [0, 1], 0 the nearest.
+uint64_t makeDrawKey(uint32_t pass,
+                     uint32_t pipeline,
+                     uint32_t mesh,
+                     float depth);
+
+// The visible entities of a scene the camera sees, in draw order, so draws
+// sharing state follow each other and binding it again can be skipped.
+// Built every frame in the frame arena, it never touches the heap.
+class DrawList
+{
+  public:
+    DrawList();
+    // Keys every visible entity whose bounding sphere, scaled by its largest
+    // scale, touches the camera's frustum, and radix sorts the keys, both
+    // split in jobs for large scenes. Equal keys keep the scene's order.
+    void build(const Scene &scene,
+               const Camera &camera,
+               FrameArena &frameArena,
+               JobSystem &jobSystem);
+
+  public:
+    uint32_t size() const { return count; }
+    const uint64_t *getKeys() const { return keys; }
+    // Dense scene indices, in draw order.
+    const uint32_t *getObjects() const { return objects; }
+
+  private:
+    uint64_t *keys;
+    uint32_t *objects;
+    uint32_t count;
+};
+
+#endif // DRAW_LIST_H
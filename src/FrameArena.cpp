@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include "FrameArena.h"
+
+static uintptr_t alignUp(uintptr_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(uintptr_t(alignment) - 1);
+}
+
+FrameArena::FrameArena(size_t capacity)
+    : block(static_cast<uint8_t *>(std::malloc(capacity))),
+      capacity(capacity),
+      offset(0),
+      overflowBytes(0),
+      peak(0),
+      overflowCount(0)
+{
+    if (!block)
+        throw std::bad_alloc();
+}
+
+FrameArena::~FrameArena()
+{
+    for (uint8_t *overflow : overflowBlocks)
+        std::free(overflow);
+    std::free(block);
+}
+
+void FrameArena::reset()
+{
+    peak = std::max(peak, getUsed());
+
+    if (!overflowBlocks.empty())
+    {
+        for (uint8_t *overflow : overflowBlocks)
+            std::free(overflow);
+        overflowBlocks.clear();
+
+        // Room for the whole frame, with some slack for the next one.
+        size_t newCapacity = capacity + overflowBytes;
+        newCapacity += newCapacity / 2;
+        uint8_t *newBlock = static_cast<uint8_t *>(std::malloc(newCapacity));
+        if (newBlock)
+        {
+            std::free(block);
+            block = newBlock;
+            capacity = newCapacity;
+        }
+    }
+
+    offset = 0;
+    overflowBytes = 0;
+}
+
+void *FrameArena::allocate(size_t size, size_t alignment)
+{
+    uintptr_t base = reinterpret_cast<uintptr_t>(block);
+    size_t begin = alignUp(base + offset, alignment) - base;
+    if (begin + size > capacity)
+        return allocateOverflow(size, alignment);
+
+    offset = begin + size;
+    return block + begin;
+}
+
+void *FrameArena::allocateOverflow(size_t size, size_t alignment)
+{
+    // Each overflow gets its own block, only until the next reset.
+    uint8_t *overflow = static_cast<uint8_t *>(std::malloc(size + alignment));
+    if (!overflow)
+        throw std::bad_alloc();
+    overflowBlocks.push_back(overflow);
+    overflowBytes += size + alignment;
+    overflowCount++;
+
+    uintptr_t aligned =
+        alignUp(reinterpret_cast<uintptr_t>(overflow), alignment);
+    return reinterpret_cast<void *>(aligned);
+}
@@ -0,0 +1,56 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+static const size_t FRAME_ARENA_INITIAL_SIZE = 1024 * 1024;
+
+// Bump allocator for CPU data that only lives until the end of a frame.
+// Nothing is freed individually: reset() reclaims everything at once. A
+// frame that runs out of space gets extra blocks, and the next reset()
+// replaces them with a single block large enough for that frame, so a
+// steady state frame never reaches the system allocator. Not thread safe,
+// allocate on the render thread and hand the memory to the jobs.
+class FrameArena
+{
+  public:
+    FrameArena(size_t capacity = FRAME_ARENA_INITIAL_SIZE);
+    ~FrameArena();
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+
+    void reset();
+    void *allocate(size_t size, size_t alignment);
+    // Uninitialized, never destroyed.
+    template <typename T> T *allocate(size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "Frame arena memory is never destroyed");
+        return static_cast<T *>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+  private:
+    void *allocateOverflow(size_t size, size_t alignment);
+
+  public:
+    size_t getCapacity() const { return capacity; }
+    // Bytes used by the current frame, overflow included.
+    size_t getUsed() const { return offset + overflowBytes; }
+    size_t getPeak() const { return peak; }
+    uint64_t getOverflowCount() const { return overflowCount; }
+
+  private:
+    uint8_t *block;
+    size_t capacity;
+    size_t offset;
+
+    std::vector<uint8_t *> overflowBlocks;
+    size_t overflowBytes;
+    size_t peak;
+    uint64_t overflowCount;
+};
+
+#endif // FRAME_ARENA_H
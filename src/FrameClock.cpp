@@ -0,0 +1,57 @@
+#include "Profiler.h"
+
+#include "FrameClock.h"
+
+FrameClock::FrameClock(double fixedStep)
+    : fixedStep(0.0),
+      paused(false),
+      last(0),
+      elapsed(0),
+      steps(0),
+      time(0.0),
+      tickCount(0)
+{
+    setFixedStep(fixedStep);
+}
+
+void FrameClock::setFixedStep(double fixedStep)
+{
+    this->fixedStep = fixedStep > 0.0 ? fixedStep : 0.0;
+    last = 0;
+    elapsed = 0;
+    steps = 0;
+    time = 0.0;
+    tickCount = 0;
+}
+
+void FrameClock::setPaused(bool paused)
+{
+    // Whatever passed while paused, ticked or not, doesn't count.
+    if (this->paused && !paused && tickCount > 0)
+        last = Profiler::now();
+    this->paused = paused;
+}
+
+double FrameClock::tick()
+{
+    if (fixedStep > 0.0)
+    {
+        // Multiplied rather than accumulated, so long runs don't drift.
+        if (tickCount > 0 && !paused)
+            steps++;
+        time = static_cast<double>(steps) * fixedStep;
+    }
+    else
+    {
+        uint64_t now = Profiler::now();
+        if (tickCount == 0)
+            last = now;
+        if (!paused)
+            elapsed += now - last;
+        last = now;
+        time = static_cast<double>(elapsed) / 1e9;
+    }
+
+    tickCount++;
+    return time;
+}
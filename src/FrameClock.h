@@ -0,0 +1,41 @@
+#ifndef FRAME_CLOCK_H
+#define FRAME_CLOCK_H
+
+#include <cstdint>
+
+// The time the simulation animates with. Real time follows the steady
+// clock; fixed time advances by exactly one step per tick, so the same
+// ticks produce the same frames on any machine and at any frame rate.
+class FrameClock
+{
+  public:
+    // A step of 0 follows the steady clock.
+    explicit FrameClock(double fixedStep = 0.0);
+    // Seconds. Starts over from 0.
+    void setFixedStep(double fixedStep);
+    // Paused ticks keep returning the same time, and time picks up where it
+    // stopped once resumed.
+    void setPaused(bool paused);
+    // Moves on to the next simulation step and returns its time.
+    double tick();
+
+  public:
+    bool isFixed() const { return fixedStep > 0.0; }
+    bool isPaused() const { return paused; }
+    // Seconds since the first tick.
+    double getTime() const { return time; }
+    uint64_t getTickCount() const { return tickCount; }
+
+  private:
+    double fixedStep;
+    bool paused;
+    // Nanoseconds of real time, last is set on the first tick.
+    uint64_t last;
+    uint64_t elapsed;
+    // Fixed steps taken by unpaused ticks.
+    uint64_t steps;
+    double time;
+    uint64_t tickCount;
+};
+
+#endif // FRAME_CLOCK_H
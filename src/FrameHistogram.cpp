@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cmath>
+
+#include "FrameHistogram.h"
+
+static uint32_t log2Floor(uint64_t value)
+{
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+#else
+    uint32_t exponent = 0;
+    while (value >>= 1)
+        exponent++;
+    return exponent;
+#endif
+}
+
+FrameHistogram::FrameHistogram() : total(0), max(0)
+{
+    for (std::atomic<uint32_t> &count : counts)
+        count.store(0, std::memory_order_relaxed);
+}
+
+void FrameHistogram::snapshot(HistogramSnapshot &snapshot) const
+{
+    // Counted from the buckets, so percentiles add up whatever raced.
+    snapshot.count = 0;
+    for (uint32_t i = 0; i < BUCKET_COUNT; i++)
+    {
+        snapshot.counts[i] = counts[i].load(std::memory_order_relaxed);
+        snapshot.count += snapshot.counts[i];
+    }
+    snapshot.total = total.load(std::memory_order_relaxed);
+    snapshot.max = max.load(std::memory_order_relaxed);
+}
+
+uint32_t FrameHistogram::getBucket(uint64_t value)
+{
+    // Exact below, one bucket per value.
+    if (value < SUB_BUCKET_COUNT)
+        return static_cast<uint32_t>(value);
+
+    uint32_t exponent = log2Floor(value);
+    if (exponent > MAX_EXPONENT)
+        return BUCKET_COUNT - 1;
+
+    // The bits right below the leading one pick the sub bucket.
+    uint32_t shift = exponent - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKET_COUNT +
+           static_cast<uint32_t>(value >> shift) - SUB_BUCKET_COUNT;
+}
+
+uint64_t FrameHistogram::getBucketValue(uint32_t bucket)
+{
+    if (bucket < SUB_BUCKET_COUNT)
+        return bucket;
+
+    uint32_t shift = bucket / SUB_BUCKET_COUNT - 1;
+    uint64_t lowest = uint64_t(bucket % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT)
+                      << shift;
+    return lowest + (uint64_t(1) << shift) - 1;
+}
+
+void HistogramSnapshot::subtract(const HistogramSnapshot &older)
+{
+    uint32_t highest = 0;
+    for (uint32_t i = 0; i < FrameHistogram::BUCKET_COUNT; i++)
+    {
+        counts[i] -= older.counts[i];
+        if (counts[i] > 0)
+            highest = i;
+    }
+    count -= older.count;
+    total -= older.total;
+    max = count > 0 ? std::min(max, FrameHistogram::getBucketValue(highest))
+                    : 0;
+}
+
+uint64_t HistogramSnapshot::getPercentile(double percentile) const
+{
+    if (count == 0)
+        return 0;
+
+    uint64_t rank = static_cast<uint64_t>(std::ceil(percentile * count));
+    rank = std::clamp<uint64_t>(rank, 1, count);
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < FrameHistogram::BUCKET_COUNT; i++)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+            return std::min(FrameHistogram::getBucketValue(i), max);
+    }
+
+    return max;
+}
@@ -0,0 +1,67 @@
+#ifndef FRAME_HISTOGRAM_H
+#define FRAME_HISTOGRAM_H
+
+#include <atomic>
+#include <cstdint>
+
+struct HistogramSnapshot;
+
+// Log linear buckets in the manner of HdrHistogram: 32 per power of two,
+// so a nanosecond value lands within about 3% of its bucket's bounds and
+// the buckets stay fixed. Recording is a few shifts and relaxed stores: one
+// thread records, any other may snapshot while it does.
+class FrameHistogram
+{
+  public:
+    static const uint32_t SUB_BUCKET_BITS = 5;
+    static const uint32_t SUB_BUCKET_COUNT = 1u << SUB_BUCKET_BITS;
+    // Values from 2^36 ns, about a minute, on share the last bucket.
+    static const uint32_t MAX_EXPONENT = 36;
+    static const uint32_t BUCKET_COUNT =
+        (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKET_COUNT;
+
+    FrameHistogram();
+    FrameHistogram(const FrameHistogram &) = delete;
+    FrameHistogram &operator=(const FrameHistogram &) = delete;
+
+    // Only ever from the same thread, nothing else writes.
+    void record(uint64_t value)
+    {
+        std::atomic<uint32_t> &count = counts[getBucket(value)];
+        count.store(count.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+        total.store(total.load(std::memory_order_relaxed) + value,
+                    std::memory_order_relaxed);
+        if (value > max.load(std::memory_order_relaxed))
+            max.store(value, std::memory_order_relaxed);
+    }
+    // Counts recorded concurrently may or may not be included.
+    void snapshot(HistogramSnapshot &snapshot) const;
+
+    static uint32_t getBucket(uint64_t value);
+    // Highest value the bucket holds.
+    static uint64_t getBucketValue(uint32_t bucket);
+
+  private:
+    std::atomic<uint32_t> counts[BUCKET_COUNT];
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> max;
+};
+
+// Plain copy of a histogram, what percentiles are computed from.
+struct HistogramSnapshot
+{
+    uint32_t counts[FrameHistogram::BUCKET_COUNT];
+    uint64_t count;
+    uint64_t total;
+    uint64_t max;
+
+    // Leaves what was recorded since older was taken. The maximum becomes
+    // the highest non empty bucket's bound.
+    void subtract(const HistogramSnapshot &older);
+    // Nearest rank, percentile in [0, 1]. Reports the highest value of the
+    // bucket, so it never underestimates by more than the bucket width.
+    uint64_t getPercentile(double percentile) const;
+};
+
+#endif // FRAME_HISTOGRAM_H
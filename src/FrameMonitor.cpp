@@ -0,0 +1,289 @@
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define FRAME_MONITOR_SHARED_MEMORY
+#endif
+
+#include "Profiler.h"
+
+#include "FrameMonitor.h"
+
+static const std::chrono::milliseconds EXPORT_INTERVAL(1000);
+// Exports the rolling window spans.
+static const uint32_t WINDOW_EXPORTS = 10;
+// Times the window's median interval a frame must take to count as a
+// stutter.
+static const uint64_t STUTTER_FACTOR = 2;
+
+static const char *frameMetricNames[FRAME_METRIC_COUNT] = {
+    "interval",
+    "cpu",
+    "gpu",
+    "acquireWait",
+    "presentWait",
+};
+
+const char *getFrameMetricName(FrameMetric metric)
+{
+    return frameMetricNames[static_cast<uint32_t>(metric)];
+}
+
+static void summarize(const HistogramSnapshot &snapshot,
+                      FrameMetricSummary &summary)
+{
+    summary.count = snapshot.count;
+    summary.mean = snapshot.count > 0 ? snapshot.total / snapshot.count : 0;
+    summary.p50 = snapshot.getPercentile(0.5);
+    summary.p90 = snapshot.getPercentile(0.9);
+    summary.p99 = snapshot.getPercentile(0.99);
+    summary.p999 = snapshot.getPercentile(0.999);
+    summary.max = snapshot.max;
+}
+
+static double toMilliseconds(uint64_t nanoseconds)
+{
+    return static_cast<double>(nanoseconds) / 1.0e6;
+}
+
+static void writeSummary(std::FILE *out, const FrameMetricSummary &summary)
+{
+    std::fprintf(out,
+                 "{\"samples\": %" PRIu64 ", \"mean\": %.3f, \"p50\": %.3f, "
+                 "\"p90\": %.3f, \"p99\": %.3f, \"p99.9\": %.3f, "
+                 "\"max\": %.3f}",
+                 summary.count,
+                 toMilliseconds(summary.mean),
+                 toMilliseconds(summary.p50),
+                 toMilliseconds(summary.p90),
+                 toMilliseconds(summary.p99),
+                 toMilliseconds(summary.p999),
+                 toMilliseconds(summary.max));
+}
+
+FrameMonitor::FrameMonitor(const std::string &path,
+                           const std::string &sharedMemoryName)
+    : lastPresent(0),
+      frameCount(0),
+      stutterCount(0),
+      stutterThreshold(UINT64_MAX),
+      path(path),
+      temporaryPath(path + ".tmp"),
+      sharedMemoryName(sharedMemoryName),
+      segment(nullptr),
+      stopping(false),
+      windowHead(0)
+{
+    if (!sharedMemoryName.empty())
+        openSegment();
+    if (path.empty() && !segment)
+        return;
+
+    // Empty snapshots, until the window fills up it starts here.
+    windowEntries.resize(WINDOW_EXPORTS + 1);
+    uint64_t now = Profiler::now();
+    for (WindowEntry &entry : windowEntries)
+        entry.time = now;
+
+    thread = std::thread(&FrameMonitor::exportLoop, this);
+}
+
+FrameMonitor::~FrameMonitor()
+{
+    if (thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        condition.notify_one();
+        thread.join();
+    }
+
+#ifdef FRAME_MONITOR_SHARED_MEMORY
+    if (segment)
+    {
+        munmap(segment, sizeof(FrameMonitorSegment));
+        shm_unlink(sharedMemoryName.c_str());
+    }
+#endif
+}
+
+void FrameMonitor::recordPresent(uint64_t time)
+{
+    if (lastPresent != 0)
+    {
+        uint64_t interval = time - lastPresent;
+        record(FrameMetric::Interval, interval);
+        if (interval > stutterThreshold.load(std::memory_order_relaxed))
+        {
+            stutterCount.store(
+                stutterCount.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+        }
+    }
+
+    lastPresent = time;
+    frameCount.store(frameCount.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_relaxed);
+}
+
+void FrameMonitor::skipInterval()
+{
+    lastPresent = 0;
+}
+
+void FrameMonitor::exportLoop()
+{
+    if (Profiler::isEnabled())
+        Profiler::setThreadName("frame monitor");
+
+    FrameRollup rollup{};
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        bool stop = condition.wait_for(
+            lock, EXPORT_INTERVAL, [this]() { return stopping; });
+        lock.unlock();
+
+        PROFILE_ZONE("FrameMonitor::export");
+        computeRollup(rollup);
+        if (!path.empty())
+            writeFile(rollup);
+        if (segment)
+            writeSegment(rollup);
+
+        // One last export covers the frames since the previous one.
+        if (stop)
+            break;
+        lock.lock();
+    }
+}
+
+void FrameMonitor::computeRollup(FrameRollup &rollup)
+{
+    windowHead = (windowHead + 1) % windowEntries.size();
+    WindowEntry &newest = windowEntries[windowHead];
+    const WindowEntry &oldest =
+        windowEntries[(windowHead + 1) % windowEntries.size()];
+
+    for (uint32_t i = 0; i < FRAME_METRIC_COUNT; i++)
+        histograms[i].snapshot(newest.metrics[i]);
+    newest.frameCount = frameCount.load(std::memory_order_relaxed);
+    newest.stutterCount = stutterCount.load(std::memory_order_relaxed);
+    newest.time = Profiler::now();
+
+    rollup.frameCount = newest.frameCount;
+    rollup.stutterCount = newest.stutterCount;
+    rollup.windowDuration = newest.time - oldest.time;
+    rollup.windowStutterCount = newest.stutterCount - oldest.stutterCount;
+
+    for (uint32_t i = 0; i < FRAME_METRIC_COUNT; i++)
+    {
+        summarize(newest.metrics[i], rollup.total[i]);
+
+        scratch = newest.metrics[i];
+        scratch.subtract(oldest.metrics[i]);
+        summarize(scratch, rollup.window[i]);
+    }
+
+    // Against the recent median, so a scene that got heavier for good
+    // stops counting as stuttering after a while.
+    const FrameMetricSummary &intervals =
+        rollup.window[static_cast<uint32_t>(FrameMetric::Interval)];
+    stutterThreshold.store(intervals.count > 0 ? intervals.p50 * STUTTER_FACTOR
+                                               : UINT64_MAX,
+                           std::memory_order_relaxed);
+}
+
+void FrameMonitor::writeFile(const FrameRollup &rollup) const
+{
+    // C stdio, so exporting never goes through operator new.
+    std::FILE *out = std::fopen(temporaryPath.c_str(), "w");
+    if (!out)
+        return;
+
+    std::fprintf(out,
+                 "{\"frames\": %" PRIu64 ", \"stutters\": %" PRIu64
+                 ", \"windowSeconds\": %.3f, \"windowStutters\": %" PRIu64
+                 ", \"metrics\": {",
+                 rollup.frameCount,
+                 rollup.stutterCount,
+                 static_cast<double>(rollup.windowDuration) / 1.0e9,
+                 rollup.windowStutterCount);
+    for (uint32_t i = 0; i < FRAME_METRIC_COUNT; i++)
+    {
+        std::fprintf(out,
+                     "%s\"%s\": {\"total\": ",
+                     i > 0 ? ", " : "",
+                     frameMetricNames[i]);
+        writeSummary(out, rollup.total[i]);
+        std::fprintf(out, ", \"window\": ");
+        writeSummary(out, rollup.window[i]);
+        std::fprintf(out, "}");
+    }
+    std::fprintf(out, "}}\n");
+
+    bool written = !std::ferror(out);
+    if (std::fclose(out) == 0 && written)
+        std::rename(temporaryPath.c_str(), path.c_str());
+}
+
+void FrameMonitor::openSegment()
+{
+#ifdef FRAME_MONITOR_SHARED_MEMORY
+    int fd = shm_open(sharedMemoryName.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0)
+    {
+        std::cerr << "Failed to open shared memory " << sharedMemoryName
+                  << ": " << std::strerror(errno) << std::endl;
+        return;
+    }
+
+    void *mapped = MAP_FAILED;
+    if (ftruncate(fd, sizeof(FrameMonitorSegment)) == 0)
+    {
+        mapped = mmap(nullptr,
+                      sizeof(FrameMonitorSegment),
+                      PROT_READ | PROT_WRITE,
+                      MAP_SHARED,
+                      fd,
+                      0);
+    }
+    close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        std::cerr << "Failed to map shared memory " << sharedMemoryName
+                  << ": " << std::strerror(errno) << std::endl;
+        shm_unlink(sharedMemoryName.c_str());
+        return;
+    }
+
+    segment = new (mapped) FrameMonitorSegment{};
+    segment->version = FrameMonitorSegment::VERSION;
+    segment->sequence.store(0, std::memory_order_relaxed);
+    segment->magic = FrameMonitorSegment::MAGIC;
+#else
+    std::cerr << "Shared memory not supported, frame statistics not "
+                 "exported to "
+              << sharedMemoryName << std::endl;
+#endif
+}
+
+void FrameMonitor::writeSegment(const FrameRollup &rollup)
+{
+    // A seqlock: readers never block the exporter, they retry instead.
+    uint32_t sequence = segment->sequence.load(std::memory_order_relaxed);
+    segment->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    segment->rollup = rollup;
+    segment->sequence.store(sequence + 2, std::memory_order_release);
+}
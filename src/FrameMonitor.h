@@ -0,0 +1,141 @@
+#ifndef FRAME_MONITOR_H
+#define FRAME_MONITOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FrameHistogram.h"
+
+enum class FrameMetric : uint32_t
+{
+    // Between consecutive presents.
+    Interval,
+    // drawFrame's own work on the render thread: without the in flight
+    // fence wait, AcquireWait and PresentWait, so a GPU bound frame shows
+    // up as waits rather than as CPU time.
+    CpuTime,
+    GpuTime,
+    // Blocked in vkAcquireNextImageKHR.
+    AcquireWait,
+    // Blocked in vkQueuePresentKHR.
+    PresentWait,
+};
+
+static const uint32_t FRAME_METRIC_COUNT = 5;
+
+const char *getFrameMetricName(FrameMetric metric);
+
+// Nanoseconds.
+struct FrameMetricSummary
+{
+    uint64_t count;
+    uint64_t mean;
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t p999;
+    uint64_t max;
+};
+
+struct FrameRollup
+{
+    uint64_t frameCount;
+    // Intervals over twice the rolling window's median.
+    uint64_t stutterCount;
+    // The rolling window, the last few seconds.
+    uint64_t windowDuration;
+    uint64_t windowStutterCount;
+    FrameMetricSummary total[FRAME_METRIC_COUNT];
+    FrameMetricSummary window[FRAME_METRIC_COUNT];
+};
+
+// What the shared memory segment holds, for monitors to map read only.
+// sequence is odd while the rollup is written: read it, copy the rollup,
+// then retry unless sequence was even and is unchanged.
+struct FrameMonitorSegment
+{
+    static const uint32_t MAGIC = 0x4E4F4D46; // "FMON"
+    static const uint32_t VERSION = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    std::atomic<uint32_t> sequence;
+    FrameRollup rollup;
+};
+
+// Frame time rollups: one histogram per metric, recorded on the render
+// thread in constant time, and an exporter thread that turns them into
+// percentiles once a second. Only the exporter allocates, formats or
+// touches files, so the render thread never waits on a reader.
+class FrameMonitor
+{
+  public:
+    // Exports to the JSON file at path and the shared memory segment of
+    // that name, either may be empty. With neither nothing is exported.
+    FrameMonitor(const std::string &path, const std::string &sharedMemoryName);
+    // Exports once more, then unlinks the segment.
+    ~FrameMonitor();
+    FrameMonitor(const FrameMonitor &) = delete;
+    FrameMonitor &operator=(const FrameMonitor &) = delete;
+
+    // Render thread only, like everything recording below.
+    void record(FrameMetric metric, uint64_t value)
+    {
+        histograms[static_cast<uint32_t>(metric)].record(value);
+    }
+    // Records the interval since the previous present.
+    void recordPresent(uint64_t time);
+    // The next present starts over, for loops that idle on purpose.
+    void skipInterval();
+
+  private:
+    // A snapshot of every histogram, taken on each export.
+    struct WindowEntry
+    {
+        HistogramSnapshot metrics[FRAME_METRIC_COUNT];
+        uint64_t frameCount;
+        uint64_t stutterCount;
+        uint64_t time;
+    };
+
+    void exportLoop();
+    void computeRollup(FrameRollup &rollup);
+    void writeFile(const FrameRollup &rollup) const;
+    void openSegment();
+    void writeSegment(const FrameRollup &rollup);
+
+  public:
+    bool isExporting() const { return thread.joinable(); }
+
+  private:
+    FrameHistogram histograms[FRAME_METRIC_COUNT];
+    uint64_t lastPresent;
+    std::atomic<uint64_t> frameCount;
+    std::atomic<uint64_t> stutterCount;
+    // Set by the exporter from the window's median interval.
+    std::atomic<uint64_t> stutterThreshold;
+
+    std::string path;
+    // Written first and renamed over path, readers never see half a file.
+    std::string temporaryPath;
+    std::string sharedMemoryName;
+    FrameMonitorSegment *segment;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping;
+
+    // Exporter only. A ring holding the last exports, the entry after the
+    // newest one is where the window starts.
+    std::vector<WindowEntry> windowEntries;
+    uint32_t windowHead;
+    HistogramSnapshot scratch;
+};
+
+#endif // FRAME_MONITOR_H
@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "Profiler.h"
+
+#include "FramePacer.h"
+
+// Nanoseconds. Typical desktop wakeup latency to start with, and bounds
+// that keep one outlier from turning every wait into a spin.
+static const uint64_t INITIAL_SPIN_MARGIN = 1000000;
+static const uint64_t MIN_SPIN_MARGIN = 50000;
+static const uint64_t MAX_SPIN_MARGIN = 4000000;
+
+FramePacer::FramePacer(double maxRate)
+    : period(0), deadline(0), spinMargin(INITIAL_SPIN_MARGIN)
+{
+    setMaxRate(maxRate);
+}
+
+void FramePacer::setMaxRate(double maxRate)
+{
+    period = maxRate > 0.0 ? static_cast<uint64_t>(1e9 / maxRate) : 0;
+    deadline = 0;
+}
+
+void FramePacer::wait()
+{
+    if (period == 0)
+        return;
+
+    uint64_t now = Profiler::now();
+    deadline = std::max(deadline + period, now);
+
+    if (deadline - now > spinMargin)
+    {
+        PROFILE_ZONE("FramePacer::sleep");
+
+        uint64_t wakeup = deadline - spinMargin;
+        std::this_thread::sleep_for(std::chrono::nanoseconds(wakeup - now));
+
+        // Grows at once, since waking up too late misses the deadline, and
+        // shrinks slowly, since waking up too early only costs spinning.
+        uint64_t woke = Profiler::now();
+        uint64_t late = woke > wakeup ? woke - wakeup : 0;
+        if (late + late / 4 > spinMargin)
+            spinMargin = late + late / 4;
+        else
+            spinMargin -= (spinMargin - late) / 16;
+        spinMargin = std::clamp(spinMargin, MIN_SPIN_MARGIN, MAX_SPIN_MARGIN);
+    }
+
+    PROFILE_ZONE("FramePacer::spin");
+    while (Profiler::now() < deadline)
+        std::this_thread::yield();
+}
@@ -0,0 +1,32 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <cstdint>
+
+// Caps how often a loop runs. Sleeping alone wakes up late by the
+// scheduler's latency, often a millisecond or more, and spinning alone
+// burns a core: wait() sleeps until shortly before the deadline and spins
+// the rest. The spin margin follows how late sleeps actually wake up.
+class FramePacer
+{
+  public:
+    // A rate of 0 never waits.
+    explicit FramePacer(double maxRate = 0.0);
+    void setMaxRate(double maxRate);
+    // Blocks until one period after the previous deadline. Late frames
+    // don't wait, and later ones don't catch up on them.
+    void wait();
+
+  public:
+    bool isEnabled() const { return period > 0; }
+    // Nanoseconds.
+    uint64_t getPeriod() const { return period; }
+    uint64_t getSpinMargin() const { return spinMargin; }
+
+  private:
+    uint64_t period;
+    uint64_t deadline;
+    uint64_t spinMargin;
+};
+
+#endif // FRAME_PACER_H
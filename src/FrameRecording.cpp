@@ -0,0 +1,296 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include "Profiler.h"
+#include "utils.h"
+
+#include "FrameRecording.h"
+
+static_assert(sizeof(float) == sizeof(uint32_t), "Columns are 4 byte wide");
+
+// Fewer, larger writes; a frame of a few thousand objects fits.
+static const size_t RECORDER_BUFFER_SIZE = 1 << 20;
+// Frames the render thread may be ahead of the disk.
+static const uint32_t RECORDER_QUEUE_CAPACITY = 16;
+
+FrameRecorder::FrameRecorder(const std::string &path)
+    : path(path),
+      file(std::fopen(path.c_str(), "wb")),
+      failed(false),
+      queue(RECORDER_QUEUE_CAPACITY),
+      queueHead(0),
+      queueCount(0),
+      stopping(false),
+      frameCount(0),
+      stallCount(0)
+{
+    if (!file)
+        throw std::runtime_error("Failed to open recording file " + path);
+    std::setvbuf(file, nullptr, _IOFBF, RECORDER_BUFFER_SIZE);
+
+    FrameRecordingHeader header{};
+    header.magic = FrameRecordingHeader::MAGIC;
+    header.version = FrameRecordingHeader::VERSION;
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1)
+    {
+        std::fclose(file);
+        throw std::runtime_error("Failed to write recording file " + path);
+    }
+
+    thread = std::thread(&FrameRecorder::writeLoop, this);
+}
+
+FrameRecorder::~FrameRecorder()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_one();
+    thread.join();
+
+    std::fclose(file);
+    if (stallCount > 0)
+    {
+        std::cerr << "Recording waited for the disk on " << stallCount
+                  << " frames" << std::endl;
+    }
+}
+
+void FrameRecorder::write(const Scene &scene, const Camera &camera)
+{
+    if (failed.load(std::memory_order_relaxed))
+        return;
+
+    PROFILE_ZONE("FrameRecorder::write");
+
+    // Only this thread queues, so the slot stays free while it is filled.
+    uint32_t capacity = static_cast<uint32_t>(queue.size());
+    std::vector<char> *bytes;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (queueCount == capacity)
+        {
+            PROFILE_ZONE("FrameRecorder::wait");
+            stallCount++;
+            freedCondition.wait(
+                lock, [this, capacity]() { return queueCount < capacity; });
+        }
+        bytes = &queue[(queueHead + queueCount) % capacity];
+    }
+
+    RecordedFrame frame{};
+    frame.objectCount = scene.size();
+    frame.meshCount = scene.getMeshCount();
+    for (int i = 0; i < 3; i++)
+    {
+        frame.cameraPosition[i] = camera.getPosition()[i];
+        frame.cameraTarget[i] = camera.getTarget()[i];
+        frame.cameraUp[i] = camera.getUp()[i];
+    }
+    frame.fovY = camera.getFovY();
+    frame.nearPlane = camera.getNearPlane();
+    frame.farPlane = camera.getFarPlane();
+
+    const TransformSystem &transforms = scene.getTransforms();
+    const void *columns[RECORDED_COLUMN_COUNT] = {
+        scene.getMeshes(),
+        scene.getFlags(),
+        scene.getMaterialKeys(),
+        transforms.getPositionsX(),
+        transforms.getPositionsY(),
+        transforms.getPositionsZ(),
+        transforms.getRotationsX(),
+        transforms.getRotationsY(),
+        transforms.getRotationsZ(),
+        transforms.getRotationsW(),
+        transforms.getScalesX(),
+        transforms.getScalesY(),
+        transforms.getScalesZ(),
+    };
+
+    size_t columnSize = size_t(frame.objectCount) * sizeof(uint32_t);
+    bytes->resize(sizeof(frame) + RECORDED_COLUMN_COUNT * columnSize);
+    char *out = bytes->data();
+    std::memcpy(out, &frame, sizeof(frame));
+    out += sizeof(frame);
+    for (const void *column : columns)
+    {
+        if (columnSize > 0)
+            std::memcpy(out, column, columnSize);
+        out += columnSize;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queueCount++;
+    }
+    condition.notify_one();
+}
+
+void FrameRecorder::writeLoop()
+{
+    if (Profiler::isEnabled())
+        Profiler::setThreadName("recorder");
+
+    while (true)
+    {
+        const std::vector<char> *bytes;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return stopping || queueCount; });
+            // Drains the queue before stopping.
+            if (queueCount == 0)
+                return;
+            bytes = &queue[queueHead];
+        }
+
+        // A full disk won't get better, stop trying.
+        if (!failed.load(std::memory_order_relaxed))
+        {
+            PROFILE_ZONE("FrameRecorder::writeLoop");
+            if (std::fwrite(bytes->data(), 1, bytes->size(), file) ==
+                bytes->size())
+            {
+                frameCount++;
+            }
+            else
+            {
+                std::cerr << "Failed to write to " << path
+                          << ", recording stopped" << std::endl;
+                failed = true;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queueHead = (queueHead + 1) % static_cast<uint32_t>(queue.size());
+            queueCount--;
+        }
+        freedCondition.notify_one();
+    }
+}
+
+FrameRecording::FrameRecording(const std::string &path)
+    : data(readFile(path)), meshCount(0), maxObjectCount(0)
+{
+    FrameRecordingHeader header{};
+    if (data.size() >= sizeof(header))
+        std::memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != FrameRecordingHeader::MAGIC ||
+        header.version != FrameRecordingHeader::VERSION)
+    {
+        throw std::runtime_error(path + " is not a frame recording");
+    }
+
+    size_t offset = sizeof(header);
+    while (data.size() - offset >= sizeof(RecordedFrame))
+    {
+        RecordedFrame frame;
+        std::memcpy(&frame, data.data() + offset, sizeof(frame));
+        size_t columnsSize = size_t(frame.objectCount) *
+                             RECORDED_COLUMN_COUNT * sizeof(uint32_t);
+        if (data.size() - offset - sizeof(frame) < columnsSize)
+            break;
+
+        // Checked once here, so apply() can trust the mesh column.
+        const uint32_t *meshes = reinterpret_cast<const uint32_t *>(
+            data.data() + offset + sizeof(frame));
+        if (std::any_of(meshes,
+                        meshes + frame.objectCount,
+                        [&frame](uint32_t mesh) {
+                            return mesh >= frame.meshCount;
+                        }))
+        {
+            throw std::runtime_error(path + " draws an unregistered mesh");
+        }
+
+        frameOffsets.push_back(offset);
+        meshCount = std::max(meshCount, frame.meshCount);
+        maxObjectCount = std::max(maxObjectCount, frame.objectCount);
+        offset += sizeof(frame) + columnsSize;
+    }
+
+    if (frameOffsets.empty())
+        throw std::runtime_error(path + " has no frames");
+}
+
+void FrameRecording::apply(uint32_t frame, Scene &scene, Camera &camera)
+{
+    PROFILE_ZONE("FrameRecording::apply");
+
+    const char *bytes = data.data() + frameOffsets[frame];
+    RecordedFrame recorded;
+    std::memcpy(&recorded, bytes, sizeof(recorded));
+
+    camera.lookAt(glm::vec3(recorded.cameraPosition[0],
+                            recorded.cameraPosition[1],
+                            recorded.cameraPosition[2]),
+                  glm::vec3(recorded.cameraTarget[0],
+                            recorded.cameraTarget[1],
+                            recorded.cameraTarget[2]),
+                  glm::vec3(recorded.cameraUp[0],
+                            recorded.cameraUp[1],
+                            recorded.cameraUp[2]));
+    camera.setPerspective(recorded.fovY, recorded.nearPlane, recorded.farPlane);
+
+    uint32_t count = recorded.objectCount;
+    const uint32_t *columns =
+        reinterpret_cast<const uint32_t *>(bytes + sizeof(recorded));
+    auto getFloats = [columns, count](uint32_t column) {
+        return reinterpret_cast<const float *>(columns + column * count);
+    };
+    const uint32_t *meshes = columns;
+    const uint32_t *flags = columns + count;
+    const uint32_t *materialKeys = columns + 2 * count;
+    const float *positionX = getFloats(3);
+    const float *positionY = getFloats(4);
+    const float *positionZ = getFloats(5);
+    const float *rotationX = getFloats(6);
+    const float *rotationY = getFloats(7);
+    const float *rotationZ = getFloats(8);
+    const float *rotationW = getFloats(9);
+    const float *scaleX = getFloats(10);
+    const float *scaleY = getFloats(11);
+    const float *scaleZ = getFloats(12);
+
+    bool reshaped = scene.size() != count || handles.size() != count ||
+                    !std::equal(meshes, meshes + count, scene.getMeshes());
+    if (reshaped)
+    {
+        scene.clear();
+        handles.clear();
+        for (uint32_t i = 0; i < count; i++)
+        {
+            handles.push_back(scene.create(
+                meshes[i],
+                glm::vec3(positionX[i], positionY[i], positionZ[i]),
+                glm::quat(
+                    rotationW[i], rotationX[i], rotationY[i], rotationZ[i]),
+                glm::vec3(scaleX[i], scaleY[i], scaleZ[i]),
+                materialKeys[i]));
+        }
+    }
+    else
+    {
+        // Created in order, the dense indices are the recorded ones.
+        TransformSystem &transforms = scene.getTransforms();
+        for (uint32_t i = 0; i < count; i++)
+        {
+            transforms.setPosition(
+                i, glm::vec3(positionX[i], positionY[i], positionZ[i]));
+            transforms.setRotation(i,
+                                   glm::quat(rotationW[i],
+                                             rotationX[i],
+                                             rotationY[i],
+                                             rotationZ[i]));
+            transforms.setScale(i, glm::vec3(scaleX[i], scaleY[i], scaleZ[i]));
+            scene.setMaterialKey(handles[i], materialKeys[i]);
+        }
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+        scene.setFlags(handles[i], flags[i]);
+}
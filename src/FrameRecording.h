@@ -0,0 +1,123 @@
+#ifndef FRAME_RECORDING_H
+#define FRAME_RECORDING_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Camera.h"
+#include "Scene.h"
+
+// A frame recording is what drawFrame was given, frame after frame, in the
+// machine's byte order: a FrameRecordingHeader, then per frame a
+// RecordedFrame followed by its objectCount long columns.
+struct FrameRecordingHeader
+{
+    static const uint32_t MAGIC = 0x52464856; // "VHFR"
+    static const uint32_t VERSION = 1;
+
+    uint32_t magic;
+    uint32_t version;
+};
+
+struct RecordedFrame
+{
+    uint32_t objectCount;
+    // Meshes registered with the scene, the mesh column indexes them.
+    uint32_t meshCount;
+    float cameraPosition[3];
+    float cameraTarget[3];
+    float cameraUp[3];
+    float fovY;
+    float nearPlane;
+    float farPlane;
+};
+
+// Four bytes per object each: mesh, flags and material key, then position
+// x, y, z, rotation x, y, z, w and scale x, y, z.
+static const uint32_t RECORDED_COLUMN_COUNT = 13;
+
+// Appends each drawn frame to a recording, on its own thread like the
+// CaptureWriter: write() only copies the scene's columns into a queued
+// buffer, so disk I/O doesn't stall the render thread. Only when the disk
+// falls a whole queue behind does write() wait, a replay needs every frame.
+class FrameRecorder
+{
+  public:
+    // Truncates path, throws when it can't be opened.
+    explicit FrameRecorder(const std::string &path);
+    // Writes everything still queued.
+    ~FrameRecorder();
+    FrameRecorder(const FrameRecorder &) = delete;
+    FrameRecorder &operator=(const FrameRecorder &) = delete;
+
+    // Blocks only while the queue is full. Allocates only while the scene
+    // grows past the largest frame a queue buffer held.
+    void write(const Scene &scene, const Camera &camera);
+
+  private:
+    void writeLoop();
+
+  public:
+    uint64_t getFrameCount() const { return frameCount.load(); }
+    uint64_t getStallCount() const { return stallCount.load(); }
+
+  private:
+    std::string path;
+    std::FILE *file;
+    // Set by the writer thread once a write failed.
+    std::atomic<bool> failed;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable condition;
+    // Signalled by the writer thread when it freed a buffer.
+    std::condition_variable freedCondition;
+    // Fixed ring of serialized frames, their buffers are reused.
+    std::vector<std::vector<char>> queue;
+    uint32_t queueHead;
+    uint32_t queueCount;
+    bool stopping;
+
+    std::atomic<uint64_t> frameCount;
+    // Frames write() had to wait for the disk on.
+    std::atomic<uint64_t> stallCount;
+};
+
+// A recording loaded whole, so replaying it never waits on the file.
+class FrameRecording
+{
+  public:
+    // Throws when path can't be read or isn't a recording. A frame cut
+    // short, by a crash while recording, is dropped.
+    explicit FrameRecording(const std::string &path);
+
+    // Makes scene and camera what the frame drew. The scene must have
+    // getMeshCount() meshes registered and be changed by apply() alone:
+    // its entities are only recreated when the draw list changed shape,
+    // otherwise their columns are overwritten in place.
+    void apply(uint32_t frame, Scene &scene, Camera &camera);
+
+  public:
+    uint32_t getFrameCount() const
+    {
+        return static_cast<uint32_t>(frameOffsets.size());
+    }
+    uint32_t getMeshCount() const { return meshCount; }
+    uint32_t getMaxObjectCount() const { return maxObjectCount; }
+
+  private:
+    std::vector<char> data;
+    std::vector<size_t> frameOffsets;
+    uint32_t meshCount;
+    uint32_t maxObjectCount;
+    // Of the entities apply() created last.
+    std::vector<SceneHandle> handles;
+};
+
+#endif // FRAME_RECORDING_H
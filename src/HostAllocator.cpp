@@ -0,0 +1,369 @@
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <vector>
+
+#include "HostAllocator.h"
+
+// Precedes every allocation, so it is also the minimum alignment pooled
+// blocks get.
+struct AllocationHeader
+{
+    uint64_t size;
+    // From the start of the system allocation, for large allocations.
+    uint32_t rawOffset;
+    uint8_t scope;
+    uint8_t sizeClass;
+    uint8_t tag;
+    uint8_t unused;
+};
+
+static const size_t HEADER_SIZE = sizeof(AllocationHeader);
+static_assert(HEADER_SIZE == 16, "Pooled blocks rely on a 16 byte header");
+
+// Blocks of 32 bytes up to 4 KiB, header included.
+static const size_t SIZE_CLASS_COUNT = 8;
+static const size_t MIN_BLOCK_SIZE = 32;
+static const size_t ARENA_SIZE = 64 * 1024;
+static const uint8_t LARGE_ALLOCATION = 0xff;
+
+static const char *hostAllocationTagNames[] = {
+    "instance",
+    "surface",
+    "device",
+    "swap chain",
+    "render pass",
+    "pipeline",
+    "descriptors",
+    "commands",
+    "synchronization",
+    "buffers",
+    "images",
+    "device memory",
+    "queries",
+    "samplers",
+    "debug",
+};
+
+static const char *scopeNames[] = {
+    "command",
+    "object",
+    "cache",
+    "device",
+    "instance",
+};
+
+const char *getHostAllocationTagName(HostAllocationTag tag)
+{
+    return hostAllocationTagNames[static_cast<size_t>(tag)];
+}
+
+bool HostAllocator::enabled = false;
+
+struct AllocatorState
+{
+    std::mutex mutex;
+    void *freeLists[SIZE_CLASS_COUNT];
+    std::vector<void *> arenas;
+    HostAllocationStatistics statistics;
+    VkAllocationCallbacks
+        callbacks[static_cast<size_t>(HostAllocationTag::Count)];
+};
+
+static size_t getBlockSize(uint8_t sizeClass)
+{
+    return MIN_BLOCK_SIZE << sizeClass;
+}
+
+static uint8_t findSizeClass(size_t size, size_t alignment)
+{
+    if (alignment > HEADER_SIZE)
+        return LARGE_ALLOCATION;
+
+    for (uint8_t sizeClass = 0; sizeClass < SIZE_CLASS_COUNT; sizeClass++)
+    {
+        if (size + HEADER_SIZE <= getBlockSize(sizeClass))
+            return sizeClass;
+    }
+    return LARGE_ALLOCATION;
+}
+
+static void addUsage(HostAllocationUsage &usage, uint64_t size)
+{
+    usage.allocatedBytes += size;
+    usage.allocationCount++;
+    usage.totalAllocations++;
+    if (usage.allocatedBytes > usage.peakBytes)
+        usage.peakBytes = usage.allocatedBytes;
+}
+
+static void removeUsage(HostAllocationUsage &usage, uint64_t size)
+{
+    usage.allocatedBytes -= size;
+    usage.allocationCount--;
+}
+
+static AllocatorState &getState();
+
+static void *VKAPI_PTR allocate(void *userData,
+                                size_t size,
+                                size_t alignment,
+                                VkSystemAllocationScope scope)
+{
+    AllocatorState &state = getState();
+    uint8_t sizeClass = findSizeClass(size, alignment);
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    uint8_t *memory;
+    uint32_t rawOffset = 0;
+    if (sizeClass != LARGE_ALLOCATION)
+    {
+        void *&freeList = state.freeLists[sizeClass];
+        if (!freeList)
+        {
+            // malloc aligns to at least 16 bytes, and so every block.
+            uint8_t *arena = static_cast<uint8_t *>(std::malloc(ARENA_SIZE));
+            if (!arena)
+                return nullptr;
+            state.arenas.push_back(arena);
+            state.statistics.arenaBytes += ARENA_SIZE;
+
+            size_t blockSize = getBlockSize(sizeClass);
+            for (size_t offset = 0; offset + blockSize <= ARENA_SIZE;
+                 offset += blockSize)
+            {
+                void *block = arena + offset;
+                *static_cast<void **>(block) = freeList;
+                freeList = block;
+            }
+        }
+
+        memory = static_cast<uint8_t *>(freeList);
+        freeList = *static_cast<void **>(freeList);
+        state.statistics.pooledAllocations++;
+    }
+    else
+    {
+        alignment = std::max(alignment, HEADER_SIZE);
+        uint8_t *raw = static_cast<uint8_t *>(
+            std::malloc(size + alignment + HEADER_SIZE));
+        if (!raw)
+            return nullptr;
+
+        uintptr_t user = reinterpret_cast<uintptr_t>(raw) + HEADER_SIZE;
+        user = (user + alignment - 1) & ~(uintptr_t(alignment) - 1);
+        memory = reinterpret_cast<uint8_t *>(user) - HEADER_SIZE;
+        rawOffset = static_cast<uint32_t>(memory - raw);
+    }
+
+    uint8_t tag = static_cast<uint8_t>(reinterpret_cast<uintptr_t>(userData));
+    AllocationHeader *header = reinterpret_cast<AllocationHeader *>(memory);
+    header->size = size;
+    header->rawOffset = rawOffset;
+    header->scope = static_cast<uint8_t>(scope);
+    header->sizeClass = sizeClass;
+    header->tag = tag;
+
+    addUsage(state.statistics.scopes[scope], size);
+    addUsage(state.statistics.tags[tag], size);
+
+    return memory + HEADER_SIZE;
+}
+
+static void VKAPI_PTR deallocate(void *, void *memory)
+{
+    if (!memory)
+        return;
+
+    AllocatorState &state = getState();
+    uint8_t *block = static_cast<uint8_t *>(memory) - HEADER_SIZE;
+    const AllocationHeader &header =
+        *reinterpret_cast<AllocationHeader *>(block);
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    removeUsage(state.statistics.scopes[header.scope], header.size);
+    removeUsage(state.statistics.tags[header.tag], header.size);
+
+    if (header.sizeClass != LARGE_ALLOCATION)
+    {
+        void *&freeList = state.freeLists[header.sizeClass];
+        *reinterpret_cast<void **>(block) = freeList;
+        freeList = block;
+    }
+    else
+    {
+        std::free(block - header.rawOffset);
+    }
+}
+
+static void *VKAPI_PTR reallocate(void *userData,
+                                  void *original,
+                                  size_t size,
+                                  size_t alignment,
+                                  VkSystemAllocationScope scope)
+{
+    if (!original)
+        return allocate(userData, size, alignment, scope);
+    if (size == 0)
+    {
+        deallocate(userData, original);
+        return nullptr;
+    }
+
+    AllocatorState &state = getState();
+    AllocationHeader &header = *reinterpret_cast<AllocationHeader *>(
+        static_cast<uint8_t *>(original) - HEADER_SIZE);
+
+    // Pooled blocks often have room to grow in place.
+    if (header.sizeClass != LARGE_ALLOCATION && alignment <= HEADER_SIZE &&
+        size + HEADER_SIZE <= getBlockSize(header.sizeClass))
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        removeUsage(state.statistics.scopes[header.scope], header.size);
+        removeUsage(state.statistics.tags[header.tag], header.size);
+        addUsage(state.statistics.scopes[header.scope], size);
+        addUsage(state.statistics.tags[header.tag], size);
+        header.size = size;
+        return original;
+    }
+
+    void *memory = allocate(userData, size, alignment, scope);
+    if (!memory)
+        return nullptr;
+
+    memcpy(memory, original, std::min<size_t>(header.size, size));
+    deallocate(userData, original);
+    return memory;
+}
+
+static void VKAPI_PTR internalAllocation(void *,
+                                         size_t size,
+                                         VkInternalAllocationType,
+                                         VkSystemAllocationScope scope)
+{
+    AllocatorState &state = getState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    addUsage(state.statistics.internal[scope], size);
+}
+
+static void VKAPI_PTR internalFree(void *,
+                                   size_t size,
+                                   VkInternalAllocationType,
+                                   VkSystemAllocationScope scope)
+{
+    AllocatorState &state = getState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    removeUsage(state.statistics.internal[scope], size);
+}
+
+static AllocatorState &getState()
+{
+    // Never destroyed: drivers may still free from their own threads while
+    // static destructors run.
+    static AllocatorState *state = []() {
+        AllocatorState *state = new AllocatorState();
+        std::fill(std::begin(state->freeLists),
+                  std::end(state->freeLists),
+                  nullptr);
+        state->statistics = {};
+
+        for (size_t i = 0; i < static_cast<size_t>(HostAllocationTag::Count);
+             i++)
+        {
+            VkAllocationCallbacks &callbacks = state->callbacks[i];
+            callbacks.pUserData = reinterpret_cast<void *>(i);
+            callbacks.pfnAllocation = allocate;
+            callbacks.pfnReallocation = reallocate;
+            callbacks.pfnFree = deallocate;
+            callbacks.pfnInternalAllocation = internalAllocation;
+            callbacks.pfnInternalFree = internalFree;
+        }
+        return state;
+    }();
+    return *state;
+}
+
+void HostAllocator::setEnabled(bool enabled)
+{
+    HostAllocator::enabled = enabled;
+}
+
+const VkAllocationCallbacks *HostAllocator::get(HostAllocationTag tag)
+{
+    if (!enabled)
+        return nullptr;
+    return &getState().callbacks[static_cast<size_t>(tag)];
+}
+
+HostAllocationStatistics HostAllocator::getStatistics()
+{
+    AllocatorState &state = getState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.statistics;
+}
+
+static void logUsage(std::ostream &out, const HostAllocationUsage &usage)
+{
+    out << usage.allocationCount << " allocations, "
+        << usage.allocatedBytes / 1024.0 << " KiB (peak "
+        << usage.peakBytes / 1024.0 << " KiB), " << usage.totalAllocations
+        << " calls";
+}
+
+void HostAllocator::logStatistics(std::ostream &out, uint32_t topTags)
+{
+    if (!enabled)
+        return;
+
+    HostAllocationStatistics statistics = getStatistics();
+
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(2);
+
+    uint64_t totalAllocations = 0;
+    for (const HostAllocationUsage &usage : statistics.scopes)
+        totalAllocations += usage.totalAllocations;
+
+    out << "Host memory: " << statistics.pooledAllocations << " of "
+        << totalAllocations << " allocations pooled, "
+        << statistics.arenaBytes / 1024.0 << " KiB of arenas\n";
+
+    for (size_t i = 0; i < HOST_ALLOCATION_SCOPE_COUNT; i++)
+    {
+        out << "  " << scopeNames[i] << ": ";
+        logUsage(out, statistics.scopes[i]);
+        if (statistics.internal[i].totalAllocations > 0)
+        {
+            out << ", internal "
+                << statistics.internal[i].allocatedBytes / 1024.0 << " KiB";
+        }
+        out << '\n';
+    }
+
+    std::vector<size_t> tags(statistics.tags.size());
+    for (size_t i = 0; i < tags.size(); i++)
+        tags[i] = i;
+    std::sort(tags.begin(), tags.end(), [&](size_t a, size_t b) {
+        return statistics.tags[a].peakBytes > statistics.tags[b].peakBytes;
+    });
+
+    for (size_t i = 0; i < std::min<size_t>(topTags, tags.size()); i++)
+    {
+        const HostAllocationUsage &usage = statistics.tags[tags[i]];
+        if (usage.totalAllocations == 0)
+            break;
+
+        out << "  " << hostAllocationTagNames[tags[i]] << ": ";
+        logUsage(out, usage);
+        out << '\n';
+    }
+
+    out.flush();
+    out.flags(flags);
+}
@@ -0,0 +1,78 @@
+#ifndef HOST_ALLOCATOR_H
+#define HOST_ALLOCATOR_H
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+#include "VulkanTypes.h"
+
+// Kind of Vulkan object an allocation was made for. Each has its own
+// VkAllocationCallbacks, so the callbacks know who is allocating.
+enum class HostAllocationTag
+{
+    Instance,
+    Surface,
+    Device,
+    SwapChain,
+    RenderPass,
+    Pipeline,
+    Descriptors,
+    Commands,
+    Synchronization,
+    Buffers,
+    Images,
+    DeviceMemory,
+    Queries,
+    Samplers,
+    Debug,
+    Count
+};
+
+const char *getHostAllocationTagName(HostAllocationTag tag);
+
+static const size_t HOST_ALLOCATION_SCOPE_COUNT =
+    VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+struct HostAllocationUsage
+{
+    uint64_t allocatedBytes;
+    uint64_t peakBytes;
+    uint32_t allocationCount;
+    // Every allocation and reallocation call so far.
+    uint64_t totalAllocations;
+};
+
+struct HostAllocationStatistics
+{
+    std::array<HostAllocationUsage, HOST_ALLOCATION_SCOPE_COUNT> scopes;
+    std::array<HostAllocationUsage,
+               static_cast<size_t>(HostAllocationTag::Count)>
+        tags;
+    // Reported through pfnInternalAllocation, made by the driver itself.
+    std::array<HostAllocationUsage, HOST_ALLOCATION_SCOPE_COUNT> internal;
+    // Served from the size class pools instead of the system allocator.
+    uint64_t pooledAllocations;
+    uint64_t arenaBytes;
+};
+
+// VkAllocationCallbacks backed by size class pools carved out of arenas,
+// with larger or over-aligned requests going to the system allocator.
+// Process wide: every object must be destroyed with the callbacks it was
+// created with, so enabling is only allowed before the instance exists.
+class HostAllocator
+{
+  public:
+    static void setEnabled(bool enabled);
+    static bool isEnabled() { return enabled; }
+    // nullptr while disabled, which gives the driver's own allocator.
+    static const VkAllocationCallbacks *get(HostAllocationTag tag);
+    static HostAllocationStatistics getStatistics();
+    // Usage per scope, then the tags with the highest peaks.
+    static void logStatistics(std::ostream &out, uint32_t topTags = 5);
+
+  private:
+    static bool enabled;
+};
+
+#endif // HOST_ALLOCATOR_H
@@ -0,0 +1,309 @@
+#include "JobSystem.h"
+
+// Jobs live in per thread rings. A thread scheduling more unfinished jobs
+// than this waits for its oldest one, see waitForSlot.
+static const uint32_t JOB_POOL_SIZE = 4096;
+
+// Batches per thread parallelFor aims for, so stealing can even out uneven
+// batches.
+static const uint32_t BATCHES_PER_THREAD = 4;
+
+struct CurrentWorker
+{
+    const JobSystem *system;
+    uint32_t index;
+};
+
+static thread_local CurrentWorker currentWorker = {nullptr, 0};
+
+JobDeque::JobDeque()
+    : top(0),
+      bottom(0),
+      jobs(new std::atomic<Job *>[CAPACITY])
+{
+}
+
+bool JobDeque::push(Job *job)
+{
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    if (b - t >= CAPACITY)
+        return false;
+
+    jobs[b & (CAPACITY - 1)].store(job, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return true;
+}
+
+Job *JobDeque::pop()
+{
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+
+    if (t > b)
+    {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job *job = jobs[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (t == b)
+    {
+        // Last job, race the thieves for it.
+        if (!top.compare_exchange_strong(t,
+                                         t + 1,
+                                         std::memory_order_seq_cst,
+                                         std::memory_order_relaxed))
+        {
+            job = nullptr;
+        }
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+Job *JobDeque::steal()
+{
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b)
+        return nullptr;
+
+    Job *job = jobs[t & (CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(
+            t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+        return nullptr;
+    }
+    return job;
+}
+
+JobSystem::JobSystem(uint32_t threadCount)
+    : injectedCapacity(0),
+      injectedHead(0),
+      injectedCount(0),
+      injectedJobPool(std::make_unique<Job[]>(JOB_POOL_SIZE)),
+      nextInjectedJob(0),
+      running(true),
+      queuedJobs(0),
+      sleepingWorkers(0)
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    for (uint32_t i = 0; i + 1 < threadCount; i++)
+    {
+        auto worker = std::make_unique<Worker>();
+        worker->jobPool = std::make_unique<Job[]>(JOB_POOL_SIZE);
+        worker->nextJob = 0;
+        workers.push_back(std::move(worker));
+    }
+
+    // A queued job holds its pool slot, so all pools together bound how
+    // many can wait here.
+    injectedCapacity = JOB_POOL_SIZE * threadCount;
+    injectedJobs = std::make_unique<Job *[]>(injectedCapacity);
+
+    // Only start once every deque exists, workers steal from each other.
+    for (uint32_t i = 0; i < workers.size(); i++)
+        workers[i]->thread = std::thread(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        running = false;
+    }
+    wakeCondition.notify_all();
+
+    for (auto &worker : workers)
+        worker->thread.join();
+}
+
+void JobSystem::schedule(JobFunction function,
+                         void *data,
+                         uint32_t begin,
+                         uint32_t end,
+                         JobCounter *counter,
+                         JobCounter *dependency)
+{
+    counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+    Job *job = allocateJob();
+    job->function = function;
+    job->data = data;
+    job->begin = begin;
+    job->end = end;
+    job->counter = counter;
+
+    if (dependency)
+    {
+        std::lock_guard<std::mutex> lock(dependency->mutex);
+        if (!dependency->isDone())
+        {
+            dependency->continuations.push_back(job);
+            return;
+        }
+    }
+
+    push(job);
+}
+
+void JobSystem::wait(JobCounter &counter)
+{
+    while (!counter.isDone())
+    {
+        Job *job = findJob();
+        if (job)
+            execute(job);
+        else
+            std::this_thread::yield();
+    }
+
+    // The last job may still hold the lock; the counter often lives on the
+    // caller's stack and must not go away under it.
+    std::lock_guard<std::mutex> lock(counter.mutex);
+}
+
+void JobSystem::workerLoop(uint32_t index)
+{
+    currentWorker = {this, index};
+
+    while (running.load(std::memory_order_relaxed))
+    {
+        Job *job = findJob();
+        if (job)
+        {
+            execute(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepingWorkers++;
+        wakeCondition.wait(lock, [this]() {
+            return !running || queuedJobs.load() > 0;
+        });
+        sleepingWorkers--;
+    }
+}
+
+Job *JobSystem::allocateJob()
+{
+    Job *job;
+    if (currentWorker.system == this)
+    {
+        Worker &worker = *workers[currentWorker.index];
+        job = &worker.jobPool[worker.nextJob++ % JOB_POOL_SIZE];
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(injectMutex);
+        job = &injectedJobPool[nextInjectedJob++ % JOB_POOL_SIZE];
+    }
+
+    if (job->busy.load(std::memory_order_acquire))
+        waitForSlot(job);
+    job->busy.store(true, std::memory_order_relaxed);
+    return job;
+}
+
+void JobSystem::waitForSlot(Job *job)
+{
+    // Deadlocks if the oldest job depends on one scheduled after it, which
+    // beats silently running a job twice and another never.
+    while (job->busy.load(std::memory_order_acquire))
+    {
+        Job *other = findJob();
+        if (other)
+            execute(other);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::push(Job *job)
+{
+    queuedJobs.fetch_add(1);
+
+    bool pushed = currentWorker.system == this &&
+                  workers[currentWorker.index]->deque.push(job);
+    if (!pushed)
+    {
+        std::lock_guard<std::mutex> lock(injectMutex);
+        uint32_t tail = (injectedHead + injectedCount) % injectedCapacity;
+        injectedJobs[tail] = job;
+        injectedCount++;
+    }
+
+    if (sleepingWorkers.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wakeCondition.notify_one();
+    }
+}
+
+Job *JobSystem::findJob()
+{
+    Job *job = nullptr;
+    uint32_t first = 0;
+
+    if (currentWorker.system == this)
+    {
+        job = workers[currentWorker.index]->deque.pop();
+        first = currentWorker.index + 1;
+    }
+
+    if (!job)
+    {
+        std::lock_guard<std::mutex> lock(injectMutex);
+        if (injectedCount > 0)
+        {
+            job = injectedJobs[injectedHead];
+            injectedHead = (injectedHead + 1) % injectedCapacity;
+            injectedCount--;
+        }
+    }
+
+    for (uint32_t i = 0; !job && i < workers.size(); i++)
+        job = workers[(first + i) % workers.size()]->deque.steal();
+
+    if (job)
+        queuedJobs.fetch_sub(1);
+    return job;
+}
+
+void JobSystem::execute(Job *job)
+{
+    // Released before running, a job may itself schedule enough jobs to
+    // wrap around to its own slot.
+    JobFunction function = job->function;
+    void *data = job->data;
+    uint32_t begin = job->begin;
+    uint32_t end = job->end;
+    JobCounter *counter = job->counter;
+    job->busy.store(false, std::memory_order_release);
+
+    function(data, begin, end);
+
+    // Under the lock so a dependency being added can not miss the
+    // counter reaching zero. Pushed before unlocking, clear() keeps the
+    // capacity for a counter that gets reused every frame.
+    std::lock_guard<std::mutex> lock(counter->mutex);
+    if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+
+    for (Job *continuation : counter->continuations)
+        push(continuation);
+    counter->continuations.clear();
+}
+
+uint32_t JobSystem::getBatchSize(uint32_t count, uint32_t minBatch) const
+{
+    uint32_t batches = getThreadCount() * BATCHES_PER_THREAD;
+    return std::max({minBatch, (count + batches - 1) / batches, 1u});
+}
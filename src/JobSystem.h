@@ -0,0 +1,165 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef void (*JobFunction)(void *data, uint32_t begin, uint32_t end);
+
+class JobCounter;
+
+struct Job
+{
+    JobFunction function;
+    void *data;
+    uint32_t begin;
+    uint32_t end;
+    JobCounter *counter;
+    // From scheduling until the job starts, its pool slot can't be reused.
+    std::atomic<bool> busy;
+};
+
+// Counts unfinished jobs. Jobs scheduled with a counter as dependency only
+// start once it drops to zero.
+class JobCounter
+{
+  public:
+    JobCounter() : pending(0) {}
+    bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+  private:
+    friend class JobSystem;
+
+    std::atomic<uint32_t> pending;
+    std::mutex mutex;
+    std::vector<Job *> continuations;
+};
+
+// Fixed size Chase-Lev deque: the owning worker pushes and pops at the
+// bottom, every other thread steals from the top.
+class JobDeque
+{
+  public:
+    JobDeque();
+    bool push(Job *job);
+    Job *pop();
+    Job *steal();
+
+  private:
+    static const int64_t CAPACITY = 4096;
+
+    std::atomic<int64_t> top;
+    std::atomic<int64_t> bottom;
+    std::unique_ptr<std::atomic<Job *>[]> jobs;
+};
+
+// Work-stealing scheduler. Any thread may schedule and wait; a waiting
+// thread runs jobs until its counter is done, so the caller of wait() is an
+// extra worker rather than a blocked one.
+class JobSystem
+{
+  public:
+    // 0 uses std::thread::hardware_concurrency, counting the thread that
+    // waits.
+    explicit JobSystem(uint32_t threadCount = 0);
+    ~JobSystem();
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    // Calls function(data, begin, end) on some thread. counter is
+    // incremented now and decremented once the job ran.
+    void schedule(JobFunction function,
+                  void *data,
+                  uint32_t begin,
+                  uint32_t end,
+                  JobCounter *counter,
+                  JobCounter *dependency = nullptr);
+    void wait(JobCounter &counter);
+
+    // Splits [0, count) in batches of at least minBatch, calls
+    // function(begin, end) for each and returns once all finished.
+    template <typename Function>
+    void parallelFor(uint32_t count,
+                     uint32_t minBatch,
+                     const Function &function)
+    {
+        uint32_t batch = getBatchSize(count, minBatch);
+        if (batch >= count)
+        {
+            if (count > 0)
+                function(0, count);
+            return;
+        }
+
+        JobCounter counter;
+        void *data = const_cast<Function *>(&function);
+        for (uint32_t begin = 0; begin < count; begin += batch)
+        {
+            schedule(invoke<Function>,
+                     data,
+                     begin,
+                     std::min(begin + batch, count),
+                     &counter);
+        }
+        wait(counter);
+    }
+
+  private:
+    struct Worker
+    {
+        JobDeque deque;
+        std::unique_ptr<Job[]> jobPool;
+        uint32_t nextJob;
+        std::thread thread;
+    };
+
+    template <typename Function>
+    static void invoke(void *data, uint32_t begin, uint32_t end)
+    {
+        (*static_cast<Function *>(data))(begin, end);
+    }
+
+    void workerLoop(uint32_t index);
+    Job *allocateJob();
+    // Runs other jobs until the one in the slot finished.
+    void waitForSlot(Job *job);
+    void push(Job *job);
+    Job *findJob();
+    void execute(Job *job);
+    uint32_t getBatchSize(uint32_t count, uint32_t minBatch) const;
+
+  public:
+    // Worker threads plus the waiting thread.
+    uint32_t getThreadCount() const
+    {
+        return static_cast<uint32_t>(workers.size()) + 1;
+    }
+
+  private:
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    // Jobs from threads that are not workers, and ones that did not fit a
+    // full deque. A FIFO ring with room for every pool slot, so pushing
+    // never has to grow it.
+    std::mutex injectMutex;
+    std::unique_ptr<Job *[]> injectedJobs;
+    uint32_t injectedCapacity;
+    uint32_t injectedHead;
+    uint32_t injectedCount;
+    std::unique_ptr<Job[]> injectedJobPool;
+    uint32_t nextInjectedJob;
+
+    std::atomic<bool> running;
+    std::atomic<int32_t> queuedJobs;
+    std::atomic<uint32_t> sleepingWorkers;
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+};
+
+#endif // JOB_SYSTEM_H
@@ -0,0 +1,47 @@
+#include <algorithm>
+#include <cmath>
+
+#include "LodSelector.h"
+
+// Keeps instances the camera is inside of from dividing by ~0.
+static const float MIN_LOD_DISTANCE = 1e-3f;
+
+float computeProjectionScale(float viewportHeight, float fovY)
+{
+    return viewportHeight / (2.0f * std::tan(fovY * 0.5f));
+}
+
+void selectLods(const LodSelectionParams &params,
+                const MeshLod *lods,
+                uint32_t lodCount,
+                const float *centerX,
+                const float *centerY,
+                const float *centerZ,
+                const float *radius,
+                size_t instanceCount,
+                uint8_t *selectedLods)
+{
+    // error * projectionScale / distance <= pixelThreshold, rearranged so
+    // that the per instance work is a distance and a few compares.
+    float errorPerDistance = params.pixelThreshold / params.projectionScale;
+
+    float thresholds[MAX_MESH_LODS];
+    lodCount = std::min(lodCount, MAX_MESH_LODS);
+    for (uint32_t i = 0; i < lodCount; i++)
+        thresholds[i] = lods[i].error / errorPerDistance;
+
+    for (size_t i = 0; i < instanceCount; i++)
+    {
+        float dx = centerX[i] - params.cameraPosition.x;
+        float dy = centerY[i] - params.cameraPosition.y;
+        float dz = centerZ[i] - params.cameraPosition.z;
+        float distance = std::sqrt(dx * dx + dy * dy + dz * dz) - radius[i];
+        distance = std::max(distance, MIN_LOD_DISTANCE);
+
+        uint8_t lod = 0;
+        for (uint32_t j = 1; j < lodCount; j++)
+            lod += thresholds[j] <= distance;
+
+        selectedLods[i] = lod;
+    }
+}
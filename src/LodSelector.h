@@ -0,0 +1,35 @@
+#ifndef LOD_SELECTOR_H
+#define LOD_SELECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "MeshSimplifier.h"
+
+struct LodSelectionParams
+{
+    glm::vec3 cameraPosition;
+    // Pixels per object space unit at distance 1:
+    // viewportHeight / (2 * tan(fovY / 2)).
+    float projectionScale;
+    // Largest screen space error, in pixels, a LOD may show.
+    float pixelThreshold;
+};
+
+float computeProjectionScale(float viewportHeight, float fovY);
+
+// Picks for every instance the coarsest LOD whose error, projected at the
+// distance of the instance's bounding sphere, stays below the threshold.
+// Instances are given as SoA bounding spheres so the loop only streams
+// through the columns it needs.
+void selectLods(const LodSelectionParams &params,
+                const MeshLod *lods,
+                uint32_t lodCount,
+                const float *centerX,
+                const float *centerY,
+                const float *centerZ,
+                const float *radius,
+                size_t instanceCount,
+                uint8_t *selectedLods);
+
+#endif // LOD_SELECTOR_H
@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "MeshAsset.h"
+
+MeshOptimizationReport bakeMeshAsset(MeshAsset &asset)
+{
+    MeshOptimizationReport report = optimizeMesh(asset.vertices, asset.indices);
+
+    asset.lods.clear();
+    generateLods(asset.indices, asset.vertices, asset.lods);
+
+    asset.boundingRadius = 0.0f;
+    for (const Vertex &vertex : asset.vertices)
+    {
+        asset.boundingRadius =
+            std::max(asset.boundingRadius, glm::length(vertex.pos));
+    }
+    return report;
+}
+
+void writeMeshAsset(const std::string &path, const MeshAsset &asset)
+{
+    MeshAssetHeader header{};
+    header.magic = MeshAssetHeader::MAGIC;
+    header.version = MeshAssetHeader::VERSION;
+    header.vertexCount = static_cast<uint32_t>(asset.vertices.size());
+    header.indexCount = static_cast<uint32_t>(asset.indices.size());
+    header.lodCount = static_cast<uint32_t>(asset.lods.size());
+    header.boundingRadius = asset.boundingRadius;
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(asset.vertices.data()),
+               asset.vertices.size() * sizeof(Vertex));
+    file.write(reinterpret_cast<const char *>(asset.indices.data()),
+               asset.indices.size() * sizeof(uint32_t));
+    file.write(reinterpret_cast<const char *>(asset.lods.data()),
+               asset.lods.size() * sizeof(MeshLod));
+    if (!file.good())
+        throw std::runtime_error("Failed to write mesh asset " + path);
+}
+
+// Copies count elements out of bytes at offset, unless they run past its
+// end.
+template <typename T>
+static bool readArray(const std::vector<char> &bytes,
+                      size_t &offset,
+                      size_t count,
+                      std::vector<T> &out)
+{
+    size_t size = count * sizeof(T);
+    if (bytes.size() - offset < size)
+        return false;
+
+    out.resize(count);
+    std::memcpy(out.data(), bytes.data() + offset, size);
+    offset += size;
+    return true;
+}
+
+void readMeshAsset(const std::vector<char> &bytes, MeshAsset &asset)
+{
+    MeshAssetHeader header{};
+    if (bytes.size() >= sizeof(header))
+        std::memcpy(&header, bytes.data(), sizeof(header));
+    if (header.magic != MeshAssetHeader::MAGIC ||
+        header.version != MeshAssetHeader::VERSION)
+    {
+        throw std::runtime_error("Not a mesh asset");
+    }
+
+    size_t offset = sizeof(header);
+    if (!readArray(bytes, offset, header.vertexCount, asset.vertices) ||
+        !readArray(bytes, offset, header.indexCount, asset.indices) ||
+        !readArray(bytes, offset, header.lodCount, asset.lods))
+    {
+        throw std::runtime_error("Truncated mesh asset");
+    }
+
+    // The renderer indexes both without checking.
+    bool valid = !asset.lods.empty();
+    for (const MeshLod &lod : asset.lods)
+    {
+        valid = valid && lod.firstIndex <= asset.indices.size() &&
+                lod.indexCount <= asset.indices.size() - lod.firstIndex;
+    }
+    for (uint32_t index : asset.indices)
+        valid = valid && index < header.vertexCount;
+    if (!valid)
+    {
+        throw std::runtime_error("Invalid mesh asset");
+    }
+    asset.boundingRadius = header.boundingRadius;
+}
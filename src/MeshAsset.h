@@ -0,0 +1,45 @@
+#ifndef MESH_ASSET_H
+#define MESH_ASSET_H
+
+#include <string>
+#include <vector>
+
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "VulkanTypes.h"
+
+// A mesh ready to upload: optimized, with its LOD chain and bounds.
+struct MeshAsset
+{
+    std::vector<Vertex> vertices;
+    // All LODs back to back, they share the vertex buffer.
+    std::vector<uint32_t> indices;
+    std::vector<MeshLod> lods;
+    float boundingRadius = 0.0f;
+};
+
+// What a .mesh file starts with, followed by the vertices, indices and
+// LODs as they are in memory. Baked on the machine that loads it, so in
+// its byte order.
+struct MeshAssetHeader
+{
+    static const uint32_t MAGIC = 0x4D574856; // "VHWM"
+    static const uint32_t VERSION = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t lodCount;
+    float boundingRadius;
+};
+
+// The offline part: optimizes vertices and indices, then adds the LOD
+// chain and bounds. Far too slow for startup on real meshes.
+MeshOptimizationReport bakeMeshAsset(MeshAsset &asset);
+
+// Throw when the file can't be written or the bytes aren't a mesh asset.
+void writeMeshAsset(const std::string &path, const MeshAsset &asset);
+void readMeshAsset(const std::vector<char> &bytes, MeshAsset &asset);
+
+#endif // MESH_ASSET_H
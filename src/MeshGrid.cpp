@@ -0,0 +1,46 @@
+#include <algorithm>
+#include <random>
+
+#include "MeshGrid.h"
+
+void buildGrid(uint32_t size,
+               bool shuffled,
+               std::vector<Vertex> &vertices,
+               std::vector<uint32_t> &indices)
+{
+    const uint32_t side = size + 1;
+    vertices.resize(side * side);
+    for (uint32_t y = 0; y < side; y++)
+    {
+        for (uint32_t x = 0; x < side; x++)
+        {
+            float u = static_cast<float>(x) / size;
+            float v = static_cast<float>(y) / size;
+            vertices[y * side + x] = {{u - 0.5f, v - 0.5f}, {u, v, 1.0f}};
+        }
+    }
+
+    std::vector<uint32_t> triangles(size * size * 2);
+    for (uint32_t i = 0; i < triangles.size(); i++)
+        triangles[i] = i;
+    if (shuffled)
+        std::shuffle(triangles.begin(), triangles.end(), std::mt19937(42));
+
+    indices.clear();
+    indices.reserve(triangles.size() * 3);
+    for (uint32_t triangle : triangles)
+    {
+        uint32_t quad = triangle / 2;
+        uint32_t corner = (quad / size) * side + quad % size;
+        if (triangle % 2 == 0)
+        {
+            indices.insert(indices.end(),
+                           {corner, corner + 1, corner + side + 1});
+        }
+        else
+        {
+            indices.insert(indices.end(),
+                           {corner + side + 1, corner + side, corner});
+        }
+    }
+}
@@ -0,0 +1,17 @@
+#ifndef MESH_GRID_H
+#define MESH_GRID_H
+
+#include <cstdint>
+#include <vector>
+
+#include "VulkanTypes.h"
+
+// A size by size quad grid over [-0.5, 0.5], the mesh the tests and
+// benchmarks run the mesh tools on. When shuffled its triangles come in
+// random order, the worst case a mesh exporter could hand over.
+void buildGrid(uint32_t size,
+               bool shuffled,
+               std::vector<Vertex> &vertices,
+               std::vector<uint32_t> &indices);
+
+#endif // MESH_GRID_H
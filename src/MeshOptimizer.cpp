@@ -0,0 +1,379 @@
+#include <algorithm>
+#include <cstring>
+
+#include "MeshOptimizer.h"
+
+static const uint32_t INVALID_INDEX = ~0u;
+
+static glm::vec3 getPosition(const Vertex &vertex)
+{
+    return glm::vec3(vertex.pos, 0.0f);
+}
+
+static uint32_t hashVertex(const Vertex &vertex)
+{
+    const unsigned char *bytes =
+        reinterpret_cast<const unsigned char *>(&vertex);
+
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(Vertex); i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+struct TriangleAdjacency
+{
+    std::vector<uint32_t> counts;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> triangles;
+};
+
+static void buildTriangleAdjacency(TriangleAdjacency &adjacency,
+                                   const std::vector<uint32_t> &indices,
+                                   size_t vertexCount)
+{
+    adjacency.counts.assign(vertexCount, 0);
+    adjacency.offsets.assign(vertexCount, 0);
+    adjacency.triangles.resize(indices.size());
+
+    for (uint32_t index : indices)
+        adjacency.counts[index]++;
+
+    uint32_t offset = 0;
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        adjacency.offsets[i] = offset;
+        offset += adjacency.counts[i];
+    }
+
+    std::vector<uint32_t> fill(adjacency.offsets);
+    for (size_t i = 0; i < indices.size(); i++)
+        adjacency.triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+}
+
+VertexCacheStatistics analyzeVertexCache(const std::vector<uint32_t> &indices,
+                                         size_t vertexCount,
+                                         uint32_t cacheSize)
+{
+    VertexCacheStatistics statistics{};
+    if (indices.empty())
+        return statistics;
+
+    // FIFO cache: a vertex is resident while fewer than cacheSize misses
+    // happened since it was loaded.
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+    uint32_t misses = 0;
+    uint32_t uniqueVertices = 0;
+
+    for (uint32_t index : indices)
+    {
+        if (timestamps[index] == 0)
+            uniqueVertices++;
+
+        if (time - timestamps[index] > cacheSize)
+        {
+            timestamps[index] = time++;
+            misses++;
+        }
+    }
+
+    statistics.acmr = static_cast<float>(misses) / (indices.size() / 3);
+    statistics.atvr = static_cast<float>(misses) / uniqueVertices;
+    return statistics;
+}
+
+size_t deduplicateVertices(std::vector<Vertex> &vertices,
+                           std::vector<uint32_t> &indices)
+{
+    size_t tableSize = 1;
+    while (tableSize < vertices.size() * 2)
+        tableSize *= 2;
+
+    std::vector<uint32_t> table(tableSize, INVALID_INDEX);
+    std::vector<uint32_t> remap(vertices.size());
+
+    uint32_t uniqueCount = 0;
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        size_t bucket = hashVertex(vertices[i]) & (tableSize - 1);
+        while (table[bucket] != INVALID_INDEX &&
+               memcmp(&vertices[table[bucket]], &vertices[i], sizeof(Vertex)))
+        {
+            bucket = (bucket + 1) & (tableSize - 1);
+        }
+
+        if (table[bucket] == INVALID_INDEX)
+        {
+            vertices[uniqueCount] = vertices[i];
+            table[bucket] = uniqueCount++;
+        }
+
+        remap[i] = table[bucket];
+    }
+
+    vertices.resize(uniqueCount);
+    for (uint32_t &index : indices)
+        index = remap[index];
+
+    return uniqueCount;
+}
+
+void optimizeVertexCache(std::vector<uint32_t> &indices,
+                         size_t vertexCount,
+                         uint32_t cacheSize)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    TriangleAdjacency adjacency;
+    buildTriangleAdjacency(adjacency, indices, vertexCount);
+
+    std::vector<uint32_t> liveTriangles(adjacency.counts);
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    deadEnd.reserve(indices.size());
+
+    uint32_t time = cacheSize + 1;
+    size_t cursor = 0;
+
+    auto skipDeadEnd = [&]() -> uint32_t {
+        while (!deadEnd.empty())
+        {
+            uint32_t vertex = deadEnd.back();
+            deadEnd.pop_back();
+            if (liveTriangles[vertex] > 0)
+                return vertex;
+        }
+
+        while (cursor < vertexCount)
+        {
+            if (liveTriangles[cursor] > 0)
+                return static_cast<uint32_t>(cursor);
+            cursor++;
+        }
+
+        return INVALID_INDEX;
+    };
+
+    uint32_t fanningVertex = skipDeadEnd();
+    while (fanningVertex != INVALID_INDEX)
+    {
+        candidates.clear();
+
+        uint32_t begin = adjacency.offsets[fanningVertex];
+        uint32_t end = begin + adjacency.counts[fanningVertex];
+        for (uint32_t i = begin; i < end; i++)
+        {
+            uint32_t triangle = adjacency.triangles[i];
+            if (emitted[triangle])
+                continue;
+
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                uint32_t vertex = indices[triangle * 3 + k];
+                result.push_back(vertex);
+                deadEnd.push_back(vertex);
+                candidates.push_back(vertex);
+                liveTriangles[vertex]--;
+
+                if (time - timestamps[vertex] > cacheSize)
+                    timestamps[vertex] = time++;
+            }
+
+            emitted[triangle] = true;
+        }
+
+        // Prefer the candidate that is still in the cache and will be for
+        // all of its remaining triangles.
+        uint32_t best = INVALID_INDEX;
+        int bestPriority = -1;
+        for (uint32_t vertex : candidates)
+        {
+            if (liveTriangles[vertex] == 0)
+                continue;
+
+            int priority = 0;
+            if (time - timestamps[vertex] + 2 * liveTriangles[vertex] <=
+                cacheSize)
+            {
+                priority = static_cast<int>(time - timestamps[vertex]);
+            }
+
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                best = vertex;
+            }
+        }
+
+        fanningVertex = best != INVALID_INDEX ? best : skipDeadEnd();
+    }
+
+    indices.swap(result);
+}
+
+struct Cluster
+{
+    size_t begin;
+    size_t end;
+    float sortKey;
+};
+
+static void splitClusters(std::vector<Cluster> &clusters,
+                          const std::vector<uint32_t> &indices,
+                          size_t vertexCount,
+                          float threshold,
+                          uint32_t cacheSize)
+{
+    size_t triangleCount = indices.size() / 3;
+    float meshAcmr = analyzeVertexCache(indices, vertexCount, cacheSize).acmr;
+
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+
+    size_t clusterBegin = 0;
+    uint32_t clusterMisses = 0;
+    for (size_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+        uint32_t misses = 0;
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            uint32_t vertex = indices[triangle * 3 + k];
+            if (time - timestamps[vertex] > cacheSize)
+            {
+                timestamps[vertex] = time++;
+                misses++;
+            }
+        }
+
+        // A triangle missing all of its vertices means the cache
+        // optimizer jumped: a hard boundary we can cut at for free.
+        if (misses == 3 && triangle > clusterBegin)
+        {
+            clusters.push_back({clusterBegin * 3, triangle * 3, 0.0f});
+            clusterBegin = triangle;
+            clusterMisses = 0;
+        }
+
+        clusterMisses += misses;
+
+        size_t clusterTriangles = triangle + 1 - clusterBegin;
+        float clusterAcmr = static_cast<float>(clusterMisses) / clusterTriangles;
+        if (clusterAcmr <= meshAcmr * threshold)
+        {
+            clusters.push_back({clusterBegin * 3, (triangle + 1) * 3, 0.0f});
+            clusterBegin = triangle + 1;
+            clusterMisses = 0;
+            // Starting a cluster anywhere means a cold cache.
+            time += cacheSize + 1;
+        }
+    }
+
+    if (clusterBegin < triangleCount)
+        clusters.push_back({clusterBegin * 3, triangleCount * 3, 0.0f});
+}
+
+void optimizeOverdraw(std::vector<uint32_t> &indices,
+                      const std::vector<Vertex> &vertices,
+                      float threshold,
+                      uint32_t cacheSize)
+{
+    if (indices.size() < 6)
+        return;
+
+    std::vector<Cluster> clusters;
+    splitClusters(clusters, indices, vertices.size(), threshold, cacheSize);
+
+    glm::vec3 meshCentroid(0.0f);
+    for (uint32_t index : indices)
+        meshCentroid += getPosition(vertices[index]);
+    meshCentroid /= static_cast<float>(indices.size());
+
+    for (Cluster &cluster : clusters)
+    {
+        glm::vec3 centroid(0.0f);
+        glm::vec3 normal(0.0f);
+        for (size_t i = cluster.begin; i < cluster.end; i += 3)
+        {
+            glm::vec3 p0 = getPosition(vertices[indices[i + 0]]);
+            glm::vec3 p1 = getPosition(vertices[indices[i + 1]]);
+            glm::vec3 p2 = getPosition(vertices[indices[i + 2]]);
+
+            centroid += p0 + p1 + p2;
+            // Unnormalized, so bigger triangles weigh more.
+            normal += glm::cross(p1 - p0, p2 - p0);
+        }
+
+        centroid /= static_cast<float>(cluster.end - cluster.begin);
+        float length = glm::length(normal);
+        if (length > 0.0f)
+            normal /= length;
+
+        cluster.sortKey = glm::dot(centroid - meshCentroid, normal);
+    }
+
+    std::stable_sort(clusters.begin(),
+                     clusters.end(),
+                     [](const Cluster &a, const Cluster &b) {
+                         return a.sortKey > b.sortKey;
+                     });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (const Cluster &cluster : clusters)
+    {
+        result.insert(result.end(),
+                      indices.begin() + cluster.begin,
+                      indices.begin() + cluster.end);
+    }
+
+    indices.swap(result);
+}
+
+void optimizeVertexFetch(std::vector<Vertex> &vertices,
+                         std::vector<uint32_t> &indices)
+{
+    std::vector<uint32_t> remap(vertices.size(), INVALID_INDEX);
+    std::vector<Vertex> result;
+    result.reserve(vertices.size());
+
+    for (uint32_t &index : indices)
+    {
+        if (remap[index] == INVALID_INDEX)
+        {
+            remap[index] = static_cast<uint32_t>(result.size());
+            result.push_back(vertices[index]);
+        }
+
+        index = remap[index];
+    }
+
+    vertices.swap(result);
+}
+
+MeshOptimizationReport optimizeMesh(std::vector<Vertex> &vertices,
+                                    std::vector<uint32_t> &indices)
+{
+    MeshOptimizationReport report{};
+    report.verticesBefore = vertices.size();
+    report.before = analyzeVertexCache(indices, vertices.size());
+
+    deduplicateVertices(vertices, indices);
+    optimizeVertexCache(indices, vertices.size());
+    optimizeOverdraw(indices, vertices);
+    optimizeVertexFetch(vertices, indices);
+
+    report.verticesAfter = vertices.size();
+    report.after = analyzeVertexCache(indices, vertices.size());
+    return report;
+}
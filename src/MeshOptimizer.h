@@ -0,0 +1,57 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "VulkanTypes.h"
+
+static const uint32_t VERTEX_CACHE_SIZE = 16;
+
+struct VertexCacheStatistics
+{
+    // Average cache miss ratio: transformed vertices per triangle.
+    float acmr;
+    // Average transform to vertex ratio: transformed vertices per unique
+    // referenced vertex. 1.0 is the optimum.
+    float atvr;
+};
+
+struct MeshOptimizationReport
+{
+    size_t verticesBefore;
+    size_t verticesAfter;
+    VertexCacheStatistics before;
+    VertexCacheStatistics after;
+};
+
+VertexCacheStatistics analyzeVertexCache(const std::vector<uint32_t> &indices,
+                                         size_t vertexCount,
+                                         uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+// Merges bitwise identical vertices and rewrites the indices accordingly.
+// Returns the number of vertices left.
+size_t deduplicateVertices(std::vector<Vertex> &vertices,
+                           std::vector<uint32_t> &indices);
+
+// Reorders triangles for post-transform vertex cache hits (Tipsify).
+void optimizeVertexCache(std::vector<uint32_t> &indices,
+                         size_t vertexCount,
+                         uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+// Reorders clusters of the cache optimized triangle order so that outward
+// facing clusters come first. threshold bounds how much the ACMR may degrade.
+void optimizeOverdraw(std::vector<uint32_t> &indices,
+                      const std::vector<Vertex> &vertices,
+                      float threshold = 1.05f,
+                      uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+// Reorders vertices by first use in the index buffer and drops unused ones.
+void optimizeVertexFetch(std::vector<Vertex> &vertices,
+                         std::vector<uint32_t> &indices);
+
+MeshOptimizationReport optimizeMesh(std::vector<Vertex> &vertices,
+                                    std::vector<uint32_t> &indices);
+
+#endif // MESH_OPTIMIZER_H
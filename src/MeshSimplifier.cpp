@@ -0,0 +1,347 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <unordered_map>
+
+#include "MeshSimplifier.h"
+
+// Boundary edges get a plane perpendicular to their triangle so that
+// collapses can not eat into the silhouette of open meshes.
+static const double BOUNDARY_WEIGHT = 10.0;
+
+struct Quadric
+{
+    double a2, ab, ac, ad;
+    double b2, bc, bd;
+    double c2, cd;
+    double d2;
+
+    Quadric &operator+=(const Quadric &other)
+    {
+        a2 += other.a2;
+        ab += other.ab;
+        ac += other.ac;
+        ad += other.ad;
+        b2 += other.b2;
+        bc += other.bc;
+        bd += other.bd;
+        c2 += other.c2;
+        cd += other.cd;
+        d2 += other.d2;
+        return *this;
+    }
+};
+
+struct Collapse
+{
+    uint32_t from;
+    uint32_t to;
+    double error;
+};
+
+static glm::vec3 getPosition(const Vertex &vertex)
+{
+    return glm::vec3(vertex.pos, 0.0f);
+}
+
+static void addPlane(Quadric &quadric,
+                     const glm::vec3 &normal,
+                     const glm::vec3 &point,
+                     double weight)
+{
+    double a = normal.x, b = normal.y, c = normal.z;
+    double d = -glm::dot(normal, point);
+
+    quadric.a2 += weight * a * a;
+    quadric.ab += weight * a * b;
+    quadric.ac += weight * a * c;
+    quadric.ad += weight * a * d;
+    quadric.b2 += weight * b * b;
+    quadric.bc += weight * b * c;
+    quadric.bd += weight * b * d;
+    quadric.c2 += weight * c * c;
+    quadric.cd += weight * c * d;
+    quadric.d2 += weight * d * d;
+}
+
+static double evaluate(const Quadric &q, const glm::vec3 &p)
+{
+    double x = p.x, y = p.y, z = p.z;
+    double result = q.a2 * x * x + q.b2 * y * y + q.c2 * z * z +
+                    2.0 * (q.ab * x * y + q.ac * x * z + q.bc * y * z) +
+                    2.0 * (q.ad * x + q.bd * y + q.cd * z) + q.d2;
+    return std::max(result, 0.0);
+}
+
+static glm::vec3 triangleNormal(const glm::vec3 &p0,
+                                const glm::vec3 &p1,
+                                const glm::vec3 &p2)
+{
+    return glm::cross(p1 - p0, p2 - p0);
+}
+
+static glm::vec3 normalize(const glm::vec3 &v)
+{
+    float length = glm::length(v);
+    return length > 0.0f ? v / length : v;
+}
+
+static uint64_t edgeKey(uint32_t a, uint32_t b)
+{
+    if (a > b)
+        std::swap(a, b);
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+static void computeQuadrics(std::vector<Quadric> &quadrics,
+                            const std::vector<uint32_t> &indices,
+                            const std::vector<Vertex> &vertices)
+{
+    quadrics.assign(vertices.size(), Quadric{});
+
+    std::unordered_map<uint64_t, uint32_t> edgeUses;
+    edgeUses.reserve(indices.size());
+
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        glm::vec3 p0 = getPosition(vertices[indices[i + 0]]);
+        glm::vec3 p1 = getPosition(vertices[indices[i + 1]]);
+        glm::vec3 p2 = getPosition(vertices[indices[i + 2]]);
+        glm::vec3 normal = normalize(triangleNormal(p0, p1, p2));
+
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            addPlane(quadrics[indices[i + k]], normal, p0, 1.0);
+            edgeUses[edgeKey(indices[i + k], indices[i + (k + 1) % 3])]++;
+        }
+    }
+
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        glm::vec3 p0 = getPosition(vertices[indices[i + 0]]);
+        glm::vec3 p1 = getPosition(vertices[indices[i + 1]]);
+        glm::vec3 p2 = getPosition(vertices[indices[i + 2]]);
+        glm::vec3 normal = triangleNormal(p0, p1, p2);
+
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            uint32_t a = indices[i + k];
+            uint32_t b = indices[i + (k + 1) % 3];
+            if (edgeUses[edgeKey(a, b)] != 1)
+                continue;
+
+            glm::vec3 pa = getPosition(vertices[a]);
+            glm::vec3 pb = getPosition(vertices[b]);
+            glm::vec3 plane = normalize(glm::cross(pb - pa, normal));
+
+            addPlane(quadrics[a], plane, pa, BOUNDARY_WEIGHT);
+            addPlane(quadrics[b], plane, pa, BOUNDARY_WEIGHT);
+        }
+    }
+}
+
+// Rejects collapses that would flip the winding of a surviving triangle.
+static bool flipsTriangle(uint32_t from,
+                          uint32_t to,
+                          const std::vector<uint32_t> &indices,
+                          const std::vector<uint32_t> &adjacencyOffsets,
+                          const std::vector<uint32_t> &adjacency,
+                          const std::vector<Vertex> &vertices)
+{
+    glm::vec3 target = getPosition(vertices[to]);
+
+    for (uint32_t i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1];
+         i++)
+    {
+        const uint32_t *triangle = &indices[adjacency[i] * 3];
+        if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+            continue;
+
+        glm::vec3 before[3], after[3];
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            before[k] = getPosition(vertices[triangle[k]]);
+            after[k] = triangle[k] == from ? target : before[k];
+        }
+
+        glm::vec3 n0 = triangleNormal(before[0], before[1], before[2]);
+        glm::vec3 n1 = triangleNormal(after[0], after[1], after[2]);
+        if (glm::dot(n0, n1) <= 0.0f)
+            return true;
+    }
+
+    return false;
+}
+
+std::vector<uint32_t> simplifyMesh(const std::vector<uint32_t> &indices,
+                                   const std::vector<Vertex> &vertices,
+                                   size_t targetIndexCount,
+                                   float maxError,
+                                   float *resultError)
+{
+    std::vector<uint32_t> result(indices);
+    std::vector<Quadric> quadrics;
+    computeQuadrics(quadrics, result, vertices);
+
+    size_t vertexCount = vertices.size();
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<bool> locked(vertexCount);
+
+    double maxErrorSquared = static_cast<double>(maxError) * maxError;
+    double worstError = 0.0;
+
+    while (result.size() > targetIndexCount)
+    {
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (uint32_t index : result)
+            adjacencyOffsets[index + 1]++;
+        for (size_t i = 0; i < vertexCount; i++)
+            adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+
+        adjacency.resize(result.size());
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(),
+                                   adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < result.size(); i++)
+            adjacency[fill[result[i]]++] = static_cast<uint32_t>(i / 3);
+
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                uint32_t a = result[i + k];
+                uint32_t b = result[i + (k + 1) % 3];
+                if (a > b)
+                    continue;
+
+                Quadric quadric = quadrics[a];
+                quadric += quadrics[b];
+                double errorToB = evaluate(quadric, getPosition(vertices[b]));
+                double errorToA = evaluate(quadric, getPosition(vertices[a]));
+
+                if (errorToB <= errorToA)
+                    collapses.push_back({a, b, errorToB});
+                else
+                    collapses.push_back({b, a, errorToA});
+            }
+        }
+
+        std::sort(collapses.begin(),
+                  collapses.end(),
+                  [](const Collapse &x, const Collapse &y) {
+                      return x.error < y.error;
+                  });
+
+        for (size_t i = 0; i < vertexCount; i++)
+            remap[i] = static_cast<uint32_t>(i);
+        std::fill(locked.begin(), locked.end(), false);
+
+        size_t triangleCount = result.size() / 3;
+        size_t targetTriangles = targetIndexCount / 3;
+        size_t collapseCount = 0;
+
+        for (const Collapse &collapse : collapses)
+        {
+            if (triangleCount <= targetTriangles ||
+                collapse.error > maxErrorSquared)
+                break;
+
+            if (locked[collapse.from] || locked[collapse.to])
+                continue;
+
+            if (flipsTriangle(collapse.from,
+                              collapse.to,
+                              result,
+                              adjacencyOffsets,
+                              adjacency,
+                              vertices))
+                continue;
+
+            // Lock the whole one-ring: its triangles are now stale for the
+            // flip test of any other collapse in this pass.
+            for (uint32_t j = adjacencyOffsets[collapse.from];
+                 j < adjacencyOffsets[collapse.from + 1];
+                 j++)
+            {
+                const uint32_t *triangle = &result[adjacency[j] * 3];
+                bool degenerate = false;
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    locked[triangle[k]] = true;
+                    degenerate |= triangle[k] == collapse.to;
+                }
+
+                if (degenerate)
+                    triangleCount--;
+            }
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to] += quadrics[collapse.from];
+            worstError = std::max(worstError, collapse.error);
+            collapseCount++;
+        }
+
+        if (collapseCount == 0)
+            break;
+
+        size_t writeIndex = 0;
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            uint32_t a = remap[result[i + 0]];
+            uint32_t b = remap[result[i + 1]];
+            uint32_t c = remap[result[i + 2]];
+            if (a == b || b == c || c == a)
+                continue;
+
+            result[writeIndex++] = a;
+            result[writeIndex++] = b;
+            result[writeIndex++] = c;
+        }
+        result.resize(writeIndex);
+    }
+
+    if (resultError)
+        *resultError = static_cast<float>(std::sqrt(worstError));
+
+    return result;
+}
+
+void generateLods(std::vector<uint32_t> &indices,
+                  const std::vector<Vertex> &vertices,
+                  std::vector<MeshLod> &lods,
+                  uint32_t maxLods,
+                  float reduction)
+{
+    maxLods = std::min(maxLods, MAX_MESH_LODS);
+
+    lods.clear();
+    lods.push_back({0, static_cast<uint32_t>(indices.size()), 0.0f});
+
+    std::vector<uint32_t> current(indices);
+    float error = 0.0f;
+
+    while (lods.size() < maxLods)
+    {
+        size_t target = static_cast<size_t>(current.size() / 3 * reduction) * 3;
+
+        float lodError = 0.0f;
+        std::vector<uint32_t> next =
+            simplifyMesh(current, vertices, target, FLT_MAX, &lodError);
+
+        // Stop once the simplifier can no longer make meaningful progress.
+        if (next.empty() || next.size() > current.size() * 0.95f)
+            break;
+
+        // Errors of successive simplifications add up in the worst case.
+        error += lodError;
+
+        lods.push_back({static_cast<uint32_t>(indices.size()),
+                        static_cast<uint32_t>(next.size()),
+                        error});
+        indices.insert(indices.end(), next.begin(), next.end());
+        current.swap(next);
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "VulkanTypes.h"
+
+static const uint32_t MAX_MESH_LODS = 8;
+
+struct MeshLod
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    // Geometric deviation from LOD 0, in object space units.
+    float error;
+};
+
+// Quadric error edge collapse. Vertices are only ever collapsed onto other
+// existing vertices, so the result indexes the same vertex buffer.
+std::vector<uint32_t> simplifyMesh(const std::vector<uint32_t> &indices,
+                                   const std::vector<Vertex> &vertices,
+                                   size_t targetIndexCount,
+                                   float maxError,
+                                   float *resultError = nullptr);
+
+// Appends a chain of simplified index lists to indices, each about
+// reduction times the size of the previous one. lods[0] covers the
+// original indices.
+void generateLods(std::vector<uint32_t> &indices,
+                  const std::vector<Vertex> &vertices,
+                  std::vector<MeshLod> &lods,
+                  uint32_t maxLods = 4,
+                  float reduction = 0.5f);
+
+#endif // MESH_SIMPLIFIER_H
@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Profiler.h"
+
+// Per thread; once full, the oldest events get overwritten.
+static const size_t EVENTS_PER_THREAD = 1 << 16;
+
+// A ProfileEvent the dump may read while its thread overwrites it. Relaxed
+// atomics cost the same as plain stores, the count decides what is valid.
+struct ProfileSlot
+{
+    std::atomic<const char *> name;
+    std::atomic<uint64_t> begin;
+    std::atomic<uint64_t> end;
+};
+
+struct ThreadEvents
+{
+    uint32_t threadId;
+    std::string name;
+    std::unique_ptr<ProfileSlot[]> events;
+    // Events published so far. Only the owning thread writes it.
+    std::atomic<uint64_t> count;
+};
+
+std::atomic<bool> Profiler::enabled(false);
+std::string Profiler::outputPath;
+
+static std::mutex registryMutex;
+static std::vector<std::unique_ptr<ThreadEvents>> registry;
+
+static ThreadEvents *registerThread(const char *name)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    auto threadEvents = std::make_unique<ThreadEvents>();
+    threadEvents->threadId = static_cast<uint32_t>(registry.size());
+    threadEvents->name = name;
+    threadEvents->events = std::make_unique<ProfileSlot[]>(EVENTS_PER_THREAD);
+    threadEvents->count = 0;
+
+    registry.push_back(std::move(threadEvents));
+    return registry.back().get();
+}
+
+// Threads register once on their first event; everything after that is
+// lock free.
+static thread_local ThreadEvents *currentThread = nullptr;
+
+static ThreadEvents &getThreadEvents()
+{
+    if (!currentThread)
+        currentThread = registerThread("thread");
+    return *currentThread;
+}
+
+static ThreadEvents &getGpuEvents()
+{
+    static ThreadEvents *gpuEvents = registerThread("GPU");
+    return *gpuEvents;
+}
+
+static void append(ThreadEvents &threadEvents,
+                   const char *name,
+                   uint64_t begin,
+                   uint64_t end)
+{
+    uint64_t count = threadEvents.count.load(std::memory_order_relaxed);
+    // Orders the previous count before overwriting the slot, a snapshot
+    // that sees the new event also sees that count.
+    std::atomic_thread_fence(std::memory_order_release);
+
+    ProfileSlot &slot = threadEvents.events[count % EVENTS_PER_THREAD];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.begin.store(begin, std::memory_order_relaxed);
+    slot.end.store(end, std::memory_order_relaxed);
+    threadEvents.count.store(count + 1, std::memory_order_release);
+}
+
+// Copies the ring while its thread keeps recording, then drops the events
+// that may have been overwritten during the copy.
+static void snapshot(const ThreadEvents &threadEvents,
+                     std::vector<ProfileEvent> &events)
+{
+    uint64_t count = threadEvents.count.load(std::memory_order_acquire);
+    uint64_t first =
+        count > EVENTS_PER_THREAD ? count - EVENTS_PER_THREAD : 0;
+
+    events.clear();
+    events.reserve(count - first);
+    for (uint64_t i = first; i < count; i++)
+    {
+        const ProfileSlot &slot = threadEvents.events[i % EVENTS_PER_THREAD];
+        events.push_back({slot.name.load(std::memory_order_relaxed),
+                          slot.begin.load(std::memory_order_relaxed),
+                          slot.end.load(std::memory_order_relaxed)});
+    }
+
+    // Event i lives until event i + EVENTS_PER_THREAD starts overwriting
+    // it, which happens before count moves past that one.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t after = threadEvents.count.load(std::memory_order_relaxed);
+    uint64_t valid = after >= EVENTS_PER_THREAD
+                         ? after - EVENTS_PER_THREAD + 1
+                         : 0;
+    if (valid > first)
+    {
+        events.erase(events.begin(),
+                     events.begin() + std::min(valid - first, count - first));
+    }
+}
+
+static void writeEscaped(std::ostream &out, const char *text)
+{
+    for (; *text; text++)
+    {
+        if (*text == '"' || *text == '\\')
+            out << '\\';
+        out << *text;
+    }
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+    Profiler::enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::setOutputPath(const std::string &path)
+{
+    outputPath = path;
+}
+
+void Profiler::setThreadName(const char *name)
+{
+    if (!currentThread)
+    {
+        currentThread = registerThread(name);
+        return;
+    }
+
+    // The exporter reads the name under the same lock.
+    std::lock_guard<std::mutex> lock(registryMutex);
+    currentThread->name = name;
+}
+
+uint64_t Profiler::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void Profiler::record(const char *name, uint64_t begin, uint64_t end)
+{
+    append(getThreadEvents(), name, begin, end);
+}
+
+void Profiler::recordGpu(const char *name, uint64_t begin, uint64_t end)
+{
+    if (isEnabled())
+        append(getGpuEvents(), name, begin, end);
+}
+
+bool Profiler::writeChromeTrace(const std::string &path)
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+        return false;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    // Taken first and written out after, threads keep recording meanwhile.
+    std::vector<std::vector<ProfileEvent>> events(registry.size());
+    uint64_t origin = UINT64_MAX;
+    for (size_t i = 0; i < registry.size(); i++)
+    {
+        snapshot(*registry[i], events[i]);
+        for (const ProfileEvent &event : events[i])
+            origin = std::min(origin, event.begin);
+    }
+
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+
+    for (size_t i = 0; i < registry.size(); i++)
+    {
+        const ThreadEvents &threadEvents = *registry[i];
+        if (i > 0)
+            file << ",\n";
+
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+             << threadEvents.threadId << ",\"args\":{\"name\":\"";
+        writeEscaped(file, threadEvents.name.c_str());
+        file << "\"}}";
+
+        for (const ProfileEvent &event : events[i])
+        {
+            file << ",\n{\"name\":\"";
+            writeEscaped(file, event.name);
+            file << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                 << threadEvents.threadId
+                 << ",\"ts\":" << (event.begin - origin) / 1000.0
+                 << ",\"dur\":" << (event.end - event.begin) / 1000.0 << "}";
+        }
+    }
+
+    file << "\n]}\n";
+    return file.good();
+}
+
+double Profiler::measureZoneOverhead(uint32_t iterations)
+{
+    // Keep the measurement out of the trace.
+    ThreadEvents &threadEvents = getThreadEvents();
+    std::vector<ProfileEvent> savedEvents;
+    snapshot(threadEvents, savedEvents);
+    uint64_t savedCount = threadEvents.count.load(std::memory_order_relaxed);
+
+    bool wasEnabled = isEnabled();
+    setEnabled(true);
+
+    uint64_t begin = now();
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        PROFILE_ZONE("profiler overhead");
+    }
+    uint64_t end = now();
+
+    setEnabled(wasEnabled);
+
+    // Rewinding the count is only safe while nothing dumps the trace,
+    // which is why this runs at startup.
+    threadEvents.count.store(savedCount - savedEvents.size(),
+                             std::memory_order_relaxed);
+    for (const ProfileEvent &event : savedEvents)
+        append(threadEvents, event.name, event.begin, event.end);
+
+    return static_cast<double>(end - begin) / iterations;
+}
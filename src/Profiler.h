@@ -0,0 +1,72 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+// name must be a string literal, only the pointer is recorded.
+#define PROFILE_ZONE(name)                                                     \
+    ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+
+struct ProfileEvent
+{
+    const char *name;
+    uint64_t begin;
+    uint64_t end;
+};
+
+class Profiler
+{
+  public:
+    static void setEnabled(bool enabled);
+    static bool isEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+    static void setOutputPath(const std::string &path);
+    static const std::string &getOutputPath() { return outputPath; }
+    static void setThreadName(const char *name);
+    // Nanoseconds on the steady clock.
+    static uint64_t now();
+    // Appends to the calling thread's ring buffer, no locks taken.
+    static void record(const char *name, uint64_t begin, uint64_t end);
+    // GPU work converted to the CPU clock. Only the render thread may call
+    // this.
+    static void recordGpu(const char *name, uint64_t begin, uint64_t end);
+    // Safe while other threads keep recording, their oldest events may be
+    // left out.
+    static bool writeChromeTrace(const std::string &path);
+    // Average cost of an enabled, empty zone in nanoseconds. Call it before
+    // any trace may be written.
+    static double measureZoneOverhead(uint32_t iterations = 100000);
+
+  private:
+    static std::atomic<bool> enabled;
+    static std::string outputPath;
+};
+
+class ProfileZone
+{
+  public:
+    explicit ProfileZone(const char *name)
+        : name(name),
+          begin(Profiler::isEnabled() ? Profiler::now() : 0)
+    {
+    }
+    ~ProfileZone()
+    {
+        if (begin != 0)
+            Profiler::record(name, begin, Profiler::now());
+    }
+    ProfileZone(const ProfileZone &) = delete;
+    ProfileZone &operator=(const ProfileZone &) = delete;
+
+  private:
+    const char *name;
+    uint64_t begin;
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,51 @@
+#include <algorithm>
+#include <cmath>
+
+#include "ResolutionScaler.h"
+
+// Frames averaged per adjustment, enough to ride out a single spike.
+static const uint32_t ADJUSTMENT_FRAMES = 8;
+// Fractions of the budget. The scale aims for TARGET_LOAD and is left alone
+// between the other two, so it doesn't oscillate around the budget.
+static const double TARGET_LOAD = 0.85;
+static const double MIN_LOAD = 0.7;
+static const double MAX_LOAD = 0.95;
+// Shrinks at once, since going over drops frames, and grows slowly, since
+// staying under only costs sharpness.
+static const float MAX_GROWTH = 1.1f;
+
+ResolutionScaler::ResolutionScaler(float minScale, uint64_t budget)
+    : minScale(std::clamp(minScale, 0.1f, 1.0f)),
+      budget(budget),
+      scale(1.0f),
+      totalTime(0),
+      frameCount(0),
+      adjustmentCount(0)
+{
+}
+
+void ResolutionScaler::update(uint64_t gpuTime)
+{
+    if (!isEnabled())
+        return;
+
+    totalTime += gpuTime;
+    if (++frameCount < ADJUSTMENT_FRAMES)
+        return;
+
+    double load = static_cast<double>(totalTime) / frameCount / budget;
+    totalTime = 0;
+    frameCount = 0;
+
+    if (load == 0.0 || (load >= MIN_LOAD && load <= MAX_LOAD))
+        return;
+
+    float ratio = static_cast<float>(std::sqrt(TARGET_LOAD / load));
+    float scaled =
+        std::clamp(scale * std::min(ratio, MAX_GROWTH), minScale, 1.0f);
+    if (scaled != scale)
+    {
+        scale = scaled;
+        adjustmentCount++;
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef RESOLUTION_SCALER_H
+#define RESOLUTION_SCALER_H
+
+#include <cstdint>
+
+// Picks the fraction of the output resolution the scene renders at, so GPU
+// frame times stay under a budget by trading pixels instead of frames. GPU
+// time mostly follows the pixel count, the square of the scale.
+class ResolutionScaler
+{
+  public:
+    // Budget in nanoseconds. A minimum scale of 1 or a budget of 0 never
+    // scales.
+    ResolutionScaler(float minScale = 1.0f, uint64_t budget = 0);
+    // Feeds one frame's GPU time, the scale changes every few frames.
+    void update(uint64_t gpuTime);
+
+  public:
+    bool isEnabled() const { return minScale < 1.0f && budget > 0; }
+    // In [minScale, 1].
+    float getScale() const { return scale; }
+    uint32_t getAdjustmentCount() const { return adjustmentCount; }
+
+  private:
+    float minScale;
+    uint64_t budget;
+    float scale;
+    uint64_t totalTime;
+    uint32_t frameCount;
+    uint32_t adjustmentCount;
+};
+
+#endif // RESOLUTION_SCALER_H
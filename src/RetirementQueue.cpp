@@ -0,0 +1,92 @@
+#include <vulkan/vulkan.h>
+
+#include "HostAllocator.h"
+#include "VulkanContext.h"
+
+#include "RetirementQueue.h"
+
+template <typename T> static T toHandle(uint64_t raw)
+{
+    T handle;
+    std::memcpy(&handle, &raw, sizeof(T));
+    return handle;
+}
+
+RetirementQueue::RetirementQueue(VulkanContext *context)
+    : context(context),
+      submitted(0)
+{
+}
+
+RetirementQueue::~RetirementQueue()
+{
+    if (pending.empty())
+        return;
+
+    // Shutting down, nothing else is rendering.
+    vkDeviceWaitIdle(context->getDevice());
+    for (const RetiredResource &resource : pending)
+        destroy(resource);
+}
+
+uint64_t RetirementQueue::markSubmitted()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return ++submitted;
+}
+
+void RetirementQueue::collect(uint64_t completedSubmission)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    while (!pending.empty() &&
+           pending.front().submission <= completedSubmission)
+    {
+        destroy(pending.front());
+        pending.pop_front();
+    }
+}
+
+void RetirementQueue::destroy(const RetiredResource &resource) const
+{
+    VkDevice device = context->getDevice();
+
+    switch (resource.kind)
+    {
+    case ResourceKind::Buffer:
+        vkDestroyBuffer(device,
+                        toHandle<VkBuffer>(resource.handle),
+                        HostAllocator::get(HostAllocationTag::Buffers));
+        break;
+    case ResourceKind::DeviceMemory:
+        context->getBufferCreator().freeMemory(
+            toHandle<VkDeviceMemory>(resource.handle));
+        break;
+    case ResourceKind::Image:
+        vkDestroyImage(device,
+                       toHandle<VkImage>(resource.handle),
+                       HostAllocator::get(HostAllocationTag::Images));
+        break;
+    case ResourceKind::ImageView:
+        vkDestroyImageView(device,
+                           toHandle<VkImageView>(resource.handle),
+                           HostAllocator::get(HostAllocationTag::Images));
+        break;
+    case ResourceKind::Framebuffer:
+        vkDestroyFramebuffer(
+            device,
+            toHandle<VkFramebuffer>(resource.handle),
+            HostAllocator::get(HostAllocationTag::RenderPass));
+        break;
+    case ResourceKind::Pipeline:
+        vkDestroyPipeline(device,
+                          toHandle<VkPipeline>(resource.handle),
+                          HostAllocator::get(HostAllocationTag::Pipeline));
+        break;
+    case ResourceKind::PipelineLayout:
+        vkDestroyPipelineLayout(
+            device,
+            toHandle<VkPipelineLayout>(resource.handle),
+            HostAllocator::get(HostAllocationTag::Pipeline));
+        break;
+    }
+}
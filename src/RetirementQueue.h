@@ -0,0 +1,139 @@
+#ifndef RETIREMENT_QUEUE_H
+#define RETIREMENT_QUEUE_H
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+
+#include "VulkanTypes.h"
+
+enum class ResourceKind
+{
+    Buffer,
+    DeviceMemory,
+    Image,
+    ImageView,
+    Framebuffer,
+    Pipeline,
+    PipelineLayout,
+};
+
+struct RetiredResource
+{
+    ResourceKind kind;
+    // Non dispatchable handles are 64 bits even on 32 bit platforms.
+    uint64_t handle;
+    // Frame submissions made before the resource was retired.
+    uint64_t submission;
+};
+
+// Destroys resources once every frame submitted before they were retired
+// has finished on the GPU, so nothing has to idle the device to free
+// them. Only frame submissions are tracked: whatever an upload still
+// reads must outlive its own fence. Resources may be retired from any
+// thread; everything still queued is destroyed with the queue.
+class RetirementQueue
+{
+  public:
+    RetirementQueue(VulkanContext *context);
+    ~RetirementQueue();
+    template <typename T> void retire(ResourceKind kind, T handle)
+    {
+        static_assert(sizeof(T) <= sizeof(uint64_t),
+                      "Only Vulkan handles can be retired");
+        uint64_t raw = 0;
+        std::memcpy(&raw, &handle, sizeof(T));
+
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back({kind, raw, submitted});
+    }
+    // Called right after each frame's vkQueueSubmit, returns the number
+    // identifying that submission.
+    uint64_t markSubmitted();
+    // Destroys everything retired before the given submission, which
+    // must have completed.
+    void collect(uint64_t completedSubmission);
+
+  private:
+    void destroy(const RetiredResource &resource) const;
+
+  public:
+    size_t getPendingCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pending.size();
+    }
+
+  private:
+    VulkanContext *context;
+
+    mutable std::mutex mutex;
+    // Submission numbers never decrease, so the oldest is always first.
+    std::deque<RetiredResource> pending;
+    uint64_t submitted;
+};
+
+// Move only owner of a Vulkan handle. Dropping it retires the handle
+// instead of destroying it, so it may still be in use by frames in flight.
+template <typename T, ResourceKind Kind> class UniqueHandle
+{
+  public:
+    UniqueHandle() : queue(nullptr), handle(VK_NULL_HANDLE) {}
+    UniqueHandle(RetirementQueue &queue, T handle)
+        : queue(&queue),
+          handle(handle)
+    {
+    }
+    UniqueHandle(UniqueHandle &&other) noexcept
+        : queue(other.queue),
+          handle(other.release())
+    {
+    }
+    UniqueHandle &operator=(UniqueHandle &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            queue = other.queue;
+            handle = other.release();
+        }
+        return *this;
+    }
+    UniqueHandle(const UniqueHandle &) = delete;
+    UniqueHandle &operator=(const UniqueHandle &) = delete;
+    ~UniqueHandle() { reset(); }
+
+    void reset()
+    {
+        if (handle != VK_NULL_HANDLE)
+            queue->retire(Kind, handle);
+        handle = VK_NULL_HANDLE;
+    }
+    // Gives up ownership without retiring.
+    T release()
+    {
+        T released = handle;
+        handle = VK_NULL_HANDLE;
+        return released;
+    }
+
+  public:
+    T get() const { return handle; }
+    operator T() const { return handle; }
+
+  private:
+    RetirementQueue *queue;
+    T handle;
+};
+
+typedef UniqueHandle<VkBuffer, ResourceKind::Buffer> UniqueBuffer;
+typedef UniqueHandle<VkDeviceMemory, ResourceKind::DeviceMemory>
+    UniqueDeviceMemory;
+typedef UniqueHandle<VkFramebuffer, ResourceKind::Framebuffer>
+    UniqueFramebuffer;
+typedef UniqueHandle<VkPipeline, ResourceKind::Pipeline> UniquePipeline;
+typedef UniqueHandle<VkPipelineLayout, ResourceKind::PipelineLayout>
+    UniquePipelineLayout;
+
+#endif // RETIREMENT_QUEUE_H
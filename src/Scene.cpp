@@ -0,0 +1,113 @@
+#include <cassert>
+
+#include "Triangle.h"
+
+#include "Scene.h"
+
+static const uint32_t INVALID_INDEX = UINT32_MAX;
+
+Scene::Scene() {}
+
+MeshHandle Scene::addMesh(const Triangle *mesh)
+{
+    meshRegistry.push_back(mesh);
+    return static_cast<MeshHandle>(meshRegistry.size() - 1);
+}
+
+SceneHandle Scene::create(MeshHandle mesh,
+                          const glm::vec3 &position,
+                          const glm::quat &rotation,
+                          const glm::vec3 &scale,
+                          uint32_t materialKey)
+{
+    uint32_t slot;
+    if (!freeSlots.empty())
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else
+    {
+        slot = static_cast<uint32_t>(slotToDense.size());
+        slotToDense.push_back(INVALID_INDEX);
+        slotGenerations.push_back(0);
+    }
+
+    uint32_t index = transforms.add(position, rotation, scale);
+    meshes.push_back(mesh);
+    materialKeys.push_back(materialKey);
+    boundingRadii.push_back(meshRegistry[mesh]->getBoundingRadius());
+    flags.push_back(SCENE_FLAG_VISIBLE);
+    denseToSlot.push_back(slot);
+
+    slotToDense[slot] = index;
+    return {slot, slotGenerations[slot]};
+}
+
+void Scene::destroy(SceneHandle handle)
+{
+    if (!isAlive(handle))
+        return;
+
+    uint32_t index = slotToDense[handle.slot];
+    uint32_t last = size() - 1;
+
+    // Move the last entity into the hole, every column the same way.
+    transforms.remove(index);
+    meshes[index] = meshes[last];
+    materialKeys[index] = materialKeys[last];
+    boundingRadii[index] = boundingRadii[last];
+    flags[index] = flags[last];
+    denseToSlot[index] = denseToSlot[last];
+    slotToDense[denseToSlot[index]] = index;
+
+    meshes.pop_back();
+    materialKeys.pop_back();
+    boundingRadii.pop_back();
+    flags.pop_back();
+    denseToSlot.pop_back();
+
+    slotToDense[handle.slot] = INVALID_INDEX;
+    slotGenerations[handle.slot]++;
+    freeSlots.push_back(handle.slot);
+}
+
+void Scene::clear()
+{
+    for (uint32_t slot : denseToSlot)
+    {
+        slotToDense[slot] = INVALID_INDEX;
+        slotGenerations[slot]++;
+        freeSlots.push_back(slot);
+    }
+
+    transforms.clear();
+    meshes.clear();
+    materialKeys.clear();
+    boundingRadii.clear();
+    flags.clear();
+    denseToSlot.clear();
+}
+
+bool Scene::isAlive(SceneHandle handle) const
+{
+    return handle.slot < slotGenerations.size() &&
+           slotGenerations[handle.slot] == handle.generation &&
+           slotToDense[handle.slot] != INVALID_INDEX;
+}
+
+uint32_t Scene::getIndex(SceneHandle handle) const
+{
+    assert(isAlive(handle));
+    return slotToDense[handle.slot];
+}
+
+void Scene::setFlags(SceneHandle handle, uint32_t flags)
+{
+    this->flags[getIndex(handle)] = flags;
+}
+
+void Scene::setMaterialKey(SceneHandle handle, uint32_t materialKey)
+{
+    materialKeys[getIndex(handle)] = materialKey;
+}
@@ -0,0 +1,82 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "TransformSystem.h"
+#include "VulkanTypes.h"
+
+typedef uint32_t MeshHandle;
+
+// Stays valid while the entity lives; a destroyed entity's handle never
+// resolves again because its slot's generation moves on.
+struct SceneHandle
+{
+    uint32_t slot;
+    uint32_t generation;
+};
+
+enum SceneFlags : uint32_t
+{
+    SCENE_FLAG_VISIBLE = 1 << 0,
+};
+
+// Renderables as dense SoA columns. Destruction swap-removes, so the
+// columns stay packed and the dense index of an entity may change; hold
+// SceneHandles across frames, never indices. The dense index also indexes
+// the transforms and the per-frame instance buffer.
+class Scene
+{
+  public:
+    Scene();
+    MeshHandle addMesh(const Triangle *mesh);
+    SceneHandle create(MeshHandle mesh,
+                       const glm::vec3 &position,
+                       const glm::quat &rotation,
+                       const glm::vec3 &scale,
+                       uint32_t materialKey);
+    void destroy(SceneHandle handle);
+    void clear();
+    bool isAlive(SceneHandle handle) const;
+    // Dense index of a live entity, only valid until the next destroy.
+    uint32_t getIndex(SceneHandle handle) const;
+    void setFlags(SceneHandle handle, uint32_t flags);
+    void setMaterialKey(SceneHandle handle, uint32_t materialKey);
+
+  public:
+    uint32_t size() const { return static_cast<uint32_t>(meshes.size()); }
+    uint32_t getMeshCount() const
+    {
+        return static_cast<uint32_t>(meshRegistry.size());
+    }
+    const Triangle &getMesh(MeshHandle mesh) const
+    {
+        return *meshRegistry[mesh];
+    }
+    const TransformSystem &getTransforms() const { return transforms; }
+    TransformSystem &getTransforms() { return transforms; }
+    const MeshHandle *getMeshes() const { return meshes.data(); }
+    const uint32_t *getMaterialKeys() const { return materialKeys.data(); }
+    // Object space bounding sphere radii, centered on the position.
+    const float *getBoundingRadii() const { return boundingRadii.data(); }
+    const uint32_t *getFlags() const { return flags.data(); }
+
+  private:
+    std::vector<const Triangle *> meshRegistry;
+
+    // Dense columns, one entry per live entity.
+    TransformSystem transforms;
+    std::vector<MeshHandle> meshes;
+    std::vector<uint32_t> materialKeys;
+    std::vector<float> boundingRadii;
+    std::vector<uint32_t> flags;
+    std::vector<uint32_t> denseToSlot;
+
+    // Sparse slots, indexed by SceneHandle::slot.
+    std::vector<uint32_t> slotToDense;
+    std::vector<uint32_t> slotGenerations;
+    std::vector<uint32_t> freeSlots;
+};
+
+#endif // SCENE_H
@@ -0,0 +1,96 @@
+#include <vulkan/vk_enum_string_helper.h>
+#include <vulkan/vulkan.h>
+
+#include <stdexcept>
+
+#include "HostAllocator.h"
+#include "VulkanContext.h"
+
+#include "StagingRing.h"
+
+// Enough for any texel and for the buffer copies' offsets.
+static const VkDeviceSize STAGING_RING_ALIGNMENT = 16;
+
+StagingRing::StagingRing(VulkanContext *context, VkDeviceSize size)
+    : context(context),
+      size(size),
+      buffer(VK_NULL_HANDLE),
+      memory(VK_NULL_HANDLE),
+      mapped(nullptr),
+      head(0),
+      used(0)
+{
+}
+
+StagingRing::~StagingRing()
+{
+    if (buffer == VK_NULL_HANDLE)
+        return;
+
+    VkDevice device = context->getDevice();
+    if (mapped != nullptr)
+        vkUnmapMemory(device, memory);
+    vkDestroyBuffer(
+        device, buffer, HostAllocator::get(HostAllocationTag::Buffers));
+    context->getBufferCreator().freeMemory(memory);
+}
+
+void StagingRing::init()
+{
+    context->getBufferCreator().createBuffer(
+        size,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        MemoryCategory::Staging,
+        buffer,
+        memory);
+
+    void *data;
+    VkResult result =
+        vkMapMemory(context->getDevice(), memory, 0, size, 0, &data);
+    if (result != VK_SUCCESS)
+    {
+        std::string errorMsg("Failed to map the staging ring: ");
+        errorMsg.append(string_VkResult(result));
+        throw std::runtime_error(errorMsg);
+    }
+    mapped = static_cast<uint8_t *>(data);
+}
+
+VkDeviceSize StagingRing::align(VkDeviceSize size)
+{
+    return (size + STAGING_RING_ALIGNMENT - 1) & ~(STAGING_RING_ALIGNMENT - 1);
+}
+
+bool StagingRing::allocate(VkDeviceSize allocationSize, VkDeviceSize &offset)
+{
+    allocationSize = align(allocationSize);
+    if (allocationSize > size)
+        throw std::runtime_error("Upload larger than the staging ring!");
+
+    if (used == 0)
+        head = 0;
+
+    VkDeviceSize tail = (head + size - used) % size;
+    if (used > 0 && head <= tail)
+    {
+        // The free space is the gap between head and tail.
+        if (tail - head < allocationSize)
+            return false;
+    }
+    else if (size - head < allocationSize)
+    {
+        // Not enough room before the end: skip it and start over at 0.
+        if (tail < allocationSize)
+            return false;
+
+        used += size - head;
+        head = 0;
+    }
+
+    offset = head;
+    head = (head + allocationSize) % size;
+    used += allocationSize;
+    return true;
+}
@@ -0,0 +1,39 @@
+#ifndef STAGING_RING_H
+#define STAGING_RING_H
+
+#include "VulkanTypes.h"
+
+// Persistently mapped upload memory, filled at the head and released in
+// allocation order, so its owner must retire its copies in that order.
+class StagingRing
+{
+  public:
+    StagingRing(VulkanContext *context, VkDeviceSize size);
+    ~StagingRing();
+    void init();
+    // False when there is no room until older bytes are released. Throws
+    // when size could never fit.
+    bool allocate(VkDeviceSize size, VkDeviceSize &offset);
+    // Bytes getUsed() grew by while allocating what is released, which
+    // includes the padding skipped when wrapping.
+    void release(VkDeviceSize bytes) { used -= bytes; }
+    static VkDeviceSize align(VkDeviceSize size);
+
+  public:
+    VkBuffer getBuffer() const { return buffer; }
+    uint8_t *getMapped() const { return mapped; }
+    VkDeviceSize getSize() const { return size; }
+    VkDeviceSize getUsed() const { return used; }
+
+  private:
+    VulkanContext *context;
+
+    VkDeviceSize size;
+    VkBuffer buffer;
+    VkDeviceMemory memory;
+    uint8_t *mapped;
+    VkDeviceSize head;
+    VkDeviceSize used;
+};
+
+#endif // STAGING_RING_H
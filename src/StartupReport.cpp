@@ -0,0 +1,43 @@
+#include <iomanip>
+
+#include "StartupReport.h"
+
+StartupReport::StartupReport()
+    : origin(Profiler::now()),
+      firstFrame(0),
+      mainThread(std::this_thread::get_id())
+{
+}
+
+void StartupReport::record(const char *name, uint64_t begin, uint64_t end)
+{
+    bool onMainThread = std::this_thread::get_id() == mainThread;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    phases.push_back({name, begin, end, onMainThread});
+}
+
+void StartupReport::setFirstFrame(uint64_t time)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    firstFrame = time;
+}
+
+void StartupReport::print(std::ostream &out) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(2);
+    out << "Startup breakdown (start + duration, ms):\n";
+    for (const StartupPhase &phase : phases)
+    {
+        out << "  " << std::left << std::setw(20) << phase.name << std::right
+            << std::setw(9) << (phase.begin - origin) / 1e6 << " +"
+            << std::setw(9) << (phase.end - phase.begin) / 1e6
+            << (phase.onMainThread ? "" : "  [worker]") << '\n';
+    }
+    if (firstFrame != 0)
+        out << "  first frame at " << (firstFrame - origin) / 1e6 << " ms\n";
+    out.flags(flags);
+}
@@ -0,0 +1,45 @@
+#ifndef STARTUP_REPORT_H
+#define STARTUP_REPORT_H
+
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#include "Profiler.h"
+
+struct StartupPhase
+{
+    const char *name;
+    uint64_t begin;
+    uint64_t end;
+    bool onMainThread;
+};
+
+// Wall clock breakdown of initialization, from construction up to the
+// first presented frame. Phases may be recorded from any thread.
+class StartupReport
+{
+  public:
+    StartupReport();
+    void record(const char *name, uint64_t begin, uint64_t end);
+    template <typename Function> void time(const char *name, Function function)
+    {
+        uint64_t begin = Profiler::now();
+        function();
+        record(name, begin, Profiler::now());
+    }
+    void setFirstFrame(uint64_t time);
+    void print(std::ostream &out) const;
+
+  private:
+    uint64_t origin;
+    uint64_t firstFrame;
+    std::thread::id mainThread;
+
+    mutable std::mutex mutex;
+    std::vector<StartupPhase> phases;
+};
+
+#endif // STARTUP_REPORT_H
@@ -0,0 +1,49 @@
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "TextureAsset.h"
+
+static const uint32_t TEXTURE_ASSET_BYTES_PER_PIXEL = 4;
+
+void writeTextureAsset(const std::string &path, const TextureAsset &asset)
+{
+    TextureAssetHeader header{};
+    header.magic = TextureAssetHeader::MAGIC;
+    header.version = TextureAssetHeader::VERSION;
+    header.width = asset.width;
+    header.height = asset.height;
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(asset.pixels.data()),
+               asset.pixels.size());
+    if (!file.good())
+        throw std::runtime_error("Failed to write texture asset " + path);
+}
+
+void readTextureAsset(const std::vector<char> &bytes, TextureAsset &asset)
+{
+    TextureAssetHeader header{};
+    if (bytes.size() >= sizeof(header))
+        std::memcpy(&header, bytes.data(), sizeof(header));
+    if (header.magic != TextureAssetHeader::MAGIC ||
+        header.version != TextureAssetHeader::VERSION)
+    {
+        throw std::runtime_error("Not a texture asset");
+    }
+
+    // The texture manager needs at least one texel.
+    if (header.width == 0 || header.height == 0)
+        throw std::runtime_error("Invalid texture asset");
+
+    uint64_t size = uint64_t(header.width) * header.height *
+                    TEXTURE_ASSET_BYTES_PER_PIXEL;
+    if (bytes.size() - sizeof(header) < size)
+        throw std::runtime_error("Truncated texture asset");
+
+    asset.width = header.width;
+    asset.height = header.height;
+    const char *pixels = bytes.data() + sizeof(header);
+    asset.pixels.assign(pixels, pixels + size);
+}
@@ -0,0 +1,33 @@
+#ifndef TEXTURE_ASSET_H
+#define TEXTURE_ASSET_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Full resolution RGBA8 pixels, the texture manager builds the mips.
+struct TextureAsset
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> pixels;
+};
+
+// What a .texture file starts with, followed by the pixels row by row.
+struct TextureAssetHeader
+{
+    static const uint32_t MAGIC = 0x54574856; // "VHWT"
+    static const uint32_t VERSION = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+};
+
+// Throw when the file can't be written or the bytes aren't a texture
+// asset.
+void writeTextureAsset(const std::string &path, const TextureAsset &asset);
+void readTextureAsset(const std::vector<char> &bytes, TextureAsset &asset);
+
+#endif // TEXTURE_ASSET_H
@@ -0,0 +1,387 @@
+#include <algorithm>
+#include <cstring>
+
+#include "TransformSystem.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define TRANSFORM_SIMD 1
+#include <immintrin.h>
+#endif
+
+struct TransformColumns
+{
+    const float *positionX;
+    const float *positionY;
+    const float *positionZ;
+    const float *rotationX;
+    const float *rotationY;
+    const float *rotationZ;
+    const float *rotationW;
+    const float *scaleX;
+    const float *scaleY;
+    const float *scaleZ;
+};
+
+typedef void (*TransformKernelFunction)(const TransformColumns &columns,
+                                        const float *viewProjection,
+                                        uint32_t first,
+                                        uint32_t count,
+                                        float *out);
+
+static const char *transformKernelNames[] = {"scalar", "sse", "avx2"};
+
+const char *getTransformKernelName(TransformKernel kernel)
+{
+    return transformKernelNames[static_cast<size_t>(kernel)];
+}
+
+// Same math as the SIMD kernels, one object at a time. Also handles their
+// remainders.
+static void computeMvpsScalar(const TransformColumns &columns,
+                              const float *viewProjection,
+                              uint32_t first,
+                              uint32_t count,
+                              float *out)
+{
+    const float *vp = viewProjection;
+
+    for (uint32_t i = first; i < first + count; i++, out += 16)
+    {
+        float x = columns.rotationX[i];
+        float y = columns.rotationY[i];
+        float z = columns.rotationZ[i];
+        float w = columns.rotationW[i];
+
+        float xx = 2.0f * x * x, yy = 2.0f * y * y, zz = 2.0f * z * z;
+        float xy = 2.0f * x * y, xz = 2.0f * x * z, yz = 2.0f * y * z;
+        float wx = 2.0f * w * x, wy = 2.0f * w * y, wz = 2.0f * w * z;
+
+        float sx = columns.scaleX[i];
+        float sy = columns.scaleY[i];
+        float sz = columns.scaleZ[i];
+
+        // Columns of the world matrix, the last one is the translation.
+        float world[4][3] = {
+            {(1.0f - (yy + zz)) * sx, (xy + wz) * sx, (xz - wy) * sx},
+            {(xy - wz) * sy, (1.0f - (xx + zz)) * sy, (yz + wx) * sy},
+            {(xz + wy) * sz, (yz - wx) * sz, (1.0f - (xx + yy)) * sz},
+            {columns.positionX[i], columns.positionY[i], columns.positionZ[i]},
+        };
+
+        for (int column = 0; column < 4; column++)
+        {
+            for (int row = 0; row < 4; row++)
+            {
+                float value = vp[row] * world[column][0] +
+                              vp[4 + row] * world[column][1] +
+                              vp[8 + row] * world[column][2];
+                if (column == 3)
+                    value += vp[12 + row];
+                out[column * 4 + row] = value;
+            }
+        }
+    }
+}
+
+#ifdef TRANSFORM_SIMD
+
+static void computeMvpsSse(const TransformColumns &columns,
+                           const float *viewProjection,
+                           uint32_t first,
+                           uint32_t count,
+                           float *out)
+{
+    __m128 vp[16];
+    for (int i = 0; i < 16; i++)
+        vp[i] = _mm_set1_ps(viewProjection[i]);
+
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+
+    uint32_t end = first + count;
+    uint32_t i = first;
+    for (; i + 4 <= end; i += 4, out += 64)
+    {
+        __m128 x = _mm_loadu_ps(columns.rotationX + i);
+        __m128 y = _mm_loadu_ps(columns.rotationY + i);
+        __m128 z = _mm_loadu_ps(columns.rotationZ + i);
+        __m128 w = _mm_loadu_ps(columns.rotationW + i);
+
+        __m128 x2 = _mm_mul_ps(x, two);
+        __m128 y2 = _mm_mul_ps(y, two);
+        __m128 z2 = _mm_mul_ps(z, two);
+        __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2);
+        __m128 zz = _mm_mul_ps(z, z2), xy = _mm_mul_ps(x, y2);
+        __m128 xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+        __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2);
+        __m128 wz = _mm_mul_ps(w, z2);
+
+        __m128 sx = _mm_loadu_ps(columns.scaleX + i);
+        __m128 sy = _mm_loadu_ps(columns.scaleY + i);
+        __m128 sz = _mm_loadu_ps(columns.scaleZ + i);
+
+        __m128 world[4][3] = {
+            {_mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx),
+             _mm_mul_ps(_mm_add_ps(xy, wz), sx),
+             _mm_mul_ps(_mm_sub_ps(xz, wy), sx)},
+            {_mm_mul_ps(_mm_sub_ps(xy, wz), sy),
+             _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy),
+             _mm_mul_ps(_mm_add_ps(yz, wx), sy)},
+            {_mm_mul_ps(_mm_add_ps(xz, wy), sz),
+             _mm_mul_ps(_mm_sub_ps(yz, wx), sz),
+             _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz)},
+            {_mm_loadu_ps(columns.positionX + i),
+             _mm_loadu_ps(columns.positionY + i),
+             _mm_loadu_ps(columns.positionZ + i)},
+        };
+
+        for (int column = 0; column < 4; column++)
+        {
+            __m128 rows[4];
+            for (int row = 0; row < 4; row++)
+            {
+                rows[row] = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(vp[row], world[column][0]),
+                               _mm_mul_ps(vp[4 + row], world[column][1])),
+                    _mm_mul_ps(vp[8 + row], world[column][2]));
+                if (column == 3)
+                    rows[row] = _mm_add_ps(rows[row], vp[12 + row]);
+            }
+
+            // Lane k of every row belongs to object k.
+            _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+            for (int object = 0; object < 4; object++)
+                _mm_stream_ps(out + object * 16 + column * 4, rows[object]);
+        }
+    }
+
+    computeMvpsScalar(columns, viewProjection, i, end - i, out);
+    _mm_sfence();
+}
+
+__attribute__((target("avx2,fma"))) static void computeMvpsAvx2(
+    const TransformColumns &columns,
+    const float *viewProjection,
+    uint32_t first,
+    uint32_t count,
+    float *out)
+{
+    __m256 vp[16];
+    for (int i = 0; i < 16; i++)
+        vp[i] = _mm256_set1_ps(viewProjection[i]);
+
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+
+    uint32_t end = first + count;
+    uint32_t i = first;
+    for (; i + 8 <= end; i += 8, out += 128)
+    {
+        __m256 x = _mm256_loadu_ps(columns.rotationX + i);
+        __m256 y = _mm256_loadu_ps(columns.rotationY + i);
+        __m256 z = _mm256_loadu_ps(columns.rotationZ + i);
+        __m256 w = _mm256_loadu_ps(columns.rotationW + i);
+
+        __m256 x2 = _mm256_mul_ps(x, two);
+        __m256 y2 = _mm256_mul_ps(y, two);
+        __m256 z2 = _mm256_mul_ps(z, two);
+        __m256 xx = _mm256_mul_ps(x, x2), yy = _mm256_mul_ps(y, y2);
+        __m256 zz = _mm256_mul_ps(z, z2), xy = _mm256_mul_ps(x, y2);
+        __m256 xz = _mm256_mul_ps(x, z2), yz = _mm256_mul_ps(y, z2);
+        __m256 wx = _mm256_mul_ps(w, x2), wy = _mm256_mul_ps(w, y2);
+        __m256 wz = _mm256_mul_ps(w, z2);
+
+        __m256 sx = _mm256_loadu_ps(columns.scaleX + i);
+        __m256 sy = _mm256_loadu_ps(columns.scaleY + i);
+        __m256 sz = _mm256_loadu_ps(columns.scaleZ + i);
+
+        __m256 world[4][3] = {
+            {_mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), sx),
+             _mm256_mul_ps(_mm256_add_ps(xy, wz), sx),
+             _mm256_mul_ps(_mm256_sub_ps(xz, wy), sx)},
+            {_mm256_mul_ps(_mm256_sub_ps(xy, wz), sy),
+             _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, zz)), sy),
+             _mm256_mul_ps(_mm256_add_ps(yz, wx), sy)},
+            {_mm256_mul_ps(_mm256_add_ps(xz, wy), sz),
+             _mm256_mul_ps(_mm256_sub_ps(yz, wx), sz),
+             _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, yy)), sz)},
+            {_mm256_loadu_ps(columns.positionX + i),
+             _mm256_loadu_ps(columns.positionY + i),
+             _mm256_loadu_ps(columns.positionZ + i)},
+        };
+
+        for (int column = 0; column < 4; column++)
+        {
+            __m256 rows[4];
+            for (int row = 0; row < 4; row++)
+            {
+                __m256 value = column == 3 ? vp[12 + row]
+                                           : _mm256_setzero_ps();
+                value = _mm256_fmadd_ps(vp[row], world[column][0], value);
+                value = _mm256_fmadd_ps(vp[4 + row], world[column][1], value);
+                rows[row] =
+                    _mm256_fmadd_ps(vp[8 + row], world[column][2], value);
+            }
+
+            // 4x4 transposes within each 128 bit half: the low half holds
+            // objects 0-3, the high half objects 4-7.
+            __m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+            __m256 t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+            __m256 t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+            __m256 t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+            __m256 objects[4] = {
+                _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)),
+                _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)),
+                _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)),
+                _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2)),
+            };
+
+            for (int object = 0; object < 4; object++)
+            {
+                float *low = out + object * 16 + column * 4;
+                _mm_stream_ps(low, _mm256_castps256_ps128(objects[object]));
+                _mm_stream_ps(low + 64,
+                              _mm256_extractf128_ps(objects[object], 1));
+            }
+        }
+    }
+
+    computeMvpsScalar(columns, viewProjection, i, end - i, out);
+    _mm_sfence();
+}
+
+#endif // TRANSFORM_SIMD
+
+TransformKernel getBestTransformKernel()
+{
+#ifdef TRANSFORM_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return TransformKernel::Avx2;
+    return TransformKernel::Sse;
+#else
+    return TransformKernel::Scalar;
+#endif
+}
+
+TransformSystem::TransformSystem() : kernel(getBestTransformKernel()) {}
+
+uint32_t TransformSystem::add(const glm::vec3 &position,
+                              const glm::quat &rotation,
+                              const glm::vec3 &scale)
+{
+    positionX.push_back(position.x);
+    positionY.push_back(position.y);
+    positionZ.push_back(position.z);
+    rotationX.push_back(rotation.x);
+    rotationY.push_back(rotation.y);
+    rotationZ.push_back(rotation.z);
+    rotationW.push_back(rotation.w);
+    scaleX.push_back(scale.x);
+    scaleY.push_back(scale.y);
+    scaleZ.push_back(scale.z);
+
+    return size() - 1;
+}
+
+void TransformSystem::remove(uint32_t index)
+{
+    // Swap with the last one, the caller fixes up whatever referenced it.
+    std::vector<float> *columns[] = {&positionX,
+                                     &positionY,
+                                     &positionZ,
+                                     &rotationX,
+                                     &rotationY,
+                                     &rotationZ,
+                                     &rotationW,
+                                     &scaleX,
+                                     &scaleY,
+                                     &scaleZ};
+    for (std::vector<float> *column : columns)
+    {
+        (*column)[index] = column->back();
+        column->pop_back();
+    }
+}
+
+void TransformSystem::clear()
+{
+    std::vector<float> *columns[] = {&positionX,
+                                     &positionY,
+                                     &positionZ,
+                                     &rotationX,
+                                     &rotationY,
+                                     &rotationZ,
+                                     &rotationW,
+                                     &scaleX,
+                                     &scaleY,
+                                     &scaleZ};
+    for (std::vector<float> *column : columns)
+        column->clear();
+}
+
+void TransformSystem::setPosition(uint32_t index, const glm::vec3 &position)
+{
+    positionX[index] = position.x;
+    positionY[index] = position.y;
+    positionZ[index] = position.z;
+}
+
+void TransformSystem::setRotation(uint32_t index, const glm::quat &rotation)
+{
+    rotationX[index] = rotation.x;
+    rotationY[index] = rotation.y;
+    rotationZ[index] = rotation.z;
+    rotationW[index] = rotation.w;
+}
+
+void TransformSystem::setScale(uint32_t index, const glm::vec3 &scale)
+{
+    scaleX[index] = scale.x;
+    scaleY[index] = scale.y;
+    scaleZ[index] = scale.z;
+}
+
+void TransformSystem::setKernel(TransformKernel kernel)
+{
+    // Never pick something the CPU can not run.
+    this->kernel = std::min(kernel, getBestTransformKernel());
+}
+
+float TransformSystem::getMaxScale(uint32_t index) const
+{
+    return std::max({scaleX[index], scaleY[index], scaleZ[index]});
+}
+
+void TransformSystem::computeMvps(const glm::mat4 &viewProjection,
+                                  uint32_t first,
+                                  uint32_t count,
+                                  glm::mat4 *out) const
+{
+    TransformColumns columns = {positionX.data(),
+                                positionY.data(),
+                                positionZ.data(),
+                                rotationX.data(),
+                                rotationY.data(),
+                                rotationZ.data(),
+                                rotationW.data(),
+                                scaleX.data(),
+                                scaleY.data(),
+                                scaleZ.data()};
+
+    TransformKernelFunction function = computeMvpsScalar;
+#ifdef TRANSFORM_SIMD
+    // Non-temporal stores need 16 byte alignment.
+    bool aligned = (reinterpret_cast<uintptr_t>(out) & 15) == 0;
+    if (aligned && kernel == TransformKernel::Avx2)
+        function = computeMvpsAvx2;
+    else if (aligned && kernel == TransformKernel::Sse)
+        function = computeMvpsSse;
+#endif
+
+    function(columns,
+             &viewProjection[0][0],
+             first,
+             count,
+             reinterpret_cast<float *>(out));
+}
@@ -0,0 +1,78 @@
+#ifndef TRANSFORM_SYSTEM_H
+#define TRANSFORM_SYSTEM_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class TransformKernel
+{
+    Scalar,
+    Sse,
+    Avx2
+};
+
+const char *getTransformKernelName(TransformKernel kernel);
+
+// Translation, rotation and scale of many objects stored as SoA columns, so
+// the matrix kernels can load the same component of 4 or 8 objects at once.
+class TransformSystem
+{
+  public:
+    TransformSystem();
+    uint32_t add(const glm::vec3 &position,
+                 const glm::quat &rotation,
+                 const glm::vec3 &scale);
+    void remove(uint32_t index);
+    void clear();
+    void setPosition(uint32_t index, const glm::vec3 &position);
+    void setRotation(uint32_t index, const glm::quat &rotation);
+    void setScale(uint32_t index, const glm::vec3 &scale);
+    // Writes viewProjection * translate * rotate * scale for count objects
+    // starting at first. out is usually mapped GPU memory: it is only
+    // written, never read, and with non-temporal stores when 16 byte
+    // aligned.
+    void computeMvps(const glm::mat4 &viewProjection,
+                     uint32_t first,
+                     uint32_t count,
+                     glm::mat4 *out) const;
+    // Defaults to the best one the CPU supports.
+    void setKernel(TransformKernel kernel);
+
+  public:
+    uint32_t size() const { return static_cast<uint32_t>(positionX.size()); }
+    TransformKernel getKernel() const { return kernel; }
+    const float *getPositionsX() const { return positionX.data(); }
+    const float *getPositionsY() const { return positionY.data(); }
+    const float *getPositionsZ() const { return positionZ.data(); }
+    const float *getRotationsX() const { return rotationX.data(); }
+    const float *getRotationsY() const { return rotationY.data(); }
+    const float *getRotationsZ() const { return rotationZ.data(); }
+    const float *getRotationsW() const { return rotationW.data(); }
+    const float *getScalesX() const { return scaleX.data(); }
+    const float *getScalesY() const { return scaleY.data(); }
+    const float *getScalesZ() const { return scaleZ.data(); }
+    // Largest of the three scale components, what bounding spheres scale by.
+    float getMaxScale(uint32_t index) const;
+
+  private:
+    TransformKernel kernel;
+
+    std::vector<float> positionX;
+    std::vector<float> positionY;
+    std::vector<float> positionZ;
+    std::vector<float> rotationX;
+    std::vector<float> rotationY;
+    std::vector<float> rotationZ;
+    std::vector<float> rotationW;
+    std::vector<float> scaleX;
+    std::vector<float> scaleY;
+    std::vector<float> scaleZ;
+};
+
+TransformKernel getBestTransformKernel();
+
+#endif // TRANSFORM_SYSTEM_H
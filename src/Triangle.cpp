@@ -1,44 +1,93 @@
 #include <vulkan/vulkan.h>
 
+#include "AssetLoader.h"
 #include "VulkanContext.h"
+#include "config.h"
+#include "utils.h"
 
 #include "Triangle.h"
 
+const char *const Triangle::ASSET_PATH = MESHES_DIR "/triangle.mesh";
+
 Triangle::Triangle(VulkanContext *context) : context(context) {}
 
-Triangle::~Triangle()
+void Triangle::init()
 {
-    VkDevice device = context->getDevice();
-
-    vkDestroyBuffer(device, vertexBuffer, nullptr);
-    vkFreeMemory(device, vertexBufferMemory, nullptr);
+    decode(readFile(ASSET_PATH));
+    createVertexBuffer();
+    createIndexBuffer();
+}
 
-    vkDestroyBuffer(device, indexBuffer, nullptr);
-    vkFreeMemory(device, indexBufferMemory, nullptr);
+void Triangle::decode(const std::vector<char> &bytes)
+{
+    readMeshAsset(bytes, mesh);
 }
 
-void Triangle::init()
+void Triangle::prepareUpload(std::vector<AssetUpload> &uploads)
 {
-    createVertexBuffer();
-    createIndexBuffer();
+    const VulkanBufferCreator &bufferCreator = context->getBufferCreator();
+
+    VkBuffer buffer;
+    VkDeviceMemory memory;
+
+    VkDeviceSize vertexSize =
+        sizeof(mesh.vertices[0]) * mesh.vertices.size();
+    bufferCreator.createBuffer(
+        vertexSize,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        MemoryCategory::Geometry,
+        buffer,
+        memory);
+    adoptBuffer(buffer, memory, vertexBuffer, vertexBufferMemory);
+    uploads.push_back({mesh.vertices.data(), vertexSize, buffer, 0});
+
+    VkDeviceSize indexSize = sizeof(mesh.indices[0]) * mesh.indices.size();
+    bufferCreator.createBuffer(
+        indexSize,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        MemoryCategory::Geometry,
+        buffer,
+        memory);
+    adoptBuffer(buffer, memory, indexBuffer, indexBufferMemory);
+    uploads.push_back({mesh.indices.data(), indexSize, buffer, 0});
 }
 
 void Triangle::createVertexBuffer()
 {
+    VkBuffer buffer;
+    VkDeviceMemory memory;
     context->getBufferCreator().createStagingBuffer(
-        vertices.data(),
-        sizeof(vertices[0]) * vertices.size(),
+        mesh.vertices.data(),
+        sizeof(mesh.vertices[0]) * mesh.vertices.size(),
         VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        vertexBuffer,
-        vertexBufferMemory);
+        MemoryCategory::Geometry,
+        buffer,
+        memory);
+    adoptBuffer(buffer, memory, vertexBuffer, vertexBufferMemory);
 }
 
 void Triangle::createIndexBuffer()
 {
+    VkBuffer buffer;
+    VkDeviceMemory memory;
     context->getBufferCreator().createStagingBuffer(
-        indices.data(),
-        sizeof(indices[0]) * indices.size(),
+        mesh.indices.data(),
+        sizeof(mesh.indices[0]) * mesh.indices.size(),
         VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-        indexBuffer,
-        indexBufferMemory);
+        MemoryCategory::Geometry,
+        buffer,
+        memory);
+    adoptBuffer(buffer, memory, indexBuffer, indexBufferMemory);
+}
+
+void Triangle::adoptBuffer(VkBuffer buffer,
+                           VkDeviceMemory memory,
+                           UniqueBuffer &ownedBuffer,
+                           UniqueDeviceMemory &ownedMemory)
+{
+    RetirementQueue &retirementQueue = context->getRetirementQueue();
+    ownedBuffer = UniqueBuffer(retirementQueue, buffer);
+    ownedMemory = UniqueDeviceMemory(retirementQueue, memory);
 }
@@ -3,45 +3,55 @@
 
 #include <vector>
 
+#include "MeshAsset.h"
+#include "RetirementQueue.h"
 #include "VulkanTypes.h"
 
 class Triangle
 {
   public:
+    // The mesh baked at build time, see tools/MeshBaker.cpp.
+    static const char *const ASSET_PATH;
+
     Triangle(VulkanContext *context);
-    ~Triangle();
+    // Loads and uploads synchronously.
     void init();
+    // CPU side only, parses the baked mesh. Safe on any thread.
+    void decode(const std::vector<char> &bytes);
+    // Creates the device local buffers and lists the copies filling them,
+    // for the asset loader's upload stage.
+    void prepareUpload(std::vector<AssetUpload> &uploads);
 
   private:
     void createVertexBuffer();
     void createIndexBuffer();
+    void adoptBuffer(VkBuffer buffer,
+                     VkDeviceMemory memory,
+                     UniqueBuffer &ownedBuffer,
+                     UniqueDeviceMemory &ownedMemory);
 
   public:
     VkBuffer getVertexBuffer() const { return vertexBuffer; }
     uint32_t getVertexCount() const
     {
-        return static_cast<uint32_t>(vertices.size());
+        return static_cast<uint32_t>(mesh.vertices.size());
     }
     VkBuffer getIndexBuffer() const { return indexBuffer; }
-    uint32_t getIndexCount() const
-    {
-        return static_cast<uint32_t>(indices.size());
-    }
+    const MeshLod &getLod(uint32_t lod) const { return mesh.lods[lod]; }
+    const std::vector<MeshLod> &getLods() const { return mesh.lods; }
+    float getBoundingRadius() const { return mesh.boundingRadius; }
 
   private:
     VulkanContext *context;
 
-    const std::vector<Vertex> vertices = {{{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}},
-                                          {{0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}},
-                                          {{0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}},
-                                          {{-0.5f, 0.5f}, {0.0f, 1.0f, 0.0f}}};
-
-    const std::vector<uint16_t> indices = {0, 1, 2, 2, 3, 0};
+    MeshAsset mesh;
 
-    VkBuffer vertexBuffer;
-    VkDeviceMemory vertexBufferMemory;
-    VkBuffer indexBuffer;
-    VkDeviceMemory indexBufferMemory;
+    // Retired when the triangle goes away, frames in flight may still draw
+    // it. Memory first, so each buffer is retired before its memory.
+    UniqueDeviceMemory vertexBufferMemory;
+    UniqueBuffer vertexBuffer;
+    UniqueDeviceMemory indexBufferMemory;
+    UniqueBuffer indexBuffer;
 };
 
 #endif // TRIANGLE_H
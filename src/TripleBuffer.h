@@ -0,0 +1,54 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Single producer, single consumer exchange of whole values. The writer
+// fills its own slot and publishes it, the reader picks up the latest
+// published slot; neither ever waits on the other. Values the reader never
+// saw are dropped.
+template <typename T> class TripleBuffer
+{
+  public:
+    TripleBuffer() : shared(1), writeIndex(0), readIndex(2) {}
+    TripleBuffer(const TripleBuffer &) = delete;
+    TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+    // Writer side. The slot keeps whatever was last written to it, so
+    // assigning over it reuses its allocations.
+    T &getWriteBuffer() { return buffers[writeIndex]; }
+    void publish()
+    {
+        uint8_t previous =
+            shared.exchange(writeIndex | NEW_DATA, std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+    }
+
+    // Reader side. Returns whether a newer value was published since the
+    // last call; the read buffer stays valid until the next one.
+    bool update()
+    {
+        if (!(shared.load(std::memory_order_relaxed) & NEW_DATA))
+            return false;
+
+        uint8_t previous =
+            shared.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & INDEX_MASK;
+        return true;
+    }
+    T &getReadBuffer() { return buffers[readIndex]; }
+
+  private:
+    static const uint8_t INDEX_MASK = 0x3;
+    static const uint8_t NEW_DATA = 0x4;
+
+    T buffers[3];
+    // Index of the slot in between, plus NEW_DATA while the reader has not
+    // taken it.
+    alignas(64) std::atomic<uint8_t> shared;
+    alignas(64) uint8_t writeIndex;
+    alignas(64) uint8_t readIndex;
+};
+
+#endif // TRIPLE_BUFFER_H
@@ -1,8 +1,104 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include "Profiler.h"
+#include "config.h"
+
 #include "VulkanApp.h"
 
-VulkanApp::VulkanApp() : triangle(&context) {}
+typedef std::chrono::steady_clock Clock;
+
+// Simulation steps per second, independent of the presentation rate.
+static const double SIMULATION_RATE = 120.0;
+static const Clock::duration TICK_DURATION =
+    std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / SIMULATION_RATE));
+// Seconds an idle on demand loop waits for events. Asset completions don't
+// post one, this bounds how late they show up.
+static const double IDLE_EVENT_TIMEOUT = 0.1;
+// Baked at build time, see tools/TextureBaker.cpp.
+static const char *const CHECKER_TEXTURE_PATH =
+    TEXTURES_DIR "/checker.texture";
+
+// Sets value from the environment variable name when that holds a number
+// of at least minValue. Anything else is reported and ignored, a typo
+// shouldn't keep the app from starting.
+template <typename T>
+static void getEnvNumber(const char *name, T minValue, T &value)
+{
+    const char *text = std::getenv(name);
+    if (!text)
+        return;
+
+    char *end;
+    errno = 0;
+    double number = std::strtod(text, &end);
+    // Written so that NaN fails too.
+    bool inRange =
+        number >= minValue && number <= std::numeric_limits<T>::max();
+    if (end == text || *end != '\0' || errno == ERANGE || !inRange)
+    {
+        std::cerr << "Ignoring " << name << "=\"" << text
+                  << "\", expected a number of at least " << minValue
+                  << std::endl;
+        return;
+    }
+
+    value = static_cast<T>(number);
+}
+
+static ContextConfig getConfig()
+{
+    ContextConfig config;
+
+    // Records every presented frame, see ContextConfig::capturePath.
+    if (const char *capturePath = std::getenv("VULKAN_HACK_WEEK_CAPTURE"))
+        config.capturePath = capturePath;
+
+    // Dynamic resolution, see ContextConfig::minResolutionScale.
+    getEnvNumber(
+        "VULKAN_HACK_WEEK_MIN_SCALE", 0.0f, config.minResolutionScale);
+    getEnvNumber("VULKAN_HACK_WEEK_GPU_BUDGET", 0.1f, config.gpuBudgetMs);
+
+    // Frame time rollups, see ContextConfig::statsPath.
+    if (const char *statsPath = std::getenv("VULKAN_HACK_WEEK_STATS"))
+        config.statsPath = statsPath;
+    if (const char *statsName = std::getenv("VULKAN_HACK_WEEK_STATS_SHM"))
+        config.statsSharedMemory = statsName;
 
-VulkanApp::~VulkanApp() {}
+    // Frame recording, see ContextConfig::recordPath.
+    if (const char *recordPath = std::getenv("VULKAN_HACK_WEEK_RECORD"))
+        config.recordPath = recordPath;
+
+    return config;
+}
+
+VulkanApp::VulkanApp() : VulkanApp(getConfig())
+{
+}
+
+VulkanApp::VulkanApp(const ContextConfig &config)
+    : context(config),
+      triangle(&context),
+      running(false),
+      onDemand(false),
+      sceneDirty(false),
+      animating(true),
+      frameRequested(false),
+      assetsReported(false)
+{
+}
+
+VulkanApp::~VulkanApp()
+{
+    if (Profiler::isEnabled())
+        writeTrace();
+}
 
 void VulkanApp::run()
 {
@@ -10,19 +106,345 @@ void VulkanApp::run()
     mainLoop();
 }
 
+void VulkanApp::step()
+{
+    simulate();
+    renderFrame();
+}
+
 void VulkanApp::init()
 {
     context.init();
-    triangle.init();
+
+    // Rendering starts right away, the mesh shows up once it streamed in.
+    AssetRequest request;
+    request.path = Triangle::ASSET_PATH;
+    request.decode = [this](std::vector<char> &bytes) {
+        triangle.decode(bytes);
+    };
+    request.prepareUpload = [this](std::vector<AssetUpload> &uploads) {
+        triangle.prepareUpload(uploads);
+    };
+    request.onLoaded = [this]() {
+        MeshHandle mesh = scene.addMesh(&triangle);
+        scene.create(mesh,
+                     glm::vec3(0.0f),
+                     glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                     glm::vec3(1.0f),
+                     0);
+        sceneDirty = true;
+    };
+    context.getAssetLoader().load(request);
+
+    // Draws sample white until the texture streams in, mip tail first.
+    AssetRequest textureRequest;
+    textureRequest.path = CHECKER_TEXTURE_PATH;
+    textureRequest.decode = [this](std::vector<char> &bytes) {
+        readTextureAsset(bytes, checkerTexture);
+    };
+    // The texture manager keeps its own copy and streams it, nothing goes
+    // through the loader's staging ring.
+    textureRequest.prepareUpload = [this](std::vector<AssetUpload> &) {
+        TextureHandle texture = context.getTextureManager().createTexture(
+            checkerTexture.pixels.data(),
+            checkerTexture.width,
+            checkerTexture.height);
+        context.getPipeline().setTexture(texture);
+    };
+    textureRequest.onLoaded = [this]() {
+        checkerTexture = TextureAsset();
+        sceneDirty = true;
+    };
+    context.getAssetLoader().load(textureRequest);
+
+    // Redraws only on input, resizes, scene changes and animation, for
+    // displays that mostly show the same frame. Starts with the animation
+    // stopped, so it idles until asked for something.
+    if (const char *onDemandMode = std::getenv("VULKAN_HACK_WEEK_ON_DEMAND"))
+        onDemand = std::string(onDemandMode) != "0";
+    animating = !onDemand;
+    clock.setPaused(!animating);
+
+    // Frames per second the render thread never exceeds, in either mode.
+    double maxFrameRate = 0.0;
+    getEnvNumber("VULKAN_HACK_WEEK_MAX_FPS", 0.0, maxFrameRate);
+    framePacer.setMaxRate(maxFrameRate);
+
+    // Animates exactly one simulation step per update instead of following
+    // the clock, so a run shows the same frames whatever its timing.
+    if (const char *fixedStep = std::getenv("VULKAN_HACK_WEEK_FIXED_STEP"))
+    {
+        if (std::string(fixedStep) != "0")
+            clock.setFixedStep(1.0 / SIMULATION_RATE);
+    }
+
+    const std::string &recordPath = context.getConfig().recordPath;
+    if (!recordPath.empty())
+        recorder = std::make_unique<FrameRecorder>(recordPath);
+
+    // Seconds between device memory statistics dumps.
+    float memoryLogInterval = 0.0f;
+    getEnvNumber("VULKAN_HACK_WEEK_MEMORY_LOG", 0.0f, memoryLogInterval);
+    context.getMemoryTracker().setLogInterval(memoryLogInterval);
+
+    // Path of the Chrome trace written at exit and when pressing F12.
+    if (const char *tracePath = std::getenv("VULKAN_HACK_WEEK_TRACE"))
+    {
+        Profiler::setThreadName("main");
+        Profiler::setOutputPath(tracePath);
+        std::cout << "Profiler zone overhead: "
+                  << Profiler::measureZoneOverhead() << " ns" << std::endl;
+        Profiler::setEnabled(true);
+    }
+    context.getWindow().setKeyHandler([this](int key, int action) {
+        if (action != GLFW_PRESS)
+            return;
+        if (key == GLFW_KEY_SPACE)
+        {
+            animating = !animating;
+            clock.setPaused(!animating);
+        }
+        else if (key == GLFW_KEY_F12 && Profiler::isEnabled())
+        {
+            writeTrace();
+        }
+    });
 }
 
 void VulkanApp::mainLoop()
 {
+    // The renderer always has a complete snapshot to draw.
+    update();
+    publishSnapshot();
+    // Drawn even on demand.
+    frameRequested = true;
+
+    running = true;
+    renderThread = std::thread(&VulkanApp::renderLoop, this);
+
+    Clock::time_point nextTick = Clock::now();
     while (!glfwWindowShouldClose(context.getWindow()))
     {
-        glfwPollEvents();
-        context.getPipeline().drawFrame(triangle);
+        if (onDemand)
+        {
+            waitForChanges(nextTick);
+            continue;
+        }
+
+        {
+            PROFILE_ZONE("glfwPollEvents");
+            glfwPollEvents();
+        }
+        simulate();
+
+        // Skip ticks instead of catching up after a stall.
+        nextTick = std::max(nextTick + TICK_DURATION, Clock::now());
+        std::this_thread::sleep_until(nextTick);
     }
 
+    stopRenderThread();
+
     vkDeviceWaitIdle(context.getDevice());
+    context.getAssetLoader().shutdown();
+
+    if (renderError)
+        std::rethrow_exception(renderError);
+}
+
+void VulkanApp::waitForChanges(Clock::time_point &nextTick)
+{
+    // Animations wake up for their next tick, anything else for events.
+    bool animating = isAnimating();
+    double timeout = IDLE_EVENT_TIMEOUT;
+    if (animating)
+    {
+        std::chrono::duration<double> untilTick = nextTick - Clock::now();
+        timeout = std::clamp(untilTick.count(), 0.0, IDLE_EVENT_TIMEOUT);
+    }
+    {
+        PROFILE_ZONE("glfwWaitEventsTimeout");
+        glfwWaitEventsTimeout(timeout);
+    }
+
+    VulkanWindow &window = context.getWindow();
+    bool changed = window.consumeRedrawRequest();
+
+    // Completions may change the scene, see sceneDirty.
+    dispatchAssets();
+    changed = changed || sceneDirty;
+    sceneDirty = false;
+
+    Clock::time_point now = Clock::now();
+    if (animating && now >= nextTick)
+    {
+        nextTick = std::max(nextTick + TICK_DURATION, now);
+        changed = true;
+    }
+
+    if (!changed)
+        return;
+
+    {
+        PROFILE_ZONE("simulate");
+        update();
+        publishSnapshot();
+    }
+    requestFrame();
+}
+
+void VulkanApp::simulate()
+{
+    PROFILE_ZONE("simulate");
+    dispatchAssets();
+    update();
+    publishSnapshot();
+}
+
+void VulkanApp::renderLoop()
+{
+    if (Profiler::isEnabled())
+        Profiler::setThreadName("render");
+
+    bool firstFrame = true;
+    try
+    {
+        while (running)
+        {
+            if (onDemand && !waitForFrameRequest())
+                break;
+            framePacer.wait();
+
+            bool presented = renderFrame();
+            // The swap chain was recreated, the frame is still owed.
+            if (!presented && onDemand)
+                requestFrame();
+
+            if (firstFrame)
+            {
+                firstFrame = false;
+                StartupReport &startupReport = context.getStartupReport();
+                startupReport.setFirstFrame(Profiler::now());
+                startupReport.print(std::cout);
+            }
+        }
+    }
+    catch (...)
+    {
+        renderError = std::current_exception();
+        glfwSetWindowShouldClose(context.getWindow(), GLFW_TRUE);
+        // The main thread may be waiting for events.
+        glfwPostEmptyEvent();
+    }
+}
+
+bool VulkanApp::renderFrame()
+{
+    PROFILE_ZONE("frame");
+
+    // Without a new snapshot the last one is drawn again.
+    snapshots.update();
+    FrameSnapshot &snapshot = snapshots.getReadBuffer();
+
+    // The slot is ours until the next update, and the swap chain is only
+    // known here.
+    const VkExtent2D &extent = context.getSwapChain().getExtent();
+    snapshot.camera.setAspect(static_cast<float>(extent.width) /
+                              static_cast<float>(extent.height));
+
+    if (recorder)
+        recorder->write(snapshot.scene, snapshot.camera);
+
+    return context.getPipeline().drawFrame(snapshot.scene, snapshot.camera);
+}
+
+void VulkanApp::requestFrame()
+{
+    {
+        std::lock_guard<std::mutex> lock(frameRequestMutex);
+        frameRequested = true;
+    }
+    frameRequestCondition.notify_one();
+}
+
+bool VulkanApp::waitForFrameRequest()
+{
+    PROFILE_ZONE("waitForFrameRequest");
+
+    std::unique_lock<std::mutex> lock(frameRequestMutex);
+    // Idling isn't stuttering, the time spent waiting for a request
+    // doesn't count as a frame interval.
+    if (!frameRequested)
+        context.getFrameMonitor().skipInterval();
+    frameRequestCondition.wait(lock,
+                               [this]() { return frameRequested || !running; });
+    frameRequested = false;
+    return running;
+}
+
+void VulkanApp::stopRenderThread()
+{
+    {
+        // Under the lock, or the render thread could miss the wakeup.
+        std::lock_guard<std::mutex> lock(frameRequestMutex);
+        running = false;
+    }
+    frameRequestCondition.notify_one();
+    renderThread.join();
+}
+
+bool VulkanApp::isAnimating() const
+{
+    // Nothing else moves on its own.
+    return animating && scene.size() > 0;
+}
+
+void VulkanApp::update()
+{
+    float time = static_cast<float>(clock.tick());
+    glm::quat rotation = glm::angleAxis(time * glm::radians(90.0f),
+                                        glm::vec3(0.0f, 0.0f, 1.0f));
+    TransformSystem &transforms = scene.getTransforms();
+    for (uint32_t i = 0; i < transforms.size(); i++)
+        transforms.setRotation(i, rotation);
+}
+
+void VulkanApp::dispatchAssets()
+{
+    AssetLoader &assetLoader = context.getAssetLoader();
+    assetLoader.dispatchCompletions();
+
+    if (assetsReported || assetLoader.getPendingCount() > 0)
+        return;
+    assetsReported = true;
+
+    // Busy time per stage, so the rates are what each stage sustains.
+    AssetLoaderStats stats = assetLoader.getStats();
+    auto megabytesPerSecond = [](uint64_t bytes, uint64_t ns) {
+        return ns > 0 ? bytes * 1000.0 / ns : 0.0;
+    };
+    std::cout << "Assets loaded: read " << stats.filesRead << " files at "
+              << megabytesPerSecond(stats.bytesRead, stats.readNs)
+              << " MB/s, decoded " << stats.decoded << " in "
+              << stats.decodeNs / 1e6 << " ms, uploaded " << stats.uploads
+              << " buffers at "
+              << megabytesPerSecond(stats.bytesUploaded, stats.uploadNs)
+              << " MB/s" << std::endl;
+}
+
+void VulkanApp::publishSnapshot()
+{
+    // Assigning keeps the slot's allocations once the scene stops growing.
+    FrameSnapshot &snapshot = snapshots.getWriteBuffer();
+    snapshot.scene = scene;
+    snapshot.camera = camera;
+    snapshots.publish();
+}
+
+void VulkanApp::writeTrace()
+{
+    const std::string &path = Profiler::getOutputPath();
+    if (Profiler::writeChromeTrace(path))
+        std::cout << "Trace written to " << path << std::endl;
+    else
+        std::cerr << "Failed to write trace to " << path << std::endl;
 }
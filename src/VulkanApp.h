@@ -1,22 +1,105 @@
 #ifndef VULKAN_APP_H
 #define VULKAN_APP_H
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "Camera.h"
+#include "FrameClock.h"
+#include "FramePacer.h"
+#include "FrameRecording.h"
+#include "Scene.h"
+#include "TextureAsset.h"
+#include "TripleBuffer.h"
 #include "Triangle.h"
 #include "VulkanContext.h"
 
+// Everything the render thread needs to draw one frame, copied out of the
+// simulation once per tick.
+struct FrameSnapshot
+{
+    Scene scene;
+    Camera camera;
+};
+
 class VulkanApp
 {
   public:
+    // Configured from the VULKAN_HACK_WEEK_* environment variables.
     VulkanApp();
+    explicit VulkanApp(const ContextConfig &config);
     ~VulkanApp();
+    // init(), then both loops until the window closes.
     void run();
+    void init();
+    // One iteration of both loops on the calling thread, without pacing:
+    // simulates, publishes the snapshot and draws it. For benchmarks that
+    // drive the app themselves, never while run() is.
+    void step();
+
+  public:
+    const VulkanContext &getContext() const { return context; }
+    // The simulation's, changed by the asset completions in step().
+    const Scene &getScene() const { return scene; }
+    Scene &getScene() { return scene; }
 
   private:
-    void init();
+    static void writeTrace();
+    // Polls events and steps the simulation on the main thread, GLFW
+    // requires both there.
     void mainLoop();
+    // Blocks until an event or the next animation tick, and steps the
+    // simulation only when something may have changed what is shown.
+    void waitForChanges(std::chrono::steady_clock::time_point &nextTick);
+    void simulate();
+    void renderLoop();
+    // Draws the latest snapshot, returns whether it was presented.
+    bool renderFrame();
+    void requestFrame();
+    // Returns false once the app stops instead.
+    bool waitForFrameRequest();
+    void stopRenderThread();
+    bool isAnimating() const;
+    void update();
+    // Runs the asset completions on the simulation thread.
+    void dispatchAssets();
+    void publishSnapshot();
 
   private:
     VulkanContext context;
     Triangle triangle;
+    // Decoded on a worker, copied by the texture manager on the render
+    // thread.
+    TextureAsset checkerTexture;
+    Scene scene;
+    Camera camera;
+    FrameClock clock;
+
+    TripleBuffer<FrameSnapshot> snapshots;
+    std::thread renderThread;
+    std::atomic<bool> running;
+
+    // Draws only the frames the main thread asks for, see waitForChanges.
+    bool onDemand;
+    // Set by the simulation thread when the scene changed outside update().
+    bool sceneDirty;
+    // Whether update() spins the objects, toggled with space. On demand
+    // loops only tick while it is set.
+    bool animating;
+    std::mutex frameRequestMutex;
+    std::condition_variable frameRequestCondition;
+    bool frameRequested;
+    // Only used by the render thread.
+    FramePacer framePacer;
+    // Set when recording the drawn frames, render thread only too.
+    std::unique_ptr<FrameRecorder> recorder;
+    // Rethrown on the main thread once the render thread stopped.
+    std::exception_ptr renderError;
+    bool assetsReported;
 };
 #endif // VULKAN_APP_H
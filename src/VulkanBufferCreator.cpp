@@ -4,6 +4,7 @@
 #include <cstring>
 #include <iostream>
 
+#include "HostAllocator.h"
 #include "VulkanContext.h"
 
 #include "VulkanBufferCreator.h"
@@ -15,7 +16,9 @@ VulkanBufferCreator::VulkanBufferCreator(VulkanContext *context)
 
 VulkanBufferCreator::~VulkanBufferCreator()
 {
-    vkDestroyCommandPool(context->getDevice(), commandPool, nullptr);
+    vkDestroyCommandPool(context->getDevice(),
+                         commandPool,
+                         HostAllocator::get(HostAllocationTag::Commands));
 }
 
 void VulkanBufferCreator::init()
@@ -27,6 +30,7 @@ void VulkanBufferCreator::createStagingBuffer(
     const void *bytes,
     VkDeviceSize size,
     VkBufferUsageFlags usage,
+    MemoryCategory category,
     VkBuffer &buffer,
     VkDeviceMemory &bufferMemory) const
 {
@@ -36,6 +40,7 @@ void VulkanBufferCreator::createStagingBuffer(
                  VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
                      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                 MemoryCategory::Staging,
                  stagingBuffer,
                  stagingBufferMemory);
 
@@ -48,18 +53,22 @@ void VulkanBufferCreator::createStagingBuffer(
     createBuffer(size,
                  VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage,
                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                 category,
                  buffer,
                  bufferMemory);
 
     copyBuffer(stagingBuffer, buffer, size);
 
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    vkDestroyBuffer(device,
+                    stagingBuffer,
+                    HostAllocator::get(HostAllocationTag::Buffers));
+    freeMemory(stagingBufferMemory);
 }
 
 void VulkanBufferCreator::createBuffer(VkDeviceSize size,
                                        VkBufferUsageFlags usage,
                                        VkMemoryPropertyFlags properties,
+                                       MemoryCategory category,
                                        VkBuffer &buffer,
                                        VkDeviceMemory &bufferMemory) const
 {
@@ -70,7 +79,11 @@ void VulkanBufferCreator::createBuffer(VkDeviceSize size,
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
     const VulkanDevice &device = context->getDevice();
-    VkResult result = vkCreateBuffer(device, &bufferInfo, nullptr, &buffer);
+    VkResult result =
+        vkCreateBuffer(device,
+                       &bufferInfo,
+                       HostAllocator::get(HostAllocationTag::Buffers),
+                       &buffer);
     if (result != VK_SUCCESS)
     {
         std::string errorMsg("Failed to create buffer: ");
@@ -81,21 +94,166 @@ void VulkanBufferCreator::createBuffer(VkDeviceSize size,
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
 
+    allocateMemory(memRequirements, size, properties, category, bufferMemory);
+
+    vkBindBufferMemory(device, buffer, bufferMemory, 0);
+}
+
+void VulkanBufferCreator::createImage(uint32_t width,
+                                      uint32_t height,
+                                      uint32_t mipLevels,
+                                      VkSampleCountFlagBits samples,
+                                      VkFormat format,
+                                      VkImageUsageFlags usage,
+                                      VkMemoryPropertyFlags properties,
+                                      MemoryCategory category,
+                                      VkImage &image,
+                                      VkDeviceMemory &imageMemory) const
+{
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent.width = width;
+    imageInfo.extent.height = height;
+    imageInfo.extent.depth = 1;
+    imageInfo.mipLevels = mipLevels;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = format;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = usage;
+    imageInfo.samples = samples;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    const VulkanDevice &device = context->getDevice();
+    VkResult result =
+        vkCreateImage(device,
+                      &imageInfo,
+                      HostAllocator::get(HostAllocationTag::Images),
+                      &image);
+    if (result != VK_SUCCESS)
+    {
+        std::string errorMsg("Failed to create image: ");
+        errorMsg.append(string_VkResult(result));
+        throw std::runtime_error(errorMsg);
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device, image, &memRequirements);
+
+    // Tiled GPUs keep such attachments in tile memory and never commit
+    // the pages.
+    VkMemoryPropertyFlags lazyProperties =
+        properties | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+    if ((usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) &&
+        hasMemoryType(memRequirements.memoryTypeBits, lazyProperties))
+    {
+        properties = lazyProperties;
+    }
+
+    allocateMemory(memRequirements,
+                   memRequirements.size,
+                   properties,
+                   category,
+                   imageMemory);
+
+    vkBindImageMemory(device, image, imageMemory, 0);
+}
+
+void VulkanBufferCreator::allocateMemory(
+    const VkMemoryRequirements &memRequirements,
+    VkDeviceSize requestedSize,
+    VkMemoryPropertyFlags properties,
+    MemoryCategory category,
+    VkDeviceMemory &memory) const
+{
     VkMemoryAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
     allocInfo.allocationSize = memRequirements.size;
     allocInfo.memoryTypeIndex =
         findMemoryType(memRequirements.memoryTypeBits, properties);
 
-    result = vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory);
+    VkResult result =
+        vkAllocateMemory(context->getDevice(),
+                         &allocInfo,
+                         HostAllocator::get(HostAllocationTag::DeviceMemory),
+                         &memory);
     if (result != VK_SUCCESS)
     {
-        std::string errorMsg("Failed to allocate buffer memory: ");
+        std::string errorMsg("Failed to allocate ");
+        errorMsg.append(getMemoryCategoryName(category));
+        errorMsg.append(" memory: ");
         errorMsg.append(string_VkResult(result));
         throw std::runtime_error(errorMsg);
     }
 
-    vkBindBufferMemory(device, buffer, bufferMemory, 0);
+    context->getMemoryTracker().recordAllocation(memory,
+                                                 allocInfo.memoryTypeIndex,
+                                                 allocInfo.allocationSize,
+                                                 requestedSize,
+                                                 category);
+}
+
+void VulkanBufferCreator::freeMemory(VkDeviceMemory memory) const
+{
+    context->getMemoryTracker().recordFree(memory);
+    vkFreeMemory(context->getDevice(),
+                 memory,
+                 HostAllocator::get(HostAllocationTag::DeviceMemory));
+}
+
+VkImageView VulkanBufferCreator::createImageView(
+    VkImage image,
+    VkFormat format,
+    VkImageAspectFlags aspectFlags,
+    uint32_t mipLevels) const
+{
+    VkImageViewCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    createInfo.image = image;
+    createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    createInfo.format = format;
+    createInfo.subresourceRange.aspectMask = aspectFlags;
+    createInfo.subresourceRange.baseMipLevel = 0;
+    createInfo.subresourceRange.levelCount = mipLevels;
+    createInfo.subresourceRange.baseArrayLayer = 0;
+    createInfo.subresourceRange.layerCount = 1;
+
+    VkImageView imageView;
+    VkResult result =
+        vkCreateImageView(context->getDevice(),
+                          &createInfo,
+                          HostAllocator::get(HostAllocationTag::Images),
+                          &imageView);
+    if (result != VK_SUCCESS)
+    {
+        std::string errorMsg("Failed to create Image View: ");
+        errorMsg.append(string_VkResult(result));
+        throw std::runtime_error(errorMsg);
+    }
+
+    return imageView;
+}
+
+bool VulkanBufferCreator::hasMemoryType(
+    uint32_t typeFilter,
+    VkMemoryPropertyFlags properties) const
+{
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(
+        context->getDevice().getPhysicalDevice(), &memProperties);
+
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+    {
+        if ((typeFilter & (1 << i)) &&
+            (memProperties.memoryTypes[i].propertyFlags & properties) ==
+                properties)
+        {
+            return true;
+        }
+    }
+
+    return false;
 }
 
 uint32_t VulkanBufferCreator::findMemoryType(
@@ -122,6 +280,19 @@ uint32_t VulkanBufferCreator::findMemoryType(
 void VulkanBufferCreator::copyBuffer(VkBuffer srcBuffer,
                                      VkBuffer dstBuffer,
                                      VkDeviceSize size) const
+{
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+    VkBufferCopy copyRegion{};
+    copyRegion.srcOffset = 0; // Optional
+    copyRegion.dstOffset = 0; // Optional
+    copyRegion.size = size;
+    vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+
+    endSingleTimeCommands(commandBuffer);
+}
+
+VkCommandBuffer VulkanBufferCreator::beginSingleTimeCommands() const
 {
     VkCommandBuffer commandBuffer;
     createCommandBuffers(&commandBuffer, 1);
@@ -132,12 +303,12 @@ void VulkanBufferCreator::copyBuffer(VkBuffer srcBuffer,
 
     vkBeginCommandBuffer(commandBuffer, &beginInfo);
 
-    VkBufferCopy copyRegion{};
-    copyRegion.srcOffset = 0; // Optional
-    copyRegion.dstOffset = 0; // Optional
-    copyRegion.size = size;
-    vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+    return commandBuffer;
+}
 
+void VulkanBufferCreator::endSingleTimeCommands(
+    VkCommandBuffer commandBuffer) const
+{
     vkEndCommandBuffer(commandBuffer);
 
     VkSubmitInfo submitInfo{};
@@ -165,7 +336,10 @@ void VulkanBufferCreator::createCommandPool()
     poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
 
     VkResult result =
-        vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool);
+        vkCreateCommandPool(device,
+                            &poolInfo,
+                            HostAllocator::get(HostAllocationTag::Commands),
+                            &commandPool);
     if (result != VK_SUCCESS)
     {
         std::string errorMsg("Failed to create command pool: ");
@@ -1,6 +1,7 @@
 #ifndef VULKAN_BUFFER_H
 #define VULKAN_BUFFER_H
 
+#include "VulkanMemoryTracker.h"
 #include "VulkanTypes.h"
 
 class VulkanBufferCreator
@@ -12,20 +13,49 @@ class VulkanBufferCreator
     void createStagingBuffer(const void *bytes,
                              VkDeviceSize size,
                              VkBufferUsageFlags usage,
+                             MemoryCategory category,
                              VkBuffer &buffer,
                              VkDeviceMemory &bufferMemory) const;
     void createBuffer(VkDeviceSize size,
                       VkBufferUsageFlags usage,
                       VkMemoryPropertyFlags properties,
+                      MemoryCategory category,
                       VkBuffer &buffer,
                       VkDeviceMemory &bufferMemory) const;
+    // Transient attachments go to lazily allocated memory when the device
+    // has it, on top of the requested properties.
+    void createImage(uint32_t width,
+                     uint32_t height,
+                     uint32_t mipLevels,
+                     VkSampleCountFlagBits samples,
+                     VkFormat format,
+                     VkImageUsageFlags usage,
+                     VkMemoryPropertyFlags properties,
+                     MemoryCategory category,
+                     VkImage &image,
+                     VkDeviceMemory &imageMemory) const;
+    VkImageView createImageView(VkImage image,
+                                VkFormat format,
+                                VkImageAspectFlags aspectFlags,
+                                uint32_t mipLevels) const;
     void createCommandBuffers(VkCommandBuffer *commandBuffers,
                               uint32_t count) const;
+    void freeMemory(VkDeviceMemory memory) const;
+    VkCommandBuffer beginSingleTimeCommands() const;
+    // Submits, waits for the graphics queue to go idle and frees.
+    void endSingleTimeCommands(VkCommandBuffer commandBuffer) const;
 
   private:
     void createCommandPool();
+    void allocateMemory(const VkMemoryRequirements &memRequirements,
+                        VkDeviceSize requestedSize,
+                        VkMemoryPropertyFlags properties,
+                        MemoryCategory category,
+                        VkDeviceMemory &memory) const;
     uint32_t findMemoryType(uint32_t typeFilter,
                             VkMemoryPropertyFlags properties) const;
+    bool hasMemoryType(uint32_t typeFilter,
+                       VkMemoryPropertyFlags properties) const;
     void copyBuffer(VkBuffer srcBuffer,
                     VkBuffer dstBuffer,
                     VkDeviceSize size) const;
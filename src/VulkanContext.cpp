@@ -1,13 +1,29 @@
+#include <exception>
+#include <functional>
 #include <iostream>
 #include <vector>
 #include <vulkan/vk_enum_string_helper.h>
 
+#include "HostAllocator.h"
+#include "Profiler.h"
 #include "VulkanDebugger.h"
 
 #include "VulkanContext.h"
 
-static std::vector<const char *> getRequiredExtensions()
+static std::vector<const char *> getRequiredExtensions(bool headless)
 {
+    if (headless)
+    {
+        std::vector<const char *> extensions = {
+            VK_KHR_SURFACE_EXTENSION_NAME,
+            VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME};
+
+        if (useDebugger)
+            VulkanDebugger::addRequiredExtensions(extensions);
+
+        return extensions;
+    }
+
     uint32_t glfwExtensionCount = 0;
     const char **glfwExtensions =
         glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
@@ -21,9 +37,17 @@ static std::vector<const char *> getRequiredExtensions()
     return extensions;
 }
 
-static VkInstance createInstance()
+static VkInstance createInstance(const ContextConfig &config,
+                                 StartupReport &startupReport)
 {
-    glfwInit();
+    uint64_t begin = Profiler::now();
+
+    // Everything created from here on must be destroyed with the same
+    // callbacks, so this can't change later.
+    HostAllocator::setEnabled(config.hostAllocator);
+
+    if (!config.headless)
+        glfwInit();
 
     VkInstanceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -34,10 +58,10 @@ static VkInstance createInstance()
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "No Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    appInfo.apiVersion = VK_API_VERSION_1_1;
     createInfo.pApplicationInfo = &appInfo;
 
-    auto extensions = getRequiredExtensions();
+    auto extensions = getRequiredExtensions(config.headless);
     createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
     createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -49,7 +73,10 @@ static VkInstance createInstance()
         VulkanDebugger::addValidationLayers(createInfo);
     }
 
-    VkResult result = vkCreateInstance(&createInfo, nullptr, &instance);
+    VkResult result =
+        vkCreateInstance(&createInfo,
+                         HostAllocator::get(HostAllocationTag::Instance),
+                         &instance);
     if (result != VK_SUCCESS)
     {
         std::string errorMsg("Failed to create instance: ");
@@ -60,18 +87,57 @@ static VkInstance createInstance()
     if (useDebugger)
         VulkanDebugger::setupDebugMessenger();
 
+    startupReport.record("instance", begin, Profiler::now());
     return instance;
 }
 
-VulkanContext::VulkanContext()
-    : instance(createInstance()),
+// Startup work handed to the job system. Jobs can't throw, so the error is
+// kept for the thread waiting on it.
+struct StartupTask
+{
+    StartupReport *startupReport;
+    const char *name;
+    std::function<void()> function;
+    // Scheduled after this one, and skipped when it failed: its error is
+    // the one reported.
+    const StartupTask *dependency;
+    std::exception_ptr error;
+};
+
+static void runStartupTask(void *data, uint32_t, uint32_t)
+{
+    StartupTask &task = *static_cast<StartupTask *>(data);
+    if (task.dependency && task.dependency->error)
+        return;
+
+    try
+    {
+        task.startupReport->time(task.name, task.function);
+    }
+    catch (...)
+    {
+        task.error = std::current_exception();
+    }
+}
+
+VulkanContext::VulkanContext(const ContextConfig &config)
+    : config(config),
+      jobSystem(config.workerThreads),
+      frameMonitor(config.statsPath, config.statsSharedMemory),
+      instance(createInstance(config, startupReport)),
       window(VulkanWindow(this)),
       surface(VulkanSurface(this)),
       device(VulkanDevice(this)),
-      swapChain(VulkanSwapChain(this)),
+      memoryTracker(VulkanMemoryTracker(this)),
       bufferCreator(VulkanBufferCreator(this)),
+      retirementQueue(RetirementQueue(this)),
+      swapChain(VulkanSwapChain(this)),
+      textureManager(VulkanTextureManager(this)),
       renderPass(VulkanRenderPass(this)),
-      pipeline(VulkanPipeline(this))
+      pipeline(VulkanPipeline(this)),
+      gpuTimer(VulkanGpuTimer(this)),
+      frameCapture(VulkanFrameCapture(this)),
+      assetLoader(AssetLoader(this))
 {
 }
 
@@ -80,16 +146,73 @@ VulkanContext::~VulkanContext()
     if (useDebugger)
         VulkanDebugger::clear();
 
-    glfwTerminate();
+    if (!config.headless)
+        glfwTerminate();
 }
 
 void VulkanContext::init()
 {
-    window.init();
-    surface.init();
-    device.init();
-    swapChain.init();
-    bufferCreator.init();
-    renderPass.init();
-    pipeline.init();
+    uint64_t begin = Profiler::now();
+
+    // Reading the shaders depends on nothing, building the pipeline only
+    // on the device and render pass: both overlap the swap chain creation.
+    StartupTask shaderTask = {&startupReport,
+                              "shader files",
+                              [this]() { pipeline.loadShaderCode(); },
+                              nullptr,
+                              nullptr};
+    StartupTask pipelineTask = {&startupReport,
+                                "pipeline",
+                                [this]() { pipeline.init(); },
+                                &shaderTask,
+                                nullptr};
+    JobCounter shadersLoaded;
+    JobCounter pipelineCreated;
+    jobSystem.schedule(runStartupTask, &shaderTask, 0, 1, &shadersLoaded);
+
+    // Whatever happens the tasks must finish before they go out of scope.
+    try
+    {
+        startupReport.time("window", [this]() { window.init(); });
+        startupReport.time("surface", [this]() { surface.init(); });
+        startupReport.time("device", [this]() { device.init(); });
+        memoryTracker.init();
+        startupReport.time("buffer creator", [this]() {
+            bufferCreator.init();
+        });
+        swapChain.selectSurfaceFormat();
+        startupReport.time("render pass", [this]() { renderPass.init(); });
+
+        jobSystem.schedule(runStartupTask,
+                           &pipelineTask,
+                           0,
+                           1,
+                           &pipelineCreated,
+                           &shadersLoaded);
+
+        startupReport.time("swap chain", [this]() { swapChain.init(); });
+    }
+    catch (...)
+    {
+        jobSystem.wait(shadersLoaded);
+        jobSystem.wait(pipelineCreated);
+        throw;
+    }
+
+    jobSystem.wait(pipelineCreated);
+    if (shaderTask.error)
+        std::rethrow_exception(shaderTask.error);
+    if (pipelineTask.error)
+        std::rethrow_exception(pipelineTask.error);
+
+    // Both submit through the buffer creator's command pool, which the
+    // pipeline was using until now.
+    startupReport.time("texture manager", [this]() {
+        textureManager.init();
+    });
+    startupReport.time("gpu timer", [this]() { gpuTimer.init(); });
+    frameCapture.init();
+    startupReport.time("asset loader", [this]() { assetLoader.init(); });
+
+    startupReport.record("VulkanContext::init", begin, Profiler::now());
 }
@@ -1,42 +1,105 @@
 #ifndef VULKAN_CONTEXT_H
 #define VULKAN_CONTEXT_H
 
+#include "AssetLoader.h"
+#include "FrameArena.h"
+#include "FrameMonitor.h"
+#include "JobSystem.h"
+#include "RetirementQueue.h"
+#include "StartupReport.h"
 #include "VulkanBufferCreator.h"
 #include "VulkanDevice.h"
+#include "VulkanFrameCapture.h"
+#include "VulkanGpuTimer.h"
+#include "VulkanMemoryTracker.h"
 #include "VulkanPipeline.h"
 #include "VulkanRenderPass.h"
 #include "VulkanSurface.h"
 #include "VulkanSwapChain.h"
+#include "VulkanTextureManager.h"
 #include "VulkanWindow.h"
 
 class VulkanContext
 {
   public:
-    VulkanContext();
+    VulkanContext(const ContextConfig &config = ContextConfig());
     ~VulkanContext();
     void init();
 
   public:
+    const ContextConfig &getConfig() const { return config; };
+    const JobSystem &getJobSystem() const { return jobSystem; };
+    const StartupReport &getStartupReport() const { return startupReport; };
+    const FrameArena &getFrameArena() const { return frameArena; };
+    const FrameMonitor &getFrameMonitor() const { return frameMonitor; };
     const VkInstance &getInstance() const { return instance; };
     const VulkanWindow &getWindow() const { return window; };
     const VulkanSurface &getSurface() const { return surface; };
     const VulkanDevice &getDevice() const { return device; };
+    const VulkanMemoryTracker &getMemoryTracker() const
+    {
+        return memoryTracker;
+    };
     const VulkanSwapChain &getSwapChain() const { return swapChain; };
     const VulkanBufferCreator &getBufferCreator() const
     {
         return bufferCreator;
     };
+    const RetirementQueue &getRetirementQueue() const
+    {
+        return retirementQueue;
+    };
+    const VulkanTextureManager &getTextureManager() const
+    {
+        return textureManager;
+    };
     const VulkanRenderPass &getRenderPass() const { return renderPass; };
     const VulkanPipeline &getPipeline() const { return pipeline; };
+    const VulkanGpuTimer &getGpuTimer() const { return gpuTimer; };
+    const VulkanFrameCapture &getFrameCapture() const
+    {
+        return frameCapture;
+    };
+    const AssetLoader &getAssetLoader() const { return assetLoader; };
+
+    // For the owners of what changes from frame to frame.
+    JobSystem &getJobSystem() { return jobSystem; };
+    StartupReport &getStartupReport() { return startupReport; };
+    FrameArena &getFrameArena() { return frameArena; };
+    FrameMonitor &getFrameMonitor() { return frameMonitor; };
+    VulkanWindow &getWindow() { return window; };
+    VulkanMemoryTracker &getMemoryTracker() { return memoryTracker; };
+    VulkanSwapChain &getSwapChain() { return swapChain; };
+    RetirementQueue &getRetirementQueue() { return retirementQueue; };
+    VulkanTextureManager &getTextureManager() { return textureManager; };
+    VulkanPipeline &getPipeline() { return pipeline; };
+    VulkanGpuTimer &getGpuTimer() { return gpuTimer; };
+    VulkanFrameCapture &getFrameCapture() { return frameCapture; };
+    AssetLoader &getAssetLoader() { return assetLoader; };
 
   private:
+    ContextConfig config;
+    JobSystem jobSystem;
+    StartupReport startupReport;
+    // Transient render thread data, reset by drawFrame.
+    FrameArena frameArena;
+    // Recorded by drawFrame, outlives everything it measures.
+    FrameMonitor frameMonitor;
     VkInstance instance;
     VulkanWindow window;
     VulkanSurface surface;
     VulkanDevice device;
-    VulkanSwapChain swapChain;
+    VulkanMemoryTracker memoryTracker;
     VulkanBufferCreator bufferCreator;
+    // Before everything that retires resources into it, so it destroys them
+    // last.
+    RetirementQueue retirementQueue;
+    VulkanSwapChain swapChain;
+    VulkanTextureManager textureManager;
     VulkanRenderPass renderPass;
     VulkanPipeline pipeline;
+    VulkanGpuTimer gpuTimer;
+    VulkanFrameCapture frameCapture;
+    AssetLoader assetLoader;
 };
 #endif // VULKAN_CONTEXT_H
@@ -5,6 +5,8 @@
 #include <iostream>
 #include <vector>
 
+#include "HostAllocator.h"
+
 #include "VulkanDebugger.h"
 
 VkInstance *VulkanDebugger::instance;
@@ -38,17 +40,18 @@ void VulkanDebugger::init(VkInstance *instance)
 
 void VulkanDebugger::clear()
 {
-    DestroyDebugUtilsMessengerEXT(
-        *VulkanDebugger::instance, VulkanDebugger::debugMessenger, nullptr);
+    DestroyDebugUtilsMessengerEXT(*VulkanDebugger::instance,
+                                  VulkanDebugger::debugMessenger,
+                                  HostAllocator::get(HostAllocationTag::Debug));
 }
 
 void VulkanDebugger::setupDebugMessenger()
 {
-    VkResult result =
-        CreateDebugUtilsMessengerEXT(*VulkanDebugger::instance,
-                                     &VulkanDebugger::debugCreateInfo,
-                                     nullptr,
-                                     &VulkanDebugger::debugMessenger);
+    VkResult result = CreateDebugUtilsMessengerEXT(
+        *VulkanDebugger::instance,
+        &VulkanDebugger::debugCreateInfo,
+        HostAllocator::get(HostAllocationTag::Debug),
+        &VulkanDebugger::debugMessenger);
     if (result != VK_SUCCESS)
     {
         std::string errorMsg("Failed to set up debug messenger: ");
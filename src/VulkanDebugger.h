@@ -5,7 +5,9 @@
 
 #include <vector>
 
-#ifdef NDEBUG
+#include "config.h"
+
+#if defined(NDEBUG) || !defined(HAS_VALIDATION_LAYERS)
 const bool useDebugger = false;
 #else
 const bool useDebugger = true;
@@ -1,29 +1,54 @@
 #include <vulkan/vk_enum_string_helper.h>
 #include <vulkan/vulkan.h>
 
+#include <cstring>
 #include <iostream>
 #include <set>
 #include <vector>
 
+#include "HostAllocator.h"
 #include "VulkanContext.h"
 #include "VulkanDebugger.h"
+#include "VulkanNullDriver.h"
 
 #include "VulkanDevice.h"
 
 static const std::vector<const char *> deviceExtensions = {
     VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 
-VulkanDevice::VulkanDevice(VulkanContext *context) : context(context) {}
+// Enabled when available, features depending on them check
+// isExtensionEnabled.
+static const std::vector<const char *> optionalDeviceExtensions = {
+    VK_EXT_MEMORY_BUDGET_EXTENSION_NAME};
+
+// Dynamic rendering and what it depends on in Vulkan 1.1, all or nothing.
+static const std::vector<const char *> dynamicRenderingExtensions = {
+    VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME,
+    VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME,
+    VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME};
+
+VulkanDevice::VulkanDevice(VulkanContext *context)
+    : context(context),
+      memoryBudgetSupported(false),
+      dynamicRenderingSupported(false),
+      sampleCount(VK_SAMPLE_COUNT_1_BIT)
+{
+}
 
 VulkanDevice::~VulkanDevice()
 {
-    vkDestroyDevice(device, nullptr);
+    vkDestroyDevice(device, HostAllocator::get(HostAllocationTag::Device));
 }
 
 void VulkanDevice::init()
 {
     pickPhysicalDevice();
+    selectOptionalExtensions();
+    selectSampleCount();
     createLogicalDevice();
+    dispatch.load(device, dynamicRenderingSupported);
+    if (context->getConfig().nullDriver)
+        VulkanNullDriver::load(dispatch);
 }
 
 void VulkanDevice::pickPhysicalDevice()
@@ -39,13 +64,17 @@ void VulkanDevice::pickPhysicalDevice()
     std::vector<VkPhysicalDevice> devices(deviceCount);
     vkEnumeratePhysicalDevices(
         context->getInstance(), &deviceCount, devices.data());
+
+    // Every query runs once per device, the chosen one keeps its results.
     for (const auto &device : devices)
     {
-        if (isDeviceSuitable(device))
+        PhysicalDeviceInfo info = queryPhysicalDevice(device);
+        if (isDeviceSuitable(info))
         {
             physicalDevice = device;
-            queueFamilyIndices = findQueueFamilies(device);
-            swapChainSupport = querySwapChainSupport(device);
+            queueFamilyIndices = info.queueFamilyIndices;
+            swapChainSupport = std::move(info.swapChainSupport);
+            availableExtensions = std::move(info.extensions);
             break;
         }
     }
@@ -54,6 +83,119 @@ void VulkanDevice::pickPhysicalDevice()
         throw std::runtime_error("Failed to find a suitable GPU!");
 }
 
+PhysicalDeviceInfo VulkanDevice::queryPhysicalDevice(
+    VkPhysicalDevice device) const
+{
+    PhysicalDeviceInfo info;
+
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(
+        device, nullptr, &extensionCount, nullptr);
+    info.extensions.resize(extensionCount);
+    vkEnumerateDeviceExtensionProperties(
+        device, nullptr, &extensionCount, info.extensions.data());
+
+    info.queueFamilyIndices = findQueueFamilies(device);
+    info.swapChainSupport = querySwapChainSupport(device);
+
+    return info;
+}
+
+void VulkanDevice::selectOptionalExtensions()
+{
+    enabledExtensions = deviceExtensions;
+    for (const char *extensionName : optionalDeviceExtensions)
+    {
+        if (isExtensionAvailable(extensionName))
+            enabledExtensions.push_back(extensionName);
+    }
+
+    // Querying the budget goes through vkGetPhysicalDeviceMemoryProperties2.
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    memoryBudgetSupported =
+        properties.apiVersion >= VK_API_VERSION_1_1 &&
+        isExtensionEnabled(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+    if (context->getConfig().dynamicRendering &&
+        properties.apiVersion >= VK_API_VERSION_1_1)
+    {
+        selectDynamicRendering();
+    }
+}
+
+void VulkanDevice::selectDynamicRendering()
+{
+    for (const char *extensionName : dynamicRenderingExtensions)
+    {
+        if (!isExtensionAvailable(extensionName))
+            return;
+    }
+
+    // The extension alone doesn't guarantee the feature.
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+    dynamicRenderingFeatures.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &dynamicRenderingFeatures;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+    if (!dynamicRenderingFeatures.dynamicRendering)
+        return;
+
+    enabledExtensions.insert(enabledExtensions.end(),
+                             dynamicRenderingExtensions.begin(),
+                             dynamicRenderingExtensions.end());
+    dynamicRenderingSupported = true;
+}
+
+void VulkanDevice::selectSampleCount()
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    VkSampleCountFlags supported =
+        properties.limits.framebufferColorSampleCounts;
+
+    // The highest supported count not above the requested one.
+    uint32_t requested = context->getConfig().msaaSamples;
+    sampleCount = VK_SAMPLE_COUNT_1_BIT;
+    for (uint32_t samples = 2; samples <= requested && samples <= 64;
+         samples *= 2)
+    {
+        if (supported & samples)
+            sampleCount = static_cast<VkSampleCountFlagBits>(samples);
+    }
+
+    uint32_t selected = static_cast<uint32_t>(sampleCount);
+    if (selected != requested && requested > 1)
+    {
+        std::cerr << "MSAA x" << requested << " not supported, using x"
+                  << selected << std::endl;
+    }
+}
+
+bool VulkanDevice::isExtensionAvailable(const char *extensionName) const
+{
+    for (const auto &extension : availableExtensions)
+    {
+        if (strcmp(extensionName, extension.extensionName) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+bool VulkanDevice::isExtensionEnabled(const char *extensionName) const
+{
+    for (const char *enabledExtension : enabledExtensions)
+    {
+        if (strcmp(extensionName, enabledExtension) == 0)
+            return true;
+    }
+
+    return false;
+}
+
 void VulkanDevice::createLogicalDevice()
 {
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
@@ -83,9 +225,16 @@ void VulkanDevice::createLogicalDevice()
     VkPhysicalDeviceFeatures deviceFeatures{};
     createInfo.pEnabledFeatures = &deviceFeatures;
 
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+    dynamicRenderingFeatures.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+    dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+    if (dynamicRenderingSupported)
+        createInfo.pNext = &dynamicRenderingFeatures;
+
     createInfo.enabledExtensionCount =
-        static_cast<uint32_t>(deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        static_cast<uint32_t>(enabledExtensions.size());
+    createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
     createInfo.enabledLayerCount = 0;
 
@@ -93,7 +242,10 @@ void VulkanDevice::createLogicalDevice()
         VulkanDebugger::addValidationLayers(createInfo);
 
     VkResult result =
-        vkCreateDevice(physicalDevice, &createInfo, nullptr, &device);
+        vkCreateDevice(physicalDevice,
+                       &createInfo,
+                       HostAllocator::get(HostAllocationTag::Device),
+                       &device);
     if (result != VK_SUCCESS)
     {
         std::string errorMsg("Failed to create logical device: ");
@@ -107,23 +259,16 @@ void VulkanDevice::createLogicalDevice()
         device, queueFamilyIndices.presentFamily.value(), 0, &presentQueue);
 }
 
-bool VulkanDevice::isDeviceSuitable(VkPhysicalDevice device) const
+bool VulkanDevice::isDeviceSuitable(const PhysicalDeviceInfo &info) const
 {
-    return supportsRequiredExtensions(device) &&
-           supportsRequiredSwapchain(device) &&
-           findQueueFamilies(device).allSet();
+    return supportsRequiredExtensions(info.extensions) &&
+           supportsRequiredSwapchain(info.swapChainSupport) &&
+           info.queueFamilyIndices.allSet();
 }
 
-bool VulkanDevice::supportsRequiredExtensions(VkPhysicalDevice device) const
+bool VulkanDevice::supportsRequiredExtensions(
+    const std::vector<VkExtensionProperties> &availableExtensions) const
 {
-    uint32_t extensionCount;
-    vkEnumerateDeviceExtensionProperties(
-        device, nullptr, &extensionCount, nullptr);
-
-    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
-    vkEnumerateDeviceExtensionProperties(
-        device, nullptr, &extensionCount, availableExtensions.data());
-
     std::set<std::string> requiredExtensions(deviceExtensions.begin(),
                                              deviceExtensions.end());
 
@@ -135,10 +280,9 @@ bool VulkanDevice::supportsRequiredExtensions(VkPhysicalDevice device) const
     return requiredExtensions.empty();
 }
 
-bool VulkanDevice::supportsRequiredSwapchain(VkPhysicalDevice device) const
+bool VulkanDevice::supportsRequiredSwapchain(
+    const SwapChainSupportDetails &swapChainSupport) const
 {
-    SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
-
     return !swapChainSupport.formats.empty() &&
            !swapChainSupport.presentModes.empty();
 }
@@ -1,8 +1,17 @@
 #ifndef VULKAN_DEVICE_H
 #define VULKAN_DEVICE_H
 
+#include "VulkanDispatch.h"
 #include "VulkanTypes.h"
 
+// Everything device selection looks at, enumerated once per device.
+struct PhysicalDeviceInfo
+{
+    std::vector<VkExtensionProperties> extensions;
+    QueueFamilyIndices queueFamilyIndices;
+    SwapChainSupportDetails swapChainSupport;
+};
+
 class VulkanDevice
 {
   public:
@@ -13,9 +22,16 @@ class VulkanDevice
   private:
     void pickPhysicalDevice();
     void createLogicalDevice();
-    bool isDeviceSuitable(VkPhysicalDevice device) const;
-    bool supportsRequiredExtensions(VkPhysicalDevice device) const;
-    bool supportsRequiredSwapchain(VkPhysicalDevice device) const;
+    void selectOptionalExtensions();
+    void selectDynamicRendering();
+    void selectSampleCount();
+    bool isExtensionAvailable(const char *extensionName) const;
+    PhysicalDeviceInfo queryPhysicalDevice(VkPhysicalDevice device) const;
+    bool isDeviceSuitable(const PhysicalDeviceInfo &info) const;
+    bool supportsRequiredExtensions(
+        const std::vector<VkExtensionProperties> &availableExtensions) const;
+    bool supportsRequiredSwapchain(
+        const SwapChainSupportDetails &swapChainSupport) const;
     SwapChainSupportDetails querySwapChainSupport(
         VkPhysicalDevice device) const;
     QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device) const;
@@ -32,6 +48,13 @@ class VulkanDevice
     VkQueue getGraphicsQueue() const { return graphicsQueue; }
     VkQueue getPresentQueue() const { return presentQueue; }
     VkPhysicalDevice getPhysicalDevice() const { return physicalDevice; }
+    bool isExtensionEnabled(const char *extensionName) const;
+    bool hasMemoryBudget() const { return memoryBudgetSupported; }
+    // Enabled only when ContextConfig::dynamicRendering asks for it.
+    bool hasDynamicRendering() const { return dynamicRenderingSupported; }
+    VkSampleCountFlagBits getSampleCount() const { return sampleCount; }
+    // For the commands called every frame, instead of the loader's.
+    const VulkanDispatch &getDispatch() const { return dispatch; }
     operator VkDevice() const { return device; }
 
   private:
@@ -39,11 +62,18 @@ class VulkanDevice
 
     VkDevice device;
     VkPhysicalDevice physicalDevice;
+    VulkanDispatch dispatch;
 
     VkQueue graphicsQueue;
     VkQueue presentQueue;
 
     QueueFamilyIndices queueFamilyIndices;
     SwapChainSupportDetails swapChainSupport;
+
+    std::vector<VkExtensionProperties> availableExtensions;
+    std::vector<const char *> enabledExtensions;
+    bool memoryBudgetSupported;
+    bool dynamicRenderingSupported;
+    VkSampleCountFlagBits sampleCount;
 };
 #endif // VULKAN_DEVICE_H
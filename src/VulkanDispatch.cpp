@@ -0,0 +1,31 @@
+#include <vulkan/vulkan.h>
+
+#include <stdexcept>
+#include <string>
+
+#include "VulkanDispatch.h"
+
+static PFN_vkVoidFunction loadFunction(VkDevice device, const char *name)
+{
+    PFN_vkVoidFunction function = vkGetDeviceProcAddr(device, name);
+    if (function == nullptr)
+    {
+        std::string errorMsg("Failed to load device function: ");
+        errorMsg.append(name);
+        throw std::runtime_error(errorMsg);
+    }
+
+    return function;
+}
+
+void VulkanDispatch::load(VkDevice device, bool dynamicRendering)
+{
+#define VULKAN_DISPATCH_LOAD(name)                                             \
+    name = reinterpret_cast<PFN_##name>(loadFunction(device, #name));
+    VULKAN_DISPATCH_DEVICE_FUNCTIONS(VULKAN_DISPATCH_LOAD)
+    if (dynamicRendering)
+    {
+        VULKAN_DISPATCH_DYNAMIC_RENDERING_FUNCTIONS(VULKAN_DISPATCH_LOAD)
+    }
+#undef VULKAN_DISPATCH_LOAD
+}
@@ -0,0 +1,56 @@
+#ifndef VULKAN_DISPATCH_H
+#define VULKAN_DISPATCH_H
+
+#include "VulkanTypes.h"
+
+// The device level commands called every frame, X(name) per command. Adding
+// one here declares, loads and checks it.
+#define VULKAN_DISPATCH_DEVICE_FUNCTIONS(X)                                    \
+    X(vkAcquireNextImageKHR)                                                   \
+    X(vkBeginCommandBuffer)                                                    \
+    X(vkCmdBeginRenderPass)                                                    \
+    X(vkCmdBindDescriptorSets)                                                 \
+    X(vkCmdBindIndexBuffer)                                                    \
+    X(vkCmdBindPipeline)                                                       \
+    X(vkCmdBindVertexBuffers)                                                  \
+    X(vkCmdBlitImage)                                                          \
+    X(vkCmdCopyImageToBuffer)                                                  \
+    X(vkCmdDrawIndexed)                                                        \
+    X(vkCmdEndRenderPass)                                                      \
+    X(vkCmdExecuteCommands)                                                    \
+    X(vkCmdPipelineBarrier)                                                    \
+    X(vkCmdResetQueryPool)                                                     \
+    X(vkCmdSetScissor)                                                         \
+    X(vkCmdSetViewport)                                                        \
+    X(vkCmdWriteTimestamp)                                                     \
+    X(vkEndCommandBuffer)                                                      \
+    X(vkGetFenceStatus)                                                        \
+    X(vkGetQueryPoolResults)                                                   \
+    X(vkQueuePresentKHR)                                                       \
+    X(vkQueueSubmit)                                                           \
+    X(vkResetCommandBuffer)                                                    \
+    X(vkResetCommandPool)                                                      \
+    X(vkResetFences)                                                           \
+    X(vkWaitForFences)
+
+// Only loaded when VulkanDevice enabled dynamic rendering.
+#define VULKAN_DISPATCH_DYNAMIC_RENDERING_FUNCTIONS(X)                         \
+    X(vkCmdBeginRenderingKHR)                                                  \
+    X(vkCmdEndRenderingKHR)
+
+// Device level function pointers, resolved once with vkGetDeviceProcAddr the
+// way volk does. The loader's exported commands are trampolines that find
+// the device's dispatch table on every call; these jump straight into the
+// driver. Startup and upload paths keep calling the loader.
+struct VulkanDispatch
+{
+#define VULKAN_DISPATCH_MEMBER(name) PFN_##name name = nullptr;
+    VULKAN_DISPATCH_DEVICE_FUNCTIONS(VULKAN_DISPATCH_MEMBER)
+    VULKAN_DISPATCH_DYNAMIC_RENDERING_FUNCTIONS(VULKAN_DISPATCH_MEMBER)
+#undef VULKAN_DISPATCH_MEMBER
+
+    // Throws when the device doesn't return one of the commands.
+    void load(VkDevice device, bool dynamicRendering);
+};
+
+#endif // VULKAN_DISPATCH_H
@@ -0,0 +1,309 @@
+#include <vulkan/vk_enum_string_helper.h>
+#include <vulkan/vulkan.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "Profiler.h"
+#include "VulkanContext.h"
+
+#include "VulkanFrameCapture.h"
+
+// Buffers beyond the frames in flight, for frames queued in the writer.
+static const uint32_t CAPTURE_WRITER_QUEUE_DEPTH = 3;
+
+VulkanFrameCapture::VulkanFrameCapture(VulkanContext *context)
+    : context(context),
+      memoryProperties(0),
+      bgra(false),
+      frameNumber(0),
+      capturedCount(0),
+      droppedCount(0)
+{
+}
+
+VulkanFrameCapture::~VulkanFrameCapture()
+{
+    stop();
+}
+
+void VulkanFrameCapture::init()
+{
+    const ContextConfig &config = context->getConfig();
+    if (config.capturePath.empty())
+        return;
+
+    const VulkanDevice &device = context->getDevice();
+    const SwapChainSupportDetails &swapChainSupport =
+        device.getSwapChainSupport();
+    if (!(swapChainSupport.capabilities.supportedUsageFlags &
+          VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
+    {
+        std::cerr << "Swap chain images can't be copied, capture disabled"
+                  << std::endl;
+        return;
+    }
+
+    switch (context->getSwapChain().getImageFormat())
+    {
+    case VK_FORMAT_B8G8R8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+        bgra = true;
+        break;
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_R8G8B8A8_UNORM:
+        bgra = false;
+        break;
+    default:
+        std::cerr << "Swap chain format not 8 bit RGBA, capture disabled"
+                  << std::endl;
+        return;
+    }
+
+    // The CPU reads every byte back, cached memory makes that much faster.
+    VkPhysicalDeviceMemoryProperties deviceMemoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(device.getPhysicalDevice(),
+                                        &deviceMemoryProperties);
+    memoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                       VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    for (uint32_t i = 0; i < deviceMemoryProperties.memoryTypeCount; i++)
+    {
+        VkMemoryPropertyFlags cached =
+            memoryProperties | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+        if ((deviceMemoryProperties.memoryTypes[i].propertyFlags & cached) ==
+            cached)
+        {
+            memoryProperties = cached;
+            break;
+        }
+    }
+
+    // Buffers are created on first use, sized for the swap chain then.
+    slots = std::vector<CaptureSlot>(config.framesInFlight +
+                                     CAPTURE_WRITER_QUEUE_DEPTH);
+    for (CaptureSlot &slot : slots)
+    {
+        slot.mapped = nullptr;
+        slot.capacity = 0;
+        slot.frameIndex = 0;
+        slot.state = CaptureSlotState::Free;
+    }
+
+    writer = std::make_unique<CaptureWriter>(
+        config.capturePath,
+        static_cast<uint32_t>(slots.size()),
+        config.captureFrameRate,
+        [this](uint32_t slot) {
+            slots[slot].state.store(CaptureSlotState::Free,
+                                    std::memory_order_release);
+        });
+}
+
+void VulkanFrameCapture::stop()
+{
+    if (!writer)
+        return;
+
+    // Joins the writer once it wrote everything it was handed.
+    CaptureFormat format = writer->getFormat();
+    uint64_t written = writer->getWrittenCount();
+    writer.reset();
+
+    std::cerr << "Captured " << capturedCount << " frames to "
+              << context->getConfig().capturePath << ", dropped "
+              << droppedCount << std::endl;
+    if (format != CaptureFormat::Png && written < capturedCount)
+    {
+        std::cerr << capturedCount - written
+                  << " frames not written, the stream keeps the size of "
+                     "its first frame"
+                  << std::endl;
+    }
+}
+
+void VulkanFrameCapture::collect(uint32_t frameIndex)
+{
+    if (!writer)
+        return;
+
+    for (uint32_t i = 0; i < slots.size(); i++)
+    {
+        CaptureSlot &slot = slots[i];
+        if (slot.frameIndex != frameIndex ||
+            slot.state.load(std::memory_order_relaxed) !=
+                CaptureSlotState::Copying)
+        {
+            continue;
+        }
+
+        // Coherent memory and the host barrier in the copy make the pixels
+        // visible once the fence signaled.
+        slot.state.store(CaptureSlotState::Writing, std::memory_order_relaxed);
+        writer->submit({slot.mapped,
+                        slot.extent.width,
+                        slot.extent.height,
+                        bgra,
+                        slot.frameNumber,
+                        i});
+        capturedCount++;
+    }
+}
+
+void VulkanFrameCapture::recordCopy(VkCommandBuffer commandBuffer,
+                                    uint32_t frameIndex,
+                                    VkImage image,
+                                    VkImageLayout layout,
+                                    VkExtent2D extent)
+{
+    if (!writer)
+        return;
+
+    PROFILE_ZONE("VulkanFrameCapture::recordCopy");
+
+    const VulkanDispatch &dispatch = context->getDevice().getDispatch();
+
+    VkDeviceSize size = VkDeviceSize(extent.width) * extent.height * 4;
+    CaptureSlot *slot = acquireSlot(size);
+    uint64_t number = frameNumber++;
+    if (!slot)
+    {
+        droppedCount++;
+        return;
+    }
+
+    slot->state.store(CaptureSlotState::Copying, std::memory_order_relaxed);
+    slot->extent = extent;
+    slot->frameIndex = frameIndex;
+    slot->frameNumber = number;
+
+    // Last written by the pass or, with dynamic resolution, by the blit.
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask =
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.oldLayout = layout;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    VkPipelineStageFlags srcStageMask =
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+        VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dispatch.vkCmdPipelineBarrier(commandBuffer,
+                                  srcStageMask,
+                                  VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                  0,
+                                  0,
+                                  nullptr,
+                                  0,
+                                  nullptr,
+                                  1,
+                                  &barrier);
+
+    // Tightly packed rows, which is what the writer expects.
+    VkBufferImageCopy region{};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {extent.width, extent.height, 1};
+    dispatch.vkCmdCopyImageToBuffer(commandBuffer,
+                                    image,
+                                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                    slot->buffer,
+                                    1,
+                                    &region);
+
+    // Back to where the image was, presentation needs no access mask.
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.dstAccessMask = 0;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.newLayout = layout;
+
+    VkBufferMemoryBarrier bufferBarrier{};
+    bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferBarrier.buffer = slot->buffer;
+    bufferBarrier.offset = 0;
+    bufferBarrier.size = size;
+
+    dispatch.vkCmdPipelineBarrier(commandBuffer,
+                                  VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                  VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT |
+                                      VK_PIPELINE_STAGE_HOST_BIT,
+                                  0,
+                                  0,
+                                  nullptr,
+                                  1,
+                                  &bufferBarrier,
+                                  1,
+                                  &barrier);
+}
+
+CaptureSlot *VulkanFrameCapture::acquireSlot(VkDeviceSize size)
+{
+    for (CaptureSlot &slot : slots)
+    {
+        // Pairs with the writer's release of the slot.
+        if (slot.state.load(std::memory_order_acquire) !=
+            CaptureSlotState::Free)
+        {
+            continue;
+        }
+
+        // After a resize, the old buffer is retired until the frames that
+        // may still use it completed.
+        if (slot.capacity < size)
+            createSlotBuffer(slot, size);
+        return &slot;
+    }
+    return nullptr;
+}
+
+void VulkanFrameCapture::createSlotBuffer(CaptureSlot &slot,
+                                          VkDeviceSize size) const
+{
+    RetirementQueue &retirementQueue = context->getRetirementQueue();
+
+    VkBuffer buffer;
+    VkDeviceMemory memory;
+    context->getBufferCreator().createBuffer(size,
+                                             VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                             memoryProperties,
+                                             MemoryCategory::Readback,
+                                             buffer,
+                                             memory);
+    slot.buffer = UniqueBuffer(retirementQueue, buffer);
+    slot.memory = UniqueDeviceMemory(retirementQueue, memory);
+
+    // The old mapping went away with the old memory.
+    slot.mapped = nullptr;
+    slot.capacity = 0;
+
+    // Freeing the memory unmaps it.
+    void *mapped;
+    VkResult result =
+        vkMapMemory(context->getDevice(), memory, 0, size, 0, &mapped);
+    if (result != VK_SUCCESS)
+    {
+        std::string errorMsg("Failed to map capture buffer: ");
+        errorMsg.append(string_VkResult(result));
+        throw std::runtime_error(errorMsg);
+    }
+    slot.mapped = static_cast<const uint8_t *>(mapped);
+    slot.capacity = size;
+}
@@ -0,0 +1,82 @@
+#ifndef VULKAN_FRAME_CAPTURE_H
+#define VULKAN_FRAME_CAPTURE_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "CaptureWriter.h"
+#include "RetirementQueue.h"
+#include "VulkanTypes.h"
+
+enum class CaptureSlotState : uint8_t
+{
+    Free,
+    // Copy recorded, waiting for the frame's fence.
+    Copying,
+    // Handed to the writer thread.
+    Writing,
+};
+
+// One host visible readback buffer of the ring.
+struct CaptureSlot
+{
+    // Before the buffer, so the buffer is retired first.
+    UniqueDeviceMemory memory;
+    UniqueBuffer buffer;
+    const uint8_t *mapped;
+    VkDeviceSize capacity;
+    VkExtent2D extent;
+    uint32_t frameIndex;
+    uint64_t frameNumber;
+    std::atomic<CaptureSlotState> state;
+};
+
+// Copies presented images into a ring of readback buffers and streams them
+// to disk, without ever making drawFrame wait: the copy is read back once
+// the frame's fence was waited on anyway, frames in flight later, and
+// frames that find no free buffer are dropped and counted instead.
+class VulkanFrameCapture
+{
+  public:
+    VulkanFrameCapture(VulkanContext *context);
+    ~VulkanFrameCapture();
+    // Starts capturing to the config's capture path, if any.
+    void init();
+    // Flushes the writer and reports. Nothing is captured afterwards.
+    void stop();
+    // Hands the copies recorded by frameIndex's last submission to the
+    // writer. Must be called after its fence was waited on.
+    void collect(uint32_t frameIndex);
+    // Copies the image, in layout and left in it, into a free buffer.
+    void recordCopy(VkCommandBuffer commandBuffer,
+                    uint32_t frameIndex,
+                    VkImage image,
+                    VkImageLayout layout,
+                    VkExtent2D extent);
+
+  private:
+    CaptureSlot *acquireSlot(VkDeviceSize size);
+    void createSlotBuffer(CaptureSlot &slot, VkDeviceSize size) const;
+
+  public:
+    bool isCapturing() const { return writer != nullptr; }
+    uint64_t getCapturedCount() const { return capturedCount; }
+    // Frames that found every buffer in use.
+    uint64_t getDroppedCount() const { return droppedCount; }
+
+  private:
+    VulkanContext *context;
+
+    std::vector<CaptureSlot> slots;
+    // After the slots, its thread releases them.
+    std::unique_ptr<CaptureWriter> writer;
+    VkMemoryPropertyFlags memoryProperties;
+    bool bgra;
+
+    uint64_t frameNumber;
+    uint64_t capturedCount;
+    uint64_t droppedCount;
+};
+
+#endif // VULKAN_FRAME_CAPTURE_H
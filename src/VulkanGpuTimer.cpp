@@ -0,0 +1,178 @@
+#include <vulkan/vk_enum_string_helper.h>
+#include <vulkan/vulkan.h>
+
+#include <iostream>
+
+#include "HostAllocator.h"
+#include "Profiler.h"
+#include "VulkanContext.h"
+
+#include "VulkanGpuTimer.h"
+
+static const uint32_t QUERIES_PER_FRAME = 2;
+
+VulkanGpuTimer::VulkanGpuTimer(VulkanContext *context)
+    : context(context),
+      supported(false),
+      queryPool(VK_NULL_HANDLE),
+      frameCount(0),
+      nanosecondsPerTick(1.0),
+      timestampMask(~0ull),
+      clockOffset(0),
+      lastFrameTime(0),
+      collectedFrameCount(0)
+{
+}
+
+VulkanGpuTimer::~VulkanGpuTimer()
+{
+    vkDestroyQueryPool(context->getDevice(),
+                       queryPool,
+                       HostAllocator::get(HostAllocationTag::Queries));
+}
+
+void VulkanGpuTimer::init()
+{
+    const VulkanDevice &device = context->getDevice();
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device.getPhysicalDevice(), &properties);
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        device.getPhysicalDevice(), &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        device.getPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+    uint32_t graphicsFamily =
+        device.getQueueFamiyIndices().graphicsFamily.value();
+    uint32_t validBits = queueFamilies[graphicsFamily].timestampValidBits;
+    if (validBits == 0 || properties.limits.timestampPeriod == 0.0f)
+    {
+        std::cerr << "GPU timestamps not supported, GPU timings disabled"
+                  << std::endl;
+        return;
+    }
+
+    supported = true;
+    nanosecondsPerTick = properties.limits.timestampPeriod;
+    timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+    frameCount = context->getPipeline().getFramesInFlight();
+
+    VkQueryPoolCreateInfo queryPoolInfo{};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = frameCount * QUERIES_PER_FRAME;
+
+    VkResult result =
+        vkCreateQueryPool(device,
+                          &queryPoolInfo,
+                          HostAllocator::get(HostAllocationTag::Queries),
+                          &queryPool);
+    if (result != VK_SUCCESS)
+    {
+        std::string errorMsg("Failed to create timestamp query pool: ");
+        errorMsg.append(string_VkResult(result));
+        throw std::runtime_error(errorMsg);
+    }
+
+    calibrate();
+}
+
+void VulkanGpuTimer::calibrate()
+{
+    const VulkanBufferCreator &bufferCreator = context->getBufferCreator();
+
+    // Also leaves every query reset, so collect() sees VK_NOT_READY for
+    // frames that were never recorded.
+    VkCommandBuffer commandBuffer = bufferCreator.beginSingleTimeCommands();
+    vkCmdResetQueryPool(
+        commandBuffer, queryPool, 0, frameCount * QUERIES_PER_FRAME);
+    vkCmdWriteTimestamp(
+        commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, 0);
+
+    uint64_t cpuBefore = Profiler::now();
+    bufferCreator.endSingleTimeCommands(commandBuffer);
+    uint64_t cpuAfter = Profiler::now();
+
+    uint64_t ticks = 0;
+    vkGetQueryPoolResults(context->getDevice(),
+                          queryPool,
+                          0,
+                          1,
+                          sizeof(ticks),
+                          &ticks,
+                          sizeof(ticks),
+                          VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+
+    // The timestamp landed somewhere between submit and idle; the midpoint
+    // keeps the error under half the round trip.
+    uint64_t gpuTime = static_cast<uint64_t>((ticks & timestampMask) *
+                                             nanosecondsPerTick);
+    clockOffset = static_cast<int64_t>(cpuBefore + (cpuAfter - cpuBefore) / 2) -
+                  static_cast<int64_t>(gpuTime);
+
+    commandBuffer = bufferCreator.beginSingleTimeCommands();
+    vkCmdResetQueryPool(commandBuffer, queryPool, 0, 1);
+    bufferCreator.endSingleTimeCommands(commandBuffer);
+}
+
+void VulkanGpuTimer::writeBegin(VkCommandBuffer commandBuffer,
+                                uint32_t frameIndex) const
+{
+    if (!supported)
+        return;
+
+    const VulkanDispatch &dispatch = context->getDevice().getDispatch();
+    uint32_t firstQuery = frameIndex * QUERIES_PER_FRAME;
+    dispatch.vkCmdResetQueryPool(
+        commandBuffer, queryPool, firstQuery, QUERIES_PER_FRAME);
+    dispatch.vkCmdWriteTimestamp(commandBuffer,
+                                 VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                 queryPool,
+                                 firstQuery);
+}
+
+void VulkanGpuTimer::writeEnd(VkCommandBuffer commandBuffer,
+                              uint32_t frameIndex) const
+{
+    if (!supported)
+        return;
+
+    const VulkanDispatch &dispatch = context->getDevice().getDispatch();
+    dispatch.vkCmdWriteTimestamp(commandBuffer,
+                                 VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                 queryPool,
+                                 frameIndex * QUERIES_PER_FRAME + 1);
+}
+
+bool VulkanGpuTimer::collect(uint32_t frameIndex, GpuFrameTiming &timing)
+{
+    if (!supported)
+        return false;
+
+    const VulkanDevice &device = context->getDevice();
+    const VulkanDispatch &dispatch = device.getDispatch();
+    uint64_t ticks[QUERIES_PER_FRAME];
+    VkResult result =
+        dispatch.vkGetQueryPoolResults(device,
+                                       queryPool,
+                                       frameIndex * QUERIES_PER_FRAME,
+                                       QUERIES_PER_FRAME,
+                                       sizeof(ticks),
+                                       ticks,
+                                       sizeof(ticks[0]),
+                                       VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS)
+        return false;
+
+    uint64_t begin = (ticks[0] & timestampMask) * nanosecondsPerTick;
+    uint64_t end = (ticks[1] & timestampMask) * nanosecondsPerTick;
+
+    timing.begin = static_cast<uint64_t>(begin + clockOffset);
+    timing.end = static_cast<uint64_t>(end + clockOffset);
+    lastFrameTime = end - begin;
+    collectedFrameCount++;
+    return true;
+}
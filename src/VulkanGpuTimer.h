@@ -0,0 +1,49 @@
+#ifndef VULKAN_GPU_TIMER_H
+#define VULKAN_GPU_TIMER_H
+
+#include "VulkanTypes.h"
+
+struct GpuFrameTiming
+{
+    // Nanoseconds on the Profiler::now() clock.
+    uint64_t begin;
+    uint64_t end;
+};
+
+class VulkanGpuTimer
+{
+  public:
+    VulkanGpuTimer(VulkanContext *context);
+    ~VulkanGpuTimer();
+    void init();
+    void writeBegin(VkCommandBuffer commandBuffer, uint32_t frameIndex) const;
+    void writeEnd(VkCommandBuffer commandBuffer, uint32_t frameIndex) const;
+    // Reads back the timestamps of the last submission of frameIndex.
+    // Must be called after its fence was waited on.
+    bool collect(uint32_t frameIndex, GpuFrameTiming &timing);
+
+  private:
+    void calibrate();
+
+  public:
+    bool isSupported() const { return supported; }
+    // Duration of the last collected frame in nanoseconds.
+    uint64_t getLastFrameTime() const { return lastFrameTime; }
+    // Increments on every successful collect().
+    uint64_t getCollectedFrameCount() const { return collectedFrameCount; }
+
+  private:
+    VulkanContext *context;
+
+    bool supported;
+    VkQueryPool queryPool;
+    uint32_t frameCount;
+    double nanosecondsPerTick;
+    uint64_t timestampMask;
+    // Profiler::now() minus GPU time in nanoseconds.
+    int64_t clockOffset;
+    uint64_t lastFrameTime;
+    uint64_t collectedFrameCount;
+};
+
+#endif // VULKAN_GPU_TIMER_H
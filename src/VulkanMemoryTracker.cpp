@@ -0,0 +1,294 @@
+#include <vulkan/vulkan.h>
+
+#include <iomanip>
+#include <iostream>
+
+#include "HostAllocator.h"
+#include "VulkanContext.h"
+
+#include "VulkanMemoryTracker.h"
+
+static const float BUDGET_WARNING_RATIO = 0.9f;
+static const float BUDGET_POLL_INTERVAL = 1.0f;
+
+static const char *memoryCategoryNames[] = {
+    "geometry",
+    "uniforms",
+    "staging",
+    "textures",
+    "attachments",
+    "readback",
+    "other",
+};
+
+const char *getMemoryCategoryName(MemoryCategory category)
+{
+    return memoryCategoryNames[static_cast<size_t>(category)];
+}
+
+static void addUsage(MemoryUsage &usage,
+                     VkDeviceSize size,
+                     VkDeviceSize padding)
+{
+    usage.allocatedBytes += size;
+    usage.paddingBytes += padding;
+    usage.allocationCount++;
+    if (usage.allocatedBytes > usage.peakBytes)
+        usage.peakBytes = usage.allocatedBytes;
+}
+
+static void removeUsage(MemoryUsage &usage,
+                        VkDeviceSize size,
+                        VkDeviceSize padding)
+{
+    usage.allocatedBytes -= size;
+    usage.paddingBytes -= padding;
+    usage.allocationCount--;
+}
+
+static double toMiB(VkDeviceSize bytes)
+{
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+static void logUsage(std::ostream &out, const MemoryUsage &usage)
+{
+    out << toMiB(usage.allocatedBytes) << " MiB in " << usage.allocationCount
+        << " allocations, peak " << toMiB(usage.peakBytes) << " MiB, padding "
+        << toMiB(usage.paddingBytes) << " MiB";
+}
+
+VulkanMemoryTracker::VulkanMemoryTracker(VulkanContext *context)
+    : context(context),
+      categoryUsage{},
+      logInterval(0.0f)
+{
+}
+
+VulkanMemoryTracker::~VulkanMemoryTracker()
+{
+    if (!allocations.empty())
+    {
+        std::cerr << "Memory tracker: " << allocations.size()
+                  << " device memory allocations leaked" << std::endl;
+    }
+}
+
+void VulkanMemoryTracker::init()
+{
+    const VulkanDevice &device = context->getDevice();
+
+    vkGetPhysicalDeviceMemoryProperties(device.getPhysicalDevice(),
+                                        &memoryProperties);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device.getPhysicalDevice(), &properties);
+    maxAllocationCount = properties.limits.maxMemoryAllocationCount;
+
+    heapUsage.assign(memoryProperties.memoryHeapCount, MemoryUsage{});
+    typeUsage.assign(memoryProperties.memoryTypeCount, MemoryUsage{});
+    heapOverBudget.assign(memoryProperties.memoryHeapCount, false);
+    lastLog = std::chrono::steady_clock::now();
+    lastBudgetPoll = lastLog;
+}
+
+void VulkanMemoryTracker::recordAllocation(VkDeviceMemory memory,
+                                           uint32_t memoryTypeIndex,
+                                           VkDeviceSize size,
+                                           VkDeviceSize requestedSize,
+                                           MemoryCategory category)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    VkDeviceSize padding = size - requestedSize;
+    allocations[memory] = {memoryTypeIndex, size, padding, category};
+
+    uint32_t heapIndex =
+        memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+    addUsage(heapUsage[heapIndex], size, padding);
+    addUsage(typeUsage[memoryTypeIndex], size, padding);
+    addUsage(categoryUsage[static_cast<size_t>(category)], size, padding);
+}
+
+void VulkanMemoryTracker::recordFree(VkDeviceMemory memory)
+{
+    if (memory == VK_NULL_HANDLE)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = allocations.find(memory);
+    if (it == allocations.end())
+        return;
+
+    const Allocation &allocation = it->second;
+    uint32_t heapIndex =
+        memoryProperties.memoryTypes[allocation.memoryTypeIndex].heapIndex;
+    removeUsage(heapUsage[heapIndex], allocation.size, allocation.padding);
+    removeUsage(typeUsage[allocation.memoryTypeIndex],
+                allocation.size,
+                allocation.padding);
+    removeUsage(categoryUsage[static_cast<size_t>(allocation.category)],
+                allocation.size,
+                allocation.padding);
+
+    allocations.erase(it);
+}
+
+MemoryStatistics VulkanMemoryTracker::getStatistics() const
+{
+    MemoryStatistics statistics{};
+    collectStatistics(statistics);
+    return statistics;
+}
+
+void VulkanMemoryTracker::collectStatistics(MemoryStatistics &statistics) const
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // Same sizes every time, reusing statistics never allocates.
+        statistics.heaps.resize(memoryProperties.memoryHeapCount);
+        for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+        {
+            statistics.heaps[i] = MemoryHeapStatistics{};
+            statistics.heaps[i].size = memoryProperties.memoryHeaps[i].size;
+            statistics.heaps[i].flags = memoryProperties.memoryHeaps[i].flags;
+            statistics.heaps[i].usage = heapUsage[i];
+        }
+
+        statistics.types.resize(memoryProperties.memoryTypeCount);
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+        {
+            statistics.types[i].heapIndex =
+                memoryProperties.memoryTypes[i].heapIndex;
+            statistics.types[i].flags =
+                memoryProperties.memoryTypes[i].propertyFlags;
+            statistics.types[i].usage = typeUsage[i];
+        }
+
+        statistics.categories = categoryUsage;
+        statistics.allocationCount =
+            static_cast<uint32_t>(allocations.size());
+        statistics.maxAllocationCount = maxAllocationCount;
+    }
+
+    queryBudget(statistics);
+}
+
+void VulkanMemoryTracker::queryBudget(MemoryStatistics &statistics) const
+{
+    const VulkanDevice &device = context->getDevice();
+    statistics.budgetAvailable = device.hasMemoryBudget();
+    if (!statistics.budgetAvailable)
+        return;
+
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+    budgetProperties.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+    VkPhysicalDeviceMemoryProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    properties.pNext = &budgetProperties;
+
+    vkGetPhysicalDeviceMemoryProperties2(device.getPhysicalDevice(),
+                                         &properties);
+
+    for (size_t i = 0; i < statistics.heaps.size(); i++)
+    {
+        statistics.heaps[i].budget = budgetProperties.heapBudget[i];
+        statistics.heaps[i].budgetUsage = budgetProperties.heapUsage[i];
+    }
+}
+
+void VulkanMemoryTracker::update()
+{
+    auto now = std::chrono::steady_clock::now();
+    bool logDue = logInterval > 0.0f &&
+                  std::chrono::duration<float>(now - lastLog).count() >=
+                      logInterval;
+    bool pollDue =
+        context->getDevice().hasMemoryBudget() &&
+        std::chrono::duration<float>(now - lastBudgetPoll).count() >=
+            BUDGET_POLL_INTERVAL;
+
+    if (!logDue && !pollDue)
+        return;
+
+    lastBudgetPoll = now;
+
+    MemoryStatistics &statistics = pollStatistics;
+    collectStatistics(statistics);
+
+    for (size_t i = 0; i < statistics.heaps.size(); i++)
+    {
+        const MemoryHeapStatistics &heap = statistics.heaps[i];
+        bool overBudget =
+            heap.budget > 0 &&
+            heap.budgetUsage > heap.budget * BUDGET_WARNING_RATIO;
+
+        if (overBudget && !heapOverBudget[i])
+        {
+            std::cerr << "Memory heap " << i << " at "
+                      << toMiB(heap.budgetUsage) << " of "
+                      << toMiB(heap.budget) << " MiB budget" << std::endl;
+        }
+        heapOverBudget[i] = overBudget;
+    }
+
+    if (logDue)
+    {
+        logStatistics(std::cout);
+        HostAllocator::logStatistics(std::cout);
+        lastLog = now;
+    }
+}
+
+void VulkanMemoryTracker::logStatistics(std::ostream &out) const
+{
+    MemoryStatistics statistics = getStatistics();
+
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(2);
+
+    out << "Device memory: " << statistics.allocationCount << " of "
+        << statistics.maxAllocationCount << " allocations\n";
+
+    for (size_t i = 0; i < statistics.heaps.size(); i++)
+    {
+        const MemoryHeapStatistics &heap = statistics.heaps[i];
+        out << "  heap " << i << " ("
+            << (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT ? "device"
+                                                             : "host")
+            << ", " << toMiB(heap.size) << " MiB): ";
+        logUsage(out, heap.usage);
+        if (statistics.budgetAvailable)
+        {
+            out << ", budget " << toMiB(heap.budgetUsage) << " / "
+                << toMiB(heap.budget) << " MiB";
+        }
+        out << '\n';
+    }
+
+    for (size_t i = 0; i < statistics.types.size(); i++)
+    {
+        const MemoryTypeStatistics &type = statistics.types[i];
+        if (type.usage.allocationCount == 0)
+            continue;
+
+        out << "  type " << i << " (heap " << type.heapIndex << ", flags 0x"
+            << std::hex << type.flags << std::dec << "): ";
+        logUsage(out, type.usage);
+        out << '\n';
+    }
+
+    for (size_t i = 0; i < statistics.categories.size(); i++)
+    {
+        out << "  " << memoryCategoryNames[i] << ": ";
+        logUsage(out, statistics.categories[i]);
+        out << '\n';
+    }
+
+    out.flush();
+    out.flags(flags);
+}
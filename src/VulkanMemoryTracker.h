@@ -0,0 +1,120 @@
+#ifndef VULKAN_MEMORY_TRACKER_H
+#define VULKAN_MEMORY_TRACKER_H
+
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#include "VulkanTypes.h"
+
+enum class MemoryCategory
+{
+    Geometry,
+    Uniforms,
+    Staging,
+    Textures,
+    Attachments,
+    Readback,
+    Other,
+    Count
+};
+
+const char *getMemoryCategoryName(MemoryCategory category);
+
+struct MemoryUsage
+{
+    VkDeviceSize allocatedBytes;
+    VkDeviceSize peakBytes;
+    // Bytes the driver rounded the requested sizes up by.
+    VkDeviceSize paddingBytes;
+    uint32_t allocationCount;
+};
+
+struct MemoryHeapStatistics
+{
+    VkDeviceSize size;
+    VkMemoryHeapFlags flags;
+    MemoryUsage usage;
+    // From VK_EXT_memory_budget, process wide and including memory this
+    // tracker does not know about. Zero when the extension is missing.
+    VkDeviceSize budget;
+    VkDeviceSize budgetUsage;
+};
+
+struct MemoryTypeStatistics
+{
+    uint32_t heapIndex;
+    VkMemoryPropertyFlags flags;
+    MemoryUsage usage;
+};
+
+struct MemoryStatistics
+{
+    std::vector<MemoryHeapStatistics> heaps;
+    std::vector<MemoryTypeStatistics> types;
+    std::array<MemoryUsage, static_cast<size_t>(MemoryCategory::Count)>
+        categories;
+    uint32_t allocationCount;
+    uint32_t maxAllocationCount;
+    bool budgetAvailable;
+};
+
+class VulkanMemoryTracker
+{
+  public:
+    VulkanMemoryTracker(VulkanContext *context);
+    ~VulkanMemoryTracker();
+    void init();
+    void recordAllocation(VkDeviceMemory memory,
+                          uint32_t memoryTypeIndex,
+                          VkDeviceSize size,
+                          VkDeviceSize requestedSize,
+                          MemoryCategory category);
+    void recordFree(VkDeviceMemory memory);
+    // Seconds between two dumps from update(); 0 disables them.
+    void setLogInterval(float seconds) { logInterval = seconds; }
+    // Called once per frame: dumps the statistics when the log interval
+    // elapsed and warns when a heap gets close to its budget.
+    void update();
+    void logStatistics(std::ostream &out) const;
+
+  private:
+    struct Allocation
+    {
+        uint32_t memoryTypeIndex;
+        VkDeviceSize size;
+        VkDeviceSize padding;
+        MemoryCategory category;
+    };
+
+    void collectStatistics(MemoryStatistics &statistics) const;
+    void queryBudget(MemoryStatistics &statistics) const;
+
+  public:
+    MemoryStatistics getStatistics() const;
+
+  private:
+    VulkanContext *context;
+
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    uint32_t maxAllocationCount;
+
+    mutable std::mutex mutex;
+    std::unordered_map<VkDeviceMemory, Allocation> allocations;
+    std::vector<MemoryUsage> heapUsage;
+    std::vector<MemoryUsage> typeUsage;
+    std::array<MemoryUsage, static_cast<size_t>(MemoryCategory::Count)>
+        categoryUsage;
+
+    float logInterval;
+    std::chrono::steady_clock::time_point lastLog;
+    std::chrono::steady_clock::time_point lastBudgetPoll;
+    std::vector<bool> heapOverBudget;
+    // Kept between update() calls so the budget poll doesn't allocate.
+    MemoryStatistics pollStatistics;
+};
+
+#endif // VULKAN_MEMORY_TRACKER_H
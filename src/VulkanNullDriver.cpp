@@ -0,0 +1,215 @@
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+#include "VulkanNullDriver.h"
+
+static const char *commandNames[VulkanNullDriver::COMMAND_COUNT] = {
+#define VULKAN_NULL_DRIVER_NAME(name) #name,
+    VULKAN_DISPATCH_DEVICE_FUNCTIONS(VULKAN_NULL_DRIVER_NAME)
+    VULKAN_DISPATCH_DYNAMIC_RENDERING_FUNCTIONS(VULKAN_NULL_DRIVER_NAME)
+#undef VULKAN_NULL_DRIVER_NAME
+};
+
+static std::atomic<uint64_t> callCounts[VulkanNullDriver::COMMAND_COUNT];
+
+// Checked on every call, the log itself only while recording.
+static std::atomic<bool> recording(false);
+static std::mutex callMutex;
+static std::vector<VulkanNullDriver::Call> calls;
+
+// VK_SUCCESS when nothing is pending.
+static std::atomic<int32_t> nextAcquireResult(VK_SUCCESS);
+static std::atomic<int32_t> nextPresentResult(VK_SUCCESS);
+
+// One argument as a 64 bit word: handles are pointers or 64 bit integers
+// depending on the platform, either is kept as is.
+template <typename T> static uint64_t toWord(T value)
+{
+    if constexpr (std::is_pointer_v<T>)
+    {
+        return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value));
+    }
+    else if constexpr (std::is_floating_point_v<T>)
+    {
+        uint64_t word = 0;
+        std::memcpy(&word, &value, sizeof(value));
+        return word;
+    }
+    else
+    {
+        return static_cast<uint64_t>(value);
+    }
+}
+
+template <typename... Arguments>
+static void recordCall(VulkanNullDriver::Command command,
+                       Arguments... arguments)
+{
+    static_assert(sizeof...(Arguments) <= VulkanNullDriver::MAX_ARGUMENTS,
+                  "Raise VulkanNullDriver::MAX_ARGUMENTS");
+    // The extra word keeps the array valid for commands without arguments.
+    const uint64_t words[] = {toWord(arguments)..., 0};
+    VulkanNullDriver::recordCall(command, words, sizeof...(Arguments));
+}
+
+// Any command: counts and returns VK_SUCCESS, or nothing for the void ones.
+template <VulkanNullDriver::Command command, typename Function>
+struct NullCommand;
+
+template <VulkanNullDriver::Command command,
+          typename Result,
+          typename... Arguments>
+struct NullCommand<command, Result(VKAPI_PTR *)(Arguments...)>
+{
+    static Result VKAPI_CALL call(Arguments... arguments)
+    {
+        recordCall(command, arguments...);
+        return Result();
+    }
+};
+
+// Always hands out the first image, it is as good as any other here.
+static VkResult VKAPI_CALL nullAcquireNextImage(VkDevice device,
+                                                VkSwapchainKHR swapChain,
+                                                uint64_t timeout,
+                                                VkSemaphore semaphore,
+                                                VkFence fence,
+                                                uint32_t *pImageIndex)
+{
+    recordCall(VulkanNullDriver::vkAcquireNextImageKHR,
+               device,
+               swapChain,
+               timeout,
+               semaphore,
+               fence,
+               pImageIndex);
+    *pImageIndex = 0;
+    return static_cast<VkResult>(nextAcquireResult.exchange(VK_SUCCESS));
+}
+
+static VkResult VKAPI_CALL nullQueuePresent(VkQueue queue,
+                                            const VkPresentInfoKHR *pInfo)
+{
+    recordCall(VulkanNullDriver::vkQueuePresentKHR, queue, pInfo);
+    return static_cast<VkResult>(nextPresentResult.exchange(VK_SUCCESS));
+}
+
+// Nothing ever executes, so no timestamp is ever written.
+static VkResult VKAPI_CALL nullGetQueryPoolResults(VkDevice device,
+                                                   VkQueryPool queryPool,
+                                                   uint32_t firstQuery,
+                                                   uint32_t queryCount,
+                                                   size_t dataSize,
+                                                   void *pData,
+                                                   VkDeviceSize stride,
+                                                   VkQueryResultFlags flags)
+{
+    recordCall(VulkanNullDriver::vkGetQueryPoolResults,
+               device,
+               queryPool,
+               firstQuery,
+               queryCount,
+               dataSize,
+               pData,
+               stride,
+               flags);
+    return VK_NOT_READY;
+}
+
+// Upload fences belong to real submissions, so their status is the device's.
+static PFN_vkGetFenceStatus deviceGetFenceStatus = nullptr;
+
+static VkResult VKAPI_CALL nullGetFenceStatus(VkDevice device, VkFence fence)
+{
+    recordCall(VulkanNullDriver::vkGetFenceStatus, device, fence);
+    return deviceGetFenceStatus(device, fence);
+}
+
+void VulkanNullDriver::load(VulkanDispatch &dispatch)
+{
+    deviceGetFenceStatus = dispatch.vkGetFenceStatus;
+
+#define VULKAN_NULL_DRIVER_LOAD(name)                                          \
+    dispatch.name = &NullCommand<name, PFN_##name>::call;
+    VULKAN_DISPATCH_DEVICE_FUNCTIONS(VULKAN_NULL_DRIVER_LOAD)
+    VULKAN_DISPATCH_DYNAMIC_RENDERING_FUNCTIONS(VULKAN_NULL_DRIVER_LOAD)
+#undef VULKAN_NULL_DRIVER_LOAD
+
+    dispatch.vkAcquireNextImageKHR = nullAcquireNextImage;
+    dispatch.vkGetFenceStatus = nullGetFenceStatus;
+    dispatch.vkGetQueryPoolResults = nullGetQueryPoolResults;
+    dispatch.vkQueuePresentKHR = nullQueuePresent;
+}
+
+void VulkanNullDriver::resetCallCounts()
+{
+    for (std::atomic<uint64_t> &count : callCounts)
+        count.store(0, std::memory_order_relaxed);
+}
+
+void VulkanNullDriver::countCall(Command command)
+{
+    callCounts[command].fetch_add(1, std::memory_order_relaxed);
+}
+
+void VulkanNullDriver::recordCall(Command command,
+                                  const uint64_t *arguments,
+                                  uint32_t argumentCount)
+{
+    countCall(command);
+    if (!recording.load(std::memory_order_relaxed))
+        return;
+
+    Call call{};
+    call.command = command;
+    call.argumentCount = argumentCount;
+    std::memcpy(call.arguments, arguments, argumentCount * sizeof(uint64_t));
+
+    std::lock_guard<std::mutex> lock(callMutex);
+    calls.push_back(call);
+}
+
+void VulkanNullDriver::setRecording(bool recording)
+{
+    ::recording.store(recording);
+}
+
+std::vector<VulkanNullDriver::Call> VulkanNullDriver::takeCalls()
+{
+    std::lock_guard<std::mutex> lock(callMutex);
+    std::vector<Call> taken;
+    taken.swap(calls);
+    return taken;
+}
+
+void VulkanNullDriver::failNextAcquire(VkResult result)
+{
+    nextAcquireResult.store(result);
+}
+
+void VulkanNullDriver::failNextPresent(VkResult result)
+{
+    nextPresentResult.store(result);
+}
+
+const char *VulkanNullDriver::getCommandName(Command command)
+{
+    return commandNames[command];
+}
+
+uint64_t VulkanNullDriver::getCallCount(Command command)
+{
+    return callCounts[command].load(std::memory_order_relaxed);
+}
+
+uint64_t VulkanNullDriver::getTotalCallCount()
+{
+    uint64_t total = 0;
+    for (const std::atomic<uint64_t> &count : callCounts)
+        total += count.load(std::memory_order_relaxed);
+    return total;
+}
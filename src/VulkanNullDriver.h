@@ -0,0 +1,66 @@
+#ifndef VULKAN_NULL_DRIVER_H
+#define VULKAN_NULL_DRIVER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "VulkanDispatch.h"
+
+// Stand-ins for the dispatch table's commands that never reach the driver:
+// each counts its call and succeeds. With them loaded a frame costs the
+// renderer's CPU time alone, and the counts show what it asked for.
+// Startup, uploads and everything else the loader serves still run on the
+// real device, so resources are real and only the frame loop is faked.
+// Acquiring always returns image 0 and timestamps are never ready. Fence
+// status is still asked of the device, only upload fences are polled.
+class VulkanNullDriver
+{
+  public:
+    enum Command : uint32_t
+    {
+#define VULKAN_NULL_DRIVER_COMMAND(name) name,
+        VULKAN_DISPATCH_DEVICE_FUNCTIONS(VULKAN_NULL_DRIVER_COMMAND)
+        VULKAN_DISPATCH_DYNAMIC_RENDERING_FUNCTIONS(VULKAN_NULL_DRIVER_COMMAND)
+#undef VULKAN_NULL_DRIVER_COMMAND
+        COMMAND_COUNT
+    };
+
+    // vkCmdPipelineBarrier takes the most.
+    static const uint32_t MAX_ARGUMENTS = 10;
+
+    // One recorded call. Integers and handles are kept by value, pointers
+    // by address; what they point to is gone once the call returned.
+    struct Call
+    {
+        Command command;
+        uint32_t argumentCount;
+        uint64_t arguments[MAX_ARGUMENTS];
+    };
+
+    // Overwrites every command, dynamic rendering ones included.
+    static void load(VulkanDispatch &dispatch);
+    static void resetCallCounts();
+    // From any thread, secondary command buffers record on the workers.
+    static void countCall(Command command);
+    // Counts the call, and logs it while recording.
+    static void recordCall(Command command,
+                           const uint64_t *arguments,
+                           uint32_t argumentCount);
+
+    // Logs every call in order, for tests. Calls from worker threads are
+    // ordered by when they were made, as seen under a lock.
+    static void setRecording(bool recording);
+    // Returns the calls logged so far and clears the log.
+    static std::vector<Call> takeCalls();
+
+    // The next acquire or present returns result instead of succeeding,
+    // once. Lets tests take the swap chain recreation paths.
+    static void failNextAcquire(VkResult result);
+    static void failNextPresent(VkResult result);
+
+    static const char *getCommandName(Command command);
+    static uint64_t getCallCount(Command command);
+    static uint64_t getTotalCallCount();
+};
+
+#endif // VULKAN_NULL_DRIVER_H
@@ -1,17 +1,34 @@
 #include <vulkan/vk_enum_string_helper.h>
 #include <vulkan/vulkan.h>
 
-#include <cstring>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 #include "config.h"
 
+#include "Camera.h"
+#include "DrawList.h"
+#include "FrameArena.h"
+#include "HostAllocator.h"
+#include "JobSystem.h"
+#include "LodSelector.h"
+#include "Profiler.h"
+#include "Scene.h"
+#include "Triangle.h"
 #include "VulkanContext.h"
 #include "utils.h"
 
 #include "VulkanPipeline.h"
 
-static const int MAX_FRAMES_IN_FLIGHT = 2;
+static const uint32_t INITIAL_INSTANCE_CAPACITY = 1024;
+// Objects per job when updating LODs and matrices.
+static const uint32_t UPDATE_OBJECTS_MIN_BATCH = 1024;
+// No level was written to the frame's descriptor set yet.
+static const uint32_t NO_BOUND_LEVEL = UINT32_MAX;
+static const SamplerDesc TEXTURE_SAMPLER = {VK_FILTER_LINEAR,
+                                            VK_SAMPLER_MIPMAP_MODE_LINEAR,
+                                            VK_SAMPLER_ADDRESS_MODE_REPEAT};
 
 static const std::vector<VkDynamicState> dynamicStates = {
     VK_DYNAMIC_STATE_VIEWPORT,
@@ -19,34 +36,42 @@ static const std::vector<VkDynamicState> dynamicStates = {
 
 VulkanPipeline::VulkanPipeline(VulkanContext *context)
     : context(context),
-      framesInFlight(MAX_FRAMES_IN_FLIGHT)
+      framesInFlight(context->getConfig().framesInFlight),
+      currentFrameIndex(0),
+      texture(VulkanTextureManager::WHITE_TEXTURE),
+      resolutionScaler(
+          context->getConfig().minResolutionScale,
+          static_cast<uint64_t>(context->getConfig().gpuBudgetMs * 1e6)),
+      drawStats{}
 {
 }
 
 VulkanPipeline::~VulkanPipeline()
 {
     VkDevice device = context->getDevice();
-
-    for (const auto &frameInFlight : framesInFlight)
+    const VkAllocationCallbacks *synchronization =
+        HostAllocator::get(HostAllocationTag::Synchronization);
+    const VkAllocationCallbacks *pipelineAllocator =
+        HostAllocator::get(HostAllocationTag::Pipeline);
+    const VkAllocationCallbacks *descriptors =
+        HostAllocator::get(HostAllocationTag::Descriptors);
+
+    for (auto &frameInFlight : framesInFlight)
     {
         vkDestroySemaphore(
-            device, frameInFlight.imageAvailableSemaphore, nullptr);
+            device, frameInFlight.imageAvailableSemaphore, synchronization);
         vkDestroySemaphore(
-            device, frameInFlight.renderFinishedSemaphore, nullptr);
-        vkDestroyFence(device, frameInFlight.inFlightFence, nullptr);
+            device, frameInFlight.renderFinishedSemaphore, synchronization);
+        vkDestroyFence(device, frameInFlight.inFlightFence, synchronization);
 
-        vkDestroyBuffer(device, frameInFlight.uniformBuffers.buffer, nullptr);
-        vkFreeMemory(device, frameInFlight.uniformBuffers.memory, nullptr);
+        destroyInstanceBuffer(frameInFlight.instanceBuffer);
     }
 
-    vkDestroyShaderModule(device, fragShaderModule, nullptr);
-    vkDestroyShaderModule(device, vertShaderModule, nullptr);
-
-    vkDestroyPipeline(device, graphicsPipeline, nullptr);
-    vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    vkDestroyShaderModule(device, fragShaderModule, pipelineAllocator);
+    vkDestroyShaderModule(device, vertShaderModule, pipelineAllocator);
 
-    vkDestroyDescriptorPool(device, descriptor.pool, nullptr);
-    vkDestroyDescriptorSetLayout(device, descriptor.setLayout, nullptr);
+    vkDestroyDescriptorPool(device, descriptor.pool, descriptors);
+    vkDestroyDescriptorSetLayout(device, descriptor.setLayout, descriptors);
 }
 
 void VulkanPipeline::init()
@@ -58,30 +83,76 @@ void VulkanPipeline::init()
     createPipeline();
 }
 
-void VulkanPipeline::drawFrame(const Triangle &triangle) const
+bool VulkanPipeline::drawFrame(const Scene &scene, const Camera &camera)
 {
+    PROFILE_ZONE("drawFrame");
+    uint64_t frameBegin = Profiler::now();
+    // Time spent waiting on the GPU and the presentation engine, left out
+    // of the frame's CPU time.
+    uint64_t blocked = 0;
+
     const VulkanDevice &device = context->getDevice();
+    const VulkanDispatch &dispatch = device.getDispatch();
 
-    static uint32_t currentFrameIndex = 0;
-    const FrameInFlight &currentFrame = framesInFlight[currentFrameIndex];
+    FrameInFlight &currentFrame = framesInFlight[currentFrameIndex];
 
-    vkWaitForFences(
-        device, 1, &currentFrame.inFlightFence, VK_TRUE, UINT64_MAX);
+    {
+        PROFILE_ZONE("vkWaitForFences");
+        uint64_t begin = Profiler::now();
+        dispatch.vkWaitForFences(
+            device, 1, &currentFrame.inFlightFence, VK_TRUE, UINT64_MAX);
+        blocked += Profiler::now() - begin;
+    }
+
+    FrameMonitor &frameMonitor = context->getFrameMonitor();
+
+    // The fence covers the last submission of this frame, so its
+    // timestamps are available now.
+    GpuFrameTiming gpuTiming;
+    if (context->getGpuTimer().collect(currentFrameIndex, gpuTiming))
+    {
+        Profiler::recordGpu("frame", gpuTiming.begin, gpuTiming.end);
+        resolutionScaler.update(gpuTiming.end - gpuTiming.begin);
+        frameMonitor.record(FrameMetric::GpuTime,
+                            gpuTiming.end - gpuTiming.begin);
+    }
+    context->getFrameCapture().collect(currentFrameIndex);
 
-    const VulkanSwapChain &swapChain = context->getSwapChain();
+    // Submissions finish in order, so does everything retired before it.
+    RetirementQueue &retirementQueue = context->getRetirementQueue();
+    retirementQueue.collect(currentFrame.submission);
+
+    // Nothing from the previous frame is referenced any more.
+    FrameArena &frameArena = context->getFrameArena();
+    frameArena.reset();
+
+    context->getTextureManager().update();
+    context->getMemoryTracker().update();
+    context->getAssetLoader().update();
+    updateTextureDescriptor(currentFrame);
+
+    VulkanSwapChain &swapChain = context->getSwapChain();
 
     uint32_t imageIndex;
-    VkResult result =
-        vkAcquireNextImageKHR(device,
-                              swapChain,
-                              UINT64_MAX,
-                              currentFrame.imageAvailableSemaphore,
-                              VK_NULL_HANDLE,
-                              &imageIndex);
+    VkResult result;
+    {
+        PROFILE_ZONE("vkAcquireNextImageKHR");
+        uint64_t begin = Profiler::now();
+        result = dispatch.vkAcquireNextImageKHR(
+            device,
+            swapChain,
+            UINT64_MAX,
+            currentFrame.imageAvailableSemaphore,
+            VK_NULL_HANDLE,
+            &imageIndex);
+        uint64_t acquireWait = Profiler::now() - begin;
+        frameMonitor.record(FrameMetric::AcquireWait, acquireWait);
+        blocked += acquireWait;
+    }
     if (result == VK_ERROR_OUT_OF_DATE_KHR)
     {
-        const_cast<VulkanSwapChain &>(swapChain).recreate();
-        return;
+        swapChain.recreate();
+        return false;
     }
     else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
     {
@@ -89,20 +160,88 @@ void VulkanPipeline::drawFrame(const Triangle &triangle) const
     }
 
     // Only reset the fence if we are submitting work
-    vkResetFences(device, 1, &currentFrame.inFlightFence);
+    dispatch.vkResetFences(device, 1, &currentFrame.inFlightFence);
+
+    // Rounded up, so even the smallest scale leaves a pixel.
+    VkExtent2D renderExtent = swapChain.getExtent();
+    if (swapChain.isScaled())
+    {
+        float scale = resolutionScaler.getScale();
+        renderExtent.width = static_cast<uint32_t>(
+            std::ceil(static_cast<float>(renderExtent.width) * scale));
+        renderExtent.height = static_cast<uint32_t>(
+            std::ceil(static_cast<float>(renderExtent.height) * scale));
+    }
+
+    const TransformSystem &transforms = scene.getTransforms();
+    uint32_t objectCount = scene.size();
+
+    // LODs are picked for the pixels actually rendered.
+    LodSelectionParams lodParams{};
+    lodParams.cameraPosition = camera.getPosition();
+    lodParams.projectionScale = computeProjectionScale(
+        (float)renderExtent.height, camera.getFovY());
+    lodParams.pixelThreshold = 1.0f;
+
+    float *objectRadii = frameArena.allocate<float>(objectCount);
+    uint8_t *objectLods = frameArena.allocate<uint8_t>(objectCount);
+
+    InstanceBuffer &instanceBuffer = currentFrame.instanceBuffer;
+    reserveInstances(instanceBuffer, objectCount);
+
+    const float *boundingRadii = scene.getBoundingRadii();
+    const MeshHandle *meshes = scene.getMeshes();
+    glm::mat4 viewProjection = camera.getViewProjection();
+    glm::mat4 *mvps = static_cast<glm::mat4 *>(instanceBuffer.mapped);
+
+    // Every batch writes a disjoint range of the radii, LODs and matrices.
+    auto updateObjects = [&](uint32_t begin, uint32_t end) {
+        PROFILE_ZONE("updateObjects");
+
+        for (uint32_t i = begin; i < end; i++)
+            objectRadii[i] = boundingRadii[i] * transforms.getMaxScale(i);
+
+        // Batched per run of entities sharing a mesh, and so a LOD chain.
+        for (uint32_t first = begin, last = begin; first < end; first = last)
+        {
+            while (last < end && meshes[last] == meshes[first])
+                last++;
+
+            const std::vector<MeshLod> &lods =
+                scene.getMesh(meshes[first]).getLods();
+            selectLods(lodParams,
+                       lods.data(),
+                       static_cast<uint32_t>(lods.size()),
+                       transforms.getPositionsX() + first,
+                       transforms.getPositionsY() + first,
+                       transforms.getPositionsZ() + first,
+                       objectRadii + first,
+                       last - first,
+                       objectLods + first);
+        }
+
+        transforms.computeMvps(
+            viewProjection, begin, end - begin, mvps + begin);
+    };
+
+    JobSystem &jobSystem = context->getJobSystem();
+    jobSystem.parallelFor(objectCount, UPDATE_OBJECTS_MIN_BATCH, updateObjects);
+
+    // Sorted by state, so recording can skip binding it again.
+    DrawList drawList;
+    drawList.build(scene, camera, frameArena, jobSystem);
 
     const VulkanRenderPass &renderPass = context->getRenderPass();
 
-    vkResetCommandBuffer(currentFrame.commandBuffer, 0);
+    dispatch.vkResetCommandBuffer(currentFrame.commandBuffer, 0);
     renderPass.recordCommandBuffer(currentFrame.commandBuffer,
-                                   &currentFrame.uniformBuffers.descriptorSet,
-                                   triangle,
-                                   imageIndex);
-
-    UniformBufferObject ubo =
-        updateUniform((float)swapChain.getExtent().width,
-                      (float)swapChain.getExtent().height);
-    memcpy(currentFrame.uniformBuffers.mapped, &ubo, sizeof(ubo));
+                                   &instanceBuffer.descriptorSet,
+                                   scene,
+                                   drawList,
+                                   objectLods,
+                                   renderExtent,
+                                   imageIndex,
+                                   drawStats);
 
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -120,14 +259,20 @@ void VulkanPipeline::drawFrame(const Triangle &triangle) const
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.pSignalSemaphores = signalSemaphores;
 
-    result = vkQueueSubmit(
-        device.getGraphicsQueue(), 1, &submitInfo, currentFrame.inFlightFence);
+    {
+        PROFILE_ZONE("vkQueueSubmit");
+        result = dispatch.vkQueueSubmit(device.getGraphicsQueue(),
+                                        1,
+                                        &submitInfo,
+                                        currentFrame.inFlightFence);
+    }
     if (result != VK_SUCCESS)
     {
         std::string errorMsg("Failed to submit draw commant buffer: ");
         errorMsg.append(string_VkResult(result));
         throw std::runtime_error(errorMsg);
     }
+    currentFrame.submission = retirementQueue.markSubmitted();
 
     VkPresentInfoKHR presentInfo{};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -139,18 +284,30 @@ void VulkanPipeline::drawFrame(const Triangle &triangle) const
     presentInfo.pImageIndices = &imageIndex;
     presentInfo.pResults = nullptr; // Optional
 
-    result = vkQueuePresentKHR(device.getPresentQueue(), &presentInfo);
-
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
     {
-        const_cast<VulkanSwapChain &>(swapChain).recreate();
+        PROFILE_ZONE("vkQueuePresentKHR");
+        uint64_t begin = Profiler::now();
+        result = dispatch.vkQueuePresentKHR(device.getPresentQueue(),
+                                            &presentInfo);
+        uint64_t end = Profiler::now();
+        frameMonitor.record(FrameMetric::PresentWait, end - begin);
+        blocked += end - begin;
+        frameMonitor.recordPresent(end);
     }
+
+    VulkanWindow &window = context->getWindow();
+    bool resized = window.consumeFramebufferResized();
+    bool recreate = result == VK_ERROR_OUT_OF_DATE_KHR ||
+                    result == VK_SUBOPTIMAL_KHR || resized;
+    if (recreate)
+        swapChain.recreate();
     else if (result != VK_SUCCESS)
-    {
         throw std::runtime_error("failed to present swap chain image!");
-    }
 
-    currentFrameIndex = (currentFrameIndex + 1) % MAX_FRAMES_IN_FLIGHT;
+    currentFrameIndex = (currentFrameIndex + 1) % getFramesInFlight();
+    frameMonitor.record(FrameMetric::CpuTime,
+                        Profiler::now() - frameBegin - blocked);
+    return !recreate;
 }
 
 void VulkanPipeline::createDescriptor()
@@ -161,20 +318,24 @@ void VulkanPipeline::createDescriptor()
 
 void VulkanPipeline::createDescriptorPool()
 {
-    descriptor.setsCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
+    descriptor.setsCount = getFramesInFlight();
 
-    VkDescriptorPoolSize poolSize{};
-    poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    poolSize.descriptorCount = descriptor.setsCount;
+    VkDescriptorPoolSize poolSizes[2]{};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[0].descriptorCount = descriptor.setsCount;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[1].descriptorCount = descriptor.setsCount;
 
     VkDescriptorPoolCreateInfo poolInfo{};
     poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.poolSizeCount = 1;
-    poolInfo.pPoolSizes = &poolSize;
+    poolInfo.poolSizeCount = 2;
+    poolInfo.pPoolSizes = poolSizes;
     poolInfo.maxSets = descriptor.setsCount;
 
+    const VkAllocationCallbacks *allocator =
+        HostAllocator::get(HostAllocationTag::Descriptors);
     if (vkCreateDescriptorPool(
-            context->getDevice(), &poolInfo, nullptr, &descriptor.pool) !=
+            context->getDevice(), &poolInfo, allocator, &descriptor.pool) !=
         VK_SUCCESS)
     {
         throw std::runtime_error("failed to create descriptor pool!");
@@ -183,20 +344,33 @@ void VulkanPipeline::createDescriptorPool()
 
 void VulkanPipeline::createDescriptorSetLayout()
 {
-    VkDescriptorSetLayoutBinding uboLayoutBinding{};
-    uboLayoutBinding.binding = 0;
-    uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    uboLayoutBinding.descriptorCount = 1;
-    uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-    uboLayoutBinding.pImmutableSamplers = nullptr; // Optional
+    VkDescriptorSetLayoutBinding instanceLayoutBinding{};
+    instanceLayoutBinding.binding = 0;
+    instanceLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    instanceLayoutBinding.descriptorCount = 1;
+    instanceLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    instanceLayoutBinding.pImmutableSamplers = nullptr; // Optional
+
+    VkDescriptorSetLayoutBinding samplerLayoutBinding{};
+    samplerLayoutBinding.binding = 1;
+    samplerLayoutBinding.descriptorType =
+        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    samplerLayoutBinding.descriptorCount = 1;
+    samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    samplerLayoutBinding.pImmutableSamplers = nullptr;
+
+    VkDescriptorSetLayoutBinding bindings[] = {instanceLayoutBinding,
+                                               samplerLayoutBinding};
 
     VkDescriptorSetLayoutCreateInfo layoutInfo{};
     layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layoutInfo.bindingCount = 1;
-    layoutInfo.pBindings = &uboLayoutBinding;
+    layoutInfo.bindingCount = 2;
+    layoutInfo.pBindings = bindings;
+    const VkAllocationCallbacks *allocator =
+        HostAllocator::get(HostAllocationTag::Descriptors);
     if (vkCreateDescriptorSetLayout(context->getDevice(),
                                     &layoutInfo,
-                                    nullptr,
+                                    allocator,
                                     &descriptor.setLayout) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to create descriptor set layout!");
@@ -221,19 +395,19 @@ void VulkanPipeline::createDescriptorSets(VkDescriptorSet *descriptorSets)
 }
 
 void VulkanPipeline::updateDescriptorSet(VkDescriptorSet descriptorSet,
-                                         VkBuffer uniformBuffer)
+                                         VkBuffer instanceBuffer) const
 {
     VkDescriptorBufferInfo bufferInfo{};
-    bufferInfo.buffer = uniformBuffer;
+    bufferInfo.buffer = instanceBuffer;
     bufferInfo.offset = 0;
-    bufferInfo.range = sizeof(UniformBufferObject);
+    bufferInfo.range = VK_WHOLE_SIZE;
 
     VkWriteDescriptorSet descriptorWrite{};
     descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
     descriptorWrite.dstSet = descriptorSet;
     descriptorWrite.dstBinding = 0;
     descriptorWrite.dstArrayElement = 0;
-    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
     descriptorWrite.descriptorCount = 1;
     descriptorWrite.pBufferInfo = &bufferInfo;
     descriptorWrite.pImageInfo = nullptr;       // Optional
@@ -243,30 +417,67 @@ void VulkanPipeline::updateDescriptorSet(VkDescriptorSet descriptorSet,
         context->getDevice(), 1, &descriptorWrite, 0, nullptr);
 }
 
+void VulkanPipeline::updateTextureDescriptor(FrameInFlight &frameInFlight) const
+{
+    // Each resident level is a new image, so the level tells whether the
+    // set still samples the current one.
+    const VulkanTextureManager &textureManager = context->getTextureManager();
+    uint32_t level = textureManager.getResidentLevel(texture);
+    if (frameInFlight.boundTexture == texture &&
+        frameInFlight.boundLevel == level)
+    {
+        return;
+    }
+
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.sampler = textureManager.getSampler(TEXTURE_SAMPLER);
+    imageInfo.imageView = textureManager.getImageView(texture);
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkWriteDescriptorSet descriptorWrite{};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = frameInFlight.instanceBuffer.descriptorSet;
+    descriptorWrite.dstBinding = 1;
+    descriptorWrite.dstArrayElement = 0;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(
+        context->getDevice(), 1, &descriptorWrite, 0, nullptr);
+
+    frameInFlight.boundTexture = texture;
+    frameInFlight.boundLevel = level;
+}
+
 void VulkanPipeline::createFramesInFlight()
 {
-    std::vector<VkCommandBuffer> commandBuffers(MAX_FRAMES_IN_FLIGHT);
+    uint32_t frameCount = getFramesInFlight();
+
+    std::vector<VkCommandBuffer> commandBuffers(frameCount);
     context->getBufferCreator().createCommandBuffers(commandBuffers.data(),
-                                                     MAX_FRAMES_IN_FLIGHT);
+                                                     frameCount);
 
-    std::vector<VkDescriptorSet> descriptorSets(MAX_FRAMES_IN_FLIGHT);
+    std::vector<VkDescriptorSet> descriptorSets(frameCount);
     createDescriptorSets(descriptorSets.data());
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+    for (size_t i = 0; i < frameCount; ++i)
     {
         framesInFlight[i].commandBuffer = commandBuffers[i];
+        framesInFlight[i].submission = 0;
+        framesInFlight[i].boundTexture = texture;
+        framesInFlight[i].boundLevel = NO_BOUND_LEVEL;
 
         createSyncObjects(framesInFlight[i].imageAvailableSemaphore,
                           framesInFlight[i].renderFinishedSemaphore,
                           framesInFlight[i].inFlightFence);
 
-        createUniformBuffers(framesInFlight[i].uniformBuffers.buffer,
-                             framesInFlight[i].uniformBuffers.memory,
-                             &framesInFlight[i].uniformBuffers.mapped);
+        InstanceBuffer &instanceBuffer = framesInFlight[i].instanceBuffer;
+        createInstanceBuffer(instanceBuffer, INITIAL_INSTANCE_CAPACITY);
 
-        framesInFlight[i].uniformBuffers.descriptorSet = descriptorSets[i];
-        updateDescriptorSet(framesInFlight[i].uniformBuffers.descriptorSet,
-                            framesInFlight[i].uniformBuffers.buffer);
+        instanceBuffer.descriptorSet = descriptorSets[i];
+        updateDescriptorSet(instanceBuffer.descriptorSet,
+                            instanceBuffer.buffer);
     }
 }
 
@@ -283,39 +494,83 @@ void VulkanPipeline::createSyncObjects(VkSemaphore &imageAvailableSemaphore,
     fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
     fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
+    const VkAllocationCallbacks *allocator =
+        HostAllocator::get(HostAllocationTag::Synchronization);
     if (vkCreateSemaphore(
-            device, &semaphoreInfo, nullptr, &imageAvailableSemaphore) !=
+            device, &semaphoreInfo, allocator, &imageAvailableSemaphore) !=
             VK_SUCCESS ||
         vkCreateSemaphore(
-            device, &semaphoreInfo, nullptr, &renderFinishedSemaphore) !=
+            device, &semaphoreInfo, allocator, &renderFinishedSemaphore) !=
             VK_SUCCESS ||
-        vkCreateFence(device, &fenceInfo, nullptr, &inFlightFence) !=
+        vkCreateFence(device, &fenceInfo, allocator, &inFlightFence) !=
             VK_SUCCESS)
     {
         throw std::runtime_error("failed to create semaphores!");
     }
 }
 
-void VulkanPipeline::createUniformBuffers(VkBuffer &uniformBuffers,
-                                          VkDeviceMemory &uniformBuffersMemory,
-                                          void **uniformBuffersMapped)
+void VulkanPipeline::createInstanceBuffer(InstanceBuffer &instanceBuffer,
+                                          uint32_t capacity) const
 {
-
-    VkDeviceSize bufferSize = sizeof(UniformBufferObject);
+    VkDeviceSize bufferSize = sizeof(glm::mat4) * capacity;
     context->getBufferCreator().createBuffer(
         bufferSize,
-        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
             VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        uniformBuffers,
-        uniformBuffersMemory);
-
-    vkMapMemory(context->getDevice(),
-                uniformBuffersMemory,
-                0,
-                bufferSize,
-                0,
-                uniformBuffersMapped);
+        MemoryCategory::Uniforms,
+        instanceBuffer.buffer,
+        instanceBuffer.memory);
+
+    VkResult result = vkMapMemory(context->getDevice(),
+                                  instanceBuffer.memory,
+                                  0,
+                                  bufferSize,
+                                  0,
+                                  &instanceBuffer.mapped);
+    if (result != VK_SUCCESS)
+    {
+        // Released here, so nothing writes through the mapping or frees
+        // the buffer twice.
+        destroyInstanceBuffer(instanceBuffer);
+        instanceBuffer.buffer = VK_NULL_HANDLE;
+        instanceBuffer.memory = VK_NULL_HANDLE;
+        instanceBuffer.mapped = nullptr;
+        instanceBuffer.capacity = 0;
+
+        std::string errorMsg("Failed to map instance buffer: ");
+        errorMsg.append(string_VkResult(result));
+        throw std::runtime_error(errorMsg);
+    }
+
+    instanceBuffer.capacity = capacity;
+}
+
+void VulkanPipeline::destroyInstanceBuffer(InstanceBuffer &instanceBuffer) const
+{
+    vkDestroyBuffer(context->getDevice(),
+                    instanceBuffer.buffer,
+                    HostAllocator::get(HostAllocationTag::Buffers));
+    context->getBufferCreator().freeMemory(instanceBuffer.memory);
+}
+
+void VulkanPipeline::reserveInstances(InstanceBuffer &instanceBuffer,
+                                      uint32_t count) const
+{
+    if (count <= instanceBuffer.capacity)
+        return;
+
+    // Empty after a failed map.
+    uint32_t capacity =
+        std::max(instanceBuffer.capacity, INITIAL_INSTANCE_CAPACITY);
+    while (capacity < count)
+        capacity *= 2;
+
+    // The frame's fence was waited on, neither the buffer nor the
+    // descriptor set are in use.
+    destroyInstanceBuffer(instanceBuffer);
+    createInstanceBuffer(instanceBuffer, capacity);
+    updateDescriptorSet(instanceBuffer.descriptorSet, instanceBuffer.buffer);
 }
 
 void VulkanPipeline::createPipeline()
@@ -330,7 +585,10 @@ void VulkanPipeline::createPipeline()
     auto bindingDescription = Vertex::getBindingDescription();
     auto attributeDescriptions = Vertex::getAttributeDescriptions();
     VkPipelineVertexInputStateCreateInfo vertexInputInfo =
-        createVertexInputInfo(bindingDescription, attributeDescriptions);
+        createVertexInputInfo(
+            bindingDescription,
+            attributeDescriptions.data(),
+            static_cast<uint32_t>(attributeDescriptions.size()));
     pipelineInfo.pVertexInputState = &vertexInputInfo;
 
     VkPipelineInputAssemblyStateCreateInfo inputAssembly =
@@ -359,23 +617,38 @@ void VulkanPipeline::createPipeline()
     createPipelineLayout();
     pipelineInfo.layout = pipelineLayout;
 
-    pipelineInfo.renderPass = context->getRenderPass();
+    // Dynamic rendering names the attachment formats instead of a render
+    // pass the pipeline must be compatible with.
+    const VulkanRenderPass &renderPass = context->getRenderPass();
+    VkFormat colorFormat = context->getSwapChain().getImageFormat();
+    VkPipelineRenderingCreateInfoKHR renderingInfo{};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+    renderingInfo.colorAttachmentCount = 1;
+    renderingInfo.pColorAttachmentFormats = &colorFormat;
+    if (renderPass.usesDynamicRendering())
+        pipelineInfo.pNext = &renderingInfo;
+
+    pipelineInfo.renderPass = renderPass;
     pipelineInfo.subpass = 0;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
     pipelineInfo.basePipelineIndex = -1;              // Optional
 
-    VkResult result = vkCreateGraphicsPipelines(context->getDevice(),
-                                                VK_NULL_HANDLE,
-                                                1,
-                                                &pipelineInfo,
-                                                nullptr,
-                                                &graphicsPipeline);
+    VkPipeline pipeline;
+    VkResult result = vkCreateGraphicsPipelines(
+        context->getDevice(),
+        VK_NULL_HANDLE,
+        1,
+        &pipelineInfo,
+        HostAllocator::get(HostAllocationTag::Pipeline),
+        &pipeline);
     if (result != VK_SUCCESS)
     {
         std::string errorMsg("Failed to create graphicsPipeline: ");
         errorMsg.append(string_VkResult(result));
         throw std::runtime_error(errorMsg);
     }
+    graphicsPipeline =
+        UniquePipeline(context->getRetirementQueue(), pipeline);
 }
 
 void VulkanPipeline::createPipelineLayout()
@@ -387,19 +660,30 @@ void VulkanPipeline::createPipelineLayout()
     pipelineLayoutInfo.pushConstantRangeCount = 0;    // Optional
     pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
 
-    VkResult result = vkCreatePipelineLayout(
-        context->getDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout);
+    VkPipelineLayout layout;
+    VkResult result =
+        vkCreatePipelineLayout(context->getDevice(),
+                               &pipelineLayoutInfo,
+                               HostAllocator::get(HostAllocationTag::Pipeline),
+                               &layout);
     if (result != VK_SUCCESS)
     {
         std::string errorMsg("Failed to create pipeline layout: ");
         errorMsg.append(string_VkResult(result));
         throw std::runtime_error(errorMsg);
     }
+    pipelineLayout =
+        UniquePipelineLayout(context->getRetirementQueue(), layout);
+}
+
+void VulkanPipeline::loadShaderCode()
+{
+    vertShaderCode = readFile(SHADERS_DIR "/vert.spv");
+    fragShaderCode = readFile(SHADERS_DIR "/frag.spv");
 }
 
 std::vector<VkPipelineShaderStageCreateInfo> VulkanPipeline::createShaders()
 {
-    auto vertShaderCode = readFile(SHADERS_DIR "/vert.spv");
     vertShaderModule = createShaderModule(vertShaderCode);
     VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
     vertShaderStageInfo.sType =
@@ -408,7 +692,6 @@ std::vector<VkPipelineShaderStageCreateInfo> VulkanPipeline::createShaders()
     vertShaderStageInfo.module = vertShaderModule;
     vertShaderStageInfo.pName = "main";
 
-    auto fragShaderCode = readFile(SHADERS_DIR "/frag.spv");
     fragShaderModule = createShaderModule(fragShaderCode);
     VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
     fragShaderStageInfo.sType =
@@ -429,8 +712,11 @@ VkShaderModule VulkanPipeline::createShaderModule(const std::vector<char> &code)
     createInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
 
     VkShaderModule shaderModule;
-    VkResult result = vkCreateShaderModule(
-        context->getDevice(), &createInfo, nullptr, &shaderModule);
+    VkResult result =
+        vkCreateShaderModule(context->getDevice(),
+                             &createInfo,
+                             HostAllocator::get(HostAllocationTag::Pipeline),
+                             &shaderModule);
     if (result != VK_SUCCESS)
     {
         std::string errorMsg("Failed to create shader module: ");
@@ -443,7 +729,8 @@ VkShaderModule VulkanPipeline::createShaderModule(const std::vector<char> &code)
 
 VkPipelineVertexInputStateCreateInfo VulkanPipeline::createVertexInputInfo(
     const VkVertexInputBindingDescription &bindingDescription,
-    const std::vector<VkVertexInputAttributeDescription> &attributeDescriptions)
+    const VkVertexInputAttributeDescription *attributeDescriptions,
+    uint32_t attributeCount)
 {
     VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
     vertexInputInfo.sType =
@@ -452,9 +739,8 @@ VkPipelineVertexInputStateCreateInfo VulkanPipeline::createVertexInputInfo(
     vertexInputInfo.vertexBindingDescriptionCount = 1;
     vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
 
-    vertexInputInfo.vertexAttributeDescriptionCount =
-        static_cast<uint32_t>(attributeDescriptions.size());
-    vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+    vertexInputInfo.vertexAttributeDescriptionCount = attributeCount;
+    vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions;
 
     return vertexInputInfo;
 }
@@ -471,25 +757,14 @@ VkPipelineInputAssemblyStateCreateInfo VulkanPipeline::createInputAssembly()
 
 VkPipelineViewportStateCreateInfo VulkanPipeline::createViewportState()
 {
-    const VkExtent2D &swapChainExtent = context->getSwapChain().getExtent();
-    VkViewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = (float)swapChainExtent.width;
-    viewport.height = (float)swapChainExtent.height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    VkRect2D scissor{};
-    scissor.offset = {0, 0};
-    scissor.extent = swapChainExtent;
-
+    // Both are dynamic states set while recording, so the pipeline does not
+    // depend on the swap chain and can be built while it is created.
     VkPipelineViewportStateCreateInfo viewportState{};
     viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
     viewportState.viewportCount = 1;
-    viewportState.pViewports = &viewport;
+    viewportState.pViewports = nullptr;
     viewportState.scissorCount = 1;
-    viewportState.pScissors = &scissor;
+    viewportState.pScissors = nullptr;
 
     return viewportState;
 }
@@ -518,7 +793,7 @@ VkPipelineMultisampleStateCreateInfo VulkanPipeline::createMultisampling()
     multisampling.sType =
         VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
     multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisampling.rasterizationSamples = context->getDevice().getSampleCount();
     multisampling.minSampleShading = 1.0f;          // Optional
     multisampling.pSampleMask = nullptr;            // Optional
     multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
@@ -1,6 +1,10 @@
 #ifndef VULKAN_PIPELINE_H
 #define VULKAN_PIPELINE_H
 
+#include "ResolutionScaler.h"
+#include "RetirementQueue.h"
+#include "VulkanRenderPass.h"
+#include "VulkanTextureManager.h"
 #include "VulkanTypes.h"
 #include <vector>
 #include <vulkan/vulkan_core.h>
@@ -12,11 +16,13 @@ struct Descriptor
     uint32_t setsCount;
 };
 
-struct UniformBuffers
+// Per object model view projection matrices, indexed by gl_InstanceIndex.
+struct InstanceBuffer
 {
     VkBuffer buffer;
     VkDeviceMemory memory;
     void *mapped;
+    uint32_t capacity;
     VkDescriptorSet descriptorSet;
 };
 
@@ -26,8 +32,14 @@ struct FrameInFlight
     VkSemaphore imageAvailableSemaphore;
     VkSemaphore renderFinishedSemaphore;
     VkFence inFlightFence;
-
-    UniformBuffers uniformBuffers;
+    // RetirementQueue number of the last submission the fence covers.
+    uint64_t submission;
+
+    InstanceBuffer instanceBuffer;
+    // Sampled through the descriptor set, which is rewritten whenever
+    // another texture or level becomes resident.
+    TextureHandle boundTexture;
+    uint32_t boundLevel;
 };
 
 class VulkanPipeline
@@ -36,7 +48,14 @@ class VulkanPipeline
     VulkanPipeline(VulkanContext *context);
     ~VulkanPipeline();
     void init();
-    void drawFrame(const Triangle &triangle) const;
+    // Reads the SPIR-V files, init() expects them loaded.
+    void loadShaderCode();
+    // One draw call per visible entity, in DrawList order. Returns false
+    // when the swap chain was recreated instead, the frame should then be
+    // drawn again.
+    bool drawFrame(const Scene &scene, const Camera &camera);
+    // Sampled by every draw, from the next frame on.
+    void setTexture(TextureHandle handle) { texture = handle; }
 
   private:
     void createDescriptor();
@@ -44,15 +63,20 @@ class VulkanPipeline
     void createDescriptorSetLayout();
     void createDescriptorSets(VkDescriptorSet *descriptorSets);
     void updateDescriptorSet(VkDescriptorSet descriptorSet,
-                             VkBuffer uniformBuffer);
+                             VkBuffer instanceBuffer) const;
+    // Only safe once the frame's fence was waited on.
+    void updateTextureDescriptor(FrameInFlight &frameInFlight) const;
 
     void createFramesInFlight();
     void createSyncObjects(VkSemaphore &imageAvailableSemaphore,
                            VkSemaphore &renderFinishedSemaphore,
                            VkFence &inFlightFence);
-    void createUniformBuffers(VkBuffer &uniformBuffers,
-                              VkDeviceMemory &uniformBuffersMemory,
-                              void **uniformBuffersMapped);
+    void createInstanceBuffer(InstanceBuffer &instanceBuffer,
+                              uint32_t capacity) const;
+    void destroyInstanceBuffer(InstanceBuffer &instanceBuffer) const;
+    // Only safe once the frame's fence was waited on.
+    void reserveInstances(InstanceBuffer &instanceBuffer,
+                          uint32_t count) const;
 
     void createPipeline();
     void createPipelineLayout();
@@ -61,8 +85,8 @@ class VulkanPipeline
     VkShaderModule createShaderModule(const std::vector<char> &code);
     VkPipelineVertexInputStateCreateInfo createVertexInputInfo(
         const VkVertexInputBindingDescription &bindingDescription,
-        const std::vector<VkVertexInputAttributeDescription>
-            &attributeDescriptions);
+        const VkVertexInputAttributeDescription *attributeDescriptions,
+        uint32_t attributeCount);
     VkPipelineInputAssemblyStateCreateInfo createInputAssembly();
     VkPipelineViewportStateCreateInfo createViewportState();
     VkPipelineRasterizationStateCreateInfo createRasterizer();
@@ -74,20 +98,39 @@ class VulkanPipeline
 
   public:
     VkPipelineLayout getLayout() const { return pipelineLayout; }
+    uint32_t getFramesInFlight() const
+    {
+        return static_cast<uint32_t>(framesInFlight.size());
+    }
+    uint32_t getCurrentFrameIndex() const { return currentFrameIndex; }
+    const ResolutionScaler &getResolutionScaler() const
+    {
+        return resolutionScaler;
+    }
+    const DrawStats &getDrawStats() const { return drawStats; }
     operator VkPipeline() const { return graphicsPipeline; }
 
   private:
     VulkanContext *context;
 
-    VkPipeline graphicsPipeline;
+    UniquePipeline graphicsPipeline;
 
-    VkPipelineLayout pipelineLayout;
+    UniquePipelineLayout pipelineLayout;
 
+    std::vector<char> vertShaderCode;
+    std::vector<char> fragShaderCode;
     VkShaderModule vertShaderModule;
     VkShaderModule fragShaderModule;
 
     Descriptor descriptor;
 
     std::vector<FrameInFlight> framesInFlight;
+    uint32_t currentFrameIndex;
+    TextureHandle texture;
+    // Follows the GPU frame times, only applied when the swap chain is
+    // scaled.
+    ResolutionScaler resolutionScaler;
+    // Of the last recorded frame.
+    DrawStats drawStats;
 };
 #endif // VULKAN_PIPELINE_H
@@ -1,68 +1,182 @@
 #include <vulkan/vk_enum_string_helper.h>
 #include <vulkan/vulkan.h>
 
+#include <algorithm>
 #include <iostream>
 
+#include "DrawList.h"
+#include "FrameArena.h"
+#include "HostAllocator.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "Scene.h"
 #include "Triangle.h"
 #include "VulkanContext.h"
 
 #include "VulkanRenderPass.h"
 
-VulkanRenderPass::VulkanRenderPass(VulkanContext *context) : context(context) {}
+// Below this recording inline is cheaper than waking the workers.
+static const uint32_t PARALLEL_RECORDING_MIN_DRAWS = 4096;
+
+static const VkClearValue CLEAR_COLOR = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
+
+static void transitionColorImage(const VulkanDispatch &dispatch,
+                                 VkCommandBuffer commandBuffer,
+                                 VkImage image,
+                                 VkImageLayout oldLayout,
+                                 VkImageLayout newLayout,
+                                 VkAccessFlags srcAccessMask,
+                                 VkAccessFlags dstAccessMask,
+                                 VkPipelineStageFlags srcStageMask,
+                                 VkPipelineStageFlags dstStageMask)
+{
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.srcAccessMask = srcAccessMask;
+    barrier.dstAccessMask = dstAccessMask;
+
+    dispatch.vkCmdPipelineBarrier(commandBuffer,
+                                  srcStageMask,
+                                  dstStageMask,
+                                  0,
+                                  0,
+                                  nullptr,
+                                  0,
+                                  nullptr,
+                                  1,
+                                  &barrier);
+}
+
+VulkanRenderPass::VulkanRenderPass(VulkanContext *context)
+    : context(context),
+      renderPass(VK_NULL_HANDLE),
+      dynamicRendering(false),
+      samples(VK_SAMPLE_COUNT_1_BIT),
+      scaled(false)
+{
+}
 
 VulkanRenderPass::~VulkanRenderPass()
 {
     VkDevice device = context->getDevice();
 
-    vkDestroyRenderPass(device, renderPass, nullptr);
+    for (const SecondaryCommandBuffer &secondary : secondaryCommandBuffers)
+        vkDestroyCommandPool(device,
+                             secondary.pool,
+                             HostAllocator::get(HostAllocationTag::Commands));
+
+    vkDestroyRenderPass(device,
+                        renderPass,
+                        HostAllocator::get(HostAllocationTag::RenderPass));
 }
 
 void VulkanRenderPass::init()
 {
-    createRenderPass();
-    const_cast<VulkanSwapChain &>(context->getSwapChain()).createFrameBuffers();
+    dynamicRendering = context->getDevice().hasDynamicRendering();
+    samples = context->getDevice().getSampleCount();
+    scaled = context->getSwapChain().isScaled();
+    if (!dynamicRendering)
+        createRenderPass();
+
+    createSecondaryCommandBuffers();
 }
 
 void VulkanRenderPass::createRenderPass()
 {
-    VkAttachmentDescription colorAttachment{};
-    colorAttachment.format = context->getSwapChain().getImageFormat();
-    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    VkFormat format = context->getSwapChain().getImageFormat();
+    bool multisampled = samples != VK_SAMPLE_COUNT_1_BIT;
+    // Scaled, the image rendered to is blitted next instead of presented.
+    VkImageLayout finalLayout = scaled ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+                                       : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    // With MSAA, attachment 0 is the multisampled target, resolved into the
+    // swap chain image at the end of the subpass and never stored.
+    VkAttachmentDescription attachments[2] = {};
+    VkAttachmentDescription &colorAttachment = attachments[0];
+    colorAttachment.format = format;
+    colorAttachment.samples = samples;
     colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.storeOp = multisampled ? VK_ATTACHMENT_STORE_OP_DONT_CARE
+                                           : VK_ATTACHMENT_STORE_OP_STORE;
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    colorAttachment.finalLayout =
+        multisampled ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : finalLayout;
+
+    VkAttachmentDescription &resolveAttachment = attachments[1];
+    resolveAttachment.format = format;
+    resolveAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    resolveAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    resolveAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    resolveAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    resolveAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    resolveAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    resolveAttachment.finalLayout = finalLayout;
 
     VkAttachmentReference colorAttachmentRef{};
     colorAttachmentRef.attachment = 0;
     colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
+    VkAttachmentReference resolveAttachmentRef{};
+    resolveAttachmentRef.attachment = 1;
+    resolveAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
     VkSubpassDescription subpass{};
     subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
     subpass.colorAttachmentCount = 1;
     subpass.pColorAttachments = &colorAttachmentRef;
+    if (multisampled)
+        subpass.pResolveAttachments = &resolveAttachmentRef;
 
-    VkSubpassDependency dependency{};
+    // The multisampled and scene targets are shared by the frames in
+    // flight, the previous frame's writes and blit must be done before they
+    // are cleared again.
+    VkSubpassDependency dependencies[2] = {};
+    VkSubpassDependency &dependency = dependencies[0];
     dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
     dependency.dstSubpass = 0;
     dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.srcAccessMask = 0;
+    if (scaled)
+        dependency.srcStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dependency.srcAccessMask =
+        multisampled ? VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT : 0;
     dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
     dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 
+    // The blit reads what the subpass wrote.
+    VkSubpassDependency &blitDependency = dependencies[1];
+    blitDependency.srcSubpass = 0;
+    blitDependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+    blitDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    blitDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    blitDependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    blitDependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
     VkRenderPassCreateInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderPassInfo.attachmentCount = 1;
-    renderPassInfo.pAttachments = &colorAttachment;
+    renderPassInfo.attachmentCount = multisampled ? 2 : 1;
+    renderPassInfo.pAttachments = attachments;
     renderPassInfo.subpassCount = 1;
     renderPassInfo.pSubpasses = &subpass;
-    renderPassInfo.dependencyCount = 1;
-    renderPassInfo.pDependencies = &dependency;
+    renderPassInfo.dependencyCount = scaled ? 2 : 1;
+    renderPassInfo.pDependencies = dependencies;
 
-    VkResult result = vkCreateRenderPass(
-        context->getDevice(), &renderPassInfo, nullptr, &renderPass);
+    VkResult result =
+        vkCreateRenderPass(context->getDevice(),
+                           &renderPassInfo,
+                           HostAllocator::get(HostAllocationTag::RenderPass),
+                           &renderPass);
     if (result != VK_SUCCESS)
     {
         std::string errorMsg("Failed to create render pass: ");
@@ -74,15 +188,23 @@ void VulkanRenderPass::createRenderPass()
 void VulkanRenderPass::recordCommandBuffer(
     VkCommandBuffer commandBuffer,
     const VkDescriptorSet *descriptorSets,
-    const Triangle &triangle,
-    uint32_t imageIndex) const
+    const Scene &scene,
+    const DrawList &drawList,
+    const uint8_t *objectLods,
+    VkExtent2D renderExtent,
+    uint32_t imageIndex,
+    DrawStats &stats) const
 {
+    PROFILE_ZONE("recordCommandBuffer");
+
+    const VulkanDispatch &dispatch = context->getDevice().getDispatch();
+
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     beginInfo.flags = 0;                  // Optional
     beginInfo.pInheritanceInfo = nullptr; // Optional
 
-    VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    VkResult result = dispatch.vkBeginCommandBuffer(commandBuffer, &beginInfo);
     if (result != VK_SUCCESS)
     {
         std::string errorMsg("Failed to begin recording a command buffer: ");
@@ -90,63 +212,562 @@ void VulkanRenderPass::recordCommandBuffer(
         throw std::runtime_error(errorMsg);
     }
 
+    const VulkanGpuTimer &gpuTimer = context->getGpuTimer();
+    uint32_t frameIndex = context->getPipeline().getCurrentFrameIndex();
+    gpuTimer.writeBegin(commandBuffer, frameIndex);
+
+    const JobSystem &jobSystem = context->getJobSystem();
+    bool parallel = jobSystem.getThreadCount() > 1 &&
+                    drawList.size() >= PARALLEL_RECORDING_MIN_DRAWS;
+
     const VulkanSwapChain &swapChain = context->getSwapChain();
+    // Dynamic rendering has none, secondaries inherit the formats instead.
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    if (dynamicRendering)
+    {
+        beginRendering(commandBuffer, imageIndex, renderExtent, parallel);
+    }
+    else
+    {
+        framebuffer = swapChain.getFrameBuffers()[imageIndex];
+        beginRenderPass(commandBuffer, framebuffer, renderExtent, parallel);
+    }
+
+    stats = {};
+    if (parallel)
+    {
+        recordParallel(commandBuffer,
+                       descriptorSets,
+                       scene,
+                       drawList,
+                       objectLods,
+                       renderExtent,
+                       framebuffer,
+                       frameIndex,
+                       stats);
+    }
+    else
+    {
+        recordDraws(commandBuffer,
+                    descriptorSets,
+                    scene,
+                    drawList,
+                    objectLods,
+                    renderExtent,
+                    0,
+                    drawList.size(),
+                    stats);
+    }
+
+    if (dynamicRendering)
+        endRendering(commandBuffer, imageIndex);
+    else
+        dispatch.vkCmdEndRenderPass(commandBuffer);
+
+    if (scaled)
+        blitToSwapChain(commandBuffer, imageIndex, renderExtent);
+
+    context->getFrameCapture().recordCopy(commandBuffer,
+                                          frameIndex,
+                                          swapChain.getImages()[imageIndex],
+                                          VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                                          swapChain.getExtent());
+
+    gpuTimer.writeEnd(commandBuffer, frameIndex);
+
+    result = dispatch.vkEndCommandBuffer(commandBuffer);
+    if (result != VK_SUCCESS)
+    {
+        std::string errorMsg("Failed to record a command buffer: ");
+        errorMsg.append(string_VkResult(result));
+        throw std::runtime_error(errorMsg);
+    }
+}
+
+void VulkanRenderPass::beginRenderPass(VkCommandBuffer commandBuffer,
+                                       VkFramebuffer framebuffer,
+                                       VkExtent2D renderExtent,
+                                       bool parallel) const
+{
     VkRenderPassBeginInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     renderPassInfo.renderPass = renderPass;
-    renderPassInfo.framebuffer = swapChain.getFrameBuffers()[imageIndex];
+    renderPassInfo.framebuffer = framebuffer;
     renderPassInfo.renderArea.offset = {0, 0};
-    renderPassInfo.renderArea.extent = swapChain.getExtent();
-    VkClearValue clearColor = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
+    renderPassInfo.renderArea.extent = renderExtent;
     renderPassInfo.clearValueCount = 1;
-    renderPassInfo.pClearValues = &clearColor;
+    renderPassInfo.pClearValues = &CLEAR_COLOR;
 
-    vkCmdBeginRenderPass(
-        commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    VkSubpassContents contents =
+        parallel ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+                 : VK_SUBPASS_CONTENTS_INLINE;
+    context->getDevice().getDispatch().vkCmdBeginRenderPass(
+        commandBuffer, &renderPassInfo, contents);
+}
 
-    const VulkanPipeline &pipeline = context->getPipeline();
+void VulkanRenderPass::beginRendering(VkCommandBuffer commandBuffer,
+                                      uint32_t imageIndex,
+                                      VkExtent2D renderExtent,
+                                      bool parallel) const
+{
+    const VulkanDispatch &dispatch = context->getDevice().getDispatch();
+    const VulkanSwapChain &swapChain = context->getSwapChain();
+    VkImage image = scaled ? swapChain.getSceneImage()
+                           : swapChain.getImages()[imageIndex];
+    VkImageView imageView = scaled ? swapChain.getSceneImageView()
+                                   : swapChain.getImageViews()[imageIndex];
+
+    // What the render pass' initial layout and subpass dependency do.
+    transitionColorImage(dispatch,
+                         commandBuffer,
+                         image,
+                         VK_IMAGE_LAYOUT_UNDEFINED,
+                         VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                         0,
+                         VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                             (scaled ? VK_PIPELINE_STAGE_TRANSFER_BIT : 0),
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+    VkRenderingAttachmentInfoKHR colorAttachment{};
+    colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+    colorAttachment.imageView = imageView;
+    colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    colorAttachment.resolveMode = VK_RESOLVE_MODE_NONE;
+    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.clearValue = CLEAR_COLOR;
+
+    if (samples != VK_SAMPLE_COUNT_1_BIT)
+    {
+        // Shared by the frames in flight, the previous writes must land
+        // before it is cleared again.
+        transitionColorImage(dispatch,
+                             commandBuffer,
+                             swapChain.getColorImage(),
+                             VK_IMAGE_LAYOUT_UNDEFINED,
+                             VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                             VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                             VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                             VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                             VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
 
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        // Resolved as the rendering ends, the samples are never stored.
+        colorAttachment.imageView = swapChain.getColorImageView();
+        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        colorAttachment.resolveMode = VK_RESOLVE_MODE_AVERAGE_BIT;
+        colorAttachment.resolveImageView = imageView;
+        colorAttachment.resolveImageLayout =
+            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    }
+
+    VkRenderingInfoKHR renderingInfo{};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+    renderingInfo.flags =
+        parallel ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR : 0;
+    renderingInfo.renderArea.offset = {0, 0};
+    renderingInfo.renderArea.extent = renderExtent;
+    renderingInfo.layerCount = 1;
+    renderingInfo.colorAttachmentCount = 1;
+    renderingInfo.pColorAttachments = &colorAttachment;
+
+    dispatch.vkCmdBeginRenderingKHR(commandBuffer, &renderingInfo);
+}
+
+void VulkanRenderPass::endRendering(VkCommandBuffer commandBuffer,
+                                    uint32_t imageIndex) const
+{
+    const VulkanDispatch &dispatch = context->getDevice().getDispatch();
+    dispatch.vkCmdEndRenderingKHR(commandBuffer);
+
+    const VulkanSwapChain &swapChain = context->getSwapChain();
+    if (scaled)
+    {
+        // What the render pass' final layout and blit dependency do.
+        transitionColorImage(dispatch,
+                             commandBuffer,
+                             swapChain.getSceneImage(),
+                             VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                             VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                             VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                             VK_ACCESS_TRANSFER_READ_BIT,
+                             VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT);
+        return;
+    }
+
+    // The render pass' final layout. Presenting waits on a semaphore, so
+    // nothing after this needs to see the writes.
+    transitionColorImage(dispatch,
+                         commandBuffer,
+                         swapChain.getImages()[imageIndex],
+                         VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                         VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                         VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                         0,
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+}
+
+void VulkanRenderPass::blitToSwapChain(VkCommandBuffer commandBuffer,
+                                       uint32_t imageIndex,
+                                       VkExtent2D renderExtent) const
+{
+    PROFILE_ZONE("blitToSwapChain");
+
+    const VulkanDispatch &dispatch = context->getDevice().getDispatch();
+    const VulkanSwapChain &swapChain = context->getSwapChain();
+    VkImage image = swapChain.getImages()[imageIndex];
+    const VkExtent2D &extent = swapChain.getExtent();
+
+    // The acquire semaphore is waited on at the color attachment output
+    // stage, starting there keeps the blit behind it.
+    transitionColorImage(dispatch,
+                         commandBuffer,
+                         image,
+                         VK_IMAGE_LAYOUT_UNDEFINED,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         0,
+                         VK_ACCESS_TRANSFER_WRITE_BIT,
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+    VkImageBlit blit{};
+    blit.srcOffsets[1] = {static_cast<int32_t>(renderExtent.width),
+                          static_cast<int32_t>(renderExtent.height),
+                          1};
+    blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    blit.srcSubresource.mipLevel = 0;
+    blit.srcSubresource.baseArrayLayer = 0;
+    blit.srcSubresource.layerCount = 1;
+    blit.dstOffsets[1] = {static_cast<int32_t>(extent.width),
+                          static_cast<int32_t>(extent.height),
+                          1};
+    blit.dstSubresource = blit.srcSubresource;
+
+    // Bilinear, the formats were checked to filter when blitting.
+    dispatch.vkCmdBlitImage(commandBuffer,
+                            swapChain.getSceneImage(),
+                            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                            image,
+                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                            1,
+                            &blit,
+                            VK_FILTER_LINEAR);
+
+    // Presenting waits on a semaphore, only a capture copy could follow.
+    transitionColorImage(dispatch,
+                         commandBuffer,
+                         image,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                         VK_ACCESS_TRANSFER_WRITE_BIT,
+                         0,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT);
+}
+
+void VulkanRenderPass::recordDraws(VkCommandBuffer commandBuffer,
+                                   const VkDescriptorSet *descriptorSets,
+                                   const Scene &scene,
+                                   const DrawList &drawList,
+                                   const uint8_t *objectLods,
+                                   VkExtent2D renderExtent,
+                                   uint32_t first,
+                                   uint32_t last,
+                                   DrawStats &stats) const
+{
+    const VulkanDispatch &dispatch = context->getDevice().getDispatch();
+    const VulkanPipeline &pipeline = context->getPipeline();
 
-    const VkExtent2D &swapChainExtent = swapChain.getExtent();
     VkViewport viewport{};
     viewport.x = 0.0f;
     viewport.y = 0.0f;
-    viewport.width = static_cast<float>(swapChainExtent.width);
-    viewport.height = static_cast<float>(swapChainExtent.height);
+    viewport.width = static_cast<float>(renderExtent.width);
+    viewport.height = static_cast<float>(renderExtent.height);
     viewport.minDepth = 0.0f;
     viewport.maxDepth = 1.0f;
-    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    dispatch.vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 
     VkRect2D scissor{};
     scissor.offset = {0, 0};
-    scissor.extent = swapChainExtent;
-    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-
-    VkBuffer vertexBuffers[] = {triangle.getVertexBuffer()};
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-    vkCmdBindIndexBuffer(
-        commandBuffer, triangle.getIndexBuffer(), 0, VK_INDEX_TYPE_UINT16);
-
-    vkCmdBindDescriptorSets(commandBuffer,
-                            VK_PIPELINE_BIND_POINT_GRAPHICS,
-                            pipeline.getLayout(),
-                            0,
-                            1,
-                            descriptorSets,
-                            0,
-                            nullptr);
+    scissor.extent = renderExtent;
+    dispatch.vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-    vkCmdDrawIndexed(commandBuffer, triangle.getIndexCount(), 1, 0, 0, 0);
+    // What the command buffer has bound. Compared by handle, so meshes
+    // sharing buffers don't bind them again either.
+    VkPipeline boundPipeline = VK_NULL_HANDLE;
+    VkDescriptorSet boundDescriptorSet = VK_NULL_HANDLE;
+    VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+    VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
 
-    vkCmdEndRenderPass(commandBuffer);
+    // Only the mesh column is touched here.
+    const MeshHandle *meshes = scene.getMeshes();
+    const uint32_t *objects = drawList.getObjects();
 
-    result = vkEndCommandBuffer(commandBuffer);
-    if (result != VK_SUCCESS)
+    // firstInstance selects the object's matrix in the instance buffer.
+    for (uint32_t i = first; i < last; i++)
     {
-        std::string errorMsg("Failed to record a command buffer: ");
-        errorMsg.append(string_VkResult(result));
-        throw std::runtime_error(errorMsg);
+        uint32_t object = objects[i];
+        const Triangle &mesh = scene.getMesh(meshes[object]);
+
+        // A single pipeline and descriptor set per frame for now, so these
+        // two bind once per command buffer. Not counted as avoided, there
+        // is nothing else they could have been.
+        if (boundPipeline != pipeline)
+        {
+            dispatch.vkCmdBindPipeline(
+                commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            boundPipeline = pipeline;
+            stats.pipelineBinds++;
+        }
+
+        if (boundDescriptorSet != descriptorSets[0])
+        {
+            dispatch.vkCmdBindDescriptorSets(commandBuffer,
+                                             VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                             pipeline.getLayout(),
+                                             0,
+                                             1,
+                                             descriptorSets,
+                                             0,
+                                             nullptr);
+            boundDescriptorSet = descriptorSets[0];
+            stats.descriptorSetBinds++;
+        }
+
+        VkBuffer vertexBuffer = mesh.getVertexBuffer();
+        if (boundVertexBuffer != vertexBuffer)
+        {
+            VkDeviceSize offset = 0;
+            dispatch.vkCmdBindVertexBuffers(
+                commandBuffer, 0, 1, &vertexBuffer, &offset);
+            boundVertexBuffer = vertexBuffer;
+            stats.vertexBufferBinds++;
+        }
+        else
+        {
+            stats.bindsAvoided++;
+        }
+
+        VkBuffer indexBuffer = mesh.getIndexBuffer();
+        if (boundIndexBuffer != indexBuffer)
+        {
+            dispatch.vkCmdBindIndexBuffer(
+                commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+            boundIndexBuffer = indexBuffer;
+            stats.indexBufferBinds++;
+        }
+        else
+        {
+            stats.bindsAvoided++;
+        }
+
+        const MeshLod &meshLod = mesh.getLod(objectLods[object]);
+        dispatch.vkCmdDrawIndexed(commandBuffer,
+                                  meshLod.indexCount,
+                                  1,
+                                  meshLod.firstIndex,
+                                  0,
+                                  object);
+        stats.draws++;
+    }
+}
+
+void VulkanRenderPass::recordParallel(VkCommandBuffer commandBuffer,
+                                      const VkDescriptorSet *descriptorSets,
+                                      const Scene &scene,
+                                      const DrawList &drawList,
+                                      const uint8_t *objectLods,
+                                      VkExtent2D renderExtent,
+                                      VkFramebuffer framebuffer,
+                                      uint32_t frameIndex,
+                                      DrawStats &stats) const
+{
+    struct Recording
+    {
+        const VulkanRenderPass *renderPass;
+        const SecondaryCommandBuffer *secondary;
+        const VkDescriptorSet *descriptorSets;
+        const Scene *scene;
+        const DrawList *drawList;
+        const uint8_t *objectLods;
+        VkExtent2D renderExtent;
+        VkFramebuffer framebuffer;
+        // Per range, summed once every range is recorded.
+        DrawStats stats;
+        // Jobs can't throw: a failed call is kept for the recording thread,
+        // which throws it once every range finished.
+        VkResult result;
+        const char *failure;
+    };
+
+    // Each range records into its own pool, command pools are externally
+    // synchronized.
+    auto recordRange = [](void *data, uint32_t begin, uint32_t end) {
+        Recording &recording = *static_cast<Recording *>(data);
+        const VulkanRenderPass &renderPass = *recording.renderPass;
+        VulkanContext *context = renderPass.context;
+        const VulkanDevice &device = context->getDevice();
+        const VulkanDispatch &dispatch = device.getDispatch();
+
+        VkResult result =
+            dispatch.vkResetCommandPool(device, recording.secondary->pool, 0);
+        if (result != VK_SUCCESS)
+        {
+            recording.result = result;
+            recording.failure = "Failed to reset a secondary command pool: ";
+            return;
+        }
+
+        // Without a render pass, the attachments are described instead.
+        VkFormat colorFormat = context->getSwapChain().getImageFormat();
+        VkCommandBufferInheritanceRenderingInfoKHR renderingInfo{};
+        renderingInfo.sType =
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR;
+        renderingInfo.colorAttachmentCount = 1;
+        renderingInfo.pColorAttachmentFormats = &colorFormat;
+        renderingInfo.rasterizationSamples = renderPass.samples;
+
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType =
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        if (renderPass.dynamicRendering)
+            inheritanceInfo.pNext = &renderingInfo;
+        inheritanceInfo.renderPass = renderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = recording.framebuffer;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT |
+                          VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        VkCommandBuffer commandBuffer = recording.secondary->commandBuffer;
+        result = dispatch.vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        if (result != VK_SUCCESS)
+        {
+            recording.result = result;
+            recording.failure =
+                "Failed to begin recording a secondary command buffer: ";
+            return;
+        }
+        renderPass.recordDraws(commandBuffer,
+                               recording.descriptorSets,
+                               *recording.scene,
+                               *recording.drawList,
+                               recording.objectLods,
+                               recording.renderExtent,
+                               begin,
+                               end,
+                               recording.stats);
+        result = dispatch.vkEndCommandBuffer(commandBuffer);
+        if (result != VK_SUCCESS)
+        {
+            recording.result = result;
+            recording.failure = "Failed to record a secondary command buffer: ";
+        }
+    };
+
+    uint32_t threadCount = context->getJobSystem().getThreadCount();
+    uint32_t drawCount = drawList.size();
+    uint32_t rangeSize = (drawCount + threadCount - 1) / threadCount;
+
+    FrameArena &frameArena = context->getFrameArena();
+    Recording *recordings = frameArena.allocate<Recording>(threadCount);
+    VkCommandBuffer *commandBuffers =
+        frameArena.allocate<VkCommandBuffer>(threadCount);
+    uint32_t rangeCount = 0;
+
+    const SecondaryCommandBuffer *frameSecondaries =
+        secondaryCommandBuffers.data() + frameIndex * threadCount;
+
+    JobSystem &jobSystem = context->getJobSystem();
+    JobCounter counter;
+    for (uint32_t begin = 0; begin < drawCount; begin += rangeSize)
+    {
+        const SecondaryCommandBuffer &secondary = frameSecondaries[rangeCount];
+        recordings[rangeCount] = {this,
+                                  &secondary,
+                                  descriptorSets,
+                                  &scene,
+                                  &drawList,
+                                  objectLods,
+                                  renderExtent,
+                                  framebuffer,
+                                  {},
+                                  VK_SUCCESS,
+                                  nullptr};
+        commandBuffers[rangeCount] = secondary.commandBuffer;
+
+        jobSystem.schedule(recordRange,
+                           &recordings[rangeCount],
+                           begin,
+                           std::min(begin + rangeSize, drawCount),
+                           &counter);
+        rangeCount++;
+    }
+    jobSystem.wait(counter);
+
+    for (uint32_t i = 0; i < rangeCount; i++)
+    {
+        const Recording &recording = recordings[i];
+        if (recording.result != VK_SUCCESS)
+        {
+            std::string errorMsg(recording.failure);
+            errorMsg.append(string_VkResult(recording.result));
+            throw std::runtime_error(errorMsg);
+        }
+        stats.add(recording.stats);
+    }
+
+    context->getDevice().getDispatch().vkCmdExecuteCommands(
+        commandBuffer, rangeCount, commandBuffers);
+}
+
+void VulkanRenderPass::createSecondaryCommandBuffers()
+{
+    VkDevice device = context->getDevice();
+    uint32_t graphicsFamily =
+        context->getDevice().getQueueFamiyIndices().graphicsFamily.value();
+
+    uint32_t count = context->getConfig().framesInFlight *
+                     context->getJobSystem().getThreadCount();
+    secondaryCommandBuffers.resize(count);
+
+    for (SecondaryCommandBuffer &secondary : secondaryCommandBuffers)
+    {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        poolInfo.queueFamilyIndex = graphicsFamily;
+
+        VkResult result =
+            vkCreateCommandPool(device,
+                                &poolInfo,
+                                HostAllocator::get(HostAllocationTag::Commands),
+                                &secondary.pool);
+        if (result != VK_SUCCESS)
+        {
+            std::string errorMsg("Failed to create recording command pool: ");
+            errorMsg.append(string_VkResult(result));
+            throw std::runtime_error(errorMsg);
+        }
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = secondary.pool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+
+        result = vkAllocateCommandBuffers(
+            device, &allocInfo, &secondary.commandBuffer);
+        if (result != VK_SUCCESS)
+        {
+            std::string errorMsg("Failed to allocate command buffers: ");
+            errorMsg.append(string_VkResult(result));
+            throw std::runtime_error(errorMsg);
+        }
     }
 }
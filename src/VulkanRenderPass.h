@@ -1,29 +1,123 @@
 #ifndef VULKAN_RENDER_PASS_H
 #define VULKAN_RENDER_PASS_H
 
+#include <vector>
+
 #include "VulkanTypes.h"
 
+// What recording a frame's draws bound, and how many vertex and index
+// buffer binds were skipped because the previous draw had bound the same
+// buffer. The pipeline and descriptor set are per frame constants, bound
+// once per command buffer, so skipping them proves nothing.
+struct DrawStats
+{
+    uint32_t draws;
+    uint32_t pipelineBinds;
+    uint32_t descriptorSetBinds;
+    uint32_t vertexBufferBinds;
+    uint32_t indexBufferBinds;
+    uint32_t bindsAvoided;
+
+    void add(const DrawStats &other)
+    {
+        draws += other.draws;
+        pipelineBinds += other.pipelineBinds;
+        descriptorSetBinds += other.descriptorSetBinds;
+        vertexBufferBinds += other.vertexBufferBinds;
+        indexBufferBinds += other.indexBufferBinds;
+        bindsAvoided += other.bindsAvoided;
+    }
+    uint32_t getBindCount() const
+    {
+        return pipelineBinds + descriptorSetBinds + vertexBufferBinds +
+               indexBufferBinds;
+    }
+};
+
+struct SecondaryCommandBuffer
+{
+    VkCommandPool pool;
+    VkCommandBuffer commandBuffer;
+};
+
 class VulkanRenderPass
 {
   public:
     VulkanRenderPass(VulkanContext *context);
     ~VulkanRenderPass();
     void init();
+    // Draws into the top left renderExtent of the target, the whole swap
+    // chain extent unless it is scaled, in the draw list's order.
     void recordCommandBuffer(VkCommandBuffer commandBuffer,
                              const VkDescriptorSet *descriptorSets,
-                             const Triangle &triangle,
-                             uint32_t imageIndex) const;
+                             const Scene &scene,
+                             const DrawList &drawList,
+                             const uint8_t *objectLods,
+                             VkExtent2D renderExtent,
+                             uint32_t imageIndex,
+                             DrawStats &stats) const;
 
   private:
     void createRenderPass();
+    void createSecondaryCommandBuffers();
+    void beginRenderPass(VkCommandBuffer commandBuffer,
+                         VkFramebuffer framebuffer,
+                         VkExtent2D renderExtent,
+                         bool parallel) const;
+    // Transitions the target image itself, there is no render pass to do
+    // it.
+    void beginRendering(VkCommandBuffer commandBuffer,
+                        uint32_t imageIndex,
+                        VkExtent2D renderExtent,
+                        bool parallel) const;
+    void endRendering(VkCommandBuffer commandBuffer,
+                      uint32_t imageIndex) const;
+    // Scales the rendered part of the scene target up to the whole swap
+    // chain image, leaving it ready to present.
+    void blitToSwapChain(VkCommandBuffer commandBuffer,
+                         uint32_t imageIndex,
+                         VkExtent2D renderExtent) const;
+    // Records the draws in [first, last) of the draw list, binding only
+    // the state that differs from the previous draw's. Adds to stats.
+    void recordDraws(VkCommandBuffer commandBuffer,
+                     const VkDescriptorSet *descriptorSets,
+                     const Scene &scene,
+                     const DrawList &drawList,
+                     const uint8_t *objectLods,
+                     VkExtent2D renderExtent,
+                     uint32_t first,
+                     uint32_t last,
+                     DrawStats &stats) const;
+    // Splits the draws in one range per job system thread, each recorded
+    // into a secondary command buffer. Secondaries inherit no bound state,
+    // each range binds its own.
+    void recordParallel(VkCommandBuffer commandBuffer,
+                        const VkDescriptorSet *descriptorSets,
+                        const Scene &scene,
+                        const DrawList &drawList,
+                        const uint8_t *objectLods,
+                        VkExtent2D renderExtent,
+                        VkFramebuffer framebuffer,
+                        uint32_t frameIndex,
+                        DrawStats &stats) const;
 
   public:
+    // No render pass nor framebuffers exist then.
+    bool usesDynamicRendering() const { return dynamicRendering; }
+    VkSampleCountFlagBits getSampleCount() const { return samples; }
     operator VkRenderPass() const { return renderPass; }
 
   private:
     VulkanContext *context;
 
     VkRenderPass renderPass;
+    bool dynamicRendering;
+    VkSampleCountFlagBits samples;
+    // Renders into the swap chain's scene target instead of its images.
+    bool scaled;
+
+    // framesInFlight * thread count, indexed by frame first.
+    std::vector<SecondaryCommandBuffer> secondaryCommandBuffers;
 };
 
 #endif // VULKAN_RENDER_PASS_H
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <vulkan/vk_enum_string_helper.h>
 
+#include "HostAllocator.h"
 #include "VulkanContext.h"
 
 #include "VulkanSurface.h"
@@ -9,13 +10,23 @@ VulkanSurface::VulkanSurface(VulkanContext *context) : context(context) {}
 
 VulkanSurface::~VulkanSurface()
 {
-    vkDestroySurfaceKHR(context->getInstance(), surface, nullptr);
+    vkDestroySurfaceKHR(context->getInstance(),
+                        surface,
+                        HostAllocator::get(HostAllocationTag::Surface));
 }
 
 void VulkanSurface::init()
 {
-    VkResult result = glfwCreateWindowSurface(
-        context->getInstance(), context->getWindow(), nullptr, &surface);
+    VkResult result;
+    if (context->getConfig().headless)
+        result = createHeadlessSurface();
+    else
+        result = glfwCreateWindowSurface(
+            context->getInstance(),
+            context->getWindow(),
+            HostAllocator::get(HostAllocationTag::Surface),
+            &surface);
+
     if (result != VK_SUCCESS)
     {
         std::string errorMsg("Failed to create window surface: ");
@@ -23,3 +34,22 @@ void VulkanSurface::init()
         throw std::runtime_error(errorMsg);
     }
 }
+
+VkResult VulkanSurface::createHeadlessSurface()
+{
+    VkInstance instance = context->getInstance();
+    auto createHeadlessSurfaceEXT =
+        reinterpret_cast<PFN_vkCreateHeadlessSurfaceEXT>(
+            vkGetInstanceProcAddr(instance, "vkCreateHeadlessSurfaceEXT"));
+    if (createHeadlessSurfaceEXT == nullptr)
+        return VK_ERROR_EXTENSION_NOT_PRESENT;
+
+    VkHeadlessSurfaceCreateInfoEXT createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT;
+
+    return createHeadlessSurfaceEXT(
+        instance,
+        &createInfo,
+        HostAllocator::get(HostAllocationTag::Surface),
+        &surface);
+}
@@ -10,6 +10,9 @@ class VulkanSurface
     ~VulkanSurface();
     void init();
 
+  private:
+    VkResult createHeadlessSurface();
+
   public:
     operator VkSurfaceKHR() const { return surface; }
 
@@ -3,14 +3,28 @@
 #include <vulkan/vulkan.h>
 
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <limits>
+#include <thread>
 
+#include "HostAllocator.h"
 #include "VulkanContext.h"
 
 #include "VulkanSwapChain.h"
 
-VulkanSwapChain::VulkanSwapChain(VulkanContext *context) : context(context) {}
+VulkanSwapChain::VulkanSwapChain(VulkanContext *context)
+    : context(context),
+      colorImage(VK_NULL_HANDLE),
+      colorImageMemory(VK_NULL_HANDLE),
+      colorImageView(VK_NULL_HANDLE),
+      sceneImage(VK_NULL_HANDLE),
+      sceneImageMemory(VK_NULL_HANDLE),
+      sceneImageView(VK_NULL_HANDLE),
+      scaled(false),
+      recreateCount(0)
+{
+}
 
 VulkanSwapChain::~VulkanSwapChain()
 {
@@ -21,6 +35,9 @@ void VulkanSwapChain::init()
 {
     createSwapChain();
     createImageViews();
+    createColorTarget();
+    createSceneTarget();
+    createFrameBuffers();
 }
 
 void VulkanSwapChain::recreate()
@@ -30,7 +47,10 @@ void VulkanSwapChain::recreate()
     clear();
     createSwapChain();
     createImageViews();
+    createColorTarget();
+    createSceneTarget();
     createFrameBuffers();
+    recreateCount++;
 }
 
 void VulkanSwapChain::createSwapChain()
@@ -40,8 +60,6 @@ void VulkanSwapChain::createSwapChain()
     const SwapChainSupportDetails &swapChainSupport =
         device.getSwapChainSupport();
 
-    VkSurfaceFormatKHR surfaceFormat =
-        chooseSwapSurfaceFormat(swapChainSupport.formats);
     VkPresentModeKHR presentMode =
         chooseSwapPresentMode(swapChainSupport.presentModes);
     VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
@@ -62,6 +80,15 @@ void VulkanSwapChain::createSwapChain()
     createInfo.imageExtent = extent;
     createInfo.imageArrayLayers = 1;
     createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    // Only when capturing, it can keep the driver from compressing them.
+    if (!context->getConfig().capturePath.empty() &&
+        (swapChainSupport.capabilities.supportedUsageFlags &
+         VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
+    {
+        createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
+    if (scaled)
+        createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 
     const QueueFamilyIndices &indices = device.getQueueFamiyIndices();
     uint32_t queueFamilyIndices[] = {indices.graphicsFamily.value(),
@@ -87,7 +114,10 @@ void VulkanSwapChain::createSwapChain()
     createInfo.oldSwapchain = VK_NULL_HANDLE;
 
     VkResult result =
-        vkCreateSwapchainKHR(device, &createInfo, nullptr, &swapChain);
+        vkCreateSwapchainKHR(device,
+                             &createInfo,
+                             HostAllocator::get(HostAllocationTag::SwapChain),
+                             &swapChain);
     if (result != VK_SUCCESS)
     {
         std::string errorMsg("Failed to create swap chain: ");
@@ -99,10 +129,44 @@ void VulkanSwapChain::createSwapChain()
     images.resize(imageCount);
     vkGetSwapchainImagesKHR(device, swapChain, &imageCount, images.data());
 
-    imageFormat = surfaceFormat.format;
     this->extent = extent;
 }
 
+void VulkanSwapChain::selectSurfaceFormat()
+{
+    surfaceFormat = chooseSwapSurfaceFormat(
+        context->getDevice().getSwapChainSupport().formats);
+
+    scaled = context->getConfig().minResolutionScale < 1.0f;
+    if (scaled && !supportsScaling())
+    {
+        std::cerr << "Swap chain images can't be blitted to, rendering at "
+                     "full resolution"
+                  << std::endl;
+        scaled = false;
+    }
+}
+
+bool VulkanSwapChain::supportsScaling() const
+{
+    const VulkanDevice &device = context->getDevice();
+    if (!(device.getSwapChainSupport().capabilities.supportedUsageFlags &
+          VK_IMAGE_USAGE_TRANSFER_DST_BIT))
+    {
+        return false;
+    }
+
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(
+        device.getPhysicalDevice(), surfaceFormat.format, &formatProperties);
+
+    VkFormatFeatureFlags blitFeatures =
+        VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (formatProperties.optimalTilingFeatures & blitFeatures) ==
+           blitFeatures;
+}
+
 void VulkanSwapChain::createImageViews()
 {
     imageViews.resize(images.size());
@@ -113,7 +177,7 @@ void VulkanSwapChain::createImageViews()
 
         createInfo.image = images[i];
         createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        createInfo.format = imageFormat;
+        createInfo.format = surfaceFormat.format;
 
         createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
         createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
@@ -126,8 +190,11 @@ void VulkanSwapChain::createImageViews()
         createInfo.subresourceRange.baseArrayLayer = 0;
         createInfo.subresourceRange.layerCount = 1;
 
-        VkResult result = vkCreateImageView(
-            context->getDevice(), &createInfo, nullptr, &imageViews[i]);
+        VkResult result =
+            vkCreateImageView(context->getDevice(),
+                              &createInfo,
+                              HostAllocator::get(HostAllocationTag::Images),
+                              &imageViews[i]);
         if (result != VK_SUCCESS)
         {
             std::string errorMsg("Failed to create Image View: ");
@@ -137,33 +204,101 @@ void VulkanSwapChain::createImageViews()
     }
 }
 
+void VulkanSwapChain::createColorTarget()
+{
+    VkSampleCountFlagBits samples = context->getDevice().getSampleCount();
+    if (samples == VK_SAMPLE_COUNT_1_BIT)
+        return;
+
+    // Only ever written and resolved inside the pass: transient, so
+    // lazily allocated memory can back it.
+    const VulkanBufferCreator &bufferCreator = context->getBufferCreator();
+    bufferCreator.createImage(extent.width,
+                              extent.height,
+                              1,
+                              samples,
+                              surfaceFormat.format,
+                              VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                                  VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                              MemoryCategory::Attachments,
+                              colorImage,
+                              colorImageMemory);
+    colorImageView = bufferCreator.createImageView(
+        colorImage, surfaceFormat.format, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+}
+
+void VulkanSwapChain::createSceneTarget()
+{
+    if (!scaled)
+        return;
+
+    // Written by the pass, or its resolve, and read by the blit.
+    const VulkanBufferCreator &bufferCreator = context->getBufferCreator();
+    bufferCreator.createImage(extent.width,
+                              extent.height,
+                              1,
+                              VK_SAMPLE_COUNT_1_BIT,
+                              surfaceFormat.format,
+                              VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                                  VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                              MemoryCategory::Attachments,
+                              sceneImage,
+                              sceneImageMemory);
+    sceneImageView = bufferCreator.createImageView(
+        sceneImage, surfaceFormat.format, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+}
+
 void VulkanSwapChain::createFrameBuffers()
 {
-    frameBuffers.resize(imageViews.size());
+    // Rendering targets the image views directly, nothing to rebuild.
+    if (context->getRenderPass().usesDynamicRendering())
+        return;
+
+    RetirementQueue &retirementQueue = context->getRetirementQueue();
+    frameBuffers.clear();
 
     for (size_t i = 0; i < imageViews.size(); i++)
     {
+        // Scaled, every image renders into the same scene target.
+        VkImageView target = scaled ? sceneImageView : imageViews[i];
+
+        // The render pass resolves attachment 0 into 1 with MSAA.
         VkImageView attachments[] = {
-            imageViews[i],
+            target,
+            VK_NULL_HANDLE,
         };
+        uint32_t attachmentCount = 1;
+        if (colorImageView != VK_NULL_HANDLE)
+        {
+            attachments[0] = colorImageView;
+            attachments[1] = target;
+            attachmentCount = 2;
+        }
 
         VkFramebufferCreateInfo frameBufferInfo{};
         frameBufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
         frameBufferInfo.renderPass = context->getRenderPass();
-        frameBufferInfo.attachmentCount = 1;
+        frameBufferInfo.attachmentCount = attachmentCount;
         frameBufferInfo.pAttachments = attachments;
         frameBufferInfo.width = extent.width;
         frameBufferInfo.height = extent.height;
         frameBufferInfo.layers = 1;
 
+        VkFramebuffer frameBuffer;
         VkResult result = vkCreateFramebuffer(
-            context->getDevice(), &frameBufferInfo, nullptr, &frameBuffers[i]);
+            context->getDevice(),
+            &frameBufferInfo,
+            HostAllocator::get(HostAllocationTag::RenderPass),
+            &frameBuffer);
         if (result != VK_SUCCESS)
         {
             std::string errorMsg("Failed to create FrameBuffer: ");
             errorMsg.append(string_VkResult(result));
             throw std::runtime_error(errorMsg);
         }
+        frameBuffers.emplace_back(retirementQueue, frameBuffer);
     }
 }
 
@@ -173,15 +308,37 @@ void VulkanSwapChain::clear()
 
     for (auto imageView : imageViews)
     {
-        vkDestroyImageView(device, imageView, nullptr);
+        vkDestroyImageView(device,
+                           imageView,
+                           HostAllocator::get(HostAllocationTag::Images));
     }
 
-    for (auto framebuffer : frameBuffers)
-    {
-        vkDestroyFramebuffer(device, framebuffer, nullptr);
-    }
+    frameBuffers.clear();
+
+    destroyTarget(colorImage, colorImageMemory, colorImageView);
+    destroyTarget(sceneImage, sceneImageMemory, sceneImageView);
 
-    vkDestroySwapchainKHR(device, swapChain, nullptr);
+    vkDestroySwapchainKHR(device,
+                          swapChain,
+                          HostAllocator::get(HostAllocationTag::SwapChain));
+}
+
+void VulkanSwapChain::destroyTarget(VkImage &image,
+                                    VkDeviceMemory &memory,
+                                    VkImageView &imageView) const
+{
+    if (image == VK_NULL_HANDLE)
+        return;
+
+    VkDevice device = context->getDevice();
+    vkDestroyImageView(
+        device, imageView, HostAllocator::get(HostAllocationTag::Images));
+    vkDestroyImage(
+        device, image, HostAllocator::get(HostAllocationTag::Images));
+    context->getBufferCreator().freeMemory(memory);
+    image = VK_NULL_HANDLE;
+    memory = VK_NULL_HANDLE;
+    imageView = VK_NULL_HANDLE;
 }
 
 VkSurfaceFormatKHR VulkanSwapChain::chooseSwapSurfaceFormat(
@@ -224,18 +381,23 @@ VkExtent2D VulkanSwapChain::chooseSwapExtent(
     }
     else
     {
+        const ContextConfig &config = context->getConfig();
+        VkExtent2D actualExtent = {config.width, config.height};
+
+        // Runs on the render thread, so it can't pump GLFW events itself:
+        // wait for the main thread to report a non zero size instead.
         const VulkanWindow &window = context->getWindow();
-        int width = 0, height = 0;
-        glfwGetFramebufferSize(window, &width, &height);
-        while (width == 0 || height == 0)
+        if (!config.headless)
         {
-            glfwGetFramebufferSize(window, &width, &height);
-            glfwWaitEvents();
+            actualExtent = window.getFramebufferSize();
+            while ((actualExtent.width == 0 || actualExtent.height == 0) &&
+                   !glfwWindowShouldClose(window))
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                actualExtent = window.getFramebufferSize();
+            }
         }
 
-        VkExtent2D actualExtent = {static_cast<uint32_t>(width),
-                                   static_cast<uint32_t>(height)};
-
         actualExtent.width = std::clamp(actualExtent.width,
                                         capabilities.minImageExtent.width,
                                         capabilities.maxImageExtent.width);
@@ -3,6 +3,7 @@
 
 #include <vector>
 
+#include "RetirementQueue.h"
 #include "VulkanTypes.h"
 
 class VulkanSwapChain
@@ -10,14 +11,26 @@ class VulkanSwapChain
   public:
     VulkanSwapChain(VulkanContext *context);
     ~VulkanSwapChain();
+    // Expects selectSurfaceFormat() and the render pass.
     void init();
+    // Only needs the device, so the render pass can be created before the
+    // swap chain. Also decides whether the scene renders scaled.
+    void selectSurfaceFormat();
     void recreate();
     void createFrameBuffers();
 
   private:
     void createSwapChain();
     void createImageViews();
+    void createColorTarget();
+    void createSceneTarget();
+    void destroyTarget(VkImage &image,
+                       VkDeviceMemory &memory,
+                       VkImageView &imageView) const;
     void clear();
+    // Blitting needs the swap chain images as transfer destinations and the
+    // format filterable both ways.
+    bool supportsScaling() const;
     VkSurfaceFormatKHR chooseSwapSurfaceFormat(
         const std::vector<VkSurfaceFormatKHR> &availableFormats) const;
     VkPresentModeKHR chooseSwapPresentMode(
@@ -26,13 +39,30 @@ class VulkanSwapChain
         const VkSurfaceCapabilitiesKHR &capabilities) const;
 
   public:
-    VkFormat getImageFormat() const { return imageFormat; }
+    VkFormat getImageFormat() const { return surfaceFormat.format; }
     VkExtent2D getExtent() const { return extent; }
-    const std::vector<VkFramebuffer> &getFrameBuffers() const
+    const std::vector<VkImage> &getImages() const { return images; }
+    const std::vector<VkImageView> &getImageViews() const
+    {
+        return imageViews;
+    }
+    // The multisampled target resolved into the presented image, null
+    // without MSAA.
+    VkImage getColorImage() const { return colorImage; }
+    VkImageView getColorImageView() const { return colorImageView; }
+    // The scene renders into the top left of the scene target, at a
+    // resolution scale, and is blitted to the presented image. Without
+    // scaling it renders into the presented image directly.
+    bool isScaled() const { return scaled; }
+    VkImage getSceneImage() const { return sceneImage; }
+    VkImageView getSceneImageView() const { return sceneImageView; }
+    const std::vector<UniqueFramebuffer> &getFrameBuffers() const
     {
         return frameBuffers;
     }
     operator VkSwapchainKHR() const { return swapChain; }
+    // Times recreate() ran since init().
+    uint32_t getRecreateCount() const { return recreateCount; }
 
   private:
     VulkanContext *context;
@@ -41,8 +71,19 @@ class VulkanSwapChain
 
     std::vector<VkImageView> imageViews;
     std::vector<VkImage> images;
-    std::vector<VkFramebuffer> frameBuffers;
-    VkFormat imageFormat;
+    // Retired, frames in flight may still use them.
+    std::vector<UniqueFramebuffer> frameBuffers;
+    // Shared by every frame in flight, its contents never outlive a pass.
+    VkImage colorImage;
+    VkDeviceMemory colorImageMemory;
+    VkImageView colorImageView;
+    // Swap chain sized, so changing the scale never recreates it.
+    VkImage sceneImage;
+    VkDeviceMemory sceneImageMemory;
+    VkImageView sceneImageView;
+    bool scaled;
+    VkSurfaceFormatKHR surfaceFormat;
     VkExtent2D extent;
+    uint32_t recreateCount;
 };
 #endif // VULKAN_SWAP_CHAIN_H
@@ -0,0 +1,694 @@
+#include <vulkan/vk_enum_string_helper.h>
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "HostAllocator.h"
+#include "VulkanContext.h"
+
+#include "VulkanTextureManager.h"
+
+static const VkFormat TEXTURE_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+static const uint32_t TEXTURE_BYTES_PER_PIXEL = 4;
+// Textures become visible with their mip tail: the levels up to this size.
+static const uint32_t STREAMING_TAIL_SIZE = 64;
+static const uint32_t MAX_PENDING_UPLOADS = 2;
+static const VkDeviceSize DEFAULT_MEMORY_BUDGET = 256 * 1024 * 1024;
+static const VkDeviceSize STAGING_RING_SIZE = 16 * 1024 * 1024;
+// A 32 bit extent never has more levels.
+static const uint32_t MAX_TEXTURE_LEVELS = 32;
+
+// Box filter: each destination texel averages the source texels it
+// covers, whatever the ratio between both extents.
+static void downsample(const uint8_t *src,
+                       VkExtent2D srcExtent,
+                       uint8_t *dst,
+                       VkExtent2D dstExtent)
+{
+    for (uint32_t y = 0; y < dstExtent.height; y++)
+    {
+        uint32_t y0 = static_cast<uint32_t>(uint64_t(y) * srcExtent.height /
+                                            dstExtent.height);
+        uint32_t y1 = static_cast<uint32_t>(
+            uint64_t(y + 1) * srcExtent.height / dstExtent.height);
+        y1 = std::max(y1, y0 + 1);
+        for (uint32_t x = 0; x < dstExtent.width; x++)
+        {
+            uint32_t x0 = static_cast<uint32_t>(uint64_t(x) * srcExtent.width /
+                                                dstExtent.width);
+            uint32_t x1 = static_cast<uint32_t>(
+                uint64_t(x + 1) * srcExtent.width / dstExtent.width);
+            x1 = std::max(x1, x0 + 1);
+            uint64_t count = uint64_t(x1 - x0) * (y1 - y0);
+
+            for (uint32_t c = 0; c < TEXTURE_BYTES_PER_PIXEL; c++)
+            {
+                uint64_t sum = 0;
+                for (uint32_t ty = y0; ty < y1; ty++)
+                {
+                    for (uint32_t tx = x0; tx < x1; tx++)
+                    {
+                        sum += src[(uint64_t(ty) * srcExtent.width + tx) *
+                                       TEXTURE_BYTES_PER_PIXEL +
+                                   c];
+                    }
+                }
+                dst[(uint64_t(y) * dstExtent.width + x) *
+                        TEXTURE_BYTES_PER_PIXEL +
+                    c] = static_cast<uint8_t>((sum + count / 2) / count);
+            }
+        }
+    }
+}
+
+static void transitionLevels(VkCommandBuffer commandBuffer,
+                             VkImage image,
+                             uint32_t baseLevel,
+                             uint32_t levelCount,
+                             VkImageLayout oldLayout,
+                             VkImageLayout newLayout,
+                             VkAccessFlags srcAccessMask,
+                             VkAccessFlags dstAccessMask,
+                             VkPipelineStageFlags srcStageMask,
+                             VkPipelineStageFlags dstStageMask)
+{
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = baseLevel;
+    barrier.subresourceRange.levelCount = levelCount;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.srcAccessMask = srcAccessMask;
+    barrier.dstAccessMask = dstAccessMask;
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         srcStageMask,
+                         dstStageMask,
+                         0,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr,
+                         1,
+                         &barrier);
+}
+
+VulkanTextureManager::VulkanTextureManager(VulkanContext *context)
+    : context(context),
+      commandPool(VK_NULL_HANDLE),
+      linearBlitSupported(false),
+      stagingRing(context, STAGING_RING_SIZE),
+      memoryBudget(DEFAULT_MEMORY_BUDGET),
+      residentBytes(0),
+      pendingBytes(0)
+{
+}
+
+VulkanTextureManager::~VulkanTextureManager()
+{
+    VkDevice device = context->getDevice();
+    const VkAllocationCallbacks *synchronization =
+        HostAllocator::get(HostAllocationTag::Synchronization);
+
+    for (TextureUpload &upload : uploads)
+    {
+        vkWaitForFences(device, 1, &upload.fence, VK_TRUE, UINT64_MAX);
+        destroyImage(upload.image);
+        vkDestroyFence(device, upload.fence, synchronization);
+    }
+    for (const TextureUpload &upload : freeUploads)
+        vkDestroyFence(device, upload.fence, synchronization);
+
+    for (const Texture &texture : textures)
+        destroyImage(texture.resident);
+
+    for (const auto &sampler : samplers)
+        vkDestroySampler(device,
+                         sampler.second,
+                         HostAllocator::get(HostAllocationTag::Samplers));
+
+    if (commandPool != VK_NULL_HANDLE)
+        vkDestroyCommandPool(device,
+                             commandPool,
+                             HostAllocator::get(HostAllocationTag::Commands));
+}
+
+void VulkanTextureManager::init()
+{
+    createCommandPool();
+    createUploads();
+    stagingRing.init();
+
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(
+        context->getDevice().getPhysicalDevice(),
+        TEXTURE_FORMAT,
+        &formatProperties);
+
+    VkFormatFeatureFlags blitFeatures =
+        VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    linearBlitSupported =
+        (formatProperties.optimalTilingFeatures & blitFeatures) == blitFeatures;
+
+    // Bound until the real textures stream in, so every descriptor is
+    // valid from the first frame on.
+    const uint8_t white[TEXTURE_BYTES_PER_PIXEL] = {255, 255, 255, 255};
+    createTexture(white, 1, 1);
+    startUpload(WHITE_TEXTURE, 0);
+    vkWaitForFences(context->getDevice(),
+                    1,
+                    &uploads.front().fence,
+                    VK_TRUE,
+                    UINT64_MAX);
+    finishUploads();
+}
+
+void VulkanTextureManager::createCommandPool()
+{
+    const VulkanDevice &device = context->getDevice();
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT |
+                     VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex =
+        device.getQueueFamiyIndices().graphicsFamily.value();
+
+    VkResult result =
+        vkCreateCommandPool(device,
+                            &poolInfo,
+                            HostAllocator::get(HostAllocationTag::Commands),
+                            &commandPool);
+    if (result != VK_SUCCESS)
+    {
+        std::string errorMsg("Failed to create texture command pool: ");
+        errorMsg.append(string_VkResult(result));
+        throw std::runtime_error(errorMsg);
+    }
+}
+
+void VulkanTextureManager::createUploads()
+{
+    VkDevice device = context->getDevice();
+
+    VkCommandBuffer commandBuffers[MAX_PENDING_UPLOADS];
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = MAX_PENDING_UPLOADS;
+
+    VkResult result =
+        vkAllocateCommandBuffers(device, &allocInfo, commandBuffers);
+    if (result != VK_SUCCESS)
+    {
+        std::string errorMsg("Failed to allocate upload command buffers: ");
+        errorMsg.append(string_VkResult(result));
+        throw std::runtime_error(errorMsg);
+    }
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    for (VkCommandBuffer commandBuffer : commandBuffers)
+    {
+        TextureUpload upload{};
+        upload.commandBuffer = commandBuffer;
+        result = vkCreateFence(
+            device,
+            &fenceInfo,
+            HostAllocator::get(HostAllocationTag::Synchronization),
+            &upload.fence);
+        if (result != VK_SUCCESS)
+        {
+            std::string errorMsg("Failed to create upload fence: ");
+            errorMsg.append(string_VkResult(result));
+            throw std::runtime_error(errorMsg);
+        }
+        freeUploads.push_back(upload);
+    }
+}
+
+VkDeviceSize VulkanTextureManager::getLevelSize(const Texture &texture,
+                                                uint32_t level) const
+{
+    const VkExtent2D &extent = texture.extents[level];
+    return VkDeviceSize(extent.width) * extent.height *
+           TEXTURE_BYTES_PER_PIXEL;
+}
+
+TextureHandle VulkanTextureManager::createTexture(const uint8_t *pixels,
+                                                  uint32_t width,
+                                                  uint32_t height)
+{
+    Texture texture{};
+
+    VkExtent2D extent = {width, height};
+    texture.extents.push_back(extent);
+    while (extent.width > 1 || extent.height > 1)
+    {
+        extent = {std::max(extent.width / 2, 1u),
+                  std::max(extent.height / 2, 1u)};
+        texture.extents.push_back(extent);
+    }
+    uint32_t levelCount = static_cast<uint32_t>(texture.extents.size());
+
+    // Blits generate the levels below the uploaded one, only the top level
+    // is filtered on the CPU then, and only when it is uploaded.
+    texture.pyramid.resize(linearBlitSupported ? 1 : levelCount);
+    texture.pyramid[0].assign(pixels, pixels + getLevelSize(texture, 0));
+    for (uint32_t level = 1; level < texture.pyramid.size(); level++)
+    {
+        texture.pyramid[level].resize(getLevelSize(texture, level));
+        downsample(texture.pyramid[level - 1].data(),
+                   texture.extents[level - 1],
+                   texture.pyramid[level].data(),
+                   texture.extents[level]);
+    }
+
+    // Without blits an upload stages its whole chain.
+    texture.firstLevel = levelCount - 1;
+    VkDeviceSize stagingSize = 0;
+    for (uint32_t level = levelCount; level-- > 0;)
+    {
+        VkDeviceSize levelSize = getLevelSize(texture, level);
+        stagingSize = linearBlitSupported ? levelSize : stagingSize + levelSize;
+        if (StagingRing::align(stagingSize) > stagingRing.getSize())
+            break;
+        texture.firstLevel = level;
+    }
+
+    texture.resident.baseLevel = levelCount;
+    texture.requestedLevel = texture.firstLevel;
+    texture.uploading = false;
+
+    textures.push_back(std::move(texture));
+    return static_cast<TextureHandle>(textures.size() - 1);
+}
+
+void VulkanTextureManager::requestLevel(TextureHandle texture, uint32_t level)
+{
+    textures[texture].requestedLevel =
+        std::max(level, textures[texture].firstLevel);
+}
+
+void VulkanTextureManager::update()
+{
+    finishUploads();
+
+    if (freeUploads.empty())
+        return;
+
+    // One more level per texture and update: the most starved texture
+    // first, as long as the result fits in the budget.
+    TextureHandle best = 0;
+    uint32_t bestDeficit = 0;
+    for (TextureHandle handle = 0; handle < textures.size(); handle++)
+    {
+        const Texture &texture = textures[handle];
+        if (texture.uploading)
+            continue;
+
+        uint32_t resident = texture.resident.baseLevel;
+        uint32_t deficit = resident > texture.requestedLevel
+                               ? resident - texture.requestedLevel
+                               : 0;
+        if (deficit > bestDeficit)
+        {
+            best = handle;
+            bestDeficit = deficit;
+        }
+    }
+
+    if (bestDeficit == 0)
+        return;
+
+    const Texture &texture = textures[best];
+    uint32_t levelCount = static_cast<uint32_t>(texture.extents.size());
+    uint32_t level = texture.resident.baseLevel - 1;
+    if (texture.resident.baseLevel == levelCount)
+    {
+        level = 0;
+        while (level + 1 < levelCount &&
+               std::max(texture.extents[level].width,
+                        texture.extents[level].height) > STREAMING_TAIL_SIZE)
+        {
+            level++;
+        }
+        level = std::max(level, texture.requestedLevel);
+    }
+
+    startUpload(best, level);
+}
+
+void VulkanTextureManager::finishUploads()
+{
+    VkDevice device = context->getDevice();
+    const VulkanDispatch &dispatch = context->getDevice().getDispatch();
+
+    // Uploads finish in submission order, the staging ring relies on it.
+    while (!uploads.empty() &&
+           dispatch.vkGetFenceStatus(device, uploads.front().fence) ==
+               VK_SUCCESS)
+    {
+        finishUpload(uploads.front());
+        freeUploads.push_back(uploads.front());
+        uploads.pop_front();
+    }
+}
+
+bool VulkanTextureManager::startUpload(TextureHandle handle, uint32_t level)
+{
+    Texture &texture = textures[handle];
+    const VulkanBufferCreator &bufferCreator = context->getBufferCreator();
+
+    uint32_t levelCount =
+        static_cast<uint32_t>(texture.extents.size()) - level;
+
+    VkDeviceSize imageSize = 0;
+    for (uint32_t i = level; i < texture.extents.size(); i++)
+        imageSize += getLevelSize(texture, i);
+
+    if (residentBytes + pendingBytes + imageSize > memoryBudget)
+        return false;
+
+    // With linear blits only the new top level crosses the bus, the rest
+    // of the chain is generated on the GPU.
+    VkDeviceSize stagingSize =
+        linearBlitSupported ? getLevelSize(texture, level) : imageSize;
+    VkDeviceSize usedBefore = stagingRing.getUsed();
+    VkDeviceSize stagingOffset;
+    if (!stagingRing.allocate(stagingSize, stagingOffset))
+        return false;
+
+    stageLevels(texture, level, stagingRing.getMapped() + stagingOffset);
+
+    TextureUpload upload = freeUploads.back();
+    freeUploads.pop_back();
+    upload.texture = handle;
+    upload.image.baseLevel = level;
+    upload.image.size = imageSize;
+    upload.ringBytes = stagingRing.getUsed() - usedBefore;
+
+    VkImageUsageFlags usage =
+        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (linearBlitSupported)
+        usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+    bufferCreator.createImage(texture.extents[level].width,
+                              texture.extents[level].height,
+                              levelCount,
+                              VK_SAMPLE_COUNT_1_BIT,
+                              TEXTURE_FORMAT,
+                              usage,
+                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                              MemoryCategory::Textures,
+                              upload.image.image,
+                              upload.image.memory);
+    upload.image.view = bufferCreator.createImageView(upload.image.image,
+                                                      TEXTURE_FORMAT,
+                                                      VK_IMAGE_ASPECT_COLOR_BIT,
+                                                      levelCount);
+
+    recordUpload(upload, texture, stagingOffset, levelCount);
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &upload.commandBuffer;
+
+    VkResult result = vkQueueSubmit(context->getDevice().getGraphicsQueue(),
+                                    1,
+                                    &submitInfo,
+                                    upload.fence);
+    if (result != VK_SUCCESS)
+    {
+        std::string errorMsg("Failed to submit texture upload: ");
+        errorMsg.append(string_VkResult(result));
+        throw std::runtime_error(errorMsg);
+    }
+
+    texture.uploading = true;
+    pendingBytes += imageSize;
+    uploads.push_back(upload);
+    return true;
+}
+
+void VulkanTextureManager::stageLevels(const Texture &texture,
+                                       uint32_t level,
+                                       uint8_t *staging) const
+{
+    if (linearBlitSupported)
+    {
+        // Only level 0 is kept, the top level is filtered straight from it.
+        const std::vector<uint8_t> &pixels = texture.pyramid[0];
+        if (level == 0)
+        {
+            memcpy(staging, pixels.data(), pixels.size());
+        }
+        else
+        {
+            downsample(pixels.data(),
+                       texture.extents[0],
+                       staging,
+                       texture.extents[level]);
+        }
+        return;
+    }
+
+    for (uint32_t i = level; i < texture.pyramid.size(); i++)
+    {
+        memcpy(staging, texture.pyramid[i].data(), texture.pyramid[i].size());
+        staging += texture.pyramid[i].size();
+    }
+}
+
+void VulkanTextureManager::recordUpload(const TextureUpload &upload,
+                                        const Texture &texture,
+                                        VkDeviceSize stagingOffset,
+                                        uint32_t levelCount) const
+{
+    VkCommandBuffer commandBuffer = upload.commandBuffer;
+    VkImage image = upload.image.image;
+    uint32_t baseLevel = upload.image.baseLevel;
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkResetCommandBuffer(commandBuffer, 0);
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    transitionLevels(commandBuffer,
+                     image,
+                     0,
+                     levelCount,
+                     VK_IMAGE_LAYOUT_UNDEFINED,
+                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                     0,
+                     VK_ACCESS_TRANSFER_WRITE_BIT,
+                     VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                     VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+    uint32_t copyCount = linearBlitSupported ? 1 : levelCount;
+    VkBufferImageCopy regions[MAX_TEXTURE_LEVELS];
+    VkDeviceSize offset = stagingOffset;
+    for (uint32_t i = 0; i < copyCount; i++)
+    {
+        const VkExtent2D &extent = texture.extents[baseLevel + i];
+        regions[i] = {};
+        regions[i].bufferOffset = offset;
+        regions[i].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        regions[i].imageSubresource.mipLevel = i;
+        regions[i].imageSubresource.baseArrayLayer = 0;
+        regions[i].imageSubresource.layerCount = 1;
+        regions[i].imageExtent = {extent.width, extent.height, 1};
+        offset += getLevelSize(texture, baseLevel + i);
+    }
+
+    vkCmdCopyBufferToImage(commandBuffer,
+                           stagingRing.getBuffer(),
+                           image,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           copyCount,
+                           regions);
+
+    if (!linearBlitSupported)
+    {
+        transitionLevels(commandBuffer,
+                         image,
+                         0,
+                         levelCount,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                         VK_ACCESS_TRANSFER_WRITE_BIT,
+                         VK_ACCESS_SHADER_READ_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+        vkEndCommandBuffer(commandBuffer);
+        return;
+    }
+
+    for (uint32_t i = 1; i < levelCount; i++)
+    {
+        transitionLevels(commandBuffer,
+                         image,
+                         i - 1,
+                         1,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                         VK_ACCESS_TRANSFER_WRITE_BIT,
+                         VK_ACCESS_TRANSFER_READ_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+        const VkExtent2D &srcExtent = texture.extents[baseLevel + i - 1];
+        const VkExtent2D &dstExtent = texture.extents[baseLevel + i];
+
+        VkImageBlit blit{};
+        blit.srcOffsets[1] = {static_cast<int32_t>(srcExtent.width),
+                              static_cast<int32_t>(srcExtent.height),
+                              1};
+        blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.srcSubresource.mipLevel = i - 1;
+        blit.srcSubresource.baseArrayLayer = 0;
+        blit.srcSubresource.layerCount = 1;
+        blit.dstOffsets[1] = {static_cast<int32_t>(dstExtent.width),
+                              static_cast<int32_t>(dstExtent.height),
+                              1};
+        blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.dstSubresource.mipLevel = i;
+        blit.dstSubresource.baseArrayLayer = 0;
+        blit.dstSubresource.layerCount = 1;
+
+        vkCmdBlitImage(commandBuffer,
+                       image,
+                       VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                       image,
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                       1,
+                       &blit,
+                       VK_FILTER_LINEAR);
+
+        transitionLevels(commandBuffer,
+                         image,
+                         i - 1,
+                         1,
+                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                         VK_ACCESS_TRANSFER_READ_BIT,
+                         VK_ACCESS_SHADER_READ_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    }
+
+    transitionLevels(commandBuffer,
+                     image,
+                     levelCount - 1,
+                     1,
+                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                     VK_ACCESS_TRANSFER_WRITE_BIT,
+                     VK_ACCESS_SHADER_READ_BIT,
+                     VK_PIPELINE_STAGE_TRANSFER_BIT,
+                     VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+    vkEndCommandBuffer(commandBuffer);
+}
+
+
+void VulkanTextureManager::finishUpload(TextureUpload &upload)
+{
+    Texture &texture = textures[upload.texture];
+
+    // Frames still in flight may sample the old image.
+    if (texture.resident.image != VK_NULL_HANDLE)
+    {
+        retireImage(texture.resident);
+        residentBytes -= texture.resident.size;
+    }
+
+    texture.resident = upload.image;
+    texture.uploading = false;
+    residentBytes += upload.image.size;
+    pendingBytes -= upload.image.size;
+
+    stagingRing.release(upload.ringBytes);
+    upload.image = {};
+    vkResetFences(context->getDevice(), 1, &upload.fence);
+}
+
+void VulkanTextureManager::retireImage(const TextureImage &image) const
+{
+    RetirementQueue &retirementQueue = context->getRetirementQueue();
+    retirementQueue.retire(ResourceKind::ImageView, image.view);
+    retirementQueue.retire(ResourceKind::Image, image.image);
+    retirementQueue.retire(ResourceKind::DeviceMemory, image.memory);
+}
+
+void VulkanTextureManager::destroyImage(const TextureImage &image) const
+{
+    if (image.image == VK_NULL_HANDLE)
+        return;
+
+    VkDevice device = context->getDevice();
+    vkDestroyImageView(device,
+                       image.view,
+                       HostAllocator::get(HostAllocationTag::Images));
+    vkDestroyImage(device,
+                   image.image,
+                   HostAllocator::get(HostAllocationTag::Images));
+    context->getBufferCreator().freeMemory(image.memory);
+}
+
+VkSampler VulkanTextureManager::getSampler(const SamplerDesc &desc) const
+{
+    for (const auto &sampler : samplers)
+    {
+        if (sampler.first == desc)
+            return sampler.second;
+    }
+
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = desc.filter;
+    samplerInfo.minFilter = desc.filter;
+    samplerInfo.mipmapMode = desc.mipmapMode;
+    samplerInfo.addressModeU = desc.addressMode;
+    samplerInfo.addressModeV = desc.addressMode;
+    samplerInfo.addressModeW = desc.addressMode;
+    samplerInfo.anisotropyEnable = VK_FALSE;
+    samplerInfo.maxAnisotropy = 1.0f;
+    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    samplerInfo.unnormalizedCoordinates = VK_FALSE;
+    samplerInfo.compareEnable = VK_FALSE;
+    samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+    samplerInfo.mipLodBias = 0.0f;
+    samplerInfo.minLod = 0.0f;
+    // Views only cover resident levels, so the full chain is always valid.
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+    VkSampler sampler;
+    VkResult result =
+        vkCreateSampler(context->getDevice(),
+                        &samplerInfo,
+                        HostAllocator::get(HostAllocationTag::Samplers),
+                        &sampler);
+    if (result != VK_SUCCESS)
+    {
+        std::string errorMsg("Failed to create sampler: ");
+        errorMsg.append(string_VkResult(result));
+        throw std::runtime_error(errorMsg);
+    }
+
+    samplers.emplace_back(desc, sampler);
+    return sampler;
+}
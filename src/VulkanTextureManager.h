@@ -0,0 +1,140 @@
+#ifndef VULKAN_TEXTURE_MANAGER_H
+#define VULKAN_TEXTURE_MANAGER_H
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "StagingRing.h"
+#include "VulkanTypes.h"
+
+typedef uint32_t TextureHandle;
+
+struct SamplerDesc
+{
+    VkFilter filter;
+    VkSamplerMipmapMode mipmapMode;
+    VkSamplerAddressMode addressMode;
+
+    bool operator==(const SamplerDesc &other) const
+    {
+        return filter == other.filter && mipmapMode == other.mipmapMode &&
+               addressMode == other.addressMode;
+    }
+};
+
+struct TextureImage
+{
+    VkImage image;
+    VkDeviceMemory memory;
+    VkImageView view;
+    // Level of the source pyramid stored in mip 0 of this image.
+    uint32_t baseLevel;
+    VkDeviceSize size;
+};
+
+struct Texture
+{
+    // CPU copy of level 0, and of every other level when the device can't
+    // blit them.
+    std::vector<std::vector<uint8_t>> pyramid;
+    std::vector<VkExtent2D> extents;
+    // Finest level whose upload fits in the staging ring.
+    uint32_t firstLevel;
+
+    TextureImage resident;
+    uint32_t requestedLevel;
+    bool uploading;
+};
+
+// Reused once its fence signals, uploads retire in submission order.
+struct TextureUpload
+{
+    TextureHandle texture;
+    TextureImage image;
+    VkCommandBuffer commandBuffer;
+    VkFence fence;
+    VkDeviceSize ringBytes;
+};
+
+class VulkanTextureManager
+{
+  public:
+    // Opaque white, resident from init() on.
+    static const TextureHandle WHITE_TEXTURE = 0;
+
+    VulkanTextureManager(VulkanContext *context);
+    ~VulkanTextureManager();
+    void init();
+    // Copies RGBA8 pixels. Nothing is uploaded until the next update(),
+    // which streams the smallest mips first.
+    TextureHandle createTexture(const uint8_t *pixels,
+                                uint32_t width,
+                                uint32_t height);
+    // Most detailed level the texture should eventually get; 0 is full
+    // resolution.
+    void requestLevel(TextureHandle texture, uint32_t level);
+    void setMemoryBudget(VkDeviceSize budget) { memoryBudget = budget; }
+    // Called once per frame. Never waits on the GPU.
+    void update();
+
+  private:
+    void createCommandPool();
+    void createUploads();
+    VkDeviceSize getLevelSize(const Texture &texture, uint32_t level) const;
+    void finishUploads();
+    bool startUpload(TextureHandle handle, uint32_t level);
+    void stageLevels(const Texture &texture,
+                     uint32_t level,
+                     uint8_t *staging) const;
+    void recordUpload(const TextureUpload &upload,
+                      const Texture &texture,
+                      VkDeviceSize stagingOffset,
+                      uint32_t levelCount) const;
+    void finishUpload(TextureUpload &upload);
+    void retireImage(const TextureImage &image) const;
+    void destroyImage(const TextureImage &image) const;
+
+  public:
+    // WHITE_TEXTURE's until the texture has a resident level.
+    VkImageView getImageView(TextureHandle texture) const
+    {
+        if (textures[texture].resident.view == VK_NULL_HANDLE)
+            return textures[WHITE_TEXTURE].resident.view;
+        return textures[texture].resident.view;
+    }
+    // getLevelCount() while nothing is resident.
+    uint32_t getResidentLevel(TextureHandle texture) const
+    {
+        return textures[texture].resident.baseLevel;
+    }
+    uint32_t getLevelCount(TextureHandle texture) const
+    {
+        return static_cast<uint32_t>(textures[texture].extents.size());
+    }
+    VkDeviceSize getResidentBytes() const { return residentBytes; }
+    uint32_t getPendingUploads() const
+    {
+        return static_cast<uint32_t>(uploads.size());
+    }
+    VkSampler getSampler(const SamplerDesc &desc) const;
+
+  private:
+    VulkanContext *context;
+
+    VkCommandPool commandPool;
+    bool linearBlitSupported;
+    StagingRing stagingRing;
+
+    std::vector<Texture> textures;
+    std::deque<TextureUpload> uploads;
+    std::vector<TextureUpload> freeUploads;
+
+    VkDeviceSize memoryBudget;
+    VkDeviceSize residentBytes;
+    VkDeviceSize pendingBytes;
+
+    mutable std::vector<std::pair<SamplerDesc, VkSampler>> samplers;
+};
+
+#endif // VULKAN_TEXTURE_MANAGER_H
@@ -5,21 +5,78 @@
 #include <glm/glm.hpp>
 #include <vulkan/vulkan.h>
 
+#include <array>
 #include <optional>
+#include <string>
 #include <vector>
 
 typedef GLFWwindow *GlfwWindow;
+class AssetLoader;
+struct AssetUpload;
+class Camera;
+class DrawList;
+class FrameArena;
+class JobSystem;
+class RetirementQueue;
+class Scene;
+class TransformSystem;
 class Triangle;
 class VulkanBufferCreator;
 class VulkanContext;
 class VulkanDebugger;
 class VulkanDevice;
+class VulkanFrameCapture;
+class VulkanGpuTimer;
+class VulkanMemoryTracker;
 class VulkanPipeline;
 class VulkanRenderPass;
 class VulkanSurface;
 class VulkanSwapChain;
+class VulkanTextureManager;
 class VulkanWindow;
 
+struct ContextConfig
+{
+    // Presents to a VK_EXT_headless_surface instead of a GLFW window.
+    bool headless = false;
+    uint32_t width = 800;
+    uint32_t height = 600;
+    uint32_t framesInFlight = 2;
+    // Threads used by the job system, 0 picks one per hardware thread.
+    uint32_t workerThreads = 0;
+    // Hands the driver HostAllocator's pools instead of its own allocator.
+    bool hostAllocator = true;
+    // Renders with VK_KHR_dynamic_rendering when the device supports it,
+    // instead of a render pass and a framebuffer per swap chain image.
+    bool dynamicRendering = true;
+    // Samples per pixel, lowered to what the device supports. Above 1 the
+    // frame renders into a transient multisampled target resolved into the
+    // swap chain image.
+    uint32_t msaaSamples = 1;
+    // Loads VulkanNullDriver's commands into the device dispatch table: the
+    // frame loop never reaches the driver, nothing is drawn or presented.
+    bool nullDriver = false;
+    // Lowest fraction of the swap chain extent the scene renders at when
+    // GPU frames go over gpuBudgetMs. Below 1 the scene renders into an
+    // offscreen target scaled up into the swap chain image.
+    float minResolutionScale = 1.0f;
+    // GPU time per frame the resolution scale aims to stay under.
+    float gpuBudgetMs = 14.0f;
+    // Streams every presented frame to this file when set, the extension
+    // picks the format: .y4m, .png (one file per frame) or raw RGBA.
+    std::string capturePath;
+    // Only written in Y4M headers, frames are captured as presented.
+    uint32_t captureFrameRate = 60;
+    // Frame time rollups are exported every second to this JSON file and
+    // to the POSIX shared memory segment of this name (e.g. /frame-stats),
+    // when set. See FrameMonitorSegment for the segment's layout.
+    std::string statsPath;
+    std::string statsSharedMemory;
+    // VulkanApp appends every drawn frame's scene and camera to this frame
+    // recording when set, for the benchmark's replay mode.
+    std::string recordPath;
+};
+
 struct SwapChainSupportDetails
 {
     VkSurfaceCapabilitiesKHR capabilities;
@@ -32,7 +89,7 @@ struct QueueFamilyIndices
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
 
-    bool allSet()
+    bool allSet() const
     {
         return graphicsFamily.has_value() && presentFamily.has_value();
     }
@@ -52,10 +109,11 @@ struct Vertex
         return bindingDescription;
     }
 
-    static std::vector<VkVertexInputAttributeDescription>
+    static std::array<VkVertexInputAttributeDescription, 2>
     getAttributeDescriptions()
     {
-        std::vector<VkVertexInputAttributeDescription> attributeDescriptions(2);
+        std::array<VkVertexInputAttributeDescription, 2>
+            attributeDescriptions{};
         attributeDescriptions[0].binding = 0;
         attributeDescriptions[0].location = 0;
         attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
@@ -67,11 +125,4 @@ struct Vertex
         return attributeDescriptions;
     }
 };
-
-struct UniformBufferObject
-{
-    glm::mat4 model;
-    glm::mat4 view;
-    glm::mat4 proj;
-};
 #endif // VULKAN_TYPES_H
@@ -4,32 +4,127 @@
 
 #include "VulkanWindow.h"
 
-static const uint32_t WINDOW_WIDTH = 800;
-static const uint32_t WINDOW_HEIGHT = 600;
 static const char *WINDOW_NAME = "Vulkan";
 
-VulkanWindow::VulkanWindow(VulkanContext *context) : context(context){};
+VulkanWindow::VulkanWindow(VulkanContext *context)
+    : context(context),
+      window(nullptr),
+      framebufferResized(false),
+      redrawRequested(false),
+      framebufferWidth(context->getConfig().width),
+      framebufferHeight(context->getConfig().height){};
 
 VulkanWindow::~VulkanWindow()
 {
-    glfwDestroyWindow(window);
+    if (window)
+        glfwDestroyWindow(window);
 }
 
-static void framebufferSizeCallback(GLFWwindow *window, int, int)
+static VulkanWindow &getVulkanWindow(GLFWwindow *window)
 {
     VulkanContext *context =
         reinterpret_cast<VulkanContext *>(glfwGetWindowUserPointer(window));
 
-    const_cast<VulkanSwapChain &>(context->getSwapChain()).recreate();
+    return context->getWindow();
+}
+
+// The swap chain belongs to the render thread, which picks the resize up
+// after its next present.
+static void framebufferSizeCallback(GLFWwindow *window, int width, int height)
+{
+    VulkanWindow &vulkanWindow = getVulkanWindow(window);
+    vulkanWindow.onFramebufferResized(width, height);
+    vulkanWindow.requestRedraw();
+}
+
+static void keyCallback(GLFWwindow *window, int key, int, int action, int)
+{
+    VulkanWindow &vulkanWindow = getVulkanWindow(window);
+    vulkanWindow.requestRedraw();
+    vulkanWindow.onKey(key, action);
+}
+
+static void cursorPosCallback(GLFWwindow *window, double, double)
+{
+    getVulkanWindow(window).requestRedraw();
+}
+
+static void mouseButtonCallback(GLFWwindow *window, int, int, int)
+{
+    getVulkanWindow(window).requestRedraw();
+}
+
+static void scrollCallback(GLFWwindow *window, double, double)
+{
+    getVulkanWindow(window).requestRedraw();
+}
+
+// Damaged or uncovered contents, with nothing else changing.
+static void windowRefreshCallback(GLFWwindow *window)
+{
+    getVulkanWindow(window).requestRedraw();
 }
 
 void VulkanWindow::init()
 {
+    const ContextConfig &config = context->getConfig();
+    if (config.headless)
+        return;
+
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
     glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
-    window = glfwCreateWindow(
-        WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_NAME, nullptr, nullptr);
+    window = glfwCreateWindow(static_cast<int>(config.width),
+                              static_cast<int>(config.height),
+                              WINDOW_NAME,
+                              nullptr,
+                              nullptr);
+
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+    framebufferWidth = static_cast<uint32_t>(width);
+    framebufferHeight = static_cast<uint32_t>(height);
 
     glfwSetWindowUserPointer(window, (void *)context);
     glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
+    glfwSetKeyCallback(window, keyCallback);
+    glfwSetCursorPosCallback(window, cursorPosCallback);
+    glfwSetMouseButtonCallback(window, mouseButtonCallback);
+    glfwSetScrollCallback(window, scrollCallback);
+    glfwSetWindowRefreshCallback(window, windowRefreshCallback);
+}
+
+void VulkanWindow::onFramebufferResized(int width, int height)
+{
+    framebufferWidth.store(static_cast<uint32_t>(width),
+                           std::memory_order_relaxed);
+    framebufferHeight.store(static_cast<uint32_t>(height),
+                            std::memory_order_relaxed);
+    framebufferResized.store(true, std::memory_order_release);
+}
+
+bool VulkanWindow::consumeFramebufferResized()
+{
+    return framebufferResized.exchange(false, std::memory_order_acquire);
+}
+
+void VulkanWindow::requestRedraw()
+{
+    redrawRequested.store(true, std::memory_order_relaxed);
+}
+
+bool VulkanWindow::consumeRedrawRequest()
+{
+    return redrawRequested.exchange(false, std::memory_order_relaxed);
+}
+
+void VulkanWindow::setKeyHandler(
+    std::function<void(int key, int action)> handler)
+{
+    keyHandler = std::move(handler);
+}
+
+void VulkanWindow::onKey(int key, int action)
+{
+    if (keyHandler)
+        keyHandler(key, action);
 }
@@ -1,6 +1,9 @@
 #ifndef GLFW_WINDOW_H
 #define GLFW_WINDOW_H
 
+#include <atomic>
+#include <functional>
+
 #include "VulkanTypes.h"
 
 class VulkanWindow
@@ -9,13 +12,40 @@ class VulkanWindow
     VulkanWindow(VulkanContext *context);
     ~VulkanWindow();
     void init();
+    // Called from the GLFW callback on the main thread.
+    void onFramebufferResized(int width, int height);
+    // Returns whether the framebuffer changed since the last call. Safe to
+    // call from the render thread.
+    bool consumeFramebufferResized();
+    // Input, resizes and the window system asking for its contents all
+    // request one. Called from the GLFW callbacks on the main thread.
+    void requestRedraw();
+    // Returns whether a redraw was requested since the last call.
+    bool consumeRedrawRequest();
+    // Called with GLFW's key and action on every key event, on the main
+    // thread.
+    void setKeyHandler(std::function<void(int key, int action)> handler);
+    void onKey(int key, int action);
 
   public:
     operator GlfwWindow() const { return window; }
+    // Last size reported by GLFW, readable from any thread.
+    VkExtent2D getFramebufferSize() const
+    {
+        return {framebufferWidth.load(std::memory_order_relaxed),
+                framebufferHeight.load(std::memory_order_relaxed)};
+    }
 
   private:
     VulkanContext *context;
 
     GlfwWindow window;
+
+    std::function<void(int key, int action)> keyHandler;
+
+    std::atomic<bool> framebufferResized;
+    std::atomic<bool> redrawRequested;
+    std::atomic<uint32_t> framebufferWidth;
+    std::atomic<uint32_t> framebufferHeight;
 };
 #endif // VULKAN_SURFACE_H
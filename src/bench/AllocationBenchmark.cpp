@@ -0,0 +1,235 @@
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#include "HostAllocator.h"
+#include "Profiler.h"
+#include "Scene.h"
+#include "VulkanApp.h"
+
+#include "Benchmarks.h"
+
+// The replacements below serve every mode, but only count while this is
+// set. Counted from any thread: job system workers run frame work too.
+static std::atomic<bool> countingAllocations(false);
+static std::atomic<uint64_t> heapAllocations(0);
+
+static void *countedAllocate(size_t size)
+{
+    if (countingAllocations.load(std::memory_order_relaxed))
+        heapAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (size == 0)
+        size = 1;
+    while (true)
+    {
+        if (void *memory = std::malloc(size))
+            return memory;
+
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+// Over-aligned new keeps the standard library's version: nothing on the
+// frame path asks for more than max_align_t.
+void *operator new(size_t size)
+{
+    return countedAllocate(size);
+}
+
+void *operator new[](size_t size)
+{
+    return countedAllocate(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    try
+    {
+        return countedAllocate(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    try
+    {
+        return countedAllocate(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, const std::nothrow_t &) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory, const std::nothrow_t &) noexcept
+{
+    std::free(memory);
+}
+
+static uint64_t getDriverAllocations()
+{
+    HostAllocationStatistics statistics = HostAllocator::getStatistics();
+
+    uint64_t total = 0;
+    for (const HostAllocationUsage &usage : statistics.scopes)
+        total += usage.totalAllocations;
+    return total;
+}
+
+// The app streams its mesh in, frames before that draw nothing.
+static const double ASSET_TIMEOUT_SECONDS = 10.0;
+
+static void createObjects(Scene &scene, MeshHandle mesh, uint32_t count)
+{
+    uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(count)));
+    float spacing = 2.0f / side;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        glm::vec3 position((i % side + 0.5f) * spacing - 1.0f,
+                           (i / side + 0.5f) * spacing - 1.0f,
+                           0.0f);
+        scene.create(mesh,
+                     position,
+                     glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                     glm::vec3(spacing),
+                     0);
+    }
+}
+
+static void writeCounts(std::ostream &out,
+                        const char *name,
+                        const std::vector<uint64_t> &counts)
+{
+    uint64_t total = 0;
+    uint64_t maxPerFrame = 0;
+    uint32_t frames = 0;
+    for (uint64_t count : counts)
+    {
+        total += count;
+        maxPerFrame = std::max(maxPerFrame, count);
+        frames += count > 0;
+    }
+
+    out << "\"" << name << "\": {\"total\": " << total
+        << ", \"maxPerFrame\": " << maxPerFrame
+        << ", \"framesAllocating\": " << frames << "}";
+}
+
+// Steady state frames must not touch the heap: after the warmup, every
+// operator new during a whole VulkanApp iteration is a failure, from
+// stepping the simulation and publishing its snapshot to recording and
+// drawing the frame. Driver allocations made through the host allocator
+// are reported, not enforced.
+int runAllocationBenchmark(const BenchOptions &options)
+{
+    VulkanApp app(options.config);
+    app.init();
+
+    uint64_t assetDeadline =
+        Profiler::now() + static_cast<uint64_t>(ASSET_TIMEOUT_SECONDS * 1e9);
+    while (app.getScene().size() == 0)
+    {
+        if (Profiler::now() > assetDeadline)
+            throw std::runtime_error("Timed out loading the app's mesh");
+        app.step();
+    }
+
+    // The app's own object is the first.
+    Scene &scene = app.getScene();
+    if (options.objectCount > 1)
+        createObjects(scene, scene.getMeshes()[0], options.objectCount - 1);
+
+    std::vector<uint64_t> heapCounts;
+    std::vector<uint64_t> driverCounts;
+    heapCounts.reserve(options.frameCount);
+    driverCounts.reserve(options.frameCount);
+
+    uint32_t totalFrames = options.warmupFrames + options.frameCount;
+    for (uint32_t frame = 0; frame < totalFrames; frame++)
+    {
+        bool measured = frame >= options.warmupFrames;
+
+        uint64_t heapBefore = heapAllocations.load();
+        uint64_t driverBefore = getDriverAllocations();
+        countingAllocations.store(measured);
+
+        app.step();
+
+        countingAllocations.store(false);
+        if (!measured)
+            continue;
+
+        heapCounts.push_back(heapAllocations.load() - heapBefore);
+        driverCounts.push_back(getDriverAllocations() - driverBefore);
+    }
+
+    const VulkanContext &context = app.getContext();
+    vkDeviceWaitIdle(context.getDevice());
+
+    const FrameArena &frameArena = context.getFrameArena();
+    std::cout << "{\n  \"config\": {\"mode\": \"allocations\", \"objects\": "
+              << scene.size() << ", \"frames\": " << options.frameCount
+              << ", \"recording\": "
+              << (options.config.recordPath.empty() ? "false" : "true")
+              << "},\n  ";
+    writeCounts(std::cout, "heap", heapCounts);
+    std::cout << ",\n  ";
+    writeCounts(std::cout, "driver", driverCounts);
+    std::cout << ",\n  \"frameArena\": {\"capacity\": "
+              << frameArena.getCapacity()
+              << ", \"peak\": " << frameArena.getPeak()
+              << ", \"overflows\": " << frameArena.getOverflowCount()
+              << "}\n}" << std::endl;
+
+    uint64_t total = 0;
+    for (uint64_t count : heapCounts)
+        total += count;
+    if (total > 0)
+    {
+        std::cerr << total << " heap allocations in steady state frames"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,25 @@
+#ifndef BENCH_OPTIONS_H
+#define BENCH_OPTIONS_H
+
+#include <string>
+
+#include "VulkanTypes.h"
+
+struct BenchOptions
+{
+    std::string mode = "frames";
+    ContextConfig config;
+    uint32_t objectCount = 1;
+    uint32_t warmupFrames = 60;
+    // Measured frames, or iterations for the CPU only modes.
+    uint32_t frameCount = 1000;
+    // Cap the pacing mode holds.
+    double frameRate = 60.0;
+    // Frame recording the replay mode draws.
+    std::string recordingPath;
+    std::string outputPath;
+    std::string baselinePath;
+    double threshold = 0.1;
+};
+
+#endif // BENCH_OPTIONS_H
@@ -0,0 +1,89 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "VulkanNullDriver.h"
+
+#include "BenchReport.h"
+
+static void writeReport(std::ostream &out,
+                        const std::string &configJson,
+                        const std::vector<NamedSummary> &summaries)
+{
+    out << "{\n  \"config\": " << configJson;
+    for (const NamedSummary &summary : summaries)
+    {
+        out << ",\n  ";
+        writeSummary(out, summary.name, summary.summary);
+    }
+    out << "\n}\n";
+}
+
+static bool compareBaseline(const BenchOptions &options,
+                            const std::vector<NamedSummary> &summaries)
+{
+    std::ifstream file(options.baselinePath);
+    if (!file.is_open())
+        throw std::runtime_error("Failed to open baseline file!");
+
+    std::stringstream json;
+    json << file.rdbuf();
+
+    bool regressed = false;
+    for (const NamedSummary &summary : summaries)
+    {
+        // GPU times are missing without timestamp support.
+        TimingSummary baseline{};
+        if (summary.summary.samples == 0 ||
+            !readSummary(json.str(), summary.name, baseline))
+        {
+            continue;
+        }
+
+        regressed |= reportRegressions(
+            summary.name, summary.summary, baseline, options.threshold);
+    }
+
+    return regressed;
+}
+
+int publishReport(const BenchOptions &options,
+                  const std::string &configJson,
+                  const std::vector<NamedSummary> &summaries)
+{
+    writeReport(std::cout, configJson, summaries);
+    if (!options.outputPath.empty())
+    {
+        std::ofstream file(options.outputPath);
+        writeReport(file, configJson, summaries);
+        if (!file.good())
+            throw std::runtime_error("Failed to write report!");
+    }
+
+    if (!options.baselinePath.empty() && compareBaseline(options, summaries))
+        return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
+
+std::string formatNullDriverCalls(uint32_t frameCount)
+{
+    std::ostringstream json;
+    json << "{";
+    const char *separator = "";
+    for (uint32_t i = 0; i < VulkanNullDriver::COMMAND_COUNT; i++)
+    {
+        VulkanNullDriver::Command command =
+            static_cast<VulkanNullDriver::Command>(i);
+        uint64_t calls = VulkanNullDriver::getCallCount(command);
+        if (calls == 0)
+            continue;
+
+        json << separator << "\"" << VulkanNullDriver::getCommandName(command)
+             << "\": " << static_cast<double>(calls) / frameCount;
+        separator = ", ";
+    }
+    json << "}";
+    return json.str();
+}
@@ -0,0 +1,27 @@
+#ifndef BENCH_REPORT_H
+#define BENCH_REPORT_H
+
+#include <string>
+#include <vector>
+
+#include "BenchOptions.h"
+#include "FrameStatistics.h"
+
+struct NamedSummary
+{
+    const char *name;
+    TimingSummary summary;
+};
+
+// Prints the JSON report, writes it to the output path and compares it
+// against the baseline when one was given. Summaries without samples are
+// not compared. Returns the process exit code.
+int publishReport(const BenchOptions &options,
+                  const std::string &configJson,
+                  const std::vector<NamedSummary> &summaries);
+
+// JSON object of the null driver's calls per frame since its counts were
+// last reset, only the commands that were called.
+std::string formatNullDriverCalls(uint32_t frameCount);
+
+#endif // BENCH_REPORT_H
@@ -0,0 +1,24 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include "BenchOptions.h"
+
+// Each returns the process exit code.
+int runFrameBenchmark(const BenchOptions &options);
+int runTransformBenchmark(const BenchOptions &options);
+int runJobBenchmark(const BenchOptions &options);
+// Loader trampolines against the device dispatch table.
+int runDispatchBenchmark(const BenchOptions &options);
+// FramePacer's intervals against sleeping until each deadline.
+int runPacingBenchmark(const BenchOptions &options);
+// FrameHistogram's recording cost and percentile accuracy.
+int runHistogramBenchmark(const BenchOptions &options);
+// optimizeMesh throughput on a shuffled million triangle grid.
+int runMeshBenchmark(const BenchOptions &options);
+// Draws a frame recording of the app, for A/B comparisons of renderer
+// changes on the same frames.
+int runReplayBenchmark(const BenchOptions &options);
+// Fails when a steady state frame allocates from the heap.
+int runAllocationBenchmark(const BenchOptions &options);
+
+#endif // BENCHMARKS_H
@@ -0,0 +1,142 @@
+#include <vulkan/vk_enum_string_helper.h>
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "HostAllocator.h"
+#include "Profiler.h"
+#include "VulkanContext.h"
+
+#include "BenchReport.h"
+#include "Benchmarks.h"
+
+// Few enough calls and the clock reads dominate.
+static const uint32_t DISPATCH_MIN_OBJECTS = 4096;
+// Bind, viewport and scissor per object.
+static const uint32_t DISPATCH_CALLS_PER_OBJECT = 3;
+
+template <typename RecordObject>
+static uint64_t timeRecording(VkCommandBuffer commandBuffer,
+                              uint32_t objectCount,
+                              RecordObject recordObject)
+{
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    vkResetCommandBuffer(commandBuffer, 0);
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    uint64_t begin = Profiler::now();
+    for (uint32_t i = 0; i < objectCount; i++)
+        recordObject(commandBuffer);
+    uint64_t end = Profiler::now();
+
+    vkEndCommandBuffer(commandBuffer);
+    return end - begin;
+}
+
+// Per call overhead of the loader's trampolines against the device
+// dispatch table, on the state recordDraws binds when objects differ. Recorded
+// outside a render pass and never submitted, so nothing is drawn and only
+// the CPU side is measured.
+int runDispatchBenchmark(const BenchOptions &options)
+{
+    VulkanContext context(options.config);
+    context.init();
+
+    const VulkanDevice &device = context.getDevice();
+    const VulkanDispatch &dispatch = device.getDispatch();
+    VkPipeline pipeline = context.getPipeline();
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex =
+        device.getQueueFamiyIndices().graphicsFamily.value();
+
+    VkCommandPool commandPool;
+    VkResult result =
+        vkCreateCommandPool(device,
+                            &poolInfo,
+                            HostAllocator::get(HostAllocationTag::Commands),
+                            &commandPool);
+    if (result != VK_SUCCESS)
+    {
+        std::string errorMsg("Failed to create command pool: ");
+        errorMsg.append(string_VkResult(result));
+        throw std::runtime_error(errorMsg);
+    }
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+
+    VkCommandBuffer commandBuffer;
+    vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
+
+    const VkExtent2D &extent = context.getSwapChain().getExtent();
+    VkViewport viewport{};
+    viewport.width = static_cast<float>(extent.width);
+    viewport.height = static_cast<float>(extent.height);
+    viewport.maxDepth = 1.0f;
+    VkRect2D scissor{};
+    scissor.extent = extent;
+
+    auto recordThroughLoader = [&](VkCommandBuffer buffer) {
+        vkCmdBindPipeline(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        vkCmdSetViewport(buffer, 0, 1, &viewport);
+        vkCmdSetScissor(buffer, 0, 1, &scissor);
+    };
+    auto recordThroughTable = [&](VkCommandBuffer buffer) {
+        dispatch.vkCmdBindPipeline(
+            buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        dispatch.vkCmdSetViewport(buffer, 0, 1, &viewport);
+        dispatch.vkCmdSetScissor(buffer, 0, 1, &scissor);
+    };
+
+    uint32_t objectCount = std::max(options.objectCount, DISPATCH_MIN_OBJECTS);
+    std::vector<uint64_t> loaderTimes;
+    std::vector<uint64_t> tableTimes;
+    loaderTimes.reserve(options.frameCount);
+    tableTimes.reserve(options.frameCount);
+
+    // Interleaved, so clock and cache drift hit both paths alike.
+    for (uint32_t i = 0; i < options.warmupFrames + options.frameCount; i++)
+    {
+        uint64_t loaderTime =
+            timeRecording(commandBuffer, objectCount, recordThroughLoader);
+        uint64_t tableTime =
+            timeRecording(commandBuffer, objectCount, recordThroughTable);
+
+        if (i < options.warmupFrames)
+            continue;
+
+        loaderTimes.push_back(loaderTime);
+        tableTimes.push_back(tableTime);
+    }
+
+    vkDestroyCommandPool(device,
+                         commandPool,
+                         HostAllocator::get(HostAllocationTag::Commands));
+
+    TimingSummary loader = summarize(std::move(loaderTimes));
+    TimingSummary table = summarize(std::move(tableTimes));
+
+    // Summaries are in milliseconds per iteration.
+    double calls = static_cast<double>(objectCount) * DISPATCH_CALLS_PER_OBJECT;
+    std::ostringstream config;
+    config << "{\"mode\": \"dispatch\", \"objects\": " << objectCount
+           << ", \"iterations\": " << options.frameCount
+           << ", \"loaderNsPerCall\": " << loader.mean * 1e6 / calls
+           << ", \"tableNsPerCall\": " << table.mean * 1e6 / calls << "}";
+
+    return publishReport(
+        options, config.str(), {{"loader", loader}, {"table", table}});
+}
@@ -0,0 +1,141 @@
+#include <glm/gtc/quaternion.hpp>
+
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+#include "Camera.h"
+#include "Profiler.h"
+#include "Scene.h"
+#include "Triangle.h"
+#include "VulkanContext.h"
+#include "VulkanNullDriver.h"
+
+#include "BenchReport.h"
+#include "Benchmarks.h"
+
+// Square grid centered on the origin that fits the default camera.
+static void createObjects(Scene &scene, MeshHandle mesh, uint32_t count)
+{
+    uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(count)));
+    float spacing = 2.0f / side;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        glm::vec3 position((i % side + 0.5f) * spacing - 1.0f,
+                           (i / side + 0.5f) * spacing - 1.0f,
+                           0.0f);
+        scene.create(mesh,
+                     position,
+                     glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                     glm::vec3(spacing),
+                     0);
+    }
+}
+
+static void animateObjects(TransformSystem &transforms, uint32_t frame)
+{
+    for (uint32_t i = 0; i < transforms.size(); i++)
+    {
+        float angle = glm::radians(static_cast<float>(frame + i));
+        transforms.setRotation(
+            i, glm::angleAxis(angle, glm::vec3(0.0f, 0.0f, 1.0f)));
+    }
+}
+
+int runFrameBenchmark(const BenchOptions &options)
+{
+    VulkanContext context(options.config);
+    context.init();
+
+    Triangle triangle(&context);
+    triangle.init();
+
+    Scene scene;
+    createObjects(scene, scene.addMesh(&triangle), options.objectCount);
+
+    const VkExtent2D &extent = context.getSwapChain().getExtent();
+    Camera camera;
+    camera.setAspect(static_cast<float>(extent.width) /
+                     static_cast<float>(extent.height));
+
+    VulkanPipeline &pipeline = context.getPipeline();
+    const VulkanGpuTimer &gpuTimer = context.getGpuTimer();
+
+    std::vector<uint64_t> cpuTimes;
+    std::vector<uint64_t> gpuTimes;
+    cpuTimes.reserve(options.frameCount);
+    gpuTimes.reserve(options.frameCount);
+
+    uint64_t collectedFrames = gpuTimer.getCollectedFrameCount();
+    uint32_t totalFrames = options.warmupFrames + options.frameCount;
+    for (uint32_t frame = 0; frame < totalFrames; frame++)
+    {
+        if (frame == options.warmupFrames)
+            VulkanNullDriver::resetCallCounts();
+
+        uint64_t begin = Profiler::now();
+        animateObjects(scene.getTransforms(), frame);
+        pipeline.drawFrame(scene, camera);
+        uint64_t end = Profiler::now();
+
+        // GPU times arrive frames in flight later, a few measured frames
+        // report warmup work and that is fine.
+        bool collected = gpuTimer.getCollectedFrameCount() != collectedFrames;
+        collectedFrames = gpuTimer.getCollectedFrameCount();
+
+        if (frame < options.warmupFrames)
+            continue;
+
+        cpuTimes.push_back(end - begin);
+        if (collected)
+            gpuTimes.push_back(gpuTimer.getLastFrameTime());
+    }
+
+    vkDeviceWaitIdle(context.getDevice());
+
+    std::ostringstream config;
+    config << "{\"mode\": \"frames\", \"objects\": " << options.objectCount
+           << ", \"width\": " << options.config.width
+           << ", \"height\": " << options.config.height
+           << ", \"framesInFlight\": " << options.config.framesInFlight
+           << ", \"frames\": " << options.frameCount;
+    // Comparable only against reports of the same path.
+    bool dynamicRendering = context.getRenderPass().usesDynamicRendering();
+    // The last frame's, the scene doesn't change shape between frames.
+    const DrawStats &drawStats = pipeline.getDrawStats();
+    config << ", \"dynamicRendering\": "
+           << (dynamicRendering ? "true" : "false") << ", \"samples\": "
+           << context.getRenderPass().getSampleCount()
+           << ", \"draws\": " << drawStats.draws << ", \"binds\": "
+           << drawStats.getBindCount()
+           << ", \"bindsAvoided\": " << drawStats.bindsAvoided;
+    // GPU times of scaled runs depend on where the scale settled.
+    if (context.getSwapChain().isScaled())
+    {
+        const ResolutionScaler &scaler = pipeline.getResolutionScaler();
+        config << ", \"minScale\": " << options.config.minResolutionScale
+               << ", \"gpuBudgetMs\": " << options.config.gpuBudgetMs
+               << ", \"finalScale\": " << scaler.getScale()
+               << ", \"scaleAdjustments\": " << scaler.getAdjustmentCount();
+    }
+    // CPU time alone, what the renderer asked of the driver instead.
+    if (options.config.nullDriver)
+    {
+        config << ", \"nullDriver\": true, \"callsPerFrame\": "
+               << formatNullDriverCalls(options.frameCount);
+    }
+    // Capturing must not slow frames down, only drop them.
+    const VulkanFrameCapture &frameCapture = context.getFrameCapture();
+    if (frameCapture.isCapturing())
+    {
+        config << ", \"capturedFrames\": " << frameCapture.getCapturedCount()
+               << ", \"droppedFrames\": " << frameCapture.getDroppedCount();
+    }
+    config << "}";
+
+    return publishReport(options,
+                         config.str(),
+                         {{"cpu", summarize(cpuTimes)},
+                          {"gpu", summarize(gpuTimes)}});
+}
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "FrameStatistics.h"
+
+static const char *metricNames[] = {"mean", "p50", "p99", "max"};
+static const size_t METRIC_COUNT = 4;
+
+static double &getMetric(TimingSummary &summary, size_t index)
+{
+    double *metrics[] = {
+        &summary.mean, &summary.p50, &summary.p99, &summary.max};
+    return *metrics[index];
+}
+
+static double getMetric(const TimingSummary &summary, size_t index)
+{
+    const double metrics[] = {
+        summary.mean, summary.p50, summary.p99, summary.max};
+    return metrics[index];
+}
+
+static double toMilliseconds(uint64_t nanoseconds)
+{
+    return static_cast<double>(nanoseconds) / 1.0e6;
+}
+
+TimingSummary summarize(std::vector<uint64_t> samples)
+{
+    TimingSummary summary{};
+    summary.samples = static_cast<uint32_t>(samples.size());
+    if (samples.empty())
+        return summary;
+
+    std::sort(samples.begin(), samples.end());
+
+    double total = 0.0;
+    for (uint64_t sample : samples)
+        total += toMilliseconds(sample);
+
+    auto percentile = [&samples](double p) {
+        size_t rank = static_cast<size_t>(p * samples.size() + 0.5);
+        rank = std::clamp<size_t>(rank, 1, samples.size());
+        return toMilliseconds(samples[rank - 1]);
+    };
+
+    summary.mean = total / samples.size();
+    summary.p50 = percentile(0.50);
+    summary.p99 = percentile(0.99);
+    summary.max = toMilliseconds(samples.back());
+    return summary;
+}
+
+void writeSummary(std::ostream &out,
+                  const char *name,
+                  const TimingSummary &summary)
+{
+    out << "\"" << name << "\": {";
+    for (size_t i = 0; i < METRIC_COUNT; i++)
+    {
+        out << "\"" << metricNames[i] << "\": " << getMetric(summary, i)
+            << ", ";
+    }
+    out << "\"samples\": " << summary.samples << "}";
+}
+
+// Finds the object value of the report's top level member called name, so
+// a config key or string of the same name can't be taken for it. Sets
+// begin and end to its braces; summaries hold no nested objects.
+static bool findSummary(const std::string &json,
+                        const char *name,
+                        size_t &begin,
+                        size_t &end)
+{
+    int depth = 0;
+    for (size_t i = 0; i < json.size(); i++)
+    {
+        char c = json[i];
+        if (c == '{' || c == '[')
+        {
+            depth++;
+            continue;
+        }
+        if (c == '}' || c == ']')
+        {
+            depth--;
+            continue;
+        }
+        if (c != '"')
+            continue;
+
+        size_t stringBegin = i + 1;
+        for (i = stringBegin; i < json.size() && json[i] != '"'; i++)
+        {
+            if (json[i] == '\\')
+                i++;
+        }
+        if (depth != 1 || json.compare(stringBegin,
+                                       i - stringBegin,
+                                       name) != 0)
+        {
+            continue;
+        }
+
+        size_t colon = json.find_first_not_of(" \t\r\n", i + 1);
+        if (colon == std::string::npos || json[colon] != ':')
+            continue;
+        begin = json.find_first_not_of(" \t\r\n", colon + 1);
+        if (begin == std::string::npos || json[begin] != '{')
+            return false;
+        end = json.find('}', begin);
+        return end != std::string::npos;
+    }
+    return false;
+}
+
+bool readSummary(const std::string &json,
+                 const char *name,
+                 TimingSummary &summary)
+{
+    size_t begin;
+    size_t end;
+    if (!findSummary(json, name, begin, end))
+        return false;
+
+    for (size_t i = 0; i < METRIC_COUNT; i++)
+    {
+        std::string key = std::string("\"") + metricNames[i] + "\"";
+        size_t position = json.find(key, begin);
+        if (position == std::string::npos || position > end)
+            return false;
+
+        position = json.find(':', position);
+        getMetric(summary, i) =
+            std::strtod(json.c_str() + position + 1, nullptr);
+    }
+
+    return true;
+}
+
+bool reportRegressions(const char *name,
+                       const TimingSummary &current,
+                       const TimingSummary &baseline,
+                       double threshold)
+{
+    bool regressed = false;
+    for (size_t i = 0; i < METRIC_COUNT; i++)
+    {
+        double value = getMetric(current, i);
+        double reference = getMetric(baseline, i);
+        if (reference <= 0.0 || value <= reference * (1.0 + threshold))
+            continue;
+
+        std::cerr << "Regression: " << name << " " << metricNames[i] << " "
+                  << value << " ms vs " << reference << " ms baseline (+"
+                  << (value / reference - 1.0) * 100.0 << "%)" << std::endl;
+        regressed = true;
+    }
+
+    return regressed;
+}
@@ -0,0 +1,39 @@
+#ifndef FRAME_STATISTICS_H
+#define FRAME_STATISTICS_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct TimingSummary
+{
+    // Milliseconds.
+    double mean;
+    double p50;
+    double p99;
+    double max;
+    uint32_t samples;
+};
+
+// Nearest rank percentiles over nanosecond samples.
+TimingSummary summarize(std::vector<uint64_t> samples);
+
+void writeSummary(std::ostream &out,
+                  const char *name,
+                  const TimingSummary &summary);
+
+// Reads a summary back from a report written by writeSummary, only the
+// metrics are parsed.
+bool readSummary(const std::string &json,
+                 const char *name,
+                 TimingSummary &summary);
+
+// Prints every metric of current that is slower than baseline by more than
+// threshold (0.1 for 10%) and returns whether any was.
+bool reportRegressions(const char *name,
+                       const TimingSummary &current,
+                       const TimingSummary &baseline,
+                       double threshold);
+
+#endif // FRAME_STATISTICS_H
@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "FrameHistogram.h"
+#include "Profiler.h"
+
+#include "BenchReport.h"
+#include "Benchmarks.h"
+
+// Recorded per iteration, few enough and the clock reads dominate.
+static const uint32_t HISTOGRAM_BATCH = 4096;
+
+// Frame intervals around 60 Hz with a long tail and the odd hitch, so the
+// high percentiles land in sparse buckets.
+static std::vector<uint64_t> generateIntervals(uint32_t count)
+{
+    std::mt19937_64 random(42);
+    std::lognormal_distribution<double> frame(std::log(16.6e6), 0.15);
+    std::uniform_real_distribution<double> hitch(0.0, 1.0);
+
+    std::vector<uint64_t> intervals(count);
+    for (uint64_t &interval : intervals)
+    {
+        double value = frame(random);
+        if (hitch(random) < 0.002)
+            value *= 4.0;
+        interval = static_cast<uint64_t>(value);
+    }
+    return intervals;
+}
+
+// Worst relative distance of the histogram's percentiles from the exact
+// nearest rank ones.
+static double measurePercentileError(const FrameHistogram &histogram,
+                                     std::vector<uint64_t> intervals)
+{
+    std::sort(intervals.begin(), intervals.end());
+
+    std::unique_ptr<HistogramSnapshot> snapshot(new HistogramSnapshot());
+    histogram.snapshot(*snapshot);
+
+    double worst = 0.0;
+    for (double percentile : {0.5, 0.9, 0.99, 0.999})
+    {
+        size_t rank = static_cast<size_t>(
+            std::ceil(percentile * static_cast<double>(intervals.size())));
+        double exact = static_cast<double>(intervals[rank - 1]);
+        double estimate =
+            static_cast<double>(snapshot->getPercentile(percentile));
+        worst = std::max(worst, std::abs(estimate - exact) / exact);
+    }
+    return worst;
+}
+
+// No device: the render thread's cost of recording into a FrameHistogram,
+// and how far its percentiles are from exact ones.
+int runHistogramBenchmark(const BenchOptions &options)
+{
+    std::vector<uint64_t> intervals = generateIntervals(HISTOGRAM_BATCH);
+
+    // Some 4 KiB of counters, kept off the stack.
+    std::unique_ptr<FrameHistogram> histogram(new FrameHistogram());
+    std::vector<uint64_t> times;
+    times.reserve(options.frameCount);
+
+    for (uint32_t i = 0; i < options.warmupFrames + options.frameCount; i++)
+    {
+        uint64_t begin = Profiler::now();
+        for (uint64_t interval : intervals)
+            histogram->record(interval);
+        uint64_t end = Profiler::now();
+
+        if (i >= options.warmupFrames)
+            times.push_back(end - begin);
+    }
+
+    // Every iteration recorded the same values, the distribution is theirs.
+    double error = measurePercentileError(*histogram, intervals);
+    TimingSummary record = summarize(std::move(times));
+
+    // Summaries are in milliseconds per batch.
+    std::ostringstream config;
+    config << "{\"mode\": \"histogram\", \"batch\": " << HISTOGRAM_BATCH
+           << ", \"iterations\": " << options.frameCount
+           << ", \"nsPerRecord\": " << record.mean * 1e6 / HISTOGRAM_BATCH
+           << ", \"maxPercentileError\": " << error << "}";
+
+    return publishReport(options, config.str(), {{"record", record}});
+}
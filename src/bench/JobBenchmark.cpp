@@ -0,0 +1,100 @@
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Camera.h"
+#include "JobSystem.h"
+#include "LodSelector.h"
+#include "MeshSimplifier.h"
+#include "Profiler.h"
+#include "TransformSystem.h"
+
+#include "BenchReport.h"
+#include "Benchmarks.h"
+
+// The per frame CPU work of drawFrame, without a device: LOD selection
+// and matrices for every object, split the same way.
+int runJobBenchmark(const BenchOptions &options)
+{
+    uint32_t count = options.objectCount;
+
+    TransformSystem transforms;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        float t = static_cast<float>(i);
+        transforms.add(
+            glm::vec3(t * 0.01f, -t * 0.02f, t * 0.03f),
+            glm::angleAxis(t, glm::normalize(glm::vec3(1.0f, t, 2.0f))),
+            glm::vec3(1.0f + t * 0.001f));
+    }
+
+    Camera camera;
+    const glm::mat4 &viewProjection = camera.getViewProjection();
+
+    MeshLod lods[] = {{0, 3000, 0.0f}, {3000, 750, 0.01f}, {3750, 180, 0.1f}};
+    LodSelectionParams lodParams{};
+    lodParams.cameraPosition = camera.getPosition();
+    lodParams.projectionScale = computeProjectionScale(
+        static_cast<float>(options.config.height), camera.getFovY());
+    lodParams.pixelThreshold = 1.0f;
+
+    std::vector<float> radii(count, 1.0f);
+    std::vector<uint8_t> selectedLods(count);
+    std::vector<glm::mat4> out(count);
+
+    uint32_t maxThreads = options.config.workerThreads;
+    if (maxThreads == 0)
+        maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    // NamedSummary only points at the names.
+    std::vector<std::string> names;
+    names.reserve(maxThreads);
+    std::vector<NamedSummary> summaries;
+
+    for (uint32_t threads = 1; threads <= maxThreads; threads++)
+    {
+        JobSystem jobSystem(threads);
+
+        auto update = [&](uint32_t begin, uint32_t end) {
+            selectLods(lodParams,
+                       lods,
+                       3,
+                       transforms.getPositionsX() + begin,
+                       transforms.getPositionsY() + begin,
+                       transforms.getPositionsZ() + begin,
+                       radii.data() + begin,
+                       end - begin,
+                       selectedLods.data() + begin);
+            transforms.computeMvps(
+                viewProjection, begin, end - begin, out.data() + begin);
+        };
+
+        std::vector<uint64_t> times;
+        times.reserve(options.frameCount);
+        for (uint32_t i = 0; i < options.warmupFrames + options.frameCount;
+             i++)
+        {
+            uint64_t begin = Profiler::now();
+            jobSystem.parallelFor(count, 1024, update);
+            uint64_t end = Profiler::now();
+
+            if (i >= options.warmupFrames)
+                times.push_back(end - begin);
+        }
+
+        names.push_back("threads" + std::to_string(threads));
+        summaries.push_back(
+            {names.back().c_str(), summarize(std::move(times))});
+    }
+
+    std::ostringstream config;
+    config << "{\"mode\": \"jobs\", \"objects\": " << count
+           << ", \"threads\": " << maxThreads
+           << ", \"iterations\": " << options.frameCount << "}";
+
+    return publishReport(options, config.str(), summaries);
+}
@@ -0,0 +1,50 @@
+#include <sstream>
+#include <vector>
+
+#include "MeshGrid.h"
+#include "MeshOptimizer.h"
+#include "Profiler.h"
+
+#include "BenchReport.h"
+#include "Benchmarks.h"
+
+// Quads per side, a little over a million triangles.
+static const uint32_t MESH_GRID_SIZE = 708;
+
+int runMeshBenchmark(const BenchOptions &options)
+{
+    std::vector<Vertex> sourceVertices;
+    std::vector<uint32_t> sourceIndices;
+    buildGrid(MESH_GRID_SIZE, true, sourceVertices, sourceIndices);
+
+    std::vector<uint64_t> times;
+    times.reserve(options.frameCount);
+    MeshOptimizationReport report{};
+
+    for (uint32_t i = 0; i < options.warmupFrames + options.frameCount; i++)
+    {
+        std::vector<Vertex> vertices = sourceVertices;
+        std::vector<uint32_t> indices = sourceIndices;
+
+        uint64_t begin = Profiler::now();
+        report = optimizeMesh(vertices, indices);
+        uint64_t end = Profiler::now();
+
+        if (i >= options.warmupFrames)
+            times.push_back(end - begin);
+    }
+
+    TimingSummary optimize = summarize(std::move(times));
+    size_t triangles = sourceIndices.size() / 3;
+
+    std::ostringstream config;
+    config << "{\"mode\": \"mesh\", \"triangles\": " << triangles
+           << ", \"iterations\": " << options.frameCount
+           << ", \"mtrisPerSecond\": " << triangles / (optimize.mean * 1e3)
+           << ", \"acmrBefore\": " << report.before.acmr
+           << ", \"acmrAfter\": " << report.after.acmr
+           << ", \"atvrBefore\": " << report.before.atvr
+           << ", \"atvrAfter\": " << report.after.atvr << "}";
+
+    return publishReport(options, config.str(), {{"optimize", optimize}});
+}
@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "FramePacer.h"
+#include "Profiler.h"
+
+#include "BenchReport.h"
+#include "Benchmarks.h"
+
+// Absolute distance of every interval from the period, the jitter a
+// capped frame rate shows.
+template <typename Wait>
+static std::vector<uint64_t> measureErrors(const BenchOptions &options,
+                                           uint64_t period,
+                                           Wait wait)
+{
+    std::vector<uint64_t> errors;
+    errors.reserve(options.frameCount);
+
+    uint64_t previous = Profiler::now();
+    for (uint32_t i = 0; i < options.warmupFrames + options.frameCount; i++)
+    {
+        wait();
+        uint64_t now = Profiler::now();
+        uint64_t interval = now - previous;
+        previous = now;
+
+        if (i >= options.warmupFrames)
+            errors.push_back(interval > period ? interval - period
+                                               : period - interval);
+    }
+
+    return errors;
+}
+
+// No device: measures how closely FramePacer holds the frame rate against
+// the plain sleep_until loop the simulation tick uses.
+int runPacingBenchmark(const BenchOptions &options)
+{
+    FramePacer pacer(options.frameRate);
+    uint64_t period = pacer.getPeriod();
+    std::vector<uint64_t> pacerErrors =
+        measureErrors(options, period, [&]() { pacer.wait(); });
+
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point deadline = Clock::now();
+    std::vector<uint64_t> sleepErrors = measureErrors(options, period, [&]() {
+        deadline = std::max(deadline + std::chrono::nanoseconds(period),
+                            Clock::now());
+        std::this_thread::sleep_until(deadline);
+    });
+
+    std::ostringstream config;
+    config << "{\"mode\": \"pacing\", \"frameRate\": " << options.frameRate
+           << ", \"iterations\": " << options.frameCount
+           << ", \"spinMarginMs\": " << pacer.getSpinMargin() / 1e6 << "}";
+
+    return publishReport(options,
+                         config.str(),
+                         {{"pacerError", summarize(std::move(pacerErrors))},
+                          {"sleepError", summarize(std::move(sleepErrors))}});
+}
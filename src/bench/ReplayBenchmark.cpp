@@ -0,0 +1,104 @@
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "Camera.h"
+#include "FrameRecording.h"
+#include "Profiler.h"
+#include "Scene.h"
+#include "Triangle.h"
+#include "VulkanContext.h"
+#include "VulkanNullDriver.h"
+
+#include "BenchReport.h"
+#include "Benchmarks.h"
+
+int runReplayBenchmark(const BenchOptions &options)
+{
+    if (options.recordingPath.empty())
+        throw std::runtime_error("The replay mode needs --recording");
+    FrameRecording recording(options.recordingPath);
+
+    VulkanContext context(options.config);
+    context.init();
+
+    // The app only draws the triangle, whatever handles it registered it
+    // under all resolve to it here.
+    Triangle triangle(&context);
+    triangle.init();
+
+    Scene scene;
+    for (uint32_t i = 0; i < recording.getMeshCount(); i++)
+        scene.addMesh(&triangle);
+
+    const VkExtent2D &extent = context.getSwapChain().getExtent();
+    Camera camera;
+    camera.setAspect(static_cast<float>(extent.width) /
+                     static_cast<float>(extent.height));
+
+    VulkanPipeline &pipeline = context.getPipeline();
+    const VulkanGpuTimer &gpuTimer = context.getGpuTimer();
+
+    std::vector<uint64_t> cpuTimes;
+    std::vector<uint64_t> gpuTimes;
+    cpuTimes.reserve(options.frameCount);
+    gpuTimes.reserve(options.frameCount);
+
+    uint64_t collectedFrames = gpuTimer.getCollectedFrameCount();
+    uint32_t totalFrames = options.warmupFrames + options.frameCount;
+    for (uint32_t frame = 0; frame < totalFrames; frame++)
+    {
+        // Loops over the recording. Applying isn't timed, the CPU time is
+        // drawFrame's alone, what renderer changes affect.
+        recording.apply(frame % recording.getFrameCount(), scene, camera);
+        if (frame == options.warmupFrames)
+            VulkanNullDriver::resetCallCounts();
+
+        uint64_t begin = Profiler::now();
+        pipeline.drawFrame(scene, camera);
+        uint64_t end = Profiler::now();
+
+        bool collected = gpuTimer.getCollectedFrameCount() != collectedFrames;
+        collectedFrames = gpuTimer.getCollectedFrameCount();
+
+        if (frame < options.warmupFrames)
+            continue;
+
+        cpuTimes.push_back(end - begin);
+        if (collected)
+            gpuTimes.push_back(gpuTimer.getLastFrameTime());
+    }
+
+    vkDeviceWaitIdle(context.getDevice());
+
+    // Only reports of the same recording compare.
+    std::ostringstream config;
+    config << "{\"mode\": \"replay\", \"recording\": \""
+           << options.recordingPath
+           << "\", \"recordedFrames\": " << recording.getFrameCount()
+           << ", \"maxObjects\": " << recording.getMaxObjectCount()
+           << ", \"width\": " << options.config.width
+           << ", \"height\": " << options.config.height
+           << ", \"framesInFlight\": " << options.config.framesInFlight
+           << ", \"frames\": " << options.frameCount;
+    bool dynamicRendering = context.getRenderPass().usesDynamicRendering();
+    // Of the last frame replayed.
+    const DrawStats &drawStats = pipeline.getDrawStats();
+    config << ", \"dynamicRendering\": "
+           << (dynamicRendering ? "true" : "false") << ", \"samples\": "
+           << context.getRenderPass().getSampleCount()
+           << ", \"draws\": " << drawStats.draws << ", \"binds\": "
+           << drawStats.getBindCount()
+           << ", \"bindsAvoided\": " << drawStats.bindsAvoided;
+    if (options.config.nullDriver)
+    {
+        config << ", \"nullDriver\": true, \"callsPerFrame\": "
+               << formatNullDriverCalls(options.frameCount);
+    }
+    config << "}";
+
+    return publishReport(options,
+                         config.str(),
+                         {{"cpu", summarize(cpuTimes)},
+                          {"gpu", summarize(gpuTimes)}});
+}
@@ -0,0 +1,102 @@
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <sstream>
+#include <vector>
+
+#include "Camera.h"
+#include "Profiler.h"
+#include "TransformSystem.h"
+
+#include "BenchReport.h"
+#include "Benchmarks.h"
+
+// What updateUniform did for its single object, once per object.
+static void computeMvpsGlm(const std::vector<glm::vec3> &positions,
+                           const std::vector<glm::quat> &rotations,
+                           const std::vector<glm::vec3> &scales,
+                           const glm::mat4 &viewProjection,
+                           glm::mat4 *out)
+{
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), positions[i]) *
+                          glm::mat4_cast(rotations[i]) *
+                          glm::scale(glm::mat4(1.0f), scales[i]);
+        out[i] = viewProjection * model;
+    }
+}
+
+template <typename Function>
+static TimingSummary measure(const BenchOptions &options, Function function)
+{
+    std::vector<uint64_t> times;
+    times.reserve(options.frameCount);
+
+    for (uint32_t i = 0; i < options.warmupFrames + options.frameCount; i++)
+    {
+        uint64_t begin = Profiler::now();
+        function();
+        uint64_t end = Profiler::now();
+
+        if (i >= options.warmupFrames)
+            times.push_back(end - begin);
+    }
+
+    return summarize(std::move(times));
+}
+
+int runTransformBenchmark(const BenchOptions &options)
+{
+    uint32_t count = options.objectCount;
+
+    std::vector<glm::vec3> positions(count);
+    std::vector<glm::quat> rotations(count);
+    std::vector<glm::vec3> scales(count);
+
+    TransformSystem transforms;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        float t = static_cast<float>(i);
+        positions[i] = glm::vec3(t * 0.01f, -t * 0.02f, t * 0.03f);
+        rotations[i] = glm::angleAxis(
+            t, glm::normalize(glm::vec3(1.0f, t, 2.0f)));
+        scales[i] = glm::vec3(1.0f + t * 0.001f);
+        transforms.add(positions[i], rotations[i], scales[i]);
+    }
+
+    Camera camera;
+    const glm::mat4 &viewProjection = camera.getViewProjection();
+
+    std::vector<glm::mat4> out(count);
+
+    std::vector<NamedSummary> summaries;
+    summaries.push_back({"glm", measure(options, [&]() {
+                             computeMvpsGlm(positions,
+                                            rotations,
+                                            scales,
+                                            viewProjection,
+                                            out.data());
+                         })});
+
+    TransformKernel kernels[] = {
+        TransformKernel::Scalar, TransformKernel::Sse, TransformKernel::Avx2};
+    for (TransformKernel kernel : kernels)
+    {
+        if (kernel > getBestTransformKernel())
+            continue;
+
+        transforms.setKernel(kernel);
+        summaries.push_back(
+            {getTransformKernelName(kernel), measure(options, [&]() {
+                 transforms.computeMvps(
+                     viewProjection, 0, count, out.data());
+             })});
+    }
+
+    std::ostringstream config;
+    config << "{\"mode\": \"transforms\", \"objects\": " << count
+           << ", \"iterations\": " << options.frameCount << "}";
+
+    return publishReport(options, config.str(), summaries);
+}
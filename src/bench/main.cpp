@@ -0,0 +1,224 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "Benchmarks.h"
+
+// stdout only ever carries the JSON report.
+static void printUsage()
+{
+    std::cerr
+        << "Usage: vulkan-hack-week-bench [options]\n"
+           "  --mode NAME           frames, replay, transforms, jobs,\n"
+           "                        allocations, dispatch, pacing,\n"
+           "                        histogram or mesh (frames)\n"
+           "  --objects N           objects drawn or transformed (1)\n"
+           "  --width N             render width (800)\n"
+           "  --height N            render height (600)\n"
+           "  --frames-in-flight N  frames recorded ahead (2)\n"
+           "  --threads N           job system threads, 0 for one per\n"
+           "                        hardware thread; jobs mode scales up\n"
+           "                        to it (0)\n"
+           "  --warmup N            frames discarded before measuring (60,\n"
+           "                        1 in mesh mode)\n"
+           "  --frames N            measured frames or iterations (1000,\n"
+           "                        10 in mesh mode)\n"
+           "  --frame-rate R        pacing mode frame rate cap (60)\n"
+           "  --recording PATH      frame recording the replay mode\n"
+           "                        draws, see VULKAN_HACK_WEEK_RECORD\n"
+           "  --record PATH         record the drawn frames to PATH,\n"
+           "                        allocations mode counts the recorder\n"
+           "  --window              present to a window instead of a\n"
+           "                        headless surface\n"
+           "  --driver-allocator    let the driver allocate host memory\n"
+           "                        instead of the pooled allocator\n"
+           "  --render-pass         render with a render pass and\n"
+           "                        framebuffers even if dynamic\n"
+           "                        rendering is supported\n"
+           "  --null-driver         frame loop commands only count their\n"
+           "                        calls, frames measure the renderer's\n"
+           "                        CPU time alone\n"
+           "  --msaa N              samples per pixel, lowered to what\n"
+           "                        the device supports (1)\n"
+           "  --min-scale S         lowest resolution scale dynamic\n"
+           "                        resolution may pick, 1 disables it (1)\n"
+           "  --gpu-budget MS       GPU frame time dynamic resolution\n"
+           "                        aims under (14)\n"
+           "  --capture PATH        stream the frames to PATH: .y4m,\n"
+           "                        .png (one per frame) or raw RGBA\n"
+           "  --output PATH         write the JSON report to PATH\n"
+           "  --baseline PATH       compare against a previous report\n"
+           "  --threshold R         allowed slowdown, 0.1 for 10% (0.1)\n";
+}
+
+// Unlike std::stoul, rejects trailing characters, negative numbers and
+// anything that doesn't fit.
+static uint32_t parseCount(const std::string &value)
+{
+    size_t end;
+    unsigned long number = std::stoul(value, &end);
+    if (end != value.size() || value.find('-') != std::string::npos)
+        throw std::invalid_argument(value);
+    if (number > UINT32_MAX)
+        throw std::out_of_range(value);
+    return static_cast<uint32_t>(number);
+}
+
+static double parseReal(const std::string &value)
+{
+    size_t end;
+    double number = std::stod(value, &end);
+    if (end != value.size())
+        throw std::invalid_argument(value);
+    return number;
+}
+
+static bool parseOptions(int argc, char **argv, BenchOptions &options)
+{
+    options.config.headless = true;
+    // Mesh mode iterations take a good part of a second.
+    bool warmupGiven = false;
+    bool framesGiven = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--window")
+        {
+            options.config.headless = false;
+            continue;
+        }
+        if (option == "--driver-allocator")
+        {
+            options.config.hostAllocator = false;
+            continue;
+        }
+        if (option == "--render-pass")
+        {
+            options.config.dynamicRendering = false;
+            continue;
+        }
+        if (option == "--null-driver")
+        {
+            options.config.nullDriver = true;
+            continue;
+        }
+        if (option == "--help" || i + 1 >= argc)
+            return false;
+
+        const char *value = argv[++i];
+        try
+        {
+            if (option == "--mode")
+                options.mode = value;
+            else if (option == "--objects")
+                options.objectCount = parseCount(value);
+            else if (option == "--width")
+                options.config.width = parseCount(value);
+            else if (option == "--height")
+                options.config.height = parseCount(value);
+            else if (option == "--frames-in-flight")
+                options.config.framesInFlight = parseCount(value);
+            else if (option == "--threads")
+                options.config.workerThreads = parseCount(value);
+            else if (option == "--warmup")
+            {
+                options.warmupFrames = parseCount(value);
+                warmupGiven = true;
+            }
+            else if (option == "--frames")
+            {
+                options.frameCount = parseCount(value);
+                framesGiven = true;
+            }
+            else if (option == "--frame-rate")
+                options.frameRate = parseReal(value);
+            else if (option == "--recording")
+                options.recordingPath = value;
+            else if (option == "--record")
+                options.config.recordPath = value;
+            else if (option == "--msaa")
+                options.config.msaaSamples = parseCount(value);
+            else if (option == "--min-scale")
+                options.config.minResolutionScale =
+                    static_cast<float>(parseReal(value));
+            else if (option == "--gpu-budget")
+                options.config.gpuBudgetMs =
+                    static_cast<float>(parseReal(value));
+            else if (option == "--capture")
+                options.config.capturePath = value;
+            else if (option == "--output")
+                options.outputPath = value;
+            else if (option == "--baseline")
+                options.baselinePath = value;
+            else if (option == "--threshold")
+                options.threshold = parseReal(value);
+            else
+                return false;
+        }
+        catch (const std::invalid_argument &)
+        {
+            std::cerr << "Invalid value " << value << " for " << option
+                      << '\n';
+            return false;
+        }
+        catch (const std::out_of_range &)
+        {
+            std::cerr << "Value " << value << " out of range for " << option
+                      << '\n';
+            return false;
+        }
+    }
+
+    if (options.mode == "mesh" && !warmupGiven)
+        options.warmupFrames = 1;
+    if (options.mode == "mesh" && !framesGiven)
+        options.frameCount = 10;
+
+    // A zero sized headless surface never gets a usable extent.
+    return options.config.width > 0 && options.config.height > 0 &&
+           options.config.framesInFlight > 0 && options.frameCount > 0 &&
+           options.frameRate > 0.0;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        if (options.mode == "frames")
+            return runFrameBenchmark(options);
+        if (options.mode == "replay")
+            return runReplayBenchmark(options);
+        if (options.mode == "transforms")
+            return runTransformBenchmark(options);
+        if (options.mode == "jobs")
+            return runJobBenchmark(options);
+        if (options.mode == "allocations")
+            return runAllocationBenchmark(options);
+        if (options.mode == "dispatch")
+            return runDispatchBenchmark(options);
+        if (options.mode == "pacing")
+            return runPacingBenchmark(options);
+        if (options.mode == "histogram")
+            return runHistogramBenchmark(options);
+        if (options.mode == "mesh")
+            return runMeshBenchmark(options);
+
+        std::cerr << "Unknown mode " << options.mode << '\n';
+        return EXIT_FAILURE;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}
@@ -1,17 +1,18 @@
 #version 450
 
-layout(binding = 0) uniform UniformBufferObject {
-    mat4 model;
-    mat4 view;
-    mat4 proj;
-} ubo;
+layout(binding = 0) readonly buffer InstanceBuffer {
+    mat4 mvp[];
+} instances;
 
 layout(location = 0) in vec2 inPosition;
 layout(location = 1) in vec3 inColor;
 
 layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 0.0, 1.0);
+    gl_Position = instances.mvp[gl_InstanceIndex] * vec4(inPosition, 0.0, 1.0);
     fragColor = inColor;
+    // The meshes span [-0.5, 0.5], so the texture covers them once.
+    fragTexCoord = inPosition + 0.5;
 }
@@ -0,0 +1,100 @@
+#include <vulkan/vulkan.h>
+
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+#include "HostAllocator.h"
+#include "VulkanContext.h"
+
+#include "TestUtils.h"
+
+static const uint32_t VALUE_COUNT = 4096;
+
+static MemoryUsage getUsage(const VulkanMemoryTracker &memoryTracker,
+                            MemoryCategory category)
+{
+    return memoryTracker.getStatistics()
+        .categories[static_cast<size_t>(category)];
+}
+
+int main()
+{
+    VulkanContext context(getNullDriverConfig());
+    context.init();
+
+    VkDevice device = context.getDevice();
+    const VulkanBufferCreator &bufferCreator = context.getBufferCreator();
+    const VulkanMemoryTracker &memoryTracker = context.getMemoryTracker();
+
+    std::vector<uint32_t> values(VALUE_COUNT);
+    std::iota(values.begin(), values.end(), 0);
+    size_t byteCount = values.size() * sizeof(values[0]);
+    VkDeviceSize size = byteCount;
+
+    MemoryUsage geometryBefore =
+        getUsage(memoryTracker, MemoryCategory::Geometry);
+    MemoryUsage stagingBefore =
+        getUsage(memoryTracker, MemoryCategory::Staging);
+    MemoryUsage readbackBefore =
+        getUsage(memoryTracker, MemoryCategory::Readback);
+
+    // Uploaded into device local memory through a staging buffer, which is
+    // freed again before returning.
+    VkBuffer buffer;
+    VkDeviceMemory memory;
+    bufferCreator.createStagingBuffer(values.data(),
+                                      size,
+                                      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                      MemoryCategory::Geometry,
+                                      buffer,
+                                      memory);
+
+    MemoryUsage geometry = getUsage(memoryTracker, MemoryCategory::Geometry);
+    CHECK(geometry.allocationCount == geometryBefore.allocationCount + 1);
+    CHECK(geometry.allocatedBytes >= geometryBefore.allocatedBytes + size);
+    MemoryUsage staging = getUsage(memoryTracker, MemoryCategory::Staging);
+    CHECK(staging.allocationCount == stagingBefore.allocationCount);
+    CHECK(staging.allocatedBytes == stagingBefore.allocatedBytes);
+    CHECK(staging.peakBytes >= stagingBefore.allocatedBytes + size);
+
+    // Read back through host visible memory, the loader's commands are
+    // real even with the null driver.
+    VkBuffer readback;
+    VkDeviceMemory readbackMemory;
+    bufferCreator.createBuffer(size,
+                               VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                               MemoryCategory::Readback,
+                               readback,
+                               readbackMemory);
+
+    VkCommandBuffer commandBuffer = bufferCreator.beginSingleTimeCommands();
+    VkBufferCopy region{};
+    region.size = size;
+    vkCmdCopyBuffer(commandBuffer, buffer, readback, 1, &region);
+    bufferCreator.endSingleTimeCommands(commandBuffer);
+
+    void *mapped;
+    CHECK(vkMapMemory(device, readbackMemory, 0, size, 0, &mapped) ==
+          VK_SUCCESS);
+    CHECK(std::memcmp(mapped, values.data(), byteCount) == 0);
+    vkUnmapMemory(device, readbackMemory);
+
+    vkDestroyBuffer(
+        device, readback, HostAllocator::get(HostAllocationTag::Buffers));
+    bufferCreator.freeMemory(readbackMemory);
+    vkDestroyBuffer(
+        device, buffer, HostAllocator::get(HostAllocationTag::Buffers));
+    bufferCreator.freeMemory(memory);
+
+    geometry = getUsage(memoryTracker, MemoryCategory::Geometry);
+    CHECK(geometry.allocationCount == geometryBefore.allocationCount);
+    CHECK(geometry.allocatedBytes == geometryBefore.allocatedBytes);
+    MemoryUsage readbackUsage =
+        getUsage(memoryTracker, MemoryCategory::Readback);
+    CHECK(readbackUsage.allocatedBytes == readbackBefore.allocatedBytes);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,188 @@
+#include <glm/gtc/quaternion.hpp>
+#include <vulkan/vulkan.h>
+
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+#include "Camera.h"
+#include "Scene.h"
+#include "Triangle.h"
+#include "VulkanContext.h"
+#include "VulkanNullDriver.h"
+
+#include "TestUtils.h"
+
+// Enough to record on the job system's threads too, when it has several.
+static const uint32_t OBJECT_COUNT = 5000;
+
+typedef VulkanNullDriver::Call Call;
+
+// Index of the first call to command at or after first, calls.size() if
+// there is none.
+static size_t find(const std::vector<Call> &calls,
+                   VulkanNullDriver::Command command,
+                   size_t first = 0)
+{
+    while (first < calls.size() && calls[first].command != command)
+        first++;
+    return first;
+}
+
+static void createObjects(Scene &scene, MeshHandle mesh)
+{
+    uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(OBJECT_COUNT)));
+    float spacing = 2.0f / side;
+
+    for (uint32_t i = 0; i < OBJECT_COUNT; i++)
+    {
+        glm::vec3 position((i % side + 0.5f) * spacing - 1.0f,
+                           (i / side + 0.5f) * spacing - 1.0f,
+                           0.0f);
+        scene.create(mesh,
+                     position,
+                     glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                     glm::vec3(spacing),
+                     0);
+    }
+}
+
+// Every draw in a command buffer comes after its state was bound there.
+static void checkBoundBeforeDraws(const std::vector<Call> &calls)
+{
+    const uint32_t pipelineBound = 1;
+    const uint32_t descriptorSetBound = 2;
+    const uint32_t vertexBufferBound = 4;
+    const uint32_t indexBufferBound = 8;
+    const uint32_t allBound = 15;
+
+    // By command buffer handle.
+    std::unordered_map<uint64_t, uint32_t> bound;
+    for (const Call &call : calls)
+    {
+        uint32_t &state = bound[call.arguments[0]];
+        switch (call.command)
+        {
+        case VulkanNullDriver::vkCmdBindPipeline:
+            state |= pipelineBound;
+            break;
+        case VulkanNullDriver::vkCmdBindDescriptorSets:
+            state |= descriptorSetBound;
+            break;
+        case VulkanNullDriver::vkCmdBindVertexBuffers:
+            state |= vertexBufferBound;
+            break;
+        case VulkanNullDriver::vkCmdBindIndexBuffer:
+            state |= indexBufferBound;
+            break;
+        case VulkanNullDriver::vkCmdDrawIndexed:
+            CHECK(state == allBound);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+int main()
+{
+    VulkanContext context(getNullDriverConfig());
+    context.init();
+
+    Triangle triangle(&context);
+    triangle.init();
+
+    Scene scene;
+    createObjects(scene, scene.addMesh(&triangle));
+    Camera camera;
+
+    VulkanPipeline &pipeline = context.getPipeline();
+    // Sizes the instance buffer to the scene.
+    CHECK(pipeline.drawFrame(scene, camera));
+
+    VulkanNullDriver::setRecording(true);
+    CHECK(pipeline.drawFrame(scene, camera));
+    VulkanNullDriver::setRecording(false);
+    std::vector<Call> calls = VulkanNullDriver::takeCalls();
+
+    // Waits for the frame slot, acquires, then resets the fence it waited
+    // for, in that order.
+    size_t wait = find(calls, VulkanNullDriver::vkWaitForFences);
+    size_t acquire = find(calls, VulkanNullDriver::vkAcquireNextImageKHR);
+    size_t resetFence = find(calls, VulkanNullDriver::vkResetFences);
+    CHECK(wait == 0);
+    CHECK(wait < acquire && acquire < resetFence);
+    CHECK(resetFence < calls.size());
+
+    // The primary command buffer is reset, begun and ended, then submitted
+    // and presented last.
+    size_t reset = find(calls, VulkanNullDriver::vkResetCommandBuffer);
+    CHECK(reset > resetFence && reset < calls.size());
+    uint64_t primary = calls[reset].arguments[0];
+    size_t begin = reset + 1;
+    while (begin < calls.size() &&
+           !(calls[begin].command == VulkanNullDriver::vkBeginCommandBuffer &&
+             calls[begin].arguments[0] == primary))
+    {
+        begin++;
+    }
+    size_t end = begin;
+    while (end < calls.size() &&
+           !(calls[end].command == VulkanNullDriver::vkEndCommandBuffer &&
+             calls[end].arguments[0] == primary))
+    {
+        end++;
+    }
+    size_t submit = find(calls, VulkanNullDriver::vkQueueSubmit);
+    CHECK(begin < end && end < submit);
+    CHECK(submit + 2 == calls.size());
+    CHECK(calls.back().command == VulkanNullDriver::vkQueuePresentKHR);
+
+    // One draw per drawn object, each selecting its own matrix.
+    const DrawStats &drawStats = pipeline.getDrawStats();
+    CHECK(drawStats.draws > 0);
+    std::vector<bool> drawn(OBJECT_COUNT, false);
+    uint32_t draws = 0;
+    for (const Call &call : calls)
+    {
+        if (call.command != VulkanNullDriver::vkCmdDrawIndexed)
+            continue;
+        // commandBuffer, indexCount, instanceCount, firstIndex,
+        // vertexOffset, firstInstance.
+        uint64_t object = call.arguments[5];
+        CHECK(call.arguments[2] == 1);
+        CHECK(call.arguments[1] > 0);
+        CHECK(object < OBJECT_COUNT && !drawn[object]);
+        drawn[object] = true;
+        draws++;
+    }
+    CHECK(draws == drawStats.draws);
+
+    // Only skipped vertex and index buffer binds count as avoided.
+    uint32_t vertexBufferBinds = 0;
+    uint32_t indexBufferBinds = 0;
+    for (const Call &call : calls)
+    {
+        vertexBufferBinds +=
+            call.command == VulkanNullDriver::vkCmdBindVertexBuffers;
+        indexBufferBinds +=
+            call.command == VulkanNullDriver::vkCmdBindIndexBuffer;
+    }
+    CHECK(vertexBufferBinds == drawStats.vertexBufferBinds);
+    CHECK(indexBufferBinds == drawStats.indexBufferBinds);
+    CHECK(drawStats.bindsAvoided ==
+          2 * draws - vertexBufferBinds - indexBufferBinds);
+    CHECK(find(calls, VulkanNullDriver::vkCmdBindPipeline) < calls.size());
+    checkBoundBeforeDraws(calls);
+
+    // Secondaries recorded on the workers are executed by the primary.
+    size_t execute = find(calls, VulkanNullDriver::vkCmdExecuteCommands);
+    if (execute < calls.size())
+    {
+        CHECK(calls[execute].arguments[0] == primary);
+        CHECK(begin < execute && execute < end);
+    }
+
+    vkDeviceWaitIdle(context.getDevice());
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "Camera.h"
+#include "DrawList.h"
+#include "FrameArena.h"
+#include "JobSystem.h"
+#include "MeshAsset.h"
+#include "Scene.h"
+#include "Triangle.h"
+
+#include "TestUtils.h"
+
+static const float ASPECT = 1.5f;
+
+// Sphere against the frustum in view space, where it is a pyramid along -Z:
+// each side plane goes through the eye at half the field of view.
+static bool isInFrustum(const Camera &camera,
+                        const glm::vec3 &position,
+                        float radius)
+{
+    glm::vec4 view = camera.getView() * glm::vec4(position, 1.0f);
+    float depth = -view.z;
+    if (depth + radius < camera.getNearPlane() ||
+        depth - radius > camera.getFarPlane())
+    {
+        return false;
+    }
+
+    float halfY = camera.getFovY() * 0.5f;
+    float halfX = std::atan(std::tan(halfY) * ASPECT);
+    return std::abs(view.x) * std::cos(halfX) - depth * std::sin(halfX) <=
+               radius &&
+           std::abs(view.y) * std::cos(halfY) - depth * std::sin(halfY) <=
+               radius;
+}
+
+// What DrawList::build does, on one thread with std::stable_sort.
+static std::vector<std::pair<uint64_t, uint32_t>>
+buildReference(const Scene &scene, const Camera &camera)
+{
+    const TransformSystem &transforms = scene.getTransforms();
+    const glm::vec3 &cameraPosition = camera.getPosition();
+    float inverseFar = 1.0f / camera.getFarPlane();
+
+    std::vector<std::pair<uint64_t, uint32_t>> draws;
+    for (uint32_t i = 0; i < scene.size(); i++)
+    {
+        if (!(scene.getFlags()[i] & SCENE_FLAG_VISIBLE))
+            continue;
+
+        glm::vec3 position(transforms.getPositionsX()[i],
+                           transforms.getPositionsY()[i],
+                           transforms.getPositionsZ()[i]);
+        float radius = scene.getBoundingRadii()[i] * transforms.getMaxScale(i);
+        if (!isInFrustum(camera, position, radius))
+            continue;
+
+        glm::vec3 offset(transforms.getPositionsX()[i] - cameraPosition.x,
+                         transforms.getPositionsY()[i] - cameraPosition.y,
+                         transforms.getPositionsZ()[i] - cameraPosition.z);
+        float depth = std::sqrt(glm::dot(offset, offset)) * inverseFar;
+        draws.push_back({makeDrawKey(DRAW_PASS_OPAQUE,
+                                     0,
+                                     scene.getMeshes()[i],
+                                     depth),
+                         i});
+    }
+
+    std::stable_sort(draws.begin(),
+                     draws.end(),
+                     [](const std::pair<uint64_t, uint32_t> &a,
+                        const std::pair<uint64_t, uint32_t> &b) {
+                         return a.first < b.first;
+                     });
+    return draws;
+}
+
+int main()
+{
+    CHECK(makeDrawKey(1, 2, 4, 1.0f) == 0x10200000004fffffull);
+
+    // Mesh data is never read, only the bounding radius.
+    Triangle triangle(nullptr);
+    JobSystem jobSystem(4);
+
+    // Sees part of the random scenes, the rest is culled on every side.
+    Camera camera;
+    camera.lookAt(glm::vec3(50.0f, 50.0f, -30.0f),
+                  glm::vec3(50.0f, 50.0f, 50.0f),
+                  glm::vec3(0.0f, 1.0f, 0.0f));
+    // Off the integer positions, no entity sits right on the far plane.
+    camera.setPerspective(glm::radians(45.0f), 0.1f, 95.5f);
+    camera.setAspect(ASPECT);
+
+    // Single chunk, several chunks, and enough for the parallel sort.
+    for (uint32_t objectCount : {0u, 1u, 1000u, 10000u, 100000u})
+    {
+        Scene scene;
+        std::mt19937 random(objectCount);
+        MeshHandle meshes[] = {scene.addMesh(&triangle),
+                               scene.addMesh(&triangle),
+                               scene.addMesh(&triangle)};
+        for (uint32_t i = 0; i < objectCount; i++)
+        {
+            glm::vec3 position(static_cast<float>(random() % 100),
+                               static_cast<float>(random() % 100),
+                               static_cast<float>(random() % 100));
+            SceneHandle handle = scene.create(meshes[random() % 3],
+                                              position,
+                                              glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                                              glm::vec3(1.0f),
+                                              random() % 7);
+            if (random() % 3 == 0)
+                scene.setFlags(handle, 0);
+        }
+
+        FrameArena frameArena;
+        DrawList drawList;
+        drawList.build(scene, camera, frameArena, jobSystem);
+
+        std::vector<std::pair<uint64_t, uint32_t>> reference =
+            buildReference(scene, camera);
+        CHECK(drawList.size() == reference.size());
+        for (uint32_t i = 0; i < drawList.size(); i++)
+        {
+            CHECK(drawList.getKeys()[i] == reference[i].first);
+            CHECK(drawList.getObjects()[i] == reference[i].second);
+        }
+    }
+
+    // Straddling a side plane counts, behind the eye, past the far plane,
+    // beside the frustum or hidden doesn't.
+    {
+        // No geometry, a bounding radius of 1 and the LOD every asset has.
+        MeshAssetHeader header{};
+        header.magic = MeshAssetHeader::MAGIC;
+        header.version = MeshAssetHeader::VERSION;
+        header.lodCount = 1;
+        header.boundingRadius = 1.0f;
+        MeshLod lod{};
+        std::vector<char> bytes(sizeof(header) + sizeof(lod));
+        std::memcpy(bytes.data(), &header, sizeof(header));
+        std::memcpy(bytes.data() + sizeof(header), &lod, sizeof(lod));
+
+        Triangle unitSphere(nullptr);
+        unitSphere.decode(bytes);
+
+        Scene scene;
+        MeshHandle mesh = scene.addMesh(&unitSphere);
+        glm::quat rotation(1.0f, 0.0f, 0.0f, 0.0f);
+        glm::vec3 scale(1.0f);
+
+        Camera front;
+        front.lookAt(glm::vec3(0.0f),
+                     glm::vec3(0.0f, 0.0f, -1.0f),
+                     glm::vec3(0.0f, 1.0f, 0.0f));
+        front.setPerspective(glm::radians(90.0f), 0.1f, 100.0f);
+        front.setAspect(1.0f);
+
+        scene.create(mesh, glm::vec3(0, 0, -10), rotation, scale, 0);
+        scene.create(mesh, glm::vec3(0, 0, 10), rotation, scale, 0);
+        scene.create(mesh, glm::vec3(0, 0, -200), rotation, scale, 0);
+        scene.create(mesh, glm::vec3(50, 0, -10), rotation, scale, 0);
+        // Its center is outside, 0.2 from the plane x = -z.
+        scene.create(mesh, glm::vec3(10.3f, 0, -10), rotation, scale, 0);
+        SceneHandle hidden = scene.create(
+            mesh, glm::vec3(0, 0, -20), rotation, scale, 0);
+        scene.setFlags(hidden, 0);
+
+        FrameArena frameArena;
+        DrawList drawList;
+        drawList.build(scene, front, frameArena, jobSystem);
+
+        CHECK(drawList.size() == 2);
+        CHECK(drawList.getObjects()[0] == 0);
+        CHECK(drawList.getObjects()[1] == 4);
+    }
+
+    return EXIT_SUCCESS;
+}
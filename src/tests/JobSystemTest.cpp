@@ -0,0 +1,73 @@
+#include <atomic>
+#include <vector>
+
+#include "JobSystem.h"
+
+#include "TestUtils.h"
+
+// More than a job pool holds, from one thread.
+static const uint32_t JOB_COUNT = 20000;
+
+struct Runs
+{
+    std::vector<std::atomic<uint32_t>> counts;
+    JobSystem *jobSystem;
+    JobCounter counter;
+
+    Runs() : counts(JOB_COUNT), jobSystem(nullptr) {}
+
+    bool ranOnce() const
+    {
+        for (const std::atomic<uint32_t> &count : counts)
+        {
+            if (count.load() != 1)
+                return false;
+        }
+        return true;
+    }
+};
+
+static void countRun(void *data, uint32_t begin, uint32_t)
+{
+    static_cast<Runs *>(data)->counts[begin]++;
+}
+
+static void scheduleAll(void *data, uint32_t, uint32_t)
+{
+    Runs &runs = *static_cast<Runs *>(data);
+    for (uint32_t i = 0; i < JOB_COUNT; i++)
+        runs.jobSystem->schedule(countRun, &runs, i, i + 1, &runs.counter);
+}
+
+int main()
+{
+    JobSystem jobSystem(4);
+
+    // Every job runs exactly once even when a thread has more in flight
+    // than its pool holds.
+    Runs injected;
+    injected.jobSystem = &jobSystem;
+    scheduleAll(&injected, 0, 0);
+    jobSystem.wait(injected.counter);
+    CHECK(injected.ranOnce());
+
+    // The same from a job, which may wrap around to its own slot.
+    Runs nested;
+    nested.jobSystem = &jobSystem;
+    JobCounter scheduled;
+    jobSystem.schedule(scheduleAll, &nested, 0, 1, &scheduled);
+    jobSystem.wait(scheduled);
+    jobSystem.wait(nested.counter);
+    CHECK(nested.ranOnce());
+
+    // Covers each index once, whatever the batching.
+    std::vector<std::atomic<uint32_t>> covered(JOB_COUNT);
+    jobSystem.parallelFor(JOB_COUNT, 16, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++)
+            covered[i]++;
+    });
+    for (const std::atomic<uint32_t> &count : covered)
+        CHECK(count.load() == 1);
+
+    return EXIT_SUCCESS;
+}
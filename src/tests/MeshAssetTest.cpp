@@ -0,0 +1,59 @@
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "MeshGrid.h"
+#include "MeshAsset.h"
+#include "utils.h"
+
+#include "TestUtils.h"
+
+static bool rejects(const std::vector<char> &bytes)
+{
+    MeshAsset asset;
+    try
+    {
+        readMeshAsset(bytes, asset);
+    }
+    catch (const std::runtime_error &)
+    {
+        return true;
+    }
+    return false;
+}
+
+int main()
+{
+    MeshAsset baked;
+    buildGrid(8, true, baked.vertices, baked.indices);
+    MeshOptimizationReport report = bakeMeshAsset(baked);
+
+    CHECK(report.after.acmr < report.before.acmr);
+    CHECK(baked.lods.size() > 1);
+    CHECK(baked.boundingRadius > 0.7f && baked.boundingRadius < 0.71f);
+
+    std::string path = "mesh_asset_test.mesh";
+    writeMeshAsset(path, baked);
+    std::vector<char> bytes = readFile(path);
+    std::remove(path.c_str());
+
+    MeshAsset loaded;
+    readMeshAsset(bytes, loaded);
+    CHECK(loaded.vertices.size() == baked.vertices.size());
+    CHECK(loaded.indices == baked.indices);
+    CHECK(loaded.lods.size() == baked.lods.size());
+    CHECK(loaded.lods.back().indexCount == baked.lods.back().indexCount);
+    CHECK(loaded.boundingRadius == baked.boundingRadius);
+
+    CHECK(rejects({}));
+    CHECK(rejects(std::vector<char>(bytes.begin(), bytes.end() - 1)));
+    std::vector<char> corrupt = bytes;
+    corrupt[sizeof(MeshAssetHeader)] ^= 0x7f;
+    CHECK(!rejects(corrupt));
+    corrupt = bytes;
+    corrupt[bytes.size() - sizeof(MeshLod) * baked.lods.size() - 1] = 0x7f;
+    CHECK(rejects(corrupt));
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "MeshGrid.h"
+#include "MeshOptimizer.h"
+
+#include "TestUtils.h"
+
+using IndexTriangle = std::array<uint32_t, 3>;
+
+// Rotated to start at its smallest index, which keeps the winding.
+static std::vector<IndexTriangle>
+getTriangles(const std::vector<uint32_t> &indices)
+{
+    std::vector<IndexTriangle> triangles;
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        IndexTriangle triangle = {indices[i], indices[i + 1], indices[i + 2]};
+        std::rotate(triangle.begin(),
+                    std::min_element(triangle.begin(), triangle.end()),
+                    triangle.end());
+        triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+static void testVertexCache()
+{
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    buildGrid(32, true, vertices, indices);
+    std::vector<uint32_t> original = indices;
+
+    VertexCacheStatistics before =
+        analyzeVertexCache(indices, vertices.size());
+    optimizeVertexCache(indices, vertices.size());
+    VertexCacheStatistics after = analyzeVertexCache(indices, vertices.size());
+
+    // Tipsify only reorders triangles.
+    CHECK(getTriangles(indices) == getTriangles(original));
+    // A shuffled grid misses on nearly every vertex, an optimized one gets
+    // close to the 0.5 per triangle of a regular grid.
+    CHECK(before.acmr > 2.0f);
+    CHECK(after.acmr < 0.8f);
+    CHECK(after.atvr < before.atvr);
+}
+
+static void testDeduplicate()
+{
+    std::vector<Vertex> vertices = {{{0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}},
+                                    {{1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}},
+                                    {{0.0f, 1.0f}, {1.0f, 0.0f, 0.0f}},
+                                    {{1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}},
+                                    {{0.0f, 1.0f}, {1.0f, 0.0f, 0.0f}},
+                                    {{1.0f, 1.0f}, {1.0f, 0.0f, 0.0f}}};
+    std::vector<uint32_t> indices = {0, 1, 2, 3, 5, 4};
+
+    CHECK(deduplicateVertices(vertices, indices) == 4);
+    CHECK(vertices.size() == 4);
+    CHECK(indices[1] == indices[3]);
+    CHECK(indices[2] == indices[5]);
+}
+
+static void testOptimizeMesh()
+{
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    buildGrid(32, true, vertices, indices);
+    std::vector<Vertex> originalVertices = vertices;
+    std::vector<uint32_t> originalIndices = indices;
+
+    MeshOptimizationReport report = optimizeMesh(vertices, indices);
+
+    CHECK(report.verticesBefore == originalVertices.size());
+    CHECK(report.verticesAfter == vertices.size());
+    CHECK(report.after.acmr < report.before.acmr);
+    CHECK(indices.size() == originalIndices.size());
+
+    // Vertex fetch order: each vertex is first used after the previous one.
+    uint32_t nextVertex = 0;
+    for (uint32_t index : indices)
+    {
+        CHECK(index <= nextVertex);
+        if (index == nextVertex)
+            nextVertex++;
+    }
+    CHECK(nextVertex == vertices.size());
+
+    // Same triangles, compared by the position of their corners.
+    auto corners = [](const std::vector<Vertex> &vertices,
+                      const std::vector<uint32_t> &indices) {
+        std::vector<std::array<float, 6>> triangles;
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            const Vertex *v[3] = {&vertices[indices[i]],
+                                  &vertices[indices[i + 1]],
+                                  &vertices[indices[i + 2]]};
+            size_t first = 0;
+            for (size_t j = 1; j < 3; j++)
+            {
+                if (std::make_pair(v[j]->pos.x, v[j]->pos.y) <
+                    std::make_pair(v[first]->pos.x, v[first]->pos.y))
+                {
+                    first = j;
+                }
+            }
+            std::array<float, 6> triangle;
+            for (size_t j = 0; j < 3; j++)
+            {
+                triangle[j * 2] = v[(first + j) % 3]->pos.x;
+                triangle[j * 2 + 1] = v[(first + j) % 3]->pos.y;
+            }
+            triangles.push_back(triangle);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    };
+    CHECK(corners(vertices, indices) ==
+          corners(originalVertices, originalIndices));
+}
+
+int main()
+{
+    testVertexCache();
+    testDeduplicate();
+    testOptimizeMesh();
+    return EXIT_SUCCESS;
+}
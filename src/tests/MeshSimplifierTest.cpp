@@ -0,0 +1,75 @@
+#include <cmath>
+#include <vector>
+
+#include "MeshGrid.h"
+#include "MeshSimplifier.h"
+
+#include "TestUtils.h"
+
+static void testSimplify()
+{
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    buildGrid(16, false, vertices, indices);
+
+    const size_t target = indices.size() / 4;
+    const float maxError = 0.01f;
+    float error = -1.0f;
+    std::vector<uint32_t> result =
+        simplifyMesh(indices, vertices, target, maxError, &error);
+
+    // A flat grid collapses down to the target without any error.
+    CHECK(result.size() % 3 == 0);
+    CHECK(result.size() <= target);
+    CHECK(!result.empty());
+    CHECK(error >= 0.0f && error <= maxError);
+    for (uint32_t index : result)
+        CHECK(index < vertices.size());
+
+    // Nothing may collapse when no error is allowed on a curved border.
+    std::vector<Vertex> fan = {{{0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}}};
+    std::vector<uint32_t> fanIndices;
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        float angle = i * 0.7f;
+        fan.push_back({{std::cos(angle), std::sin(angle)}, {1.0f, 1.0f, 1.0f}});
+        if (i > 0)
+            fanIndices.insert(fanIndices.end(), {0, i, i + 1});
+    }
+    result = simplifyMesh(fanIndices, fan, 3, 0.0f, &error);
+    CHECK(result.size() == fanIndices.size());
+}
+
+static void testLods()
+{
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    buildGrid(16, false, vertices, indices);
+    const size_t originalCount = indices.size();
+
+    std::vector<MeshLod> lods;
+    generateLods(indices, vertices, lods);
+
+    CHECK(lods.size() > 1);
+    CHECK(lods[0].firstIndex == 0);
+    CHECK(lods[0].indexCount == originalCount);
+    CHECK(lods[0].error == 0.0f);
+    for (size_t i = 0; i < lods.size(); i++)
+    {
+        CHECK(lods[i].firstIndex + lods[i].indexCount <= indices.size());
+        if (i == 0)
+            continue;
+
+        CHECK(lods[i].indexCount < lods[i - 1].indexCount);
+        CHECK(lods[i].error >= lods[i - 1].error);
+    }
+    for (uint32_t index : indices)
+        CHECK(index < vertices.size());
+}
+
+int main()
+{
+    testSimplify();
+    testLods();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,87 @@
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+#include "Camera.h"
+#include "Scene.h"
+#include "VulkanContext.h"
+#include "VulkanNullDriver.h"
+
+#include "TestUtils.h"
+
+static bool called(const std::vector<VulkanNullDriver::Call> &calls,
+                   VulkanNullDriver::Command command)
+{
+    for (const VulkanNullDriver::Call &call : calls)
+    {
+        if (call.command == command)
+            return true;
+    }
+    return false;
+}
+
+// The swap chain and everything sized after it are whole again.
+static void checkSwapChain(const VulkanContext &context)
+{
+    const ContextConfig &config = context.getConfig();
+    const VulkanSwapChain &swapChain = context.getSwapChain();
+    CHECK(swapChain != VK_NULL_HANDLE);
+    CHECK(swapChain.getExtent().width == config.width);
+    CHECK(swapChain.getExtent().height == config.height);
+    CHECK(!swapChain.getImages().empty());
+    CHECK(swapChain.getImageViews().size() == swapChain.getImages().size());
+    // Only the render pass path has framebuffers.
+    if (!context.getRenderPass().usesDynamicRendering())
+    {
+        CHECK(swapChain.getFrameBuffers().size() ==
+              swapChain.getImages().size());
+    }
+}
+
+int main()
+{
+    VulkanContext context(getNullDriverConfig());
+    context.init();
+
+    const VulkanSwapChain &swapChain = context.getSwapChain();
+    VulkanPipeline &pipeline = context.getPipeline();
+    Scene scene;
+    Camera camera;
+
+    checkSwapChain(context);
+    CHECK(swapChain.getRecreateCount() == 0);
+    CHECK(pipeline.drawFrame(scene, camera));
+
+    VulkanNullDriver::setRecording(true);
+
+    // Out of date when acquiring: nothing is drawn, the swap chain is
+    // recreated right away.
+    VulkanNullDriver::failNextAcquire(VK_ERROR_OUT_OF_DATE_KHR);
+    CHECK(!pipeline.drawFrame(scene, camera));
+    std::vector<VulkanNullDriver::Call> calls = VulkanNullDriver::takeCalls();
+    CHECK(!calls.empty());
+    CHECK(calls.back().command == VulkanNullDriver::vkAcquireNextImageKHR);
+    CHECK(!called(calls, VulkanNullDriver::vkQueueSubmit));
+    CHECK(swapChain.getRecreateCount() == 1);
+    checkSwapChain(context);
+
+    // Suboptimal when presenting: the frame still went out, the swap chain
+    // is recreated after it.
+    VulkanNullDriver::failNextPresent(VK_SUBOPTIMAL_KHR);
+    CHECK(!pipeline.drawFrame(scene, camera));
+    calls = VulkanNullDriver::takeCalls();
+    CHECK(called(calls, VulkanNullDriver::vkQueueSubmit));
+    CHECK(calls.back().command == VulkanNullDriver::vkQueuePresentKHR);
+    CHECK(swapChain.getRecreateCount() == 2);
+    checkSwapChain(context);
+
+    // And frames go on as before.
+    CHECK(pipeline.drawFrame(scene, camera));
+    calls = VulkanNullDriver::takeCalls();
+    CHECK(calls.back().command == VulkanNullDriver::vkQueuePresentKHR);
+    CHECK(swapChain.getRecreateCount() == 2);
+
+    VulkanNullDriver::setRecording(false);
+    vkDeviceWaitIdle(context.getDevice());
+    return EXIT_SUCCESS;
+}
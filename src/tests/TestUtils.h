@@ -0,0 +1,31 @@
+#ifndef TEST_UTILS_H
+#define TEST_UTILS_H
+
+#include <cstdlib>
+#include <iostream>
+
+#include "VulkanTypes.h"
+
+// Fails the test, which is its own process, on the first broken check.
+#define CHECK(condition)                                                     \
+    do                                                                       \
+    {                                                                        \
+        if (!(condition))                                                    \
+        {                                                                    \
+            std::cerr << __FILE__ << ':' << __LINE__ << ": " #condition      \
+                      << " failed\n";                                        \
+            std::exit(EXIT_FAILURE);                                         \
+        }                                                                    \
+    } while (0)
+
+// Headless, with the frame loop on VulkanNullDriver. Startup still creates
+// real Vulkan objects, so tests using it need a device.
+inline ContextConfig getNullDriverConfig()
+{
+    ContextConfig config;
+    config.headless = true;
+    config.nullDriver = true;
+    return config;
+}
+
+#endif // TEST_UTILS_H
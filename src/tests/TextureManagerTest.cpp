@@ -0,0 +1,121 @@
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "Camera.h"
+#include "Scene.h"
+#include "VulkanContext.h"
+
+#include "TestUtils.h"
+
+// Not powers of two, so some levels round their extent down.
+static const uint32_t TEXTURE_WIDTH = 300;
+static const uint32_t TEXTURE_HEIGHT = 200;
+// 300x200 down to 1x1.
+static const uint32_t LEVEL_COUNT = 9;
+// The first level no larger than the streaming tail, 75x50.
+static const uint32_t TAIL_LEVEL = 2;
+// Far more than streaming the whole chain takes.
+static const uint32_t MAX_UPDATES = 64;
+
+static MemoryUsage getUsage(const VulkanMemoryTracker &memoryTracker,
+                            MemoryCategory category)
+{
+    return memoryTracker.getStatistics()
+        .categories[static_cast<size_t>(category)];
+}
+
+int main()
+{
+    VulkanContext context(getNullDriverConfig());
+    context.init();
+
+    VkDevice device = context.getDevice();
+    VulkanTextureManager &textureManager = context.getTextureManager();
+    const VulkanMemoryTracker &memoryTracker = context.getMemoryTracker();
+    const TextureHandle white = VulkanTextureManager::WHITE_TEXTURE;
+
+    // The fallback is resident as soon as init() returns.
+    CHECK(textureManager.getResidentLevel(white) == 0);
+    CHECK(textureManager.getImageView(white) != VK_NULL_HANDLE);
+    VkDeviceSize whiteBytes = textureManager.getResidentBytes();
+    CHECK(whiteBytes == 4);
+
+    std::vector<uint8_t> pixels(TEXTURE_WIDTH * TEXTURE_HEIGHT * 4);
+    for (size_t i = 0; i < pixels.size(); i++)
+        pixels[i] = static_cast<uint8_t>(i);
+
+    TextureHandle texture = textureManager.createTexture(
+        pixels.data(), TEXTURE_WIDTH, TEXTURE_HEIGHT);
+    CHECK(textureManager.getLevelCount(texture) == LEVEL_COUNT);
+    CHECK(textureManager.getResidentLevel(texture) == LEVEL_COUNT);
+    CHECK(textureManager.getImageView(texture) ==
+          textureManager.getImageView(white));
+
+    MemoryUsage stagingBefore =
+        getUsage(memoryTracker, MemoryCategory::Staging);
+    MemoryUsage texturesBefore =
+        getUsage(memoryTracker, MemoryCategory::Textures);
+    size_t retiredBefore = context.getRetirementQueue().getPendingCount();
+
+    // The mip tail first, then one finer level per finished upload.
+    uint32_t resident = LEVEL_COUNT;
+    for (uint32_t i = 0; i < MAX_UPDATES && resident > 0; i++)
+    {
+        textureManager.update();
+        // update() never waits, the uploads finish in the background.
+        vkDeviceWaitIdle(device);
+
+        uint32_t level = textureManager.getResidentLevel(texture);
+        if (level != resident)
+        {
+            CHECK(level == (resident == LEVEL_COUNT ? TAIL_LEVEL
+                                                    : resident - 1));
+            CHECK(textureManager.getImageView(texture) !=
+                  textureManager.getImageView(white));
+        }
+        resident = level;
+    }
+    CHECK(resident == 0);
+    CHECK(textureManager.getPendingUploads() == 0);
+
+    // Every level below the resident one is part of its image.
+    VkDeviceSize textureBytes = 0;
+    uint32_t width = TEXTURE_WIDTH;
+    uint32_t height = TEXTURE_HEIGHT;
+    for (uint32_t level = 0; level < LEVEL_COUNT; level++)
+    {
+        textureBytes += VkDeviceSize(width) * height * 4;
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+    }
+    CHECK(textureManager.getResidentBytes() == whiteBytes + textureBytes);
+
+    // Staged through the persistent ring, never a buffer of their own.
+    MemoryUsage staging = getUsage(memoryTracker, MemoryCategory::Staging);
+    CHECK(staging.allocationCount == stagingBefore.allocationCount);
+    CHECK(staging.peakBytes == stagingBefore.peakBytes);
+
+    // The tail and level 1 images wait for the frames that may sample them,
+    // with their views and memory.
+    RetirementQueue &retirementQueue = context.getRetirementQueue();
+    CHECK(retirementQueue.getPendingCount() == retiredBefore + 2 * 3);
+    MemoryUsage textures = getUsage(memoryTracker, MemoryCategory::Textures);
+    CHECK(textures.allocationCount == texturesBefore.allocationCount + 3);
+
+    VulkanPipeline &pipeline = context.getPipeline();
+    pipeline.setTexture(texture);
+    Scene scene;
+    Camera camera;
+    for (uint32_t i = 0; i <= pipeline.getFramesInFlight(); i++)
+        CHECK(pipeline.drawFrame(scene, camera));
+
+    CHECK(retirementQueue.getPendingCount() <= retiredBefore);
+    textures = getUsage(memoryTracker, MemoryCategory::Textures);
+    CHECK(textures.allocationCount == texturesBefore.allocationCount + 1);
+    CHECK(textureManager.getResidentLevel(texture) == 0);
+
+    vkDeviceWaitIdle(device);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,43 @@
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+
+#include "MeshAsset.h"
+
+// Optimizes the app's mesh, builds its LODs and writes it where the app
+// loads it from, as part of the build.
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage: vulkan-hack-week-bake-mesh OUTPUT\n";
+        return EXIT_FAILURE;
+    }
+
+    MeshAsset asset;
+    asset.vertices = {{{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}},
+                      {{0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}},
+                      {{0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}},
+                      {{-0.5f, 0.5f}, {0.0f, 1.0f, 0.0f}}};
+    asset.indices = {0, 1, 2, 2, 3, 0};
+
+    try
+    {
+        MeshOptimizationReport report = bakeMeshAsset(asset);
+        writeMeshAsset(argv[1], asset);
+
+        std::cout << "Mesh optimized: " << report.verticesBefore << " -> "
+                  << report.verticesAfter << " vertices, ACMR "
+                  << report.before.acmr << " -> " << report.after.acmr
+                  << ", ATVR " << report.before.atvr << " -> "
+                  << report.after.atvr << ", " << asset.lods.size()
+                  << " LODs" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
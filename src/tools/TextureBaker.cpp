@@ -0,0 +1,49 @@
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+
+#include "TextureAsset.h"
+
+static const uint32_t TEXTURE_SIZE = 256;
+// Squares per side.
+static const uint32_t CHECKER_COUNT = 8;
+
+// Writes the checkerboard the app samples where the app loads it from, as
+// part of the build.
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage: vulkan-hack-week-bake-texture OUTPUT\n";
+        return EXIT_FAILURE;
+    }
+
+    TextureAsset asset;
+    asset.width = TEXTURE_SIZE;
+    asset.height = TEXTURE_SIZE;
+    asset.pixels.reserve(TEXTURE_SIZE * TEXTURE_SIZE * 4);
+
+    uint32_t square = TEXTURE_SIZE / CHECKER_COUNT;
+    for (uint32_t y = 0; y < TEXTURE_SIZE; y++)
+    {
+        for (uint32_t x = 0; x < TEXTURE_SIZE; x++)
+        {
+            uint8_t value = (x / square + y / square) % 2 == 0 ? 255 : 64;
+            asset.pixels.insert(asset.pixels.end(), {value, value, value, 255});
+        }
+    }
+
+    try
+    {
+        writeTextureAsset(argv[1], asset);
+        std::cout << "Texture baked: " << asset.width << "x" << asset.height
+                  << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
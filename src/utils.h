@@ -8,6 +8,4 @@
 
 std::vector<char> readFile(const std::string &filename);
 
-UniformBufferObject updateUniform(float width, float height);
-
 #endif // UTILS_H